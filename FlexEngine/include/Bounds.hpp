@@ -0,0 +1,40 @@
+#pragma once
+
+#include <glm/integer.hpp>
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+
+namespace flex
+{
+	struct AABB
+	{
+		glm::vec3 minimum;
+		glm::vec3 maximum;
+	};
+
+	struct BoundingSphere
+	{
+		glm::vec3 center;
+		float radius;
+	};
+
+	// Volumes enclosing every vertex of a mesh, in whichever space its positions are in
+	struct MeshBounds
+	{
+		AABB box;
+		BoundingSphere sphere;
+	};
+
+	// positions must point at the first position of a vertex buffer with the given stride (in bytes)
+	// The sphere is centered on the box, with the smallest radius which contains every position
+	// Bounds are empty (zero sized, at the origin) when vertexCount is zero
+	MeshBounds CalculateMeshBounds(const void* positions, glm::uint vertexCount, glm::uint vertexStride);
+
+	// Returns the smallest box which contains box after being transformed (Arvo - "Transforming Axis-Aligned Bounding Boxes")
+	AABB TransformAABB(const AABB& box, const glm::mat4& transform);
+
+	// The radius is scaled by the transform's largest axis scale, so stays conservative under non-uniform scales
+	BoundingSphere TransformBoundingSphere(const BoundingSphere& sphere, const glm::mat4& transform);
+
+	MeshBounds TransformMeshBounds(const MeshBounds& bounds, const glm::mat4& transform);
+} // namespace flex
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <glm/integer.hpp>
+#include <glm/vec3.hpp>
+
+#include "Bounds.hpp"
+#include "MeshOptimizer.hpp"
+#include "Typedefs.hpp"
+
+namespace flex
+{
+	class VertexBufferData;
+
+	// Read-only view of an entire file mapped into memory
+	class MappedFile
+	{
+	public:
+		MappedFile();
+		~MappedFile();
+
+		bool Open(const std::string& filePath);
+		void Close();
+
+		bool IsOpen() const;
+		const void* GetData() const;
+		size_t GetSize() const;
+
+	private:
+		const void* m_Data = nullptr;
+		size_t m_Size = 0;
+
+#ifdef _WIN32
+		void* m_FileHandle = nullptr;
+		void* m_MappingHandle = nullptr;
+#else
+		int m_FileDescriptor = -1;
+#endif
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+	};
+
+	// Cooked meshes store the final interleaved vertex data and indices produced by
+	// MeshPrefab::LoadFromFile so subsequent loads can bypass Assimp entirely.
+	// A cooked mesh is only valid for the source file, modification time and import flags it was built with
+	class CookedMesh
+	{
+	public:
+		struct Key
+		{
+			std::string sourceFilePath;
+			glm::uint64 sourceModifiedTime;
+			glm::uint importFlags; // Hash of every import setting which affects the resulting vertex data
+		};
+
+		CookedMesh();
+		~CookedMesh();
+
+		// Fills out key for the given file, returns false if the source file doesn't exist
+		static bool CreateKey(const std::string& sourceFilePath, glm::uint importFlags, Key& key);
+
+		// lods & meshlets may be empty, otherwise each one is a range of indices
+		static bool Save(const Key& key, const VertexBufferData& vertexBufferData, const std::vector<glm::uint>& indices,
+			const std::vector<MeshLOD>& lods, const std::vector<Meshlet>& meshlets, const MeshBounds& bounds);
+
+		// Maps the cooked file for key into memory, returns false if there is no cooked file or it is stale
+		bool Load(const Key& key);
+		void Unload();
+		bool IsLoaded() const;
+
+		// All pointers are only valid while this mesh is loaded
+		void* GetVertexData() const;
+		glm::uint GetVertexBufferSize() const;
+		glm::uint GetVertexCount() const;
+		VertexAttributes GetVertexAttributes() const;
+
+		const glm::uint* GetIndices() const;
+		glm::uint GetIndexCount() const;
+
+		const MeshLOD* GetLODs() const;
+		glm::uint GetLODCount() const;
+
+		const Meshlet* GetMeshlets() const;
+		glm::uint GetMeshletCount() const;
+
+		MeshBounds GetBounds() const;
+
+		// FNV-1a, shared by every cooked asset to identify their source files
+		static glm::uint HashString(const std::string& str);
+
+	private:
+		struct Header
+		{
+			glm::uint magic;
+			glm::uint version;
+			glm::uint64 sourceModifiedTime;
+			glm::uint sourcePathHash;
+			glm::uint importFlags;
+
+			VertexAttributes vertexAttributes;
+			glm::uint vertexCount;
+			glm::uint vertexStride;
+			glm::uint vertexBufferSize;
+			glm::uint indexCount;
+			glm::uint lodCount; // LOD ranges follow the indices
+			glm::uint meshletCount; // Meshlets follow the LOD ranges
+
+			float boundsMin[3];
+			float boundsMax[3];
+			float boundingSphere[4]; // Center & radius
+			glm::uint padding[1]; // Keeps vertex data following the header 16-byte aligned
+		};
+
+		static std::string GetCookedFilePath(const Key& key);
+
+		static const glm::uint MAGIC; // "FMSH"
+		static const glm::uint VERSION;
+		static const std::string COOKED_MESH_DIRECTORY;
+
+		MappedFile m_File;
+		const Header* m_Header = nullptr;
+
+		CookedMesh(const CookedMesh&) = delete;
+		CookedMesh& operator=(const CookedMesh&) = delete;
+	};
+} // namespace flex
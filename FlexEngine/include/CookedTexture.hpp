@@ -0,0 +1,137 @@
+#pragma once
+
+#include <string>
+
+#include <glm/integer.hpp>
+
+#include "CookedMesh.hpp" // For MappedFile
+#include "TextureCompression.hpp"
+
+namespace flex
+{
+	// What a texture's contents represent, which decides the format it's cooked into
+	enum class TextureUsage
+	{
+		COLOR, // BC7
+		NORMAL, // BC5: tangent space X & Y, Z is reconstructed when sampled
+		SINGLE_CHANNEL, // BC4: red only, for metallic, roughness & AO maps
+		HDR, // BC6H
+		ORM, // BC7: occlusion, roughness & metallic maps packed into red, green & blue
+		NONE // Never cooked
+	};
+
+	BlockCompressionFormat GetCookedTextureFormat(TextureUsage usage);
+
+	// Cooked textures are DDS files holding a block compressed copy of a source image along with its entire mip chain,
+	// so textures can be uploaded in the format they're sampled in without decoding or generating mips at runtime.
+	// Like cooked meshes, a cooked texture is only valid for the source file, modification time and settings it was built with
+	class CookedTexture
+	{
+	public:
+		struct Key
+		{
+			std::string sourceFilePath;
+			glm::uint64 sourceModifiedTime;
+			TextureUsage usage;
+			bool flipVertically;
+		};
+
+		CookedTexture();
+		~CookedTexture();
+
+		// Fills out key for the given file, returns false if the source file doesn't exist
+		static bool CreateKey(const std::string& sourceFilePath, TextureUsage usage, bool flipVertically, Key& key);
+		// For a texture packed from several source files, any of which may be empty. Its source is named after the first file
+		// & a hash of them all, and was modified whenever the most recently modified of them was. Returns false if none exist
+		static bool CreatePackedKey(const std::string* sourceFilePaths, glm::uint sourceCount, TextureUsage usage, bool flipVertically, Key& key);
+
+		// Compresses pixels & every mip below them into the cooked file for key
+		// pixels must be 8 bit with channelCount channels, or 32 bit floats for HDR textures
+		// Images whose dimensions aren't multiples of 4 are never cooked
+		static bool Save(const Key& key, const void* pixels, glm::uint width, glm::uint height, glm::uint channelCount);
+
+		// Decodes the source file & saves it, for when its pixels aren't already at hand
+		// Packed textures can't be cooked this way since their key doesn't name their sources
+		static bool Cook(const Key& key);
+
+		// Maps the cooked file for key into memory, returns false if there is no cooked file or it is stale
+		bool Load(const Key& key);
+		void Unload();
+		bool IsLoaded() const;
+
+		BlockCompressionFormat GetFormat() const;
+		glm::uint GetWidth() const;
+		glm::uint GetHeight() const;
+		glm::uint GetMipCount() const;
+
+		glm::uint GetMipWidth(glm::uint mipLevel) const;
+		glm::uint GetMipHeight(glm::uint mipLevel) const;
+		// Only valid while this texture is loaded
+		const void* GetMipData(glm::uint mipLevel) const;
+		glm::uint GetMipSize(glm::uint mipLevel) const;
+		// Size of every mip level combined
+		glm::uint GetDataSize() const;
+
+	private:
+		// DDS_PIXELFORMAT
+		struct PixelFormat
+		{
+			glm::uint size;
+			glm::uint flags;
+			glm::uint fourCC;
+			glm::uint rgbBitCount;
+			glm::uint rBitMask;
+			glm::uint gBitMask;
+			glm::uint bBitMask;
+			glm::uint aBitMask;
+		};
+
+		// "DDS " followed by DDS_HEADER & DDS_HEADER_DXT10, so cooked textures open in any DDS viewer
+		// The key each texture was cooked with is stored in the header's reserved words
+		struct Header
+		{
+			glm::uint fileMagic;
+
+			glm::uint size;
+			glm::uint flags;
+			glm::uint height;
+			glm::uint width;
+			glm::uint pitchOrLinearSize;
+			glm::uint depth;
+			glm::uint mipMapCount;
+			glm::uint magic; // First of eleven reserved words
+			glm::uint version;
+			glm::uint sourceModifiedTimeLow;
+			glm::uint sourceModifiedTimeHigh;
+			glm::uint sourcePathHash;
+			glm::uint cookFlags; // Usage & whether the source was flipped
+			glm::uint reserved[5];
+			PixelFormat pixelFormat;
+			glm::uint caps;
+			glm::uint caps2;
+			glm::uint caps3;
+			glm::uint caps4;
+			glm::uint reserved2;
+
+			glm::uint dxgiFormat;
+			glm::uint resourceDimension;
+			glm::uint miscFlag;
+			glm::uint arraySize;
+			glm::uint miscFlags2;
+		};
+
+		static std::string GetCookedFilePath(const Key& key);
+		static glm::uint GetCookFlags(const Key& key);
+
+		static const glm::uint MAGIC; // "FTEX"
+		static const glm::uint VERSION;
+		static const std::string COOKED_TEXTURE_DIRECTORY;
+
+		MappedFile m_File;
+		const Header* m_Header = nullptr;
+		BlockCompressionFormat m_Format = BlockCompressionFormat::NONE;
+
+		CookedTexture(const CookedTexture&) = delete;
+		CookedTexture& operator=(const CookedTexture&) = delete;
+	};
+} // namespace flex
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <map>
+
+#include <glm/integer.hpp>
+
+namespace flex
+{
+	// Tracks which parts of [0, capacity) are unallocated, for sub-allocating elements (vertices, indices, ...) from large buffers
+	// Freed ranges are merged with free neighbours, so space released in any order becomes usable by larger allocations again
+	class FreeRangeList
+	{
+	public:
+		FreeRangeList();
+
+		// Forgets every allocation, leaving one free range which covers the whole capacity
+		void Reset(glm::uint capacity);
+
+		// First fit, returns false when no single free range holds count elements
+		bool Allocate(glm::uint count, glm::uint& outOffset);
+		void Free(glm::uint offset, glm::uint count);
+
+		glm::uint GetCapacity() const;
+		glm::uint GetFreeCount() const;
+		glm::uint GetFreeRangeCount() const;
+
+	private:
+		std::map<glm::uint, glm::uint> m_FreeRanges; // Offset -> count, never adjacent to each other
+		glm::uint m_Capacity = 0;
+		glm::uint m_FreeCount = 0;
+	};
+} // namespace flex
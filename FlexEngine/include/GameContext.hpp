@@ -10,6 +10,7 @@ namespace flex
 	class Renderer;
 	class FlexEngine;
 	class SceneManager;
+	class ThreadPool;
 
 	struct GameContext
 	{
@@ -19,6 +20,7 @@ namespace flex
 		Renderer* renderer;
 		FlexEngine* engineInstance;
 		SceneManager* sceneManager;
+		ThreadPool* threadPool;
 		Monitor monitor;
 
 		float elapsedTime;
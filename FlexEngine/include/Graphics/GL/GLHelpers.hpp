@@ -3,14 +3,19 @@
 
 #include <string>
 #include <array>
+#include <functional>
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
 #include "Logger.hpp"
+#include "TextureCompression.hpp"
 
 namespace flex
 {
+	class CookedTexture;
+	class ThreadPool;
+
 	namespace gl
 	{
 		struct GLShader
@@ -18,6 +23,7 @@ namespace flex
 			Renderer::Shader shader = {};
 
 			glm::uint program;
+			bool usesPerObjectBuffer = false; // Reads its model matrices from PerObjectBuffer rather than from uniforms
 		};
 
 		struct GLCubemapGBuffer
@@ -55,6 +61,8 @@ namespace flex
 				int enableAOSampler;
 				int hdrEquirectangularSampler;
 				int enableIrradianceSampler;
+				int enableIrradianceSH;
+				int irradianceSH;
 				int verticalScale;
 			};
 			UniformIDs uniformIDs;
@@ -71,14 +79,32 @@ namespace flex
 			glm::uint metallicSamplerID;
 			glm::uint roughnessSamplerID;
 			glm::uint aoSamplerID;
+			glm::uint ormSamplerID;
 
 			glm::uint hdrTextureID;
 
 			glm::uint irradianceSamplerID;
 			glm::uint prefilteredMapSamplerID;
 			glm::uint brdfLUTSamplerID;
+
+			// The materials whose irradiance sampler (or SH) & prefiltered map this material uses, may be itself
+			// Their textures are re-created after being evicted, so the sampler IDs above are refreshed from them every frame
+			MaterialID irradianceSourceMatID = INVALID_MATERIAL_ID;
+			MaterialID prefilteredMapSourceMatID = INVALID_MATERIAL_ID;
+			IrradianceSH9 irradianceSH; // Only valid once irradianceSHGenerated is true
+			bool irradianceSHGenerated = false;
+
+			// Skybox environment maps (cubemap, irradiance & prefiltered) are only created once the material is first used
+			bool lazyEnvironmentMaps = false;
+			bool environmentMapsResident = false; // Textures exist
+			bool environmentMapsGenerated = false; // Textures hold the environment
+			float environmentMapsLastUsedTime = 0.0f;
+			bool enableCubemapTrilinearFiltering = false;
 		};
 
+		const glm::uint INVALID_DRAW_LIST_INDEX = (glm::uint)-1;
+		const glm::uint INVALID_GEOMETRY_POOL = (glm::uint)-1;
+
 		struct GLRenderObject
 		{
 			RenderID renderID;
@@ -90,10 +116,16 @@ namespace flex
 			bool visible = true;
 			bool isStatic = true; // If true, this object will be rendered to reflection probes
 
-			glm::uint VAO;
+			glm::uint VAO; // Shared by every object in the same geometry pool drawn with the same shader
 			glm::uint VBO;
 			glm::uint IBO;
 
+			glm::uint meshID = 0; // Identifies the vertex & index data, objects created from the same data share it
+			glm::uint64 sharedDataID = 0; // See RenderObjectCreateInfo::sharedDataID
+			glm::uint geometryPool = INVALID_GEOMETRY_POOL; // Index into GLRenderer's geometry pools, when sub-allocated from one
+			GLint baseVertex = 0; // Where this object's vertices & indices start in its (possibly shared) buffers
+			glm::uint indexBufferOffset = 0;
+
 			GLenum topology = GL_TRIANGLES;
 			GLenum cullFace = GL_BACK;
 			GLboolean enableCulling = GL_TRUE;
@@ -103,32 +135,90 @@ namespace flex
 
 			glm::uint vertexBuffer;
 			VertexBufferData* vertexBufferData = nullptr;
+			glm::uint vertexCount = 0; // Copied on creation, vertexBufferData's data may be released once uploaded
 
 			bool indexed = false;
 			glm::uint indexBuffer;
 			std::vector<glm::uint>* indices = nullptr;
+			GLenum indexType = GL_UNSIGNED_INT; // GL_UNSIGNED_SHORT when all indices fit in 16 bits
+			glm::uint totalIndexCount = 0; // Copied on creation, indices may be released once uploaded
+			glm::uint firstIndex = 0; // Range of indices which is drawn (see SetRenderObjectIndexRange), relative to indexBufferOffset
+			glm::uint indexCount = 0;
+
+			const std::vector<Meshlet>* meshlets = nullptr; // When set, visibleIndexRanges are drawn instead of the index range above
+			std::vector<MeshLOD> visibleIndexRanges; // Refreshed every frame by CullRenderObjectMeshlets
+
+			bool hasBounds = false;
+			MeshBounds localBounds; // Of the vertices' positions, before being transformed
+			MeshBounds worldBounds; // Only valid once UpdateWorldBounds has been called, see GetRenderObjectWorldBounds
+			glm::uint worldBoundsVersion = 0; // Version of transform worldBounds was last calculated with
 
 			glm::uint materialID;
+
+			glm::uint drawListIndex = INVALID_DRAW_LIST_INDEX; // Position in GLRenderer's draw list, only set while visible
 		};
 		typedef std::vector<GLRenderObject*>::iterator RenderObjectIter;
 
+		// One visible render object in GLRenderer's persistent draw list, see GLRenderer::CalculateSortKey for the key's layout
+		struct DrawListEntry
+		{
+			glm::uint64 sortKey;
+			GLRenderObject* renderObject;
+		};
+
+		// LSD radix sort on sortKey, one pass per byte which isn't the same in every key. scratch is used as the second buffer
+		void RadixSortDrawList(std::vector<DrawListEntry>& entries, std::vector<DrawListEntry>& scratch);
+
+		// Points a render object whose shader changed from previousShaderID to shaderID at the VAO it must now be drawn with. Objects in a
+		// geometry pool move to the pool's VAO for the new shader (from getPoolVAO), others keep their own
+		// Returns true when the object's vertex attributes must be described again, which is whenever the shader changed
+		bool SelectVAOForShader(GLRenderObject& renderObject, ShaderID previousShaderID, ShaderID shaderID,
+			const std::function<glm::uint(glm::uint poolIndex, ShaderID shaderID)>& getPoolVAO);
+
 		struct UniformInfo
 		{
 			const GLchar* name;
 			int* id;
 		};
 
-		struct ViewProjectionUBO
+		const glm::uint MAX_POINT_LIGHTS = 4; // Must match NUMBER_POINT_LIGHTS in per_frame.glsl
+
+		// Matches the std140 layout of PerFrameUBO in per_frame.glsl, the light structs are already padded to multiples of 16 bytes
+		struct PerFrameUBO
 		{
 			glm::mat4 view;
-			glm::mat4 proj;
+			glm::mat4 viewInv;
+			glm::mat4 projection;
+			glm::mat4 viewProjection;
+			glm::vec4 camPos;
+			Renderer::DirectionalLight dirLight;
+			Renderer::PointLight pointLights[MAX_POINT_LIGHTS];
+		};
+		static_assert(sizeof(PerFrameUBO) == 512, "PerFrameUBO must match its std140 layout in per_frame.glsl");
+
+		// Matches the std430 layout of PerObjectData in per_object.glsl, one per draw list entry
+		struct PerObjectData
+		{
+			glm::mat4 model;
+			glm::mat4 modelInvTranspose;
+			glm::uint materialID;
+			glm::uint padding[3];
 		};
+		static_assert(sizeof(PerObjectData) == 144, "PerObjectData must match its std430 layout in per_object.glsl");
 
-		struct ViewProjectionCombinedUBO
+		// Layout glMultiDrawElementsIndirect reads its commands in
+		struct DrawElementsIndirectCommand
 		{
-			glm::mat4 viewProj;
+			GLuint count;
+			GLuint instanceCount;
+			GLuint firstIndex;
+			GLint baseVertex;
+			GLuint baseInstance;
 		};
 
+		// Per-instance vertex attribute holding a draw's index into PerObjectBuffer, the draw's base instance selects it
+		const glm::uint OBJECT_INDEX_ATTRIBUTE_LOCATION = 15; // Must match in_ObjectIndex in per_object.glsl
+
 		bool GenerateGLTexture_Empty(glm::uint& textureID, glm::vec2i dimensions, bool generateMipMaps, GLenum internalFormat, GLenum format, GLenum type);
 		bool GenerateGLTexture_EmptyWithParams(glm::uint& textureID, glm::vec2i dimensions, bool generateMipMaps, GLenum internalFormat, GLenum format, GLenum type, int sWrap, int tWrap, int minFilter, int magFilter);
 		bool GenerateGLTexture(glm::uint& textureID, const std::string& filePath, bool flipVertically, bool generateMipMaps);
@@ -136,6 +226,15 @@ namespace flex
 		bool GenerateHDRGLTexture(glm::uint& textureID, const std::string& filePath, bool flipVertically, bool generateMipMaps);
 		bool GenerateHDRGLTextureWithParams(glm::uint& textureID, const std::string& filePath, bool flipVertically, bool generateMipMaps, int sWrap, int tWrap, int minFilter, int magFilter);
 
+		// Generates a 1x1 texture of the given color, to be sampled from until a streamed texture's real contents have been uploaded into it
+		bool GenerateGLTexture_Placeholder(glm::uint& textureID, const glm::vec3& color);
+
+		// RGTC (BC4 & BC5) is core in GL 3.0, BPTC (BC6H & BC7) only in 4.2
+		bool IsBlockCompressionFormatSupported(BlockCompressionFormat format);
+
+		// Uploads every mip level of a cooked texture into the already generated textureID
+		void UploadCookedGLTexture(glm::uint textureID, const CookedTexture& cookedTexture);
+
 		struct GLCubemapCreateInfo
 		{
 			glm::uint program;
@@ -144,6 +243,7 @@ namespace flex
 			std::vector<GLCubemapGBuffer>* textureGBufferIDs;
 			glm::uvec2 textureSize;
 			std::array<std::string, 6> filePaths; // Leave empty to generate an "empty" cubemap (no pixel data)
+			ThreadPool* threadPool = nullptr; // When set, the six faces are decoded in parallel
 			bool generateMipmaps = false;
 			bool enableTrilinearFiltering = false;
 			bool HDR = false;
@@ -152,6 +252,11 @@ namespace flex
 
 		bool GenerateGLCubemap(GLCubemapCreateInfo& createInfo);
 
+		// Reads GLSL source, replacing each #include "file" line with that file's contents (relative to the including file)
+		// GLSL has no include mechanism of its own, the files are shared with glslangValidator's GL_GOOGLE_include_directive
+		bool ReadGLSLFile(const std::string& filePath, std::vector<char>& outCode, glm::uint includeDepth = 0);
+		const glm::uint MAX_GLSL_INCLUDE_DEPTH = 8;
+
 		bool LoadGLShaders(glm::uint program, GLShader& shader);
 		bool LinkProgram(glm::uint program);
 
@@ -164,6 +269,9 @@ namespace flex
 		glm::uint CullFaceToGLMode(Renderer::CullFace cullFace);
 		GLenum DepthTestFuncToGlenum(Renderer::DepthTestFunc func);
 
+		// Byte offset of firstIndex into an index buffer of indexType, as passed to glDrawElements
+		void* GetIndexBufferOffset(GLenum indexType, glm::uint firstIndex);
+
 	} // namespace gl
 } // namespace flex
 
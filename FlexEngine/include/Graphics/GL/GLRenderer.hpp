@@ -2,12 +2,16 @@
 #if COMPILE_OPEN_GL
 
 #include "Graphics/Renderer.hpp"
+#include "FreeRangeList.hpp"
 
 #include <imgui.h>
 
+#include <future>
 #include <map>
 
 #include "Graphics/GL/GLHelpers.hpp"
+#include "Graphics/GL/GLStateCache.hpp"
+#include "Graphics/TextureLoader.hpp"
 
 namespace flex
 {
@@ -54,7 +58,12 @@ namespace flex
 				Renderer::Type renderType, bool normalized, int stride, void* pointer) override;
 			
 			virtual void SetSkyboxMaterial(MaterialID skyboxMaterialID) override;
+			virtual void SetEnvironmentMapEvictionDelay(float seconds) override;
 			virtual void SetRenderObjectMaterialID(RenderID renderID, MaterialID materialID) override;
+			virtual void SetRenderObjectIndexRange(RenderID renderID, glm::uint firstIndex, glm::uint indexCount) override;
+			virtual void SetRenderObjectMeshlets(RenderID renderID, const std::vector<Meshlet>* meshlets) override;
+			virtual bool GetRenderObjectWorldBounds(RenderID renderID, MeshBounds& worldBounds) override;
+			virtual bool IsRenderObjectUploaded(RenderID renderID) override;
 
 			virtual void Destroy(RenderID renderID) override;
 
@@ -81,12 +90,42 @@ namespace flex
 			void CaptureSceneToCubemap(const GameContext& gameContext, RenderID cubemapRenderID);
 			void GenerateCubemapFromHDREquirectangular(const GameContext& gameContext, MaterialID cubemapMaterialID, const std::string& environmentMapPath);
 			void GeneratePrefilteredMapFromCubemap(const GameContext& gameContext, MaterialID cubemapMaterialID);
+			// Projects onto spherical harmonics instead when the material's generateIrradianceSH is set
 			void GenerateIrradianceSamplerFromCubemap(const GameContext& gameContext, MaterialID cubemapMaterialID);
+			// Reads back a small mip of the material's cubemap and projects it onto irradianceSH on the CPU
+			void GenerateIrradianceSHFromCubemap(MaterialID cubemapMaterialID);
 			void GenerateBRDFLUT(const GameContext& gameContext, glm::uint brdfLUTTextureID, glm::uvec2 BRDFLUTSize);
+			// Creates m_BRDFTextureHandle if it doesn't exist yet, from its baked copy when there is one
+			void CreateBRDFLUT(const GameContext& gameContext);
+			// Uploads the material's cubemap, irradiance & prefiltered maps from their baked copies, returns false if they haven't been baked yet
+			bool LoadBakedEnvironment(MaterialID cubemapMaterialID, glm::uint64 sourceHash);
+
+			// Environment maps of skybox materials are created on first use rather than by InitializeMaterial
+			void CreateEnvironmentMapTextures(MaterialID materialID);
+			void DestroyEnvironmentMapTextures(MaterialID materialID);
+			// Creates & fills the material's environment maps unless they already are, from their baked copies when possible
+			void MaterializeEnvironmentMaps(const GameContext& gameContext, MaterialID materialID);
+			// Re-creates evicted maps of every batched material & the materials it samples, must be called after BatchRenderObjects
+			void MaterializeBatchedEnvironmentMaps(const GameContext& gameContext);
+			void EvictUnusedEnvironmentMaps(const GameContext& gameContext);
 
 			void SwapBuffers(const GameContext& gameContext);
 
-			void DrawRenderObjectBatch(const GameContext& gameContext, const std::vector<GLRenderObject*>& batchedRenderObjects, const DrawCallInfo& drawCallInfo);
+			// Consecutive draw list entries which share a material
+			struct DrawBatch
+			{
+				glm::uint firstEntry;
+				glm::uint entryCount;
+			};
+
+			void DrawRenderObjectBatch(const GameContext& gameContext, const DrawBatch& batch, const DrawCallInfo& drawCallInfo);
+			// Whether other can be drawn as an instance of renderObject, both must be in the same batch
+			bool CanDrawInstanced(const GLRenderObject* renderObject, const GLRenderObject* other) const;
+			// Whether other can be drawn by the same glMultiDrawElementsIndirect call as renderObject (possibly as a different mesh)
+			bool CanMultiDrawIndirect(const GLRenderObject* renderObject, const GLRenderObject* other) const;
+			// Draws the entries [first, end) of the draw list, which must all be pooled & able to be multi drawn together, through one
+			// glMultiDrawElementsIndirect call. Returns false (drawing nothing) when the indirect buffer's region has no room left
+			bool MultiDrawIndirect(glm::uint first, glm::uint end);
 			void DrawSpriteQuad(const GameContext& gameContext, glm::uint textureHandle, MaterialID materialID, bool flipVertically = false);
 
 			bool GetLoadedTexture(const std::string& filePath, glm::uint& handle);
@@ -104,11 +143,90 @@ namespace flex
 			void ResizeFrameBufferTexture(glm::uint handle, GLint internalFormat, GLenum format, GLenum type, const glm::vec2i& size);
 			void ResizeRenderBuffer(glm::uint handle, const glm::vec2i& size);
 
+			// Uploads the camera & lights into m_PerFrameUBO, once per frame rather than per material
+			void UpdatePerFrameUBO(const GameContext& gameContext);
+			// Overwrites only the camera matrices, used when capturing from another point of view than the camera's
+			void UpdatePerFrameUBOCamera(const glm::mat4& view, const glm::mat4& projection);
 			void UpdateMaterialUniforms(const GameContext& gameContext, MaterialID materialID);
+			// Only needed by shaders which don't read from PerObjectBuffer
 			void UpdatePerObjectUniforms(RenderID renderID, const GameContext& gameContext);
 			void UpdatePerObjectUniforms(MaterialID materialID, const glm::mat4& model, const GameContext& gameContext);
 
+			// Vertex & index buffers, shared by every render object created from the same data
+			struct GLSharedBuffers
+			{
+				glm::uint VBO;
+				glm::uint IBO;
+				GLenum indexType;
+				glm::uint refCount;
+				glm::uint meshID;
+				glm::uint geometryPool = INVALID_GEOMETRY_POOL; // When set, VBO & IBO belong to the pool and the data starts at the offsets below
+				GLint baseVertex = 0;
+				glm::uint firstIndex = 0;
+				glm::uint vertexCount = 0; // Size of the pool's ranges, which are freed along with these buffers
+				glm::uint indexCount = 0;
+			};
+			// The data's shared ID, or zero & the object's own render ID for data which isn't shared
+			typedef std::pair<glm::uint64, RenderID> SharedBufferKey;
+			static SharedBufferKey GetSharedBufferKey(const GLRenderObject* renderObject);
+
+			// Uploads vertex & (optional) index data into a geometry pool when possible, otherwise into new buffers. refCount starts at zero
+			GLSharedBuffers CreateSharedBuffers(const VertexBufferData* vertexBufferData, const std::vector<glm::uint>* indices);
+
+			// Large vertex & index buffers which indexed meshes with the same vertex layout are sub-allocated from, so drawing
+			// one after another needs no VAO or buffer changes and whole runs of them can be submitted through one indirect draw
+			struct GLGeometryPool
+			{
+				VertexAttributes attributes;
+				glm::uint vertexStride;
+				glm::uint VBO;
+				glm::uint IBO; // Meshes' indices are relative to their base vertex
+				GLenum indexType; // Meshes only share pools with others whose indices are the same size, see AllocateFromGeometryPool
+				FreeRangeList freeVertices;
+				FreeRangeList freeIndices;
+				glm::uint meshCount; // Meshes currently allocated from this pool
+				std::map<ShaderID, glm::uint> VAOs; // Attribute locations differ between shaders, so there's one VAO per shader
+			};
+
+			// Copies the data into free ranges of a pool with the same layout, creating a new pool when none has large enough ranges left
+			// Returns false when the mesh can't be pooled (it isn't indexed, has a separate position stream or is larger than a pool)
+			bool AllocateFromGeometryPool(const VertexBufferData* vertexBufferData, const std::vector<glm::uint>* indices, GLSharedBuffers& outSharedBuffers);
+			// Frees the buffers' ranges for later allocations from the same pool
+			void ReleaseFromGeometryPool(const GLSharedBuffers& sharedBuffers);
+			// Creates the pool's VAO for shaderID on first use, its attributes are described as render objects using it are initialized
+			glm::uint GetGeometryPoolVAO(glm::uint poolIndex, ShaderID shaderID);
+			void DestroyGeometryPools();
+
+			// Uploads textures whose images have finished decoding on worker threads into the placeholders created for them
+			// Stops once MAX_TEXTURE_UPLOAD_BYTES_PER_FRAME have been uploaded, unless waitForAll is true (which also waits for unfinished decodes)
+			void UploadPendingTextures(bool waitForAll);
+			// Copies image into textureID's storage through the next pixel unpack buffer in m_TextureUploadPBOs
+			void UploadDecodedTexture(glm::uint textureID, const DecodedImage& image, bool generateMipMaps);
+
+			// Keeps m_DrawList in sync with visible render objects, any change marks the list as needing to be re-sorted
+			void AddToDrawList(GLRenderObject* renderObject);
+			void RemoveFromDrawList(GLRenderObject* renderObject);
+			void UpdateDrawListEntry(GLRenderObject* renderObject);
+			// Bits 62-63: pass (deferred first), 52-61: shader, 36-51: material, 16-35: mesh ID, 0-15: distance to the camera
+			glm::uint64 CalculateSortKey(const GLRenderObject* renderObject, const glm::vec3& cameraPosition) const;
+			// Re-sorts the draw list and rebuilds the deferred & forward batches, only when something changed or the camera moved far enough
 			void BatchRenderObjects(const GameContext& gameContext);
+
+			// (Re)creates m_PerObjectSSBO & m_ObjectIndexBuffer with room for capacity objects per region
+			void CreatePerObjectBuffer(glm::uint capacity);
+			void DestroyPerObjectBuffer();
+			// Points the object index attribute of renderObject's VAO at m_ObjectIndexBuffer
+			void BindObjectIndexAttribute(GLRenderObject* renderObject);
+			// (Re)creates m_IndirectDrawBuffer with room for capacity commands per region, regions are shared with m_PerObjectSSBO
+			void CreateIndirectDrawBuffer(glm::uint capacity);
+			void DestroyIndirectDrawBuffer();
+			// Writes every draw list entry's data into the next region of m_PerObjectSSBO and binds that region
+			// Must be called after BatchRenderObjects, as entries are indexed by their position in the draw list
+			void UpdatePerObjectBuffer();
+			// Marks the current region as in use until the commands issued since UpdatePerObjectBuffer have completed
+			void FencePerObjectBuffer();
+			// Finds which meshlets of each render object that has them can be seen from the camera this frame
+			void CullRenderObjectMeshlets(const GameContext& gameContext);
 			void DrawDeferredObjects(const GameContext& gameContext, const DrawCallInfo& drawCallInfo);
 			void DrawGBufferQuad(const GameContext& gameContext, const DrawCallInfo& drawCallInfo);
 			void DrawForwardObjects(const GameContext& gameContext, const DrawCallInfo& drawCallInfo);
@@ -135,15 +253,70 @@ namespace flex
 			std::map<MaterialID, GLMaterial> m_Materials;
 			std::map<RenderID, GLRenderObject*> m_RenderObjects;
 
+			std::map<SharedBufferKey, GLSharedBuffers> m_SharedBuffers;
+
 			bool m_VSyncEnabled;
 
 			// TODO: Convert to map?
 			std::vector<GLShader> m_Shaders;
+
+			GLStateCache m_StateCache; // Frequently changed state set while drawing goes through here, see Draw
 			std::map<std::string, glm::uint> m_LoadedTextures; // Key is filepath, value is texture id
 
-			// TODO: Clean up (make more dynamic)
-			glm::uint viewProjectionUBO;
-			glm::uint viewProjectionCombinedUBO;
+			// A texture which is sampled as a placeholder until its image has been decoded & uploaded
+			struct PendingTextureUpload
+			{
+				glm::uint textureID;
+				std::future<DecodedImage> image;
+				bool generateMipMaps;
+			};
+			std::vector<PendingTextureUpload> m_PendingTextureUploads;
+
+			static const size_t MAX_TEXTURE_UPLOAD_BYTES_PER_FRAME = 16 * 1024 * 1024;
+			static const glm::uint NUM_TEXTURE_UPLOAD_PBOS = 3;
+			static const glm::uint PREFILTERED_MAP_MIP_COUNT = 5;
+			static const glm::uint IRRADIANCE_SH_SOURCE_SIZE = 32; // Largest cubemap face size read back to project irradiance SH from
+			// The draw list is re-keyed & re-sorted once the camera moves this far, so front-to-back order stays roughly correct
+			static constexpr float DRAW_LIST_RESORT_DISTANCE = 2.0f;
+			static constexpr float DRAW_LIST_MAX_SORT_DEPTH = 1000.0f; // Objects further away than this all land in the last depth bucket
+			static const glm::uint PER_FRAME_UBO_BINDING = 0;
+			static const glm::uint PER_OBJECT_SSBO_BINDING = 0;
+			static const glm::uint NUM_PER_OBJECT_SSBO_REGIONS = 3;
+			static const glm::uint MIN_PER_OBJECT_SSBO_CAPACITY = 1024;
+			static const glm::uint MIN_PER_OBJECT_DATA_PER_THREAD = 1024; // Fewer objects than this are filled in on the render thread alone
+			static const glm::uint MIN_INDIRECT_DRAW_BUFFER_CAPACITY = 1024;
+			static const glm::uint GEOMETRY_POOL_VERTEX_BUFFER_SIZE = 32 * 1024 * 1024; // In bytes
+			static const glm::uint GEOMETRY_POOL_INDEX_CAPACITY = 4 * 1024 * 1024;
+			static const glm::uint GEOMETRY_POOL_VERTEX_BINDING = 0; // Vertex buffer binding point of geometry pool VAOs
+			// Rotated through so a new upload rarely has to wait on the last one's transfer. Generated on first use
+			glm::uint m_TextureUploadPBOs[NUM_TEXTURE_UPLOAD_PBOS] = {};
+			glm::uint m_NextTextureUploadPBO = 0;
+
+			// Camera & lighting data, bound to PER_FRAME_UBO_BINDING and shared by every program
+			glm::uint m_PerFrameUBO = 0;
+			size_t m_LastWarnedPointLightCount = 0; // So dropped point lights are only warned about when their count changes
+
+			// Model matrices & material of every draw list entry, bound to PER_OBJECT_SSBO_BINDING. Persistently mapped and split into
+			// NUM_PER_OBJECT_SSBO_REGIONS regions which are written in turn, so the CPU never overwrites data the GPU may still be reading
+			glm::uint m_PerObjectSSBO = 0;
+			glm::uint8* m_PerObjectSSBOMapped = nullptr;
+			glm::uint m_PerObjectSSBOCapacity = 0; // In objects, per region
+			GLsizeiptr m_PerObjectSSBORegionSize = 0; // In bytes, a multiple of GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT
+			glm::uint m_PerObjectSSBORegion = 0; // Region being written to & read from this frame
+			GLsync m_PerObjectSSBOFences[NUM_PER_OBJECT_SSBO_REGIONS] = {};
+			// Holds 0, 1, 2, ..., read through the object index attribute (which has a divisor of one) of every VAO
+			glm::uint m_ObjectIndexBuffer = 0;
+
+			// Commands for glMultiDrawElementsIndirect, persistently mapped like m_PerObjectSSBO and split into the same regions
+			// (guarded by the same fences). When a frame runs out of room the remaining runs are drawn directly & it grows next frame
+			glm::uint m_IndirectDrawBuffer = 0;
+			DrawElementsIndirectCommand* m_IndirectDrawBufferMapped = nullptr;
+			glm::uint m_IndirectDrawBufferCapacity = 0; // In commands, per region
+			glm::uint m_IndirectDrawCommandCount = 0; // Written into the current region so far this frame
+			bool m_IndirectDrawBufferOverflowed = false;
+
+			std::vector<GLGeometryPool> m_GeometryPools;
+			glm::uint m_NextMeshID = 1;
 
 			RenderID m_GBufferQuadRenderID;
 			VertexBufferData m_gBufferQuadVertexBufferData;
@@ -189,15 +362,26 @@ namespace flex
 			glm::mat4 m_CaptureProjection;
 			std::array<glm::mat4, 6> m_CaptureViews;
 
-			MaterialID m_SkyBoxMaterialID; // Set by the user via SetSkyboxMaterial
+			MaterialID m_SkyBoxMaterialID = INVALID_MATERIAL_ID; // Set by the user via SetSkyboxMaterial
+
+			float m_EnvironmentMapEvictionDelay = 0.0f; // In seconds, 0 disables eviction
+			float m_LastEnvironmentMapEvictionCheckTime = 0.0f;
 			MeshPrefab* m_SkyBoxMesh = nullptr;
 
 			VertexBufferData m_1x1_NDC_QuadVertexBufferData;
 			Transform m_1x1_NDC_QuadTransform;
 			GLRenderObject* m_1x1_NDC_Quad = nullptr; // A 1x1 quad in NDC space
 
-			std::vector<std::vector<GLRenderObject*>> m_DeferredRenderObjectBatches;
-			std::vector<std::vector<GLRenderObject*>> m_ForwardRenderObjectBatches;
+			std::vector<DrawListEntry> m_DrawList; // Sorted by key unless m_DrawListDirty is set
+			std::vector<DrawListEntry> m_DrawListScratch;
+			bool m_DrawListDirty = true;
+			glm::vec3 m_DrawListCameraPosition = glm::vec3(0.0f); // Camera position the distances in the draw list's keys were calculated from
+
+			std::vector<DrawBatch> m_DeferredRenderObjectBatches;
+			std::vector<DrawBatch> m_ForwardRenderObjectBatches;
+
+			glm::uint m_DrawCallCount = 0; // Draw calls issued for draw list entries so far this frame
+			glm::uint m_LastFrameDrawCallCount = 0;
 
 			GLRenderer(const GLRenderer&) = delete;
 			GLRenderer& operator=(const GLRenderer&) = delete;
@@ -0,0 +1,63 @@
+#pragma once
+#if COMPILE_OPEN_GL
+
+#include <glad/glad.h>
+
+namespace flex
+{
+	namespace gl
+	{
+		// Shadows the GL state which changes most often while drawing, so calls which wouldn't change anything are never issued
+		// Code which changes any of this state without going through the cache must call Invalidate afterwards
+		class GLStateCache
+		{
+		public:
+			struct Stats
+			{
+				glm::uint issuedCalls = 0;
+				glm::uint skippedCalls = 0;
+			};
+
+			GLStateCache();
+
+			// Keeps the counts of the frame which just ended & forgets all state, since it may have been changed outside of the cache
+			void BeginFrame();
+			void Invalidate();
+
+			void UseProgram(GLuint program);
+			void BindVertexArray(GLuint VAO);
+			void BindArrayBuffer(GLuint VBO);
+			void SetCullingEnabled(GLboolean enabled);
+			void CullFace(GLenum mode);
+			void DepthFunc(GLenum func);
+			void DepthMask(GLboolean enabled);
+			// Only GL_TEXTURE_2D & GL_TEXTURE_CUBE_MAP bindings are cached, other targets are always bound
+			void BindTexture(glm::uint unit, GLenum target, GLuint texture);
+
+			const Stats& GetLastFrameStats() const;
+
+		private:
+			// Returns true when the call needs to be issued, and updates cachedValue
+			bool Changed(GLuint& cachedValue, GLuint newValue);
+
+			static const GLuint UNKNOWN = (GLuint)-1;
+			static const glm::uint MAX_CACHED_TEXTURE_UNITS = 32;
+
+			GLuint m_Program;
+			GLuint m_VAO;
+			GLuint m_ArrayBuffer;
+			GLuint m_CullingEnabled;
+			GLuint m_CullFace;
+			GLuint m_DepthFunc;
+			GLuint m_DepthMask;
+			GLuint m_ActiveTextureUnit;
+			GLuint m_Textures2D[MAX_CACHED_TEXTURE_UNITS];
+			GLuint m_TexturesCube[MAX_CACHED_TEXTURE_UNITS];
+
+			Stats m_FrameStats;
+			Stats m_LastFrameStats;
+		};
+	} // namespace gl
+} // namespace flex
+
+#endif // COMPILE_OPEN_GL
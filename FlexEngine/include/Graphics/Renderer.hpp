@@ -9,7 +9,10 @@
 #include <glm/vec4.hpp>
 #include <glm/mat4x4.hpp>
 
+#include "Bounds.hpp"
 #include "GameContext.hpp"
+#include "IBLBaker.hpp"
+#include "MeshOptimizer.hpp"
 #include "Typedefs.hpp"
 #include "VertexBufferData.hpp"
 #include "Transform.hpp"
@@ -71,7 +74,8 @@ namespace flex
 			INT,
 			UNSIGNED_INT,
 			FLOAT,
-			DOUBLE
+			DOUBLE,
+			HALF_FLOAT
 		};
 
 		enum class TopologyMode
@@ -142,6 +146,7 @@ namespace flex
 			bool enableIrradianceSampler;
 			bool generateIrradianceSampler;
 			glm::uvec2 generatedIrradianceCubemapSize;
+			bool generateIrradianceSH; // Project irradiance onto spherical harmonics instead of rendering it into a cubemap (generateIrradianceSampler must be true)
 			MaterialID irradianceSamplerMatID; // The id of the material who has an irradiance sampler object (generateIrradianceSampler must be false)
 			std::string environmentMapPath;
 
@@ -222,6 +227,7 @@ namespace flex
 			bool enableIrradianceSampler;
 			bool generateIrradianceSampler;
 			glm::uvec2 irradianceSamplerSize;
+			bool generateIrradianceSH;
 			std::string environmentMapPath;
 
 			bool enablePrefilteredMap;
@@ -246,6 +252,11 @@ namespace flex
 
 			VertexBufferData* vertexBufferData = nullptr;
 			std::vector<glm::uint>* indices = nullptr;
+			const MeshBounds* bounds = nullptr; // Of the vertices' positions, before being transformed. Copied, may be null if unknown
+
+			// Objects created with the same non-zero ID share vertex & index buffers. Unlike the addresses above, which
+			// may belong to other data once freed, IDs are never reused
+			glm::uint64 sharedDataID = 0;
 
 			std::string name;
 			Transform* transform;
@@ -292,6 +303,7 @@ namespace flex
 			bool needMetallicSampler;
 			bool needRoughnessSampler;
 			bool needAOSampler;
+			bool needORMSampler; // Occlusion, roughness & metallic packed into one texture, see TextureUsage::ORM
 			bool needHDREquirectangularSampler;
 			bool needIrradianceSampler;
 			bool needPrefilteredMap;
@@ -335,7 +347,18 @@ namespace flex
 			int stride, void* pointer) = 0;
 
 		virtual void SetSkyboxMaterial(MaterialID skyboxMaterialID) = 0;
+		// Environment maps which haven't been used for this many seconds are destroyed until they're next needed. 0 disables eviction
+		// Only the GL renderer creates environment maps on first use, others make them all up front & ignore this
+		virtual void SetEnvironmentMapEvictionDelay(float seconds);
 		virtual void SetRenderObjectMaterialID(RenderID renderID, MaterialID materialID) = 0;
+		virtual void SetRenderObjectIndexRange(RenderID renderID, glm::uint firstIndex, glm::uint indexCount) = 0; // Draws only this range of an indexed object's indices (used to select LODs)
+		// When set, only meshlets which pass frustum & normal cone culling are drawn instead of the index range. Pass nullptr to stop culling
+		// meshlets must remain valid until they're replaced or the render object is destroyed
+		virtual void SetRenderObjectMeshlets(RenderID renderID, const std::vector<Meshlet>* meshlets) = 0;
+		// Fills worldBounds with the object's bounds transformed by its current transform, returns false if it has none
+		virtual bool GetRenderObjectWorldBounds(RenderID renderID, MeshBounds& worldBounds) = 0;
+		// Returns true once the renderer has its own copy of the object's vertex & index data, after which the CPU side copy may be released
+		virtual bool IsRenderObjectUploaded(RenderID renderID) = 0;
 
 		virtual void Destroy(RenderID renderID) = 0;
 
@@ -348,6 +371,17 @@ namespace flex
 		std::vector<PointLight> m_PointLights;
 		DirectionalLight m_DirectionalLight;
 
+		// Fills visibleRanges with the index ranges of every meshlet which might be visible from cameraPosition, merging adjacent ones
+		// All tests happen in the object's local space so non-uniform scaling doesn't loosen the bounds
+		static void CullMeshlets(const glm::mat4& viewProjection, const glm::vec3& cameraPosition, const glm::mat4& model,
+			const std::vector<Meshlet>& meshlets, std::vector<MeshLOD>& visibleRanges);
+
+		// Recalculates worldBounds from localBounds if transform has changed since worldBoundsVersion was last updated
+		static void UpdateWorldBounds(Transform* transform, const MeshBounds& localBounds, MeshBounds& worldBounds, glm::uint& worldBoundsVersion);
+
+		// Sizes of the image based lighting maps a material generates from its environment map, used to find its baked copy
+		static IBLBakeSettings GetIBLBakeSettings(const Material& material, glm::uint prefilteredMipCount);
+
 		struct DrawCallInfo
 		{
 			bool renderToCubemap = false;
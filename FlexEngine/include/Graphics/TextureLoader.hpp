@@ -0,0 +1,58 @@
+#pragma once
+
+#include <array>
+#include <future>
+#include <memory>
+#include <string>
+
+#include "CookedTexture.hpp"
+
+namespace flex
+{
+	class ThreadPool;
+
+	// An 8-bit per channel image decoded from file, or its cooked block compressed copy when one exists
+	// Either is owned by whoever holds it until Free is called
+	struct DecodedImage
+	{
+		void Free();
+
+		std::string filePath;
+		int width = 0;
+		int height = 0;
+		int channels = 0; // Of pixels, always the count requested when decoding
+		unsigned char* pixels = nullptr; // Null if decoding failed or cooked is set
+		std::shared_ptr<CookedTexture> cooked; // Already holds every mip level
+	};
+
+	// Decodes the file with stb_image on the calling thread, channels must be between 1 and 4
+	// Safe to call from any thread: flipping is done here rather than through stb_image's global flag
+	// When usage isn't NONE the file's cooked copy is returned instead if it's up to date, otherwise
+	// the decoded pixels are cooked on cookThreadPool (if given) so that the next load can use them
+	DecodedImage DecodeImage(const std::string& filePath, int channels, bool flipVertically,
+		TextureUsage usage = TextureUsage::NONE, ThreadPool* cookThreadPool = nullptr);
+
+	// Decodes the file on threadPool, or immediately when threadPool is null
+	// Results must be freed by whoever gets them, even if they're no longer needed
+	std::future<DecodedImage> DecodeImageAsync(ThreadPool* threadPool, const std::string& filePath, int channels, bool flipVertically,
+		TextureUsage usage = TextureUsage::NONE);
+
+	// Red, green & blue source files of a packed texture, any of which may be empty
+	typedef std::array<std::string, 3> PackedTextureSources;
+
+	// Name a packed texture is known by, unique to its sources
+	std::string GetPackedTextureName(const PackedTextureSources& filePaths);
+
+	// Decodes each source as a single channel (greyscale) image into the matching channel of one three channel image, like DecodeImage
+	// Sources whose sizes differ from the largest are resampled to match it, channels without a source are left black
+	// The result's pixels are null if none of the sources could be decoded
+	DecodedImage DecodePackedImage(const PackedTextureSources& filePaths, bool flipVertically,
+		TextureUsage usage = TextureUsage::NONE, ThreadPool* cookThreadPool = nullptr);
+
+	std::future<DecodedImage> DecodePackedImageAsync(ThreadPool* threadPool, const PackedTextureSources& filePaths, bool flipVertically,
+		TextureUsage usage = TextureUsage::NONE);
+
+	// Cooks the file on threadPool unless an up to date cooked copy already exists
+	// For textures which are loaded by other means, such as HDR images
+	void CookTextureAsync(ThreadPool* threadPool, const std::string& filePath, TextureUsage usage, bool flipVertically);
+} // namespace flex
@@ -8,6 +8,7 @@
 #include <vulkan/vulkan.h>
 
 #include "Graphics/Renderer.hpp"
+#include "TextureCompression.hpp"
 #include "VulkanBuffer.hpp"
 #include "VertexBufferData.hpp"
 #include "VDeleter.hpp"
@@ -32,10 +33,11 @@ namespace flex
 	}
 #endif // VK_CHECK_RESULT
 
-		VkVertexInputBindingDescription GetVertexBindingDescription(glm::uint vertexStride);
+		VkVertexInputBindingDescription GetVertexBindingDescription(glm::uint vertexStride, uint32_t binding = 0);
 
+		// When separatePositions is true positions are read from binding 0 and all other attributes from binding 1
 		void GetVertexAttributeDescriptions(VertexAttributes vertexAttributes,
-			std::vector<VkVertexInputAttributeDescription>& attributeDescriptions);
+			std::vector<VkVertexInputAttributeDescription>& attributeDescriptions, bool separatePositions = false);
 
 		// Framebuffer for offscreen rendering
 		struct FrameBufferAttachment
@@ -100,6 +102,7 @@ namespace flex
 			VulkanBuffer* indexBuffer = nullptr;
 			glm::uint vertexCount;
 			glm::uint indexCount;
+			VkIndexType indexType = VK_INDEX_TYPE_UINT32; // VK_INDEX_TYPE_UINT16 when every indexed object's vertices fit in 16 bits
 			bool useStagingBuffer = true; // Set to false for vertex buffers that need to be updated very frequently (eg. ImGui vertex buffer)
 		};
 
@@ -215,11 +218,27 @@ namespace flex
 			glm::uint IBO;
 
 			VertexBufferData* vertexBufferData = nullptr;
+			glm::uint vertexCount = 0; // Copied on creation, vertexBufferData's data may be released once uploaded
 			glm::uint vertexOffset = 0;
+			VkDeviceSize vertexBufferOffset = 0; // Offset in bytes of this object's data in its shader's vertex buffer
 
 			bool indexed = false;
 			std::vector<glm::uint>* indices = nullptr;
 			glm::uint indexOffset = 0;
+			glm::uint totalIndexCount = 0; // Copied on creation, indices may be released once uploaded
+			bool uploaded = false; // Whether this object's data has been copied into its shader's static buffers
+			glm::uint firstIndex = 0; // Range of indices which is drawn, relative to indexOffset (see SetRenderObjectIndexRange)
+			glm::uint indexCount = 0;
+
+			const std::vector<Meshlet>* meshlets = nullptr; // When set, visibleIndexRanges are drawn instead of the index range above
+			std::vector<MeshLOD> visibleIndexRanges; // Relative to indexOffset, refreshed every frame by CullRenderObjectMeshlets
+			glm::uint firstIndirectCommand = 0; // visibleIndexRanges' commands in VulkanRenderer's indirect draw buffer
+			glm::uint indirectCommandCount = 0;
+
+			bool hasBounds = false;
+			MeshBounds localBounds; // Of the vertices' positions, before being transformed
+			MeshBounds worldBounds; // Only valid once UpdateWorldBounds has been called, see GetRenderObjectWorldBounds
+			glm::uint worldBoundsVersion = 0; // Version of transform worldBounds was last calculated with
 
 			VkDescriptorSet descriptorSet;
 
@@ -234,6 +253,7 @@ namespace flex
 		{
 			ShaderID shaderID;
 			VertexAttributes vertexAttributes;
+			bool separatePositionStream = false;
 
 			VkPrimitiveTopology topology;
 			VkCullModeFlags cullMode;
@@ -293,6 +313,7 @@ namespace flex
 
 		VkPrimitiveTopology TopologyModeToVkPrimitiveTopology(Renderer::TopologyMode mode);
 		VkCullModeFlagBits CullFaceToVkCullMode(Renderer::CullFace cullFace);
+		VkFormat BlockCompressionFormatToVkFormat(BlockCompressionFormat format);
 
 		VkResult CreateDebugReportCallbackEXT(VkInstance instance, const VkDebugReportCallbackCreateInfoEXT* pCreateInfo,
 			const VkAllocationCallbacks* pAllocator, VkDebugReportCallbackEXT* pCallback);
@@ -2,11 +2,13 @@
 #if COMPILE_VULKAN
 
 #include <array>
+#include <future>
 #include <map>
 
 #include <imgui.h>
 
 #include "Graphics/Renderer.hpp"
+#include "Graphics/TextureLoader.hpp"
 #include "Graphics/Vulkan/VulkanHelpers.hpp"
 #include "VDeleter.hpp"
 #include "VulkanBuffer.hpp"
@@ -59,6 +61,10 @@ namespace flex
 			
 			virtual void SetSkyboxMaterial(MaterialID skyboxMaterialID) override;
 			virtual void SetRenderObjectMaterialID(RenderID renderID, MaterialID materialID) override;
+			virtual void SetRenderObjectIndexRange(RenderID renderID, glm::uint firstIndex, glm::uint indexCount) override;
+			virtual void SetRenderObjectMeshlets(RenderID renderID, const std::vector<Meshlet>* meshlets) override;
+			virtual bool GetRenderObjectWorldBounds(RenderID renderID, MeshBounds& worldBounds) override;
+			virtual bool IsRenderObjectUploaded(RenderID renderID) override;
 
 			virtual void Destroy(RenderID renderID) override;
 
@@ -104,6 +110,10 @@ namespace flex
 			void GenerateIrradianceSampler(const GameContext& gameContext, VulkanRenderObject* renderObject);
 			void GeneratePrefilteredCube(const GameContext& gameContext, VulkanRenderObject* renderObject);
 			void GenerateBRDFLUT(const GameContext& gameContext, VulkanTexture* brdfTexture);
+			// Creates m_BRDFTexture if it doesn't exist yet, from its baked copy when there is one
+			void CreateBRDFLUT(const GameContext& gameContext);
+			// Uploads the object's cubemap, irradiance & prefiltered maps from their baked copies, returns false if they haven't been baked yet
+			bool LoadBakedEnvironment(VulkanRenderObject* renderObject, glm::uint64 sourceHash);
 
 			RenderID GetFirstAvailableRenderID() const;
 			void InsertNewRenderObject(VulkanRenderObject* renderObject);
@@ -131,9 +141,13 @@ namespace flex
 
 			void CreateVulkanCubemap_Empty(glm::uint width, glm::uint height, glm::uint channels, glm::uint mipLevels, bool enableTrilinearFiltering, VkFormat format, VulkanTexture** texture) const;
 			// Expects *texture == nullptr
-			void CreateVulkanCubemap(const std::array<std::string, 6>& filePaths, VkFormat format, VulkanTexture** texture, bool generateMipMaps) const;
+			void CreateVulkanCubemap(const std::array<std::string, 6>& filePaths, VkFormat format, VulkanTexture** texture, bool generateMipMaps, ThreadPool* threadPool = nullptr) const;
 
 			void CreateTextureImage(const std::string& filePath, VkFormat format, glm::uint mipLevels, VulkanTexture** texture) const;
+
+			// Waits for every texture queued by InitializeMaterial to finish decoding, then creates & uploads them all
+			// through one staging buffer, submitting the copies in as few command buffers as fit in TEXTURE_STAGING_BUFFER_SIZE
+			void FinishPendingTextureUploads();
 			void CreateTextureImage_Empty(glm::uint width, glm::uint height, VkFormat format, glm::uint mipLevels, VulkanTexture** texture) const;
 			void CreateTextureImage_HDR(const std::string& filePath, VkFormat format, glm::uint mipLevels, VulkanTexture** texture) const;
 			void CreateTextureImageView(VulkanTexture* texture, VkFormat format) const;
@@ -148,6 +162,18 @@ namespace flex
 			// Creates vertex buffers for all render objects
 			void CreateStaticVertexBuffers();
 
+			// Binds the vertex stream(s) renderObject reads from, returns the vertex offset its draws must use
+			glm::uint BindVertexBuffers(VkCommandBuffer commandBuffer, VulkanRenderObject* renderObject);
+
+			// Finds which meshlets of each render object that has them can be seen from the camera this frame
+			// and writes an indirect draw command for each visible run of them into m_IndirectDrawBuffer
+			void CullRenderObjectMeshlets(const GameContext& gameContext);
+			// Copies m_IndirectDrawCommands into m_IndirectDrawBuffer, growing it first when needed
+			void UploadIndirectDrawCommands();
+
+			// Records renderObject's indexed draw(s): its visible meshlets through one indirect draw when it has any, otherwise its index range
+			void DrawIndexed(VkCommandBuffer commandBuffer, VulkanRenderObject* renderObject, glm::uint vertexOffset);
+
 			// Creates vertex buffer for all render objects' verts which use specified shader index
 			// Returns vertex count
 			glm::uint CreateStaticVertexBuffer(VulkanBuffer* vertexBuffer, ShaderID shaderID, int size);
@@ -157,9 +183,9 @@ namespace flex
 			void CreateStaticIndexBuffers();
 
 			// Creates index buffer for all render objects' indices which use specified shader index
-			// Returns index count
-			glm::uint CreateStaticIndexBuffer(VulkanBuffer* indexBuffer, ShaderID shaderID);
-			void VulkanRenderer::CreateStaticIndexBuffer(VulkanBuffer* indexBuffer, const std::vector<glm::uint>& indices);
+			// Returns index count, outIndexType is set to the smallest index type able to address every object's vertices
+			glm::uint CreateStaticIndexBuffer(VulkanBuffer* indexBuffer, ShaderID shaderID, VkIndexType* outIndexType);
+			void CreateStaticIndexBuffer(VulkanBuffer* indexBuffer, const void* indexData, size_t bufferSize);
 
 			void CreateDescriptorPool();
 			glm::uint AllocateUniformBuffer(glm::uint dynamicDataSize, void** data);
@@ -209,6 +235,10 @@ namespace flex
 			void UpdateConstantUniformBuffers(const GameContext& gameContext, UniformOverrides const* overridenUniforms = nullptr);
 			void UpdateConstantUniformBuffer(const GameContext& gameContext, UniformOverrides const* overridenUniforms, size_t bufferIndex);
 			void UpdateDynamicUniformBuffer(const GameContext& gameContext, RenderID renderID, UniformOverrides const * overridenUniforms = nullptr);
+			// Calculates every render object's model matrices at once, before their dynamic uniforms are written
+			void UpdateObjectMatrices();
+			// Makes every object's dynamic uniforms visible to the device, once they've all been written
+			void FlushDynamicUniformBuffers();
 
 			void LoadDefaultShaderCode();
 			void GenerateSkybox(const GameContext& gameContext);
@@ -222,6 +252,14 @@ namespace flex
 			std::vector<VulkanRenderObject*> m_RenderObjects;
 			std::vector<VulkanMaterial> m_LoadedMaterials;
 
+			struct ObjectMatrices
+			{
+				glm::mat4 model;
+				glm::mat4 modelInvTranspose;
+			};
+			std::vector<ObjectMatrices> m_ObjectMatrices; // Indexed by RenderID, refreshed by UpdateObjectMatrices
+			static const glm::uint MIN_OBJECT_MATRICES_PER_THREAD = 1024; // Fewer objects than this are handled on the calling thread alone
+
 			glm::vec2i m_BRDFSize;
 			VulkanTexture* m_BRDFTexture = nullptr;
 
@@ -276,6 +314,21 @@ namespace flex
 
 			std::vector<VulkanTexture*> m_LoadedTextures;
 
+			// A texture in m_LoadedTextures whose image is still being decoded on a worker thread
+			struct PendingTextureUpload
+			{
+				VulkanTexture* texture;
+				VkFormat format;
+				std::future<DecodedImage> image;
+			};
+			std::vector<PendingTextureUpload> m_PendingTextureUploads;
+
+			// Images larger than this get a staging buffer of their own size
+			static const VkDeviceSize TEXTURE_STAGING_BUFFER_SIZE = 32 * 1024 * 1024;
+
+			// Set once descriptor sets have been created, textures for materials initialized after that are uploaded immediately
+			bool m_PostInitialized = false;
+
 			VulkanTexture* m_BlankTexture = nullptr;
 
 			// TODO: Use FrameBufferAttachment
@@ -286,6 +339,10 @@ namespace flex
 
 			std::vector<VertexIndexBufferPair> m_VertexIndexBufferPairs;
 
+			// Rewritten every frame before command buffers are built, frames don't overlap so nothing can still be reading it
+			std::vector<VkDrawIndexedIndirectCommand> m_IndirectDrawCommands;
+			VulkanBuffer* m_IndirectDrawBuffer = nullptr; // Host visible & coherent, kept mapped
+
 			glm::uint m_DynamicAlignment = 0;
 
 			VDeleter<VkSemaphore> m_PresentCompleteSemaphore;
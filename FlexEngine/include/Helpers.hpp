@@ -1,5 +1,6 @@
 #pragma once
 
+#include <functional>
 #include <string>
 #include <vector>
 
@@ -18,6 +19,9 @@ namespace flex
 	GLFWimage LoadGLFWimage(const std::string& filePath, bool alpha = false, bool flipVertically = false);
 	void DestroyGLFWimage(GLFWimage& image);
 
+	// Reverses the order of an image's rows in place. Used instead of stb_image's flip flag, which is shared by every thread
+	void FlipImageVertically(void* pixels, int width, int height, int bytesPerPixel);
+
 	struct HDRImage
 	{
 		bool Load(const std::string& hdrFilePath, bool flipVertically);
@@ -36,6 +40,11 @@ namespace flex
 	// Removes all content before the final '/' or '\' 
 	void StripLeadingDirectories(std::string& filePath);
 
+	// Calls function with consecutive ranges of [0, count) spread across as many threads as are useful, and waits for them all
+	// Runs on a thread pool of its own rather than GameContext's, so it's safe to call from inside that pool's jobs. The calling
+	// thread works through ranges too, so it never waits on ranges no thread has started
+	void ParallelFor(glm::uint count, glm::uint minCountPerThread, const std::function<void(glm::uint begin, glm::uint end)>& function);
+
 	float Lerp(float a, float b, float t);
 	glm::vec2 Lerp(const glm::vec2& a, const glm::vec2& b, float t);
 	glm::vec3 Lerp(const glm::vec3& a, const glm::vec3& b, float t);
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <string>
+
+#include <glm/integer.hpp>
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+
+#include "CookedMesh.hpp" // For MappedFile
+
+namespace flex
+{
+	class ThreadPool;
+
+	struct IBLBakeSettings
+	{
+		glm::uint cubemapSize;
+		glm::uint irradianceSize;
+		glm::uint prefilteredSize;
+		glm::uint prefilteredMipCount; // Mip i is prefiltered for a roughness of i / (prefilteredMipCount - 1)
+	};
+
+	// Irradiance projected onto the first nine spherical harmonics (L2), already convolved with the cosine lobe
+	// Evaluating it in a direction gives what an irradiance cubemap would hold there, without the texture
+	struct IrradianceSH9
+	{
+		glm::vec3 coefficients[9];
+	};
+
+	// faces are the six RGBA float faces of a cubemap in GL order, projected across several threads
+	void ProjectIrradianceSH9(const float* const faces[6], glm::uint size, IrradianceSH9& irradianceSH);
+	glm::vec3 EvaluateIrradianceSH9(const IrradianceSH9& irradianceSH, const glm::vec3& normal);
+
+	// Image based lighting maps baked on the CPU from an equirectangular HDR image, in place of rendering them on every launch
+	// Baked maps are cached on disk, keyed by the contents of the HDR image & the settings they were baked with
+	// Every map is a cubemap with faces in GL order (+X, -X, +Y, -Y, +Z, -Z) whose texels are RGBA half floats
+	class BakedEnvironment
+	{
+	public:
+		enum class Map
+		{
+			CUBEMAP, // Full mip chain
+			IRRADIANCE, // Full mip chain
+			PREFILTERED, // prefilteredMipCount levels
+			NONE
+		};
+
+		BakedEnvironment();
+		~BakedEnvironment();
+
+		// Hashes the HDR image's contents, which identify its cache file. Remembered per path until the file's modification time
+		// or size change, so large images are only read once. Returns false if the file doesn't exist
+		static bool HashSource(const std::string& hdrFilePath, glm::uint64& outSourceHash);
+
+		// Bakes every map & writes them to the cache, returns false if the HDR image couldn't be loaded
+		static bool Bake(const std::string& hdrFilePath, glm::uint64 sourceHash, const IBLBakeSettings& settings);
+
+		// Bakes on threadPool unless an up to date cache file already exists or is already being baked
+		static void BakeAsync(ThreadPool* threadPool, const std::string& hdrFilePath, glm::uint64 sourceHash, const IBLBakeSettings& settings);
+
+		// Maps the cache file for the HDR image into memory, returns false if it hasn't been baked with these settings yet
+		bool Load(const std::string& hdrFilePath, glm::uint64 sourceHash, const IBLBakeSettings& settings);
+		void Unload();
+		bool IsLoaded() const;
+
+		glm::uint GetMipCount(Map map) const;
+		glm::uint GetMipSize(Map map, glm::uint mipLevel) const; // Faces are square
+		// Only valid while loaded
+		void GetIrradianceSH(IrradianceSH9& irradianceSH) const;
+		const void* GetFaceData(Map map, glm::uint mipLevel, glm::uint face) const;
+		size_t GetFaceDataSize(Map map, glm::uint mipLevel) const;
+
+	private:
+		struct Header
+		{
+			glm::uint magic;
+			glm::uint version;
+			glm::uint64 sourceHash;
+			glm::uint cubemapSize;
+			glm::uint irradianceSize;
+			glm::uint prefilteredSize;
+			glm::uint prefilteredMipCount;
+			float irradianceSH[9 * 3];
+		};
+
+		static std::string GetCacheFilePath(const std::string& hdrFilePath, glm::uint64 sourceHash, const IBLBakeSettings& settings);
+		size_t GetMapOffset(Map map) const;
+		size_t GetMapSize(Map map) const;
+
+		static const glm::uint MAGIC; // "FIBL"
+		static const glm::uint VERSION;
+
+		MappedFile m_File;
+		const Header* m_Header = nullptr;
+
+		BakedEnvironment(const BakedEnvironment&) = delete;
+		BakedEnvironment& operator=(const BakedEnvironment&) = delete;
+	};
+
+	// Split sum environment BRDF, scale & bias as RG half floats. U is N.V and V is roughness
+	// Doesn't depend on any source image so only a single copy per size is ever baked
+	class BakedBRDFLUT
+	{
+	public:
+		BakedBRDFLUT();
+		~BakedBRDFLUT();
+
+		static bool Bake(const glm::uvec2& size);
+		static void BakeAsync(ThreadPool* threadPool, const glm::uvec2& size);
+
+		bool Load(const glm::uvec2& size);
+		void Unload();
+		bool IsLoaded() const;
+
+		// Only valid while loaded
+		const void* GetData() const;
+
+	private:
+		struct Header
+		{
+			glm::uint magic;
+			glm::uint version;
+			glm::uint width;
+			glm::uint height;
+		};
+
+		static std::string GetCacheFilePath(const glm::uvec2& size);
+
+		static const glm::uint MAGIC; // "FBRD"
+		static const glm::uint VERSION;
+
+		MappedFile m_File;
+		const Header* m_Header = nullptr;
+
+		BakedBRDFLUT(const BakedBRDFLUT&) = delete;
+		BakedBRDFLUT& operator=(const BakedBRDFLUT&) = delete;
+	};
+} // namespace flex
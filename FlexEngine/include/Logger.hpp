@@ -1,5 +1,6 @@
 #pragma once
 
+#include <mutex>
 #include <string>
 
 namespace flex
@@ -49,6 +50,9 @@ namespace flex
 		static int m_SuppressedWarningCount;
 		static int m_SuppressedErrorCount;
 
+		// Messages may be logged from worker threads
+		static std::mutex m_Mutex;
+
 #ifdef _WIN32
 		static HANDLE m_ConsoleHandle;
 		static const WORD CONSOLE_COLOR_INFO = 0 | FOREGROUND_INTENSITY;
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <vector>
+
+#include <glm/integer.hpp>
+#include <glm/vec3.hpp>
+
+namespace flex
+{
+	// A contiguous range of a mesh's index buffer which draws one level of detail
+	struct MeshLOD
+	{
+		glm::uint firstIndex;
+		glm::uint indexCount;
+	};
+
+	// A small cluster of triangles stored contiguously in a mesh's index buffer, with the data needed to cull it as a whole
+	struct Meshlet
+	{
+		glm::uint firstIndex;
+		glm::uint indexCount;
+
+		glm::vec3 center; // Bounding sphere
+		float radius;
+
+		// Every triangle faces away from any viewer for which dot(normalize(coneApex - viewer), coneAxis) >= coneCutoff
+		// Clusters whose normals are spread too widely to ever be back-face culled have a cutoff of 1 & an axis of zero
+		glm::vec3 coneApex;
+		glm::vec3 coneAxis;
+		float coneCutoff;
+	};
+
+	// Post-transform vertex cache statistics for an indexed triangle list
+	struct VertexCacheStatistics
+	{
+		float ACMR; // Average cache miss ratio: vertex shader invocations per triangle (0.5 is ideal for large regular meshes, 3.0 is worst case)
+		float ATVR; // Average transform to vertex ratio: vertex shader invocations per referenced vertex (1.0 is ideal)
+	};
+
+	// Simulates a FIFO post-transform cache of the given size
+	VertexCacheStatistics AnalyzeVertexCache(const std::vector<glm::uint>& indices, glm::uint vertexCount, glm::uint cacheSize = 16);
+
+	// Reorders triangles to improve post-transform vertex cache hit rate (Tom Forsyth's linear-speed vertex cache optimization)
+	void OptimizeVertexCache(std::vector<glm::uint>& indices, glm::uint vertexCount);
+
+	// Reorders clusters of cache-optimized triangles so outward facing ones are drawn first, reducing overdraw while keeping most of
+	// the cache locality (based on Sander et al. - "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw")
+	// positions must point at the first position of an interleaved vertex buffer with the given stride (in bytes)
+	void OptimizeOverdraw(std::vector<glm::uint>& indices, const void* positions, glm::uint vertexCount, glm::uint vertexStride);
+
+	// Reorders vertices into the order they're first referenced by indices so vertex fetches are as linear as possible
+	// Unreferenced vertices are removed. Indices are remapped in place, returns the new vertex count
+	glm::uint OptimizeVertexFetch(std::vector<glm::uint>& indices, void* vertexData, glm::uint vertexCount, glm::uint vertexStride);
+
+	// Reorders triangles into clusters of at most maxVertices unique vertices & maxTriangles triangles, grown across shared vertices so
+	// each is as spatially compact as possible, and fills out meshlets with their index ranges & culling bounds
+	void BuildMeshlets(std::vector<glm::uint>& indices, const void* positions, glm::uint vertexCount, glm::uint vertexStride,
+		std::vector<Meshlet>& meshlets, glm::uint maxVertices = 64, glm::uint maxTriangles = 124);
+
+	// Writes a simplified copy of indices with at most targetIndexCount indices (if reachable) into result by collapsing edges onto existing
+	// vertices in order of quadric error (Garland & Heckbert - "Surface Simplification Using Quadric Error Metrics"), so no vertex data changes
+	// Vertices on open borders or attribute seams (several vertices sharing a position) never move, keeping silhouettes & UV seams intact
+	// Collapses with an error above maxError (in position units) are never made. Returns the largest error of any collapse made
+	float SimplifyMesh(const std::vector<glm::uint>& indices, const void* positions, glm::uint vertexCount, glm::uint vertexStride,
+		size_t targetIndexCount, float maxError, std::vector<glm::uint>& result);
+} // namespace flex
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <vector>
+
+#include <glm/integer.hpp>
+
+namespace flex
+{
+	enum class MipFilter
+	{
+		BOX, // Averages each 2x2 square, cheap but blurs & aliases slightly
+		KAISER, // Kaiser windowed sinc, keeps more detail in lower mips
+		NONE
+	};
+
+	struct MipGenerationSettings
+	{
+		MipFilter filter = MipFilter::KAISER;
+		bool sRGB = false; // 8 bit RGB channels are decoded to linear before filtering & encoded again afterwards
+		bool normalMap = false; // RGB holds a unit vector which is renormalized in every level
+	};
+
+	// Number of levels in a full mip chain for the given size, down to and including 1x1
+	glm::uint CalculateMipCount(glm::uint width, glm::uint height);
+
+	// Fills levels with every level of the mip chain of a 4 channel image, starting with a copy of pixels itself
+	// Each level is filtered from the one above it in linear space, large levels are split across several threads
+	void GenerateMipChain(const unsigned char* pixels, glm::uint width, glm::uint height, const MipGenerationSettings& settings,
+		std::vector<std::vector<unsigned char>>& levels);
+	void GenerateMipChain(const float* pixels, glm::uint width, glm::uint height, const MipGenerationSettings& settings,
+		std::vector<std::vector<float>>& levels);
+} // namespace flex
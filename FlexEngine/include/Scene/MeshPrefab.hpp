@@ -2,6 +2,11 @@
 
 #include "Scene/GameObject.hpp"
 
+#include <atomic>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <vector>
 
 #include <glm/integer.hpp>
@@ -12,6 +17,9 @@
 #include <assimp/scene.h>
 #include <assimp/Importer.hpp>
 
+#include "Bounds.hpp"
+#include "CookedMesh.hpp"
+#include "MeshOptimizer.hpp"
 #include "Typedefs.hpp"
 #include "VertexAttribute.hpp"
 #include "VertexBufferData.hpp"
@@ -34,12 +42,48 @@ namespace flex
 			SKYBOX
 		};
 
+		// What happens to a mesh's CPU side vertex & index data once every renderer using it has its own copy
+		enum class Residency
+		{
+			KEEP_CPU_COPY, // Always kept, for meshes whose geometry is read on the CPU
+			RELEASE_AFTER_UPLOAD, // Freed along with the cooked file mapping, reloaded from disk if needed again
+			COLD_CACHE // Freed, but the cooked file stays mapped so the OS can page it back in cheaply when needed again
+		};
+
 		void ForceAttributes(VertexAttributes attributes); // Call this before loading to force certain attributes to be filled
 		void IgnoreAttributes(VertexAttributes attributes); // Call this before loading to ignore certain attributes
+		void EnableOverdrawOptimization(bool enabled); // Call this before loading to sort triangle clusters front-to-back (slightly worse vertex cache use)
+		void EnableAttributeCompression(bool enabled); // Call this before loading to store UVs as half floats & normals, tangents & bitangents as a tangent frame quaternion (use with "pbr_compressed"). Meshes without all three are left uncompressed
+		void EnableSeparatePositionStream(bool enabled); // Call this before loading to store positions in their own vertex stream, ahead of all other attributes
+		void EnableMeshlets(bool enabled); // Call this before loading to split the most detailed LOD into meshlets which are frustum & back-face culled individually
+		void SetResidency(Residency residency); // Call this before loading. Only meshes with a cooked copy on disk are ever released
+
+		// Call this before loading to generate up to lodCount levels of detail (including the original mesh), each with roughly reductionPerLOD
+		// times the triangles of the previous one. No collapse moves the surface further than maxErrorFraction of the mesh's bounds diagonal
+		void SetLODs(glm::uint lodCount, float reductionPerLOD = 0.5f, float maxErrorFraction = 0.01f);
+		// screenSizes[i] is the fraction of the screen's height the mesh's bounding sphere must cover for LOD i to be drawn instead of LOD i + 1
+		// Any LODs without a screen size fall back to a default based on the reduction per LOD
+		void SetLODScreenSizes(const std::vector<float>& screenSizes);
+		// Relative amount the screen size must pass a threshold by before switching LOD, stops meshes sitting on a boundary from flickering between them
+		void SetLODHysteresis(float hysteresis);
+		glm::uint GetCurrentLOD() const;
 
 		bool LoadFromFile(const GameContext& gameContext, const std::string& filepath, bool flipNormalYZ = false, bool flipZ = false, bool flipU = false, bool flipV = false);
+
+		// Imports the file on gameContext.threadPool, the render object is then created on the main thread by FinishPendingLoads
+		// The returned future is only fulfilled by FinishPendingLoads, so never block on it from the main thread
+		std::shared_future<bool> LoadFromFileAsync(const GameContext& gameContext, const std::string& filepath, bool flipNormalYZ = false, bool flipZ = false, bool flipU = false, bool flipV = false);
+
+		// Creates render objects for every async load whose data is ready (or for all of them when waitForAll is true)
+		// Must be called from the main thread
+		static void FinishPendingLoads(const GameContext& gameContext, bool waitForAll);
+
 		bool LoadPrefabShape(const GameContext& gameContext, PrefabShape shape);
 
+		// Imported scenes are kept around so other prefabs using the same file don't re-import it,
+		// the least recently used ones are freed once they take up more than this many bytes (estimated)
+		static void SetImportedSceneCacheBudget(size_t bytes);
+
 		virtual void Initialize(const GameContext& gameContext) override;
 		virtual void PostInitialize(const GameContext& gameContext) override;
 		virtual void Update(const GameContext& gameContext) override;
@@ -52,10 +96,117 @@ namespace flex
 		struct LoadedMesh
 		{
 			Assimp::Importer importer;
-			const aiScene* scene;
+			const aiScene* scene = nullptr;
+			bool attemptedLoad = false;
+			size_t size = 0; // Estimated bytes used by scene, guarded by m_LoadedMeshesMutex
+			glm::uint64 lastUse = 0; // Guarded by m_LoadedMeshesMutex
+			std::mutex mutex; // Held while importing so concurrent requests for the same file only import it once
 		};
-		static bool GetLoadedMesh(const std::string& filePath, const aiScene** scene);
-		static std::map<std::string, LoadedMesh> m_LoadedMeshes;
+		// Imports the file the first time it is requested, returns nullptr on failure. Safe to call from any thread
+		// The scene stays valid for as long as the returned pointer is held, even if it has since been evicted from the cache
+		static std::shared_ptr<const aiScene> GetLoadedScene(const std::string& filePath);
+		// Frees least recently used scenes until the cache fits its budget, never evicting keep. Expects m_LoadedMeshesMutex to be held
+		static void EvictLoadedScenes(const LoadedMesh* keep);
+		static std::map<std::string, std::shared_ptr<LoadedMesh>> m_LoadedMeshes;
+		static std::mutex m_LoadedMeshesMutex;
+		static size_t m_LoadedMeshesSize;
+		static size_t m_LoadedMeshesBudget;
+		static glm::uint64 m_LoadedMeshesUseCount;
+
+		// Vertex & index data, shared by every mesh prefab loaded from the same file with the same import settings
+		// Renderers share GPU buffers between render objects created from the same data, so instances only own per-object state
+		struct MeshData
+		{
+			MeshData();
+			~MeshData(); // Erases its m_SharedMeshData entry when nothing else is waiting on it
+
+			const glm::uint64 id; // Passed to renderers as RenderObjectCreateInfo::sharedDataID
+			std::string sharedKey; // Into m_SharedMeshData, empty when not shared
+
+			VertexBufferData vertexBufferData;
+			std::vector<glm::uint> indices;
+			std::vector<MeshLOD> lods; // Index ranges into indices, from most to least detailed
+			std::vector<Meshlet> meshlets; // Cover the first LOD, whose triangles are stored in meshlet order
+
+			MeshBounds bounds = {}; // Of the vertices' positions, in model space
+
+			// Keeps the mapped cooked file alive for as long as vertexBufferData points into it
+			CookedMesh cookedMesh;
+
+			Residency residency = Residency::KEEP_CPU_COPY;
+			CookedMesh::Key cookedMeshKey = {};
+			bool hasCookedCopy = false; // Whether vertexBufferData & indices can be restored from disk after being released
+			// Render objects created from this data which the renderer hasn't copied yet (it may do so long after creation)
+			// vertexBufferData & indices are only released once this is zero. Only used on the main thread
+			glm::uint pendingUploadCount = 0;
+		};
+		struct SharedMeshData
+		{
+			std::weak_ptr<MeshData> meshData; // Expires once the last prefab using it is destroyed
+			std::mutex mutex; // Held while loading so concurrent requests for the same data only load it once
+			glm::uint requestCount = 0; // LoadMeshData calls using this entry, which keep it from being erased. Guarded by m_SharedMeshDataMutex
+		};
+		static std::map<std::string, SharedMeshData> m_SharedMeshData;
+		static std::mutex m_SharedMeshDataMutex;
+		static std::atomic<glm::uint64> m_NextMeshDataID;
+
+		// Every setting which affects the loaded vertex & index data, copied when a load starts
+		// so workers never read members which the main thread may change while they run
+		struct ImportSettings
+		{
+			std::string name; // Of the prefab, only used for logging
+			bool flipNormalYZ;
+			bool flipZ;
+			bool flipU;
+			bool flipV;
+			VertexAttributes forcedAttributes;
+			VertexAttributes ignoredAttributes;
+			bool optimizeOverdraw;
+			bool compressAttributes;
+			bool separatePositionStream;
+			bool buildMeshlets;
+			Residency residency;
+			glm::vec2 uvScale;
+			glm::uint lodCount;
+			float lodReduction;
+			float lodMaxErrorFraction;
+		};
+		ImportSettings GetImportSettings(bool flipNormalYZ, bool flipZ, bool flipU, bool flipV) const;
+
+		// Points m_MeshData at data already loaded by another prefab using the same file & settings, or loads it with LoadUniqueMeshData
+		// Doesn't touch the renderer
+		bool LoadMeshData(const std::string& filepath, const CookedMesh::Key& cookedMeshKey, bool sourceFileExists, const ImportSettings& settings);
+		// Fills m_MeshData from a cooked mesh, or by importing the source file
+		bool LoadUniqueMeshData(const std::string& filepath, const CookedMesh::Key& cookedMeshKey, bool sourceFileExists, const ImportSettings& settings);
+		void CreateRenderObject(const GameContext& gameContext);
+
+		// Restores vertex & index data released by ReleaseCPUData, returns false if it couldn't be
+		bool MakeResident();
+		// Frees vertex & index data according to the mesh's residency, unless a render object created from it hasn't been uploaded yet
+		void ReleaseCPUData();
+		// Stops counting this prefab's render object as waiting for an upload, releasing the data if nothing else is waiting
+		void FinishUpload();
+
+		// Fills m_MeshData from the source file using Assimp
+		bool ImportMesh(const std::string& filepath, const ImportSettings& settings);
+
+		// Fills m_MeshData->bounds from the vertex data's positions, leaving them empty if there are none
+		void CalculateBounds();
+
+		// Reorders imported triangles & vertices for the post-transform cache, vertex fetch and optionally overdraw
+		void OptimizeMesh(const std::string& filepath, const ImportSettings& settings);
+
+		// Appends simplified copies of the first LOD's indices for every other LOD, filling out m_MeshData->lods
+		void GenerateLODs(const std::string& filepath, const ImportSettings& settings);
+
+		// Picks the LOD to draw based on the size of the mesh's bounds on screen
+		void SelectLOD(const GameContext& gameContext);
+		float GetLODScreenSize(glm::uint lod) const;
+
+		// Returns a hash of every setting which affects the imported vertex data (used to key cooked meshes)
+		static glm::uint CalculateImportFlags(const ImportSettings& settings);
+
+		static const glm::uint m_ImportPostProcessFlags;
 
 		bool m_Initialized = false;
 
@@ -68,9 +219,27 @@ namespace flex
 
 		VertexAttributes m_ForcedAttributes = (glm::uint)VertexAttribute::NONE;
 		VertexAttributes m_IgnoredAttributes = (glm::uint)VertexAttribute::NONE;
-		VertexBufferData m_VertexBufferData;
-
-		std::vector<glm::uint> m_Indices;
+		bool m_OptimizeOverdraw = false;
+		bool m_CompressAttributes = false;
+		bool m_SeparatePositionStream = false;
+		bool m_BuildMeshlets = false;
+		Residency m_Residency = Residency::KEEP_CPU_COPY;
+		bool m_UploadPending = false; // Whether this prefab's render object is counted in m_MeshData->pendingUploadCount
+
+		std::shared_ptr<MeshData> m_MeshData;
+
+		glm::uint m_LODCount = 1;
+		float m_LODReduction = 0.5f;
+		float m_LODMaxErrorFraction = 0.01f;
+		std::vector<float> m_LODScreenSizes;
+		float m_LODHysteresis = 0.1f;
+		glm::uint m_CurrentLOD = 0;
+
+		// Async loading (see LoadFromFileAsync)
+		std::future<bool> m_PendingLoadData; // Ready once a worker has filled in the vertex & index data
+		std::promise<bool> m_LoadPromise; // Fulfilled once the render object has been created
+		bool m_PostInitializeRequested = false;
+		static std::vector<MeshPrefab*> m_PendingLoads;
 
 		static glm::vec4 m_DefaultColor_4;
 		static glm::vec3 m_DefaultPosition;
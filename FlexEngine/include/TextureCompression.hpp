@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+
+#include <glm/integer.hpp>
+
+namespace flex
+{
+	// GPU block compressed formats, each of which encodes every 4x4 block of pixels into a fixed number of bytes
+	enum class BlockCompressionFormat
+	{
+		BC4, // Red only, 8 bytes per block
+		BC5, // Red & green, 16 bytes per block
+		BC6H, // Unsigned half float RGB, 16 bytes per block
+		BC7, // RGBA, 16 bytes per block
+		NONE
+	};
+
+	glm::uint GetBlockCompressionBlockSize(BlockCompressionFormat format);
+
+	// Size in bytes of a compressed width x height image, blocks along the right & bottom edges may be partially filled
+	size_t GetBlockCompressedImageSize(BlockCompressionFormat format, glm::uint width, glm::uint height);
+
+	// Encodes a width x height image into dst, which must be at least GetBlockCompressedImageSize bytes
+	// pixels must have 4 channels per pixel: 32 bit floats for BC6H, otherwise 8 bit unorm
+	// BC6H & BC7 only use their single-region modes (11 & 6), which trades some quality on blocks
+	// with several distinct colors for an encoder that's quick enough to run in the background while loading
+	void CompressImage(BlockCompressionFormat format, const void* pixels, glm::uint width, glm::uint height, void* dst);
+} // namespace flex
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+#include <glm/integer.hpp>
+
+namespace flex
+{
+	// Fixed set of worker threads which execute queued jobs in submission order
+	// Jobs must not touch any graphics API state, results should be handed back to the main thread
+	class ThreadPool
+	{
+	public:
+		typedef std::function<void()> Job;
+
+		// A thread count of 0 uses one thread per hardware thread, minus one for the main thread
+		ThreadPool(glm::uint threadCount = 0);
+		~ThreadPool();
+
+		void Enqueue(Job job);
+
+		// Blocks until every queued job has finished executing
+		void WaitForIdle();
+
+		glm::uint GetThreadCount() const;
+
+	private:
+		void WorkerLoop();
+
+		std::vector<std::thread> m_Threads;
+
+		std::queue<Job> m_Jobs;
+		std::mutex m_Mutex;
+		std::condition_variable m_JobAvailable;
+		std::condition_variable m_Idle;
+
+		glm::uint m_ActiveJobCount = 0;
+		bool m_Stopping = false;
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+	};
+} // namespace flex
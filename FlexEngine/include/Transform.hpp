@@ -1,5 +1,6 @@
 #pragma once
 
+#include <glm/integer.hpp>
 #include <glm/vec3.hpp>
 #include <glm/mat4x4.hpp>
 #include <glm/gtc/quaternion.hpp>
@@ -60,6 +61,9 @@ namespace flex
 		
 		glm::mat4 GetModelMatrix();
 
+		// Changes whenever the global position, rotation or scale do, so anything derived from them can be cached until it changes
+		glm::uint GetVersion() const;
+
 		static Transform Identity();
 
 	private:
@@ -74,6 +78,8 @@ namespace flex
 		glm::quat globalRotation;
 		glm::vec3 globalScale;
 
+		glm::uint version = 1;
+
 		Transform* parentTransform = nullptr;
 		std::vector<Transform*> childrenTransforms;
 
@@ -15,4 +15,6 @@ namespace flex
 	typedef glm::uint MaterialID;
 	typedef glm::uint PointLightID;
 	typedef glm::uint DirectionalLightID;
+
+	const MaterialID INVALID_MATERIAL_ID = (MaterialID)-1;
 } // namespace flex
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <string>
+
+namespace flex
+{
+	// Round trip & invariant checks of the engine's deterministic CPU side processing
+	// Run by passing -test on the command line. Logs every failed check & returns whether all of them passed
+	bool RunUnitTests();
+
+	namespace UnitTests
+	{
+		// Runs one test of a group, reporting whether every check it made passed
+		void Run(const std::string& testName, void(*test)());
+
+		// Counts a check made by the running test, logging its description when it fails
+		void Check(bool condition, const std::string& description);
+
+		// Groups of tests, each defined in src/Tests/ next to the others & named after the module it checks
+		void RunMeshOptimizerTests();
+		void RunVertexBufferWriterTests();
+		void RunTextureCompressionTests();
+		void RunCookedTextureTests();
+		void RunMipGeneratorTests();
+		void RunFreeRangeListTests();
+#if COMPILE_OPEN_GL
+		void RunGLHelpersTests();
+#endif
+	} // namespace UnitTests
+} // namespace flex
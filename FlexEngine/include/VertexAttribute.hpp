@@ -18,8 +18,17 @@ namespace flex
 		TANGENT = (1 << 6),
 		BITANGENT = (1 << 7),
 		NORMAL = (1 << 8),
+
+		// Compressed formats, generated from the full precision data in VertexBufferData::CreateInfo
+		UV_HALF = (1 << 9), // texCoords_UV stored as two half floats (read as in_TexCoord)
+		NORMAL_OCT = (1 << 10), // normals octahedral-encoded into two snorm16s
+		TANGENT_FRAME = (1 << 11), // normals, tangents & bitangents stored as a quaternion in four snorm16s, w's sign is the bitangent's handedness
 	};
 
 	glm::uint CalculateVertexStride(VertexAttributes vertexAttributes);
 
+	// Replaces full precision attributes with their compressed equivalents where one exists
+	// Only meshes with a full tangent frame (read by pbr_compressed) are compressed, others are returned unchanged
+	VertexAttributes CompressVertexAttributes(VertexAttributes vertexAttributes);
+
 } // namespace flex
@@ -31,6 +31,26 @@ namespace flex
 		};
 
 		void Initialize(CreateInfo* createInfo);
+
+		// Allocates room for vertexCount vertices without writing anything, to be filled in directly by the caller (see VertexBufferWriter.hpp)
+		bool Initialize(glm::uint vertexCount, VertexAttributes attributes);
+
+		// Uses already interleaved vertex data which is owned elsewhere (e.g. a memory mapped cooked mesh)
+		// The data must outlive any renderer use of this object and is not freed by Destroy
+		void InitializeFromMemory(void* data, glm::uint vertexCount, VertexAttributes attributes, bool separatePositions = false);
+
+		// Rearranges interleaved data so that every position comes first (stream 0) followed by all other
+		// attributes interleaved (stream 1), letting position-only passes fetch just the data they need
+		// Does nothing and returns false if there are no positions or nothing else to separate them from
+		bool SeparatePositionStream();
+
+		// Stream 0 holds positions when SeparatePositions is true, otherwise it holds everything and stream 1 is empty
+		glm::uint GetStreamStride(glm::uint stream) const;
+		glm::uint GetStreamOffset(glm::uint stream) const;
+
+		// Frees (or forgets, when not owned) the vertex data but keeps everything describing it, for use once renderers have their own copy
+		void ReleaseData();
+
 		void Destroy();
 
 		void DescribeShaderVariables(Renderer* renderer, RenderID renderID);
@@ -40,5 +60,9 @@ namespace flex
 		glm::uint VertexCount;
 		glm::uint VertexStride;
 		VertexAttributes Attributes;
+		bool SeparatePositions;
+
+	private:
+		bool m_OwnsData;
 	};
 } // namespace flex
@@ -0,0 +1,191 @@
+#pragma once
+
+#include <cstring>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+// F16C is always available when the compiler has been told it can be assumed, otherwise it's detected at runtime on x86
+#if defined(__AVX2__) || defined(__F16C__)
+#include <immintrin.h>
+#define FLEX_F16C 1
+#define FLEX_F16C_RUNTIME_CHECK 0
+#elif defined(_M_X64) || defined(_M_IX86)
+#include <immintrin.h>
+#define FLEX_F16C 1
+#define FLEX_F16C_RUNTIME_CHECK 1
+#else
+#define FLEX_F16C 0
+#define FLEX_F16C_RUNTIME_CHECK 0
+#endif
+
+#include "Typedefs.hpp"
+#include "VertexAttribute.hpp"
+
+namespace flex
+{
+	// Maps a unit vector onto the octahedron then unfolds it into the [-1, 1] square
+	inline glm::vec2 EncodeOctahedral(const glm::vec3& n)
+	{
+		glm::vec3 v = n / (glm::abs(n.x) + glm::abs(n.y) + glm::abs(n.z));
+		glm::vec2 result(v.x, v.y);
+		if (v.z < 0.0f)
+		{
+			result.x = (1.0f - glm::abs(v.y)) * (v.x >= 0.0f ? 1.0f : -1.0f);
+			result.y = (1.0f - glm::abs(v.x)) * (v.y >= 0.0f ? 1.0f : -1.0f);
+		}
+		return result;
+	}
+
+	// Builds a "QTangent": a quaternion representing the orthonormalized tangent frame whose
+	// w component's sign stores the bitangent's handedness (see Frey - "Spherical Skinning with Dual-Quaternions and QTangents")
+	inline glm::quat EncodeTangentFrame(const glm::vec3& tangent, const glm::vec3& bitangent, const glm::vec3& normal)
+	{
+		const glm::vec3 n = glm::normalize(normal);
+		glm::vec3 t = tangent - n * glm::dot(n, tangent);
+		if (glm::dot(t, t) < 1e-12f)
+		{
+			// Degenerate tangent, pick any vector perpendicular to the normal
+			t = glm::abs(n.x) < 0.9f ? glm::cross(n, glm::vec3(1.0f, 0.0f, 0.0f)) : glm::cross(n, glm::vec3(0.0f, 1.0f, 0.0f));
+		}
+		t = glm::normalize(t);
+		const glm::vec3 b = glm::cross(n, t);
+		const bool reflected = glm::dot(b, bitangent) < 0.0f;
+
+		glm::quat q = glm::normalize(glm::quat_cast(glm::mat3(t, b, n)));
+		if (q.w < 0.0f)
+		{
+			q = -q;
+		}
+
+		// Keep w away from zero so its sign survives quantization
+		const float bias = 1.0f / 32767.0f;
+		if (q.w < bias)
+		{
+			const float xyzScale = glm::sqrt(1.0f - bias * bias);
+			q.x *= xyzScale;
+			q.y *= xyzScale;
+			q.z *= xyzScale;
+			q.w = bias;
+		}
+
+		return reflected ? -q : q;
+	}
+
+#if FLEX_F16C_RUNTIME_CHECK
+	// Set once at startup from cpuid (see VertexBufferWriter.cpp)
+	extern const bool CPU_SUPPORTS_F16C;
+#endif
+
+	inline glm::uint PackHalf2(const glm::vec2& v)
+	{
+#if FLEX_F16C
+#if FLEX_F16C_RUNTIME_CHECK
+		if (!CPU_SUPPORTS_F16C)
+		{
+			return glm::packHalf2x16(v);
+		}
+#endif
+		const __m128i packed = _mm_cvtps_ph(_mm_setr_ps(v.x, v.y, 0.0f, 0.0f), _MM_FROUND_TO_NEAREST_INT);
+		return (glm::uint)_mm_cvtsi128_si32(packed);
+#else
+		return glm::packHalf2x16(v);
+#endif
+	}
+
+	template<typename T>
+	inline void WriteVertexElement(char*& dst, const T& value)
+	{
+		memcpy(dst, &value, sizeof(T));
+		dst += sizeof(T);
+	}
+
+	// Writes a single interleaved vertex in the order attributes are laid out by CalculateVertexStride
+	// Source must provide accessors for every attribute: Position, Position2D, UV, UVW, Color32, Color, Tangent, Bitangent, & Normal
+	// When layout is a compile time constant every attribute test folds away (see WriteVerticesFixed)
+	template<typename Source>
+	inline void WriteVertex(VertexAttributes layout, const Source& source, glm::uint index, char* dst)
+	{
+		if (layout & (glm::uint)VertexAttribute::POSITION) WriteVertexElement(dst, source.Position(index));
+		if (layout & (glm::uint)VertexAttribute::POSITION_2D) WriteVertexElement(dst, source.Position2D(index));
+		if (layout & (glm::uint)VertexAttribute::UV) WriteVertexElement(dst, source.UV(index));
+		if (layout & (glm::uint)VertexAttribute::UVW) WriteVertexElement(dst, source.UVW(index));
+		if (layout & (glm::uint)VertexAttribute::COLOR_R8G8B8A8_UNORM) WriteVertexElement(dst, source.Color32(index));
+		if (layout & (glm::uint)VertexAttribute::COLOR_R32G32B32A32_SFLOAT) WriteVertexElement(dst, source.Color(index));
+		if (layout & (glm::uint)VertexAttribute::TANGENT) WriteVertexElement(dst, source.Tangent(index));
+		if (layout & (glm::uint)VertexAttribute::BITANGENT) WriteVertexElement(dst, source.Bitangent(index));
+		if (layout & (glm::uint)VertexAttribute::NORMAL) WriteVertexElement(dst, source.Normal(index));
+		if (layout & (glm::uint)VertexAttribute::UV_HALF) WriteVertexElement(dst, PackHalf2(source.UV(index)));
+		if (layout & (glm::uint)VertexAttribute::NORMAL_OCT) WriteVertexElement(dst, glm::packSnorm2x16(EncodeOctahedral(source.Normal(index))));
+		if (layout & (glm::uint)VertexAttribute::TANGENT_FRAME)
+		{
+			const glm::quat q = EncodeTangentFrame(source.Tangent(index), source.Bitangent(index), source.Normal(index));
+			WriteVertexElement(dst, glm::packSnorm4x16(glm::vec4(q.x, q.y, q.z, q.w)));
+		}
+	}
+
+	template<VertexAttributes Layout, typename Source>
+	void WriteVerticesFixed(const Source& source, glm::uint vertexCount, glm::uint vertexStride, char* dst)
+	{
+		for (glm::uint i = 0; i < vertexCount; ++i)
+		{
+			WriteVertex(Layout, source, i, dst);
+			dst += vertexStride;
+		}
+	}
+
+	template<typename Source>
+	void WriteVerticesGeneric(VertexAttributes layout, const Source& source, glm::uint vertexCount, glm::uint vertexStride, char* dst)
+	{
+		for (glm::uint i = 0; i < vertexCount; ++i)
+		{
+			WriteVertex(layout, source, i, dst);
+			dst += vertexStride;
+		}
+	}
+
+	// Interleaves vertexCount vertices from source into dst, which must have room for vertexCount * CalculateVertexStride(layout) bytes
+	// Common layouts get a writer specialized at compile time, any others test each attribute per vertex
+	template<typename Source>
+	void WriteVertices(VertexAttributes layout, const Source& source, glm::uint vertexCount, void* dst)
+	{
+		static const VertexAttributes POSITION = (glm::uint)VertexAttribute::POSITION;
+		static const VertexAttributes UV = (glm::uint)VertexAttribute::UV;
+		static const VertexAttributes COLOR = (glm::uint)VertexAttribute::COLOR_R32G32B32A32_SFLOAT;
+		static const VertexAttributes TANGENT = (glm::uint)VertexAttribute::TANGENT;
+		static const VertexAttributes BITANGENT = (glm::uint)VertexAttribute::BITANGENT;
+		static const VertexAttributes NORMAL = (glm::uint)VertexAttribute::NORMAL;
+		static const VertexAttributes UV_HALF = (glm::uint)VertexAttribute::UV_HALF;
+		static const VertexAttributes NORMAL_OCT = (glm::uint)VertexAttribute::NORMAL_OCT;
+		static const VertexAttributes TANGENT_FRAME = (glm::uint)VertexAttribute::TANGENT_FRAME;
+
+		const glm::uint vertexStride = CalculateVertexStride(layout);
+		char* dstStart = (char*)dst;
+
+		switch (layout)
+		{
+		case POSITION | UV | TANGENT | BITANGENT | NORMAL:
+			WriteVerticesFixed<POSITION | UV | TANGENT | BITANGENT | NORMAL>(source, vertexCount, vertexStride, dstStart);
+			break;
+		case POSITION | COLOR | UV | TANGENT | BITANGENT | NORMAL:
+			WriteVerticesFixed<POSITION | COLOR | UV | TANGENT | BITANGENT | NORMAL>(source, vertexCount, vertexStride, dstStart);
+			break;
+		case POSITION | UV | NORMAL:
+			WriteVerticesFixed<POSITION | UV | NORMAL>(source, vertexCount, vertexStride, dstStart);
+			break;
+		case POSITION | NORMAL:
+			WriteVerticesFixed<POSITION | NORMAL>(source, vertexCount, vertexStride, dstStart);
+			break;
+		case POSITION | UV_HALF | TANGENT_FRAME:
+			WriteVerticesFixed<POSITION | UV_HALF | TANGENT_FRAME>(source, vertexCount, vertexStride, dstStart);
+			break;
+		case POSITION | UV_HALF | NORMAL_OCT:
+			WriteVerticesFixed<POSITION | UV_HALF | NORMAL_OCT>(source, vertexCount, vertexStride, dstStart);
+			break;
+		default:
+			WriteVerticesGeneric(layout, source, vertexCount, vertexStride, dstStart);
+			break;
+		}
+	}
+} // namespace flex
@@ -1,16 +1,16 @@
-#version 400
+#version 430
 
 layout (location = 0) in vec3 in_Position;
 
 out vec3 WorldPos;
 
-uniform mat4 view;
-uniform mat4 projection;
-
-uniform mat4 model;
+#include "per_frame.glsl"
+#include "per_object.glsl"
 
 void main()
 {
+	mat4 model = perObjectData[in_ObjectIndex].model;
+
     WorldPos = in_Position;
 
     // Remove translation part from view matrix to keep it centered around viewer
@@ -1,17 +1,18 @@
-#version 400
+#version 430
 
-uniform mat4 view;
-uniform mat4 projection;
-
-uniform mat4 model;
+#include "per_frame.glsl"
 
 in vec3 in_Position;
 in vec4 in_Color;
 
 out vec4 ex_Color;
 
+#include "per_object.glsl"
+
 void main() 
 {
+	mat4 model = perObjectData[in_ObjectIndex].model;
+
 	gl_Position = projection * view * model * vec4(in_Position, 1.0);
 	
 	ex_Color = in_Color;
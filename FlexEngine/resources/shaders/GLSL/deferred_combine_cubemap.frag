@@ -9,26 +9,8 @@ in vec3 WorldPos;
 
 out vec4 fragmentColor;
 
-struct DirectionalLight 
-{
-	vec4 direction;
-	vec4 color;
-	bool enabled;
-	float padding[3];
-};
-uniform DirectionalLight dirLight;
-
-struct PointLight
-{
-	vec4 position;
-	vec4 color;
-	bool enabled;
-	float padding[3];
-};
-#define NUMBER_POINT_LIGHTS 4
-uniform PointLight pointLights[NUMBER_POINT_LIGHTS];
-
-uniform vec4 camPos;
+#include "per_frame.glsl"
+
 uniform bool enableIrradianceSampler;
 const float PI = 3.14159265359;
 
@@ -39,6 +21,8 @@ layout (binding = 3) uniform sampler2D brdfLUT;
 layout (binding = 4) uniform samplerCube irradianceSampler;
 layout (binding = 5) uniform samplerCube prefilterMap;
 
+#include "sh_irradiance.glsl"
+
 vec3 FresnelSchlick(float cosTheta, vec3 F0)
 {
 	return F0 + (1.0 - F0) * pow(1.0 - cosTheta, 5.0);
@@ -158,7 +142,7 @@ void main()
 		vec3 kS = F;
 	    vec3 kD = 1.0 - kS;
 	    kD *= 1.0 - metallic;	  
-	    vec3 irradiance = texture(irradianceSampler, N).rgb;
+	    vec3 irradiance = enableIrradianceSH ? EvaluateIrradianceSH(N) : texture(irradianceSampler, N).rgb;
 	    vec3 diffuse = irradiance * albedo;
 
 		// Specular ambient term (IBL)
@@ -6,8 +6,7 @@ in vec3 in_Position;
 
 out vec3 WorldPos;
 
-uniform mat4 view;
-uniform mat4 projection;
+#include "per_frame.glsl"
 
 uniform mat4 model;
 
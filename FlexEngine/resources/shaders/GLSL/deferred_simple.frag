@@ -15,6 +15,8 @@ uniform bool enableNormalSampler;
 uniform sampler2D diffuseSampler;
 uniform sampler2D normalSampler;
 
+#include "normal_mapping.glsl"
+
 void main()
 {
 	// Render to all GBuffers
@@ -23,7 +25,7 @@ void main()
 	if (enableNormalSampler)
 	{
 		vec4 normalSample = texture(normalSampler, ex_TexCoord);
-		out_NormalRoughness.rgb = normalize(ex_TBN * (normalSample.xyz * 2 - 1));
+		out_NormalRoughness.rgb = normalize(ex_TBN * DecodeTangentSpaceNormal(normalSample.rg));
 	}
 	else
 	{
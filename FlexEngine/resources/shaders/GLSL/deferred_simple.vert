@@ -1,4 +1,4 @@
-#version 400
+#version 430
 
 layout (location = 0) in vec3 in_Position;
 layout (location = 1) in vec2 in_TexCoord;
@@ -12,13 +12,14 @@ out vec2 ex_TexCoord;
 out vec4 ex_Color;
 out mat3 ex_TBN;
 
-uniform mat4 model;
-uniform mat4 modelInvTranspose;
-uniform mat4 view;
-uniform mat4 projection;
+#include "per_frame.glsl"
+#include "per_object.glsl"
 
 void main()
 {
+	mat4 model = perObjectData[in_ObjectIndex].model;
+	mat4 modelInvTranspose = perObjectData[in_ObjectIndex].modelInvTranspose;
+
     vec4 worldPos = model * vec4(in_Position, 1.0);
     ex_FragPos = worldPos.xyz; 
 	
@@ -0,0 +1,8 @@
+// Shared by every shader which samples normal maps, included through #include "normal_mapping.glsl"
+
+// Normal maps may be cooked into two channel formats, so Z is always reconstructed from X & Y
+vec3 DecodeTangentSpaceNormal(vec2 rg)
+{
+	vec2 xy = rg * 2 - 1;
+	return vec3(xy, sqrt(max(0, 1 - dot(xy, xy))));
+}
@@ -33,13 +33,15 @@ layout (binding = 3) uniform sampler2D aoSampler;
 uniform bool enableNormalSampler;
 layout (binding = 4) uniform sampler2D normalSampler;
 
+#include "normal_mapping.glsl"
+
 void main() 
 {
 	vec3 albedo = enableAlbedoSampler ? texture(albedoSampler, ex_TexCoord).rgb : vec3(constAlbedo);
 	float metallic = enableMetallicSampler ? texture(metallicSampler, ex_TexCoord).r : constMetallic;
 	float roughness = enableRoughnessSampler ? texture(roughnessSampler, ex_TexCoord).r : constRoughness;
 	float ao = enableAOSampler ? texture(aoSampler, ex_TexCoord).r : constAO;
-	vec3 Normal = enableNormalSampler ? (ex_TBN * (texture(normalSampler, ex_TexCoord).xyz * 2 - 1)) : ex_TBN[2];
+	vec3 Normal = enableNormalSampler ? (ex_TBN * DecodeTangentSpaceNormal(texture(normalSampler, ex_TexCoord).rg)) : ex_TBN[2];
 	
 	outPositionMetallic.rgb = ex_WorldPos;
 	outPositionMetallic.a = metallic;
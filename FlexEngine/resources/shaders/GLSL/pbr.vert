@@ -1,4 +1,4 @@
-#version 400
+#version 430
 
 // Deferred PBR
 
@@ -12,12 +12,13 @@ out vec3 ex_WorldPos;
 out mat3 ex_TBN;
 out vec2 ex_TexCoord;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+#include "per_frame.glsl"
+#include "per_object.glsl"
 
 void main()
 {
+	mat4 model = perObjectData[in_ObjectIndex].model;
+
     vec4 worldPos = model * vec4(in_Position, 1.0);
     ex_WorldPos = worldPos.xyz; 
 	
@@ -0,0 +1,43 @@
+#version 430
+
+// Deferred PBR - compressed vertex attributes (VertexAttribute::UV_HALF | VertexAttribute::TANGENT_FRAME)
+
+layout (location = 0) in vec3 in_Position;
+layout (location = 1) in vec2 in_TexCoord;
+layout (location = 2) in vec4 in_TangentFrame;
+
+out vec3 ex_WorldPos;
+out mat3 ex_TBN;
+out vec2 ex_TexCoord;
+
+#include "per_frame.glsl"
+#include "per_object.glsl"
+
+// Rotates the x & z axes by the tangent frame quaternion, w's sign holds the bitangent's handedness
+void DecodeTangentFrame(vec4 q, out vec3 tangent, out vec3 bitangent, out vec3 normal)
+{
+	q = normalize(q);
+	tangent = vec3(1.0 - 2.0 * (q.y * q.y + q.z * q.z), 2.0 * (q.x * q.y + q.w * q.z), 2.0 * (q.x * q.z - q.w * q.y));
+	normal = vec3(2.0 * (q.x * q.z + q.w * q.y), 2.0 * (q.y * q.z - q.w * q.x), 1.0 - 2.0 * (q.x * q.x + q.y * q.y));
+	bitangent = cross(normal, tangent) * (q.w < 0.0 ? -1.0 : 1.0);
+}
+
+void main()
+{
+	mat4 model = perObjectData[in_ObjectIndex].model;
+
+    vec4 worldPos = model * vec4(in_Position, 1.0);
+    ex_WorldPos = worldPos.xyz; 
+	
+	ex_TexCoord = in_TexCoord;
+
+	vec3 tangent, bitangent, normal;
+	DecodeTangentFrame(in_TangentFrame, tangent, bitangent, normal);
+
+	ex_TBN = mat3(
+		normalize(mat3(model) * tangent), 
+		normalize(mat3(model) * bitangent), 
+		normalize(mat3(model) * normal));
+
+    gl_Position = projection * view * worldPos;
+}
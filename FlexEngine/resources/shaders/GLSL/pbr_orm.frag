@@ -0,0 +1,55 @@
+#version 400
+
+// Deferred PBR, sampling occlusion, roughness & metallic from a single texture
+
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_ARB_shading_language_420pack : enable
+
+in vec3 ex_WorldPos;
+in mat3 ex_TBN;
+in vec2 ex_TexCoord;
+
+out vec4 outPositionMetallic;
+out vec4 outNormalRoughness;
+out vec4 outAlbedoAO;
+
+// Material variables
+uniform vec4 constAlbedo;
+uniform bool enableAlbedoSampler;
+layout (binding = 0) uniform sampler2D albedoSampler;
+
+uniform float constMetallic;
+uniform bool enableMetallicSampler;
+
+uniform float constRoughness;
+uniform bool enableRoughnessSampler;
+
+uniform float constAO;
+uniform bool enableAOSampler;
+
+// Occlusion, roughness & metallic in red, green & blue, packed from separate maps when the material was loaded
+layout (binding = 1) uniform sampler2D ormSampler;
+
+uniform bool enableNormalSampler;
+layout (binding = 2) uniform sampler2D normalSampler;
+
+#include "normal_mapping.glsl"
+
+void main() 
+{
+	vec3 albedo = enableAlbedoSampler ? texture(albedoSampler, ex_TexCoord).rgb : vec3(constAlbedo);
+	vec3 orm = (enableAOSampler || enableRoughnessSampler || enableMetallicSampler) ? texture(ormSampler, ex_TexCoord).rgb : vec3(0);
+	float ao = enableAOSampler ? orm.r : constAO;
+	float roughness = enableRoughnessSampler ? orm.g : constRoughness;
+	float metallic = enableMetallicSampler ? orm.b : constMetallic;
+	vec3 Normal = enableNormalSampler ? (ex_TBN * DecodeTangentSpaceNormal(texture(normalSampler, ex_TexCoord).rg)) : ex_TBN[2];
+	
+	outPositionMetallic.rgb = ex_WorldPos;
+	outPositionMetallic.a = metallic;
+
+	outNormalRoughness.rgb = normalize(Normal);
+	outNormalRoughness.a = roughness;
+	
+	outAlbedoAO.rgb = albedo;
+	outAlbedoAO.a = ao;
+}
@@ -0,0 +1,29 @@
+// Shared by every program, included through #include "per_frame.glsl"
+// The std140 layout of PerFrameUBO must match the 512 byte PerFrameUBO struct in GLHelpers.hpp
+
+struct DirectionalLight 
+{
+	vec4 direction;
+	vec4 color;
+	bool enabled;
+};
+
+struct PointLight
+{
+	vec4 position;
+	vec4 color;
+	bool enabled;
+};
+#define NUMBER_POINT_LIGHTS 4
+
+// Filled once per frame by GLRenderer::UpdatePerFrameUBO
+layout (std140) uniform PerFrameUBO
+{
+	mat4 view;
+	mat4 viewInv;
+	mat4 projection;
+	mat4 viewProjection;
+	vec4 camPos;
+	DirectionalLight dirLight;
+	PointLight pointLights[NUMBER_POINT_LIGHTS];
+};
@@ -0,0 +1,17 @@
+// Shared by every vertex shader which reads its model matrices from PerObjectBuffer, included through #include "per_object.glsl"
+// The std430 layout of PerObjectData must match the 144 byte PerObjectData struct in GLHelpers.hpp
+
+layout (location = 15) in uint in_ObjectIndex; // OBJECT_INDEX_ATTRIBUTE_LOCATION, selected by each draw's base instance
+
+struct PerObjectData
+{
+	mat4 model;
+	mat4 modelInvTranspose;
+	uint materialID;
+};
+
+// Written once per frame by GLRenderer::UpdatePerObjectBuffer, one entry per object in the draw list
+layout (std430) readonly buffer PerObjectBuffer
+{
+	PerObjectData perObjectData[];
+};
@@ -0,0 +1,22 @@
+// Shared by the deferred combine shaders, included through #include "sh_irradiance.glsl"
+// The basis order & constants must match EvaluateSH9Basis in IBLBaker.cpp, which projects the environment onto it
+
+// Irradiance as nine spherical harmonics coefficients, used instead of irradianceSampler when enabled
+// Already convolved with the cosine lobe, so evaluating them gives what the irradiance cubemap would hold
+uniform bool enableIrradianceSH;
+uniform vec3 irradianceSH[9];
+
+vec3 EvaluateIrradianceSH(vec3 n)
+{
+	vec3 result =
+		irradianceSH[0] * 0.282095 +
+		irradianceSH[1] * (0.488603 * n.y) +
+		irradianceSH[2] * (0.488603 * n.z) +
+		irradianceSH[3] * (0.488603 * n.x) +
+		irradianceSH[4] * (1.092548 * n.x * n.y) +
+		irradianceSH[5] * (1.092548 * n.y * n.z) +
+		irradianceSH[6] * (0.315392 * (3.0 * n.z * n.z - 1.0)) +
+		irradianceSH[7] * (1.092548 * n.x * n.z) +
+		irradianceSH[8] * (0.546274 * (n.x * n.x - n.y * n.y));
+	return max(result, vec3(0.0));
+}
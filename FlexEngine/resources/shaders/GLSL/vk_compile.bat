@@ -16,6 +16,7 @@
 
 @ glslangvalidator -V vk_pbr.vert -o spv/vk_pbr_vert.spv
 @ glslangvalidator -V vk_pbr.frag -o spv/vk_pbr_frag.spv
+@ glslangvalidator -V vk_pbr_compressed.vert -o spv/vk_pbr_compressed_vert.spv
 
 @ glslangvalidator -V vk_background.vert -o spv/vk_background_vert.spv
 @ glslangvalidator -V vk_background.frag -o spv/vk_background_frag.spv
@@ -4,6 +4,7 @@
 
 #extension GL_ARB_separate_shader_objects : enable
 #extension GL_ARB_shading_language_420pack : enable
+#extension GL_GOOGLE_include_directive : require
 
 // Updated once per frame
 layout (binding = 0) uniform UBOConstant
@@ -44,13 +45,15 @@ layout (location = 0) out vec4 outPositionMetallic;
 layout (location = 1) out vec4 outNormalRoughness;
 layout (location = 2) out vec4 outAlbedoAO;
 
+#include "normal_mapping.glsl"
+
 void main() 
 {
 	vec3 albedo = uboDynamic.enableAlbedoSampler ? texture(albedoSampler, ex_TexCoord).rgb : vec3(uboDynamic.constAlbedo);
 	float metallic = uboDynamic.enableMetallicSampler ? texture(metallicSampler, ex_TexCoord).r : uboDynamic.constMetallic;
 	float roughness = uboDynamic.enableRoughnessSampler ? texture(roughnessSampler, ex_TexCoord).r : uboDynamic.constRoughness;
 	float ao = uboDynamic.enableAOSampler ? texture(aoSampler, ex_TexCoord).r : uboDynamic.constAO;
-	vec3 Normal = normalize(uboDynamic.enableNormalSampler ? (ex_TBN * (texture(normalSampler, ex_TexCoord).xyz * 2 - 1)) : ex_TBN[2]);
+	vec3 Normal = normalize(uboDynamic.enableNormalSampler ? (ex_TBN * DecodeTangentSpaceNormal(texture(normalSampler, ex_TexCoord).rg)) : ex_TBN[2]);
 
 	outPositionMetallic.rgb = ex_WorldPos;
 	outPositionMetallic.a = metallic;
@@ -0,0 +1,71 @@
+#version 450
+
+// Deferred PBR - compressed vertex attributes (VertexAttribute::UV_HALF | VertexAttribute::TANGENT_FRAME)
+
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_ARB_shading_language_420pack : enable
+
+layout (location = 0) in vec3 in_Position;
+layout (location = 1) in vec2 in_TexCoord;
+layout (location = 2) in vec4 in_TangentFrame;
+
+layout (location = 0) out vec3 ex_WorldPos;
+layout (location = 1) out vec2 ex_TexCoord;
+layout (location = 2) out mat3 ex_TBN;
+
+// Updated once per frame
+layout (binding = 0) uniform UBOConstant
+{
+	mat4 viewProjection;
+} uboConstant;
+
+// Updated once per object
+layout (binding = 1) uniform UBODynamic
+{
+	mat4 model;
+
+	// Constant values to use when not using samplers
+	vec4 constAlbedo;
+	float constMetallic;
+	float constRoughness;
+	float constAO;
+
+	// PBR samplers
+	bool enableAlbedoSampler;
+	bool enableMetallicSampler;
+	bool enableRoughnessSampler;
+	bool enableAOSampler;
+	bool enableNormalSampler;
+} uboDynamic;
+
+// Rotates the x & z axes by the tangent frame quaternion, w's sign holds the bitangent's handedness
+void DecodeTangentFrame(vec4 q, out vec3 tangent, out vec3 bitangent, out vec3 normal)
+{
+	q = normalize(q);
+	tangent = vec3(1.0 - 2.0 * (q.y * q.y + q.z * q.z), 2.0 * (q.x * q.y + q.w * q.z), 2.0 * (q.x * q.z - q.w * q.y));
+	normal = vec3(2.0 * (q.x * q.z + q.w * q.y), 2.0 * (q.y * q.z - q.w * q.x), 1.0 - 2.0 * (q.x * q.x + q.y * q.y));
+	bitangent = cross(normal, tangent) * (q.w < 0.0 ? -1.0 : 1.0);
+}
+
+void main()
+{
+    vec4 worldPos = uboDynamic.model * vec4(in_Position, 1.0);
+    ex_WorldPos = worldPos.xyz; 
+	
+	ex_TexCoord = in_TexCoord;
+
+	vec3 tangent, bitangent, normal;
+	DecodeTangentFrame(in_TangentFrame, tangent, bitangent, normal);
+
+	ex_TBN = mat3(
+		normalize(mat3(uboDynamic.model) * tangent), 
+		normalize(mat3(uboDynamic.model) * bitangent), 
+		normalize(mat3(uboDynamic.model) * normal));
+
+    gl_Position = uboConstant.viewProjection * worldPos;
+    
+	// Convert from GL coordinates to Vulkan coordinates
+	// TODO: Move out to external function in helper file
+	gl_Position.y = -gl_Position.y;
+	gl_Position.z = (gl_Position.z + gl_Position.w) / 2.0;
+}
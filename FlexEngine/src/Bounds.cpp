@@ -0,0 +1,123 @@
+#include "stdafx.hpp"
+
+#include "Bounds.hpp"
+
+#include <cfloat>
+
+#include <glm/common.hpp>
+#include <glm/exponential.hpp>
+#include <glm/geometric.hpp>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define FLEX_SSE2 1
+#else
+#define FLEX_SSE2 0
+#endif
+
+namespace flex
+{
+	MeshBounds CalculateMeshBounds(const void* positions, glm::uint vertexCount, glm::uint vertexStride)
+	{
+		MeshBounds bounds = {};
+		if (vertexCount == 0)
+		{
+			return bounds;
+		}
+
+		const char* vertex = (const char*)positions;
+
+#if FLEX_SSE2
+		// Two independent accumulators per bound halve the dependency chain through min/max
+		__m128 minimum0 = _mm_set1_ps(FLT_MAX);
+		__m128 maximum0 = _mm_set1_ps(-FLT_MAX);
+		__m128 minimum1 = minimum0;
+		__m128 maximum1 = maximum0;
+
+		glm::uint i = 0;
+		for (; i + 1 < vertexCount; i += 2)
+		{
+			const float* p0 = (const float*)(vertex + (size_t)i * vertexStride);
+			const float* p1 = (const float*)(vertex + (size_t)(i + 1) * vertexStride);
+			const __m128 pos0 = _mm_setr_ps(p0[0], p0[1], p0[2], 0.0f);
+			const __m128 pos1 = _mm_setr_ps(p1[0], p1[1], p1[2], 0.0f);
+			minimum0 = _mm_min_ps(minimum0, pos0);
+			maximum0 = _mm_max_ps(maximum0, pos0);
+			minimum1 = _mm_min_ps(minimum1, pos1);
+			maximum1 = _mm_max_ps(maximum1, pos1);
+		}
+		if (i < vertexCount)
+		{
+			const float* p = (const float*)(vertex + (size_t)i * vertexStride);
+			const __m128 pos = _mm_setr_ps(p[0], p[1], p[2], 0.0f);
+			minimum0 = _mm_min_ps(minimum0, pos);
+			maximum0 = _mm_max_ps(maximum0, pos);
+		}
+
+		float result[4];
+		_mm_storeu_ps(result, _mm_min_ps(minimum0, minimum1));
+		bounds.box.minimum = glm::vec3(result[0], result[1], result[2]);
+		_mm_storeu_ps(result, _mm_max_ps(maximum0, maximum1));
+		bounds.box.maximum = glm::vec3(result[0], result[1], result[2]);
+#else
+		bounds.box.minimum = glm::vec3(FLT_MAX);
+		bounds.box.maximum = glm::vec3(-FLT_MAX);
+		for (glm::uint i = 0; i < vertexCount; ++i)
+		{
+			const glm::vec3& pos = *(const glm::vec3*)(vertex + (size_t)i * vertexStride);
+			bounds.box.minimum = glm::min(bounds.box.minimum, pos);
+			bounds.box.maximum = glm::max(bounds.box.maximum, pos);
+		}
+#endif
+
+		// Tighter than the box's half diagonal for anything but box shaped meshes
+		const glm::vec3 center = (bounds.box.minimum + bounds.box.maximum) * 0.5f;
+		float maxDistanceSquared = 0.0f;
+		for (glm::uint i = 0; i < vertexCount; ++i)
+		{
+			const glm::vec3 offset = *(const glm::vec3*)(vertex + (size_t)i * vertexStride) - center;
+			maxDistanceSquared = glm::max(maxDistanceSquared, glm::dot(offset, offset));
+		}
+
+		bounds.sphere.center = center;
+		bounds.sphere.radius = glm::sqrt(maxDistanceSquared);
+
+		return bounds;
+	}
+
+	AABB TransformAABB(const AABB& box, const glm::mat4& transform)
+	{
+		const glm::vec3 center = (box.minimum + box.maximum) * 0.5f;
+		const glm::vec3 extents = (box.maximum - box.minimum) * 0.5f;
+
+		const glm::vec3 transformedCenter = glm::vec3(transform * glm::vec4(center, 1.0f));
+		const glm::vec3 transformedExtents =
+			glm::abs(glm::vec3(transform[0])) * extents.x +
+			glm::abs(glm::vec3(transform[1])) * extents.y +
+			glm::abs(glm::vec3(transform[2])) * extents.z;
+
+		AABB result;
+		result.minimum = transformedCenter - transformedExtents;
+		result.maximum = transformedCenter + transformedExtents;
+		return result;
+	}
+
+	BoundingSphere TransformBoundingSphere(const BoundingSphere& sphere, const glm::mat4& transform)
+	{
+		const float scaleSquared = glm::max(glm::dot(glm::vec3(transform[0]), glm::vec3(transform[0])),
+			glm::max(glm::dot(glm::vec3(transform[1]), glm::vec3(transform[1])), glm::dot(glm::vec3(transform[2]), glm::vec3(transform[2]))));
+
+		BoundingSphere result;
+		result.center = glm::vec3(transform * glm::vec4(sphere.center, 1.0f));
+		result.radius = sphere.radius * glm::sqrt(scaleSquared);
+		return result;
+	}
+
+	MeshBounds TransformMeshBounds(const MeshBounds& bounds, const glm::mat4& transform)
+	{
+		MeshBounds result;
+		result.box = TransformAABB(bounds.box, transform);
+		result.sphere = TransformBoundingSphere(bounds.sphere, transform);
+		return result;
+	}
+} // namespace flex
@@ -0,0 +1,395 @@
+#include "stdafx.hpp"
+
+#include "CookedMesh.hpp"
+
+#include <fstream>
+#include <functional>
+#include <thread>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "Helpers.hpp"
+#include "Logger.hpp"
+#include "VertexAttribute.hpp"
+#include "VertexBufferData.hpp"
+
+namespace flex
+{
+	MappedFile::MappedFile()
+	{
+	}
+
+	MappedFile::~MappedFile()
+	{
+		Close();
+	}
+
+	bool MappedFile::Open(const std::string& filePath)
+	{
+		Close();
+
+#ifdef _WIN32
+		HANDLE fileHandle = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (fileHandle == INVALID_HANDLE_VALUE)
+		{
+			return false;
+		}
+
+		LARGE_INTEGER fileSize;
+		if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0)
+		{
+			CloseHandle(fileHandle);
+			return false;
+		}
+
+		HANDLE mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (!mappingHandle)
+		{
+			CloseHandle(fileHandle);
+			return false;
+		}
+
+		const void* data = MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+		if (!data)
+		{
+			CloseHandle(mappingHandle);
+			CloseHandle(fileHandle);
+			return false;
+		}
+
+		m_FileHandle = fileHandle;
+		m_MappingHandle = mappingHandle;
+		m_Data = data;
+		m_Size = (size_t)fileSize.QuadPart;
+#else
+		int fileDescriptor = open(filePath.c_str(), O_RDONLY);
+		if (fileDescriptor == -1)
+		{
+			return false;
+		}
+
+		struct stat fileStat;
+		if (fstat(fileDescriptor, &fileStat) != 0 || fileStat.st_size == 0)
+		{
+			close(fileDescriptor);
+			return false;
+		}
+
+		void* data = mmap(nullptr, (size_t)fileStat.st_size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+		if (data == MAP_FAILED)
+		{
+			close(fileDescriptor);
+			return false;
+		}
+
+		m_FileDescriptor = fileDescriptor;
+		m_Data = data;
+		m_Size = (size_t)fileStat.st_size;
+#endif
+
+		return true;
+	}
+
+	void MappedFile::Close()
+	{
+#ifdef _WIN32
+		if (m_Data) UnmapViewOfFile(m_Data);
+		if (m_MappingHandle) CloseHandle(m_MappingHandle);
+		if (m_FileHandle) CloseHandle(m_FileHandle);
+		m_MappingHandle = nullptr;
+		m_FileHandle = nullptr;
+#else
+		if (m_Data) munmap(const_cast<void*>(m_Data), m_Size);
+		if (m_FileDescriptor != -1) close(m_FileDescriptor);
+		m_FileDescriptor = -1;
+#endif
+
+		m_Data = nullptr;
+		m_Size = 0;
+	}
+
+	bool MappedFile::IsOpen() const
+	{
+		return m_Data != nullptr;
+	}
+
+	const void* MappedFile::GetData() const
+	{
+		return m_Data;
+	}
+
+	size_t MappedFile::GetSize() const
+	{
+		return m_Size;
+	}
+
+	const glm::uint CookedMesh::MAGIC = 0x48534D46; // "FMSH" in little-endian
+	const glm::uint CookedMesh::VERSION = 6; // Increment whenever the layout or contents of cooked files change
+	const std::string CookedMesh::COOKED_MESH_DIRECTORY = RESOURCE_LOCATION + "models/cooked/";
+
+	CookedMesh::CookedMesh()
+	{
+	}
+
+	CookedMesh::~CookedMesh()
+	{
+		Unload();
+	}
+
+	bool CookedMesh::CreateKey(const std::string& sourceFilePath, glm::uint importFlags, Key& key)
+	{
+		struct stat fileStat;
+		if (stat(sourceFilePath.c_str(), &fileStat) != 0)
+		{
+			return false;
+		}
+
+		key.sourceFilePath = sourceFilePath;
+		key.sourceModifiedTime = (glm::uint64)fileStat.st_mtime;
+		key.importFlags = importFlags;
+
+		return true;
+	}
+
+	bool CookedMesh::Save(const Key& key, const VertexBufferData& vertexBufferData, const std::vector<glm::uint>& indices,
+		const std::vector<MeshLOD>& lods, const std::vector<Meshlet>& meshlets, const MeshBounds& bounds)
+	{
+		if (!vertexBufferData.pDataStart || vertexBufferData.VertexCount == 0)
+		{
+			return false;
+		}
+
+#ifdef _WIN32
+		_mkdir(COOKED_MESH_DIRECTORY.c_str());
+#else
+		mkdir(COOKED_MESH_DIRECTORY.c_str(), 0755);
+#endif
+
+		// Written to a temporary file first and then moved into place, so meshes being cooked by
+		// several threads at once never leave a partially written file for others to map
+		const std::string cookedFilePath = GetCookedFilePath(key);
+		const std::string tempFilePath = cookedFilePath + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+
+		std::ofstream file(tempFilePath, std::ios::out | std::ios::binary | std::ios::trunc);
+		if (!file.is_open())
+		{
+			Logger::LogWarning("Failed to write cooked mesh " + cookedFilePath);
+			return false;
+		}
+
+		Header header = {};
+		header.magic = MAGIC;
+		header.version = VERSION;
+		header.sourceModifiedTime = key.sourceModifiedTime;
+		header.sourcePathHash = HashString(key.sourceFilePath);
+		header.importFlags = key.importFlags;
+		header.vertexAttributes = vertexBufferData.Attributes;
+		header.vertexCount = vertexBufferData.VertexCount;
+		header.vertexStride = vertexBufferData.VertexStride;
+		header.vertexBufferSize = vertexBufferData.BufferSize;
+		header.indexCount = (glm::uint)indices.size();
+		header.lodCount = (glm::uint)lods.size();
+		header.meshletCount = (glm::uint)meshlets.size();
+		memcpy(header.boundsMin, &bounds.box.minimum, sizeof(header.boundsMin));
+		memcpy(header.boundsMax, &bounds.box.maximum, sizeof(header.boundsMax));
+		memcpy(header.boundingSphere, &bounds.sphere.center, sizeof(float) * 3);
+		header.boundingSphere[3] = bounds.sphere.radius;
+
+		file.write((const char*)&header, sizeof(header));
+		file.write((const char*)vertexBufferData.pDataStart, vertexBufferData.BufferSize);
+		if (!indices.empty())
+		{
+			file.write((const char*)indices.data(), sizeof(indices[0]) * indices.size());
+		}
+		if (!lods.empty())
+		{
+			file.write((const char*)lods.data(), sizeof(lods[0]) * lods.size());
+		}
+		if (!meshlets.empty())
+		{
+			file.write((const char*)meshlets.data(), sizeof(meshlets[0]) * meshlets.size());
+		}
+
+		const bool written = file.good();
+		file.close();
+
+		if (!written)
+		{
+			Logger::LogWarning("Failed to write cooked mesh " + cookedFilePath);
+			remove(tempFilePath.c_str());
+			return false;
+		}
+
+#ifdef _WIN32
+		const bool moved = (MoveFileExA(tempFilePath.c_str(), cookedFilePath.c_str(), MOVEFILE_REPLACE_EXISTING) != 0);
+#else
+		const bool moved = (rename(tempFilePath.c_str(), cookedFilePath.c_str()) == 0);
+#endif
+		if (!moved)
+		{
+			// Most likely another thread's identical copy is already in place and mapped
+			remove(tempFilePath.c_str());
+			return false;
+		}
+
+		return true;
+	}
+
+	bool CookedMesh::Load(const Key& key)
+	{
+		Unload();
+
+		const std::string cookedFilePath = GetCookedFilePath(key);
+		if (!m_File.Open(cookedFilePath))
+		{
+			return false;
+		}
+
+		const Header* header = (const Header*)m_File.GetData();
+
+		bool valid =
+			m_File.GetSize() >= sizeof(Header) &&
+			header->magic == MAGIC &&
+			header->version == VERSION &&
+			header->sourceModifiedTime == key.sourceModifiedTime &&
+			header->sourcePathHash == HashString(key.sourceFilePath) &&
+			header->importFlags == key.importFlags &&
+			header->vertexStride == CalculateVertexStride(header->vertexAttributes) &&
+			header->vertexBufferSize == header->vertexCount * header->vertexStride &&
+			m_File.GetSize() == sizeof(Header) + header->vertexBufferSize + sizeof(glm::uint) * header->indexCount + sizeof(MeshLOD) * header->lodCount + sizeof(Meshlet) * header->meshletCount;
+
+		if (valid)
+		{
+			// Never hand out LOD or meshlet ranges which would read past the indices
+			const MeshLOD* lods = (const MeshLOD*)((const char*)m_File.GetData() + sizeof(Header) + header->vertexBufferSize + sizeof(glm::uint) * header->indexCount);
+			for (glm::uint i = 0; i < header->lodCount && valid; ++i)
+			{
+				valid = ((glm::uint64)lods[i].firstIndex + lods[i].indexCount <= header->indexCount);
+			}
+
+			const Meshlet* meshlets = (const Meshlet*)(lods + header->lodCount);
+			for (glm::uint i = 0; i < header->meshletCount && valid; ++i)
+			{
+				valid = ((glm::uint64)meshlets[i].firstIndex + meshlets[i].indexCount <= header->indexCount);
+			}
+		}
+
+		if (!valid)
+		{
+			// Stale or corrupt, will be overwritten once the source has been re-imported
+			m_File.Close();
+			return false;
+		}
+
+		m_Header = header;
+
+		return true;
+	}
+
+	void CookedMesh::Unload()
+	{
+		m_File.Close();
+		m_Header = nullptr;
+	}
+
+	bool CookedMesh::IsLoaded() const
+	{
+		return m_Header != nullptr;
+	}
+
+	void* CookedMesh::GetVertexData() const
+	{
+		// Mapped read-only, renderers only ever read from vertex buffer data
+		return (char*)m_File.GetData() + sizeof(Header);
+	}
+
+	glm::uint CookedMesh::GetVertexBufferSize() const
+	{
+		return m_Header->vertexBufferSize;
+	}
+
+	glm::uint CookedMesh::GetVertexCount() const
+	{
+		return m_Header->vertexCount;
+	}
+
+	VertexAttributes CookedMesh::GetVertexAttributes() const
+	{
+		return m_Header->vertexAttributes;
+	}
+
+	const glm::uint* CookedMesh::GetIndices() const
+	{
+		return (const glm::uint*)((const char*)m_File.GetData() + sizeof(Header) + m_Header->vertexBufferSize);
+	}
+
+	glm::uint CookedMesh::GetIndexCount() const
+	{
+		return m_Header->indexCount;
+	}
+
+	const MeshLOD* CookedMesh::GetLODs() const
+	{
+		return (const MeshLOD*)(GetIndices() + m_Header->indexCount);
+	}
+
+	glm::uint CookedMesh::GetLODCount() const
+	{
+		return m_Header->lodCount;
+	}
+
+	const Meshlet* CookedMesh::GetMeshlets() const
+	{
+		return (const Meshlet*)(GetLODs() + m_Header->lodCount);
+	}
+
+	glm::uint CookedMesh::GetMeshletCount() const
+	{
+		return m_Header->meshletCount;
+	}
+
+	MeshBounds CookedMesh::GetBounds() const
+	{
+		MeshBounds bounds;
+		bounds.box.minimum = glm::vec3(m_Header->boundsMin[0], m_Header->boundsMin[1], m_Header->boundsMin[2]);
+		bounds.box.maximum = glm::vec3(m_Header->boundsMax[0], m_Header->boundsMax[1], m_Header->boundsMax[2]);
+		bounds.sphere.center = glm::vec3(m_Header->boundingSphere[0], m_Header->boundingSphere[1], m_Header->boundingSphere[2]);
+		bounds.sphere.radius = m_Header->boundingSphere[3];
+		return bounds;
+	}
+
+	std::string CookedMesh::GetCookedFilePath(const Key& key)
+	{
+		std::string fileName = key.sourceFilePath;
+		StripLeadingDirectories(fileName);
+
+		// Include the path & flags so that identically named files and differently imported
+		// versions of the same file don't overwrite each other
+		char suffix[32];
+		snprintf(suffix, sizeof(suffix), "_%08x_%08x", HashString(key.sourceFilePath), key.importFlags);
+
+		return COOKED_MESH_DIRECTORY + fileName + suffix + ".fmesh";
+	}
+
+	glm::uint CookedMesh::HashString(const std::string& str)
+	{
+		// FNV-1a
+		glm::uint hash = 2166136261u;
+		for (char c : str)
+		{
+			hash ^= (glm::uint)(unsigned char)c;
+			hash *= 16777619u;
+		}
+		return hash;
+	}
+} // namespace flex
@@ -0,0 +1,453 @@
+#include "stdafx.hpp"
+
+#include "CookedTexture.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#include <windows.h>
+#endif
+
+#include "Helpers.hpp"
+#include "Logger.hpp"
+#include "MipGenerator.hpp"
+
+namespace flex
+{
+	namespace
+	{
+		// DXGI_FORMAT values
+		const glm::uint DXGI_FORMAT_BC4_UNORM = 80;
+		const glm::uint DXGI_FORMAT_BC5_UNORM = 83;
+		const glm::uint DXGI_FORMAT_BC6H_UF16 = 95;
+		const glm::uint DXGI_FORMAT_BC7_UNORM = 98;
+
+		const glm::uint DDS_MAGIC = 0x20534444; // "DDS "
+		const glm::uint DDS_FOURCC_DX10 = 0x30315844; // "DX10"
+
+		glm::uint FormatToDXGIFormat(BlockCompressionFormat format)
+		{
+			switch (format)
+			{
+			case BlockCompressionFormat::BC4: return DXGI_FORMAT_BC4_UNORM;
+			case BlockCompressionFormat::BC5: return DXGI_FORMAT_BC5_UNORM;
+			case BlockCompressionFormat::BC6H: return DXGI_FORMAT_BC6H_UF16;
+			case BlockCompressionFormat::BC7: return DXGI_FORMAT_BC7_UNORM;
+			default: return 0;
+			}
+		}
+
+		BlockCompressionFormat DXGIFormatToFormat(glm::uint dxgiFormat)
+		{
+			switch (dxgiFormat)
+			{
+			case DXGI_FORMAT_BC4_UNORM: return BlockCompressionFormat::BC4;
+			case DXGI_FORMAT_BC5_UNORM: return BlockCompressionFormat::BC5;
+			case DXGI_FORMAT_BC6H_UF16: return BlockCompressionFormat::BC6H;
+			case DXGI_FORMAT_BC7_UNORM: return BlockCompressionFormat::BC7;
+			default: return BlockCompressionFormat::NONE;
+			}
+		}
+
+		MipGenerationSettings GetMipGenerationSettings(TextureUsage usage)
+		{
+			MipGenerationSettings settings = {};
+			switch (usage)
+			{
+			case TextureUsage::COLOR:
+				settings.sRGB = true;
+				break;
+			case TextureUsage::NORMAL:
+				settings.normalMap = true;
+				break;
+			case TextureUsage::HDR:
+				// Sharper filters ring visibly around very bright texels, like the sun
+				settings.filter = MipFilter::BOX;
+				break;
+			default:
+				break;
+			}
+			return settings;
+		}
+
+		// Compresses every level in turn, appending them to data
+		template<typename T>
+		void CompressMipChain(BlockCompressionFormat format, const std::vector<std::vector<T>>& levels, glm::uint width, glm::uint height, std::vector<unsigned char>& data)
+		{
+			for (glm::uint mip = 0; mip < (glm::uint)levels.size(); ++mip)
+			{
+				const glm::uint mipWidth = std::max(width >> mip, 1u);
+				const glm::uint mipHeight = std::max(height >> mip, 1u);
+
+				const size_t offset = data.size();
+				data.resize(offset + GetBlockCompressedImageSize(format, mipWidth, mipHeight));
+				CompressImage(format, levels[mip].data(), mipWidth, mipHeight, data.data() + offset);
+			}
+		}
+	} // namespace
+
+	BlockCompressionFormat GetCookedTextureFormat(TextureUsage usage)
+	{
+		switch (usage)
+		{
+		case TextureUsage::COLOR: return BlockCompressionFormat::BC7;
+		case TextureUsage::NORMAL: return BlockCompressionFormat::BC5;
+		case TextureUsage::SINGLE_CHANNEL: return BlockCompressionFormat::BC4;
+		case TextureUsage::HDR: return BlockCompressionFormat::BC6H;
+		case TextureUsage::ORM: return BlockCompressionFormat::BC7;
+		default: return BlockCompressionFormat::NONE;
+		}
+	}
+
+	const glm::uint CookedTexture::MAGIC = 0x58455446; // "FTEX" in little-endian
+	const glm::uint CookedTexture::VERSION = 2; // Increment whenever cooked files' contents change
+	const std::string CookedTexture::COOKED_TEXTURE_DIRECTORY = RESOURCE_LOCATION + "textures/cooked/";
+
+	CookedTexture::CookedTexture()
+	{
+	}
+
+	CookedTexture::~CookedTexture()
+	{
+		Unload();
+	}
+
+	bool CookedTexture::CreateKey(const std::string& sourceFilePath, TextureUsage usage, bool flipVertically, Key& key)
+	{
+		struct stat fileStat;
+		if (stat(sourceFilePath.c_str(), &fileStat) != 0)
+		{
+			return false;
+		}
+
+		key.sourceFilePath = sourceFilePath;
+		key.sourceModifiedTime = (glm::uint64)fileStat.st_mtime;
+		key.usage = usage;
+		key.flipVertically = flipVertically;
+
+		return true;
+	}
+
+	bool CookedTexture::CreatePackedKey(const std::string* sourceFilePaths, glm::uint sourceCount, TextureUsage usage, bool flipVertically, Key& key)
+	{
+		std::string firstFilePath;
+		std::string allFilePaths;
+		glm::uint64 latestModifiedTime = 0;
+		bool anyExist = false;
+		for (glm::uint i = 0; i < sourceCount; ++i)
+		{
+			// Empty entries still separate the others, so the same files in different channels hash differently
+			allFilePaths += sourceFilePaths[i] + "\n";
+
+			struct stat fileStat;
+			if (sourceFilePaths[i].empty() || stat(sourceFilePaths[i].c_str(), &fileStat) != 0)
+			{
+				continue;
+			}
+
+			if (!anyExist)
+			{
+				firstFilePath = sourceFilePaths[i];
+				anyExist = true;
+			}
+			latestModifiedTime = std::max(latestModifiedTime, (glm::uint64)fileStat.st_mtime);
+		}
+
+		if (!anyExist)
+		{
+			return false;
+		}
+
+		char suffix[16];
+		snprintf(suffix, sizeof(suffix), ".%08x", CookedMesh::HashString(allFilePaths));
+
+		key.sourceFilePath = firstFilePath + suffix;
+		key.sourceModifiedTime = latestModifiedTime;
+		key.usage = usage;
+		key.flipVertically = flipVertically;
+
+		return true;
+	}
+
+	bool CookedTexture::Save(const Key& key, const void* pixels, glm::uint width, glm::uint height, glm::uint channelCount)
+	{
+		const BlockCompressionFormat format = GetCookedTextureFormat(key.usage);
+		if (format == BlockCompressionFormat::NONE || !pixels || channelCount == 0 || channelCount > 4)
+		{
+			return false;
+		}
+
+		if (width == 0 || height == 0 || (width % 4) != 0 || (height % 4) != 0)
+		{
+			std::string fileName = key.sourceFilePath;
+			StripLeadingDirectories(fileName);
+			Logger::LogWarning("Not cooking " + fileName + ", block compressed textures' dimensions must be multiples of 4");
+			return false;
+		}
+
+		const size_t pixelCount = (size_t)width * height;
+		const MipGenerationSettings mipSettings = GetMipGenerationSettings(key.usage);
+
+		// The mip generator & encoders always read four channels
+		std::vector<unsigned char> data;
+		glm::uint mipCount;
+		if (format == BlockCompressionFormat::BC6H)
+		{
+			const float* src = (const float*)pixels;
+			std::vector<float> image(pixelCount * 4, 1.0f);
+			for (size_t i = 0; i < pixelCount; ++i)
+			{
+				memcpy(&image[i * 4], &src[i * channelCount], sizeof(float) * std::min(channelCount, 3u));
+			}
+
+			std::vector<std::vector<float>> levels;
+			GenerateMipChain(image.data(), width, height, mipSettings, levels);
+			CompressMipChain(format, levels, width, height, data);
+			mipCount = (glm::uint)levels.size();
+		}
+		else
+		{
+			const unsigned char* src = (const unsigned char*)pixels;
+			std::vector<unsigned char> image(pixelCount * 4, 255);
+			for (size_t i = 0; i < pixelCount; ++i)
+			{
+				memcpy(&image[i * 4], &src[i * channelCount], channelCount);
+			}
+
+			std::vector<std::vector<unsigned char>> levels;
+			GenerateMipChain(image.data(), width, height, mipSettings, levels);
+			CompressMipChain(format, levels, width, height, data);
+			mipCount = (glm::uint)levels.size();
+		}
+
+#ifdef _WIN32
+		_mkdir(COOKED_TEXTURE_DIRECTORY.c_str());
+#else
+		mkdir(COOKED_TEXTURE_DIRECTORY.c_str(), 0755);
+#endif
+
+		// Written to a temporary file first and then moved into place, so cooked textures
+		// being loaded by other threads at the same time are never partially written
+		const std::string cookedFilePath = GetCookedFilePath(key);
+		const std::string tempFilePath = cookedFilePath + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+
+		std::ofstream file(tempFilePath, std::ios::out | std::ios::binary | std::ios::trunc);
+		if (!file.is_open())
+		{
+			Logger::LogWarning("Failed to write cooked texture " + cookedFilePath);
+			return false;
+		}
+
+		Header header = {};
+		header.fileMagic = DDS_MAGIC;
+		header.size = 124;
+		header.flags = 0x1 | 0x2 | 0x4 | 0x1000 | 0x20000 | 0x80000; // CAPS | HEIGHT | WIDTH | PIXELFORMAT | MIPMAPCOUNT | LINEARSIZE
+		header.height = height;
+		header.width = width;
+		header.pitchOrLinearSize = (glm::uint)GetBlockCompressedImageSize(format, width, height);
+		header.depth = 1;
+		header.mipMapCount = mipCount;
+		header.magic = MAGIC;
+		header.version = VERSION;
+		header.sourceModifiedTimeLow = (glm::uint)(key.sourceModifiedTime & 0xFFFFFFFF);
+		header.sourceModifiedTimeHigh = (glm::uint)(key.sourceModifiedTime >> 32);
+		header.sourcePathHash = CookedMesh::HashString(key.sourceFilePath);
+		header.cookFlags = GetCookFlags(key);
+		header.pixelFormat.size = sizeof(PixelFormat);
+		header.pixelFormat.flags = 0x4; // FOURCC
+		header.pixelFormat.fourCC = DDS_FOURCC_DX10;
+		header.caps = 0x1000 | 0x8 | 0x400000; // TEXTURE | COMPLEX | MIPMAP
+		header.dxgiFormat = FormatToDXGIFormat(format);
+		header.resourceDimension = 3; // TEXTURE2D
+		header.arraySize = 1;
+
+		file.write((const char*)&header, sizeof(header));
+		file.write((const char*)data.data(), data.size());
+
+		const bool written = file.good();
+		file.close();
+
+		if (!written)
+		{
+			Logger::LogWarning("Failed to write cooked texture " + cookedFilePath);
+			remove(tempFilePath.c_str());
+			return false;
+		}
+
+#ifdef _WIN32
+		const bool moved = (MoveFileExA(tempFilePath.c_str(), cookedFilePath.c_str(), MOVEFILE_REPLACE_EXISTING) != 0);
+#else
+		const bool moved = (rename(tempFilePath.c_str(), cookedFilePath.c_str()) == 0);
+#endif
+		if (!moved)
+		{
+			remove(tempFilePath.c_str());
+			return false;
+		}
+
+		return true;
+	}
+
+	bool CookedTexture::Cook(const Key& key)
+	{
+		if (key.usage == TextureUsage::HDR)
+		{
+			HDRImage image = {};
+			if (!image.Load(key.sourceFilePath, key.flipVertically))
+			{
+				return false;
+			}
+
+			const bool saved = Save(key, image.pixels, (glm::uint)image.width, (glm::uint)image.height, 4);
+			image.Free();
+			return saved;
+		}
+
+		GLFWimage image = LoadGLFWimage(key.sourceFilePath, true, key.flipVertically);
+		if (!image.pixels)
+		{
+			return false;
+		}
+
+		const bool saved = Save(key, image.pixels, (glm::uint)image.width, (glm::uint)image.height, 4);
+		DestroyGLFWimage(image);
+		return saved;
+	}
+
+	bool CookedTexture::Load(const Key& key)
+	{
+		Unload();
+
+		const std::string cookedFilePath = GetCookedFilePath(key);
+		if (!m_File.Open(cookedFilePath))
+		{
+			return false;
+		}
+
+		const Header* header = (const Header*)m_File.GetData();
+
+		bool valid =
+			m_File.GetSize() >= sizeof(Header) &&
+			header->fileMagic == DDS_MAGIC &&
+			header->magic == MAGIC &&
+			header->version == VERSION &&
+			header->sourceModifiedTimeLow == (glm::uint)(key.sourceModifiedTime & 0xFFFFFFFF) &&
+			header->sourceModifiedTimeHigh == (glm::uint)(key.sourceModifiedTime >> 32) &&
+			header->sourcePathHash == CookedMesh::HashString(key.sourceFilePath) &&
+			header->cookFlags == GetCookFlags(key) &&
+			header->pixelFormat.fourCC == DDS_FOURCC_DX10 &&
+			DXGIFormatToFormat(header->dxgiFormat) == GetCookedTextureFormat(key.usage) &&
+			header->mipMapCount > 0 && header->mipMapCount <= 32;
+
+		if (valid)
+		{
+			m_Header = header;
+			m_Format = DXGIFormatToFormat(header->dxgiFormat);
+			valid = (m_File.GetSize() == sizeof(Header) + GetDataSize());
+		}
+
+		if (!valid)
+		{
+			// Stale or corrupt, will be overwritten once the source has been cooked again
+			m_Header = nullptr;
+			m_Format = BlockCompressionFormat::NONE;
+			m_File.Close();
+			return false;
+		}
+
+		return true;
+	}
+
+	void CookedTexture::Unload()
+	{
+		m_File.Close();
+		m_Header = nullptr;
+		m_Format = BlockCompressionFormat::NONE;
+	}
+
+	bool CookedTexture::IsLoaded() const
+	{
+		return m_Header != nullptr;
+	}
+
+	BlockCompressionFormat CookedTexture::GetFormat() const
+	{
+		return m_Format;
+	}
+
+	glm::uint CookedTexture::GetWidth() const
+	{
+		return m_Header->width;
+	}
+
+	glm::uint CookedTexture::GetHeight() const
+	{
+		return m_Header->height;
+	}
+
+	glm::uint CookedTexture::GetMipCount() const
+	{
+		return m_Header->mipMapCount;
+	}
+
+	glm::uint CookedTexture::GetMipWidth(glm::uint mipLevel) const
+	{
+		return std::max(m_Header->width >> mipLevel, 1u);
+	}
+
+	glm::uint CookedTexture::GetMipHeight(glm::uint mipLevel) const
+	{
+		return std::max(m_Header->height >> mipLevel, 1u);
+	}
+
+	const void* CookedTexture::GetMipData(glm::uint mipLevel) const
+	{
+		size_t offset = sizeof(Header);
+		for (glm::uint i = 0; i < mipLevel; ++i)
+		{
+			offset += GetMipSize(i);
+		}
+		return (const char*)m_File.GetData() + offset;
+	}
+
+	glm::uint CookedTexture::GetMipSize(glm::uint mipLevel) const
+	{
+		return (glm::uint)GetBlockCompressedImageSize(m_Format, GetMipWidth(mipLevel), GetMipHeight(mipLevel));
+	}
+
+	glm::uint CookedTexture::GetDataSize() const
+	{
+		glm::uint size = 0;
+		for (glm::uint i = 0; i < m_Header->mipMapCount; ++i)
+		{
+			size += GetMipSize(i);
+		}
+		return size;
+	}
+
+	std::string CookedTexture::GetCookedFilePath(const Key& key)
+	{
+		std::string fileName = key.sourceFilePath;
+		StripLeadingDirectories(fileName);
+
+		// Include the path & flags so that identically named files and differently cooked
+		// versions of the same file don't overwrite each other
+		char suffix[32];
+		snprintf(suffix, sizeof(suffix), "_%08x_%02x", CookedMesh::HashString(key.sourceFilePath), GetCookFlags(key));
+
+		return COOKED_TEXTURE_DIRECTORY + fileName + suffix + ".dds";
+	}
+
+	glm::uint CookedTexture::GetCookFlags(const Key& key)
+	{
+		return (glm::uint)key.usage | (key.flipVertically ? 0x80 : 0);
+	}
+} // namespace flex
@@ -12,6 +12,7 @@
 #include "Scene/SceneManager.hpp"
 #include "Scene/Scenes/Scene_02.hpp"
 #include "Scene/Scenes/TestScene.hpp"
+#include "ThreadPool.hpp"
 #include "Typedefs.hpp"
 
 namespace flex
@@ -73,6 +74,7 @@ namespace flex
 		m_GameContext.camera = m_DefaultCamera;
 
 		m_GameContext.sceneManager = new SceneManager();
+		m_GameContext.threadPool = new ThreadPool();
 
 		LoadDefaultScenes();
 
@@ -142,6 +144,7 @@ namespace flex
 
 		if (m_GameContext.sceneManager) m_GameContext.sceneManager->DestroyAllScenes(m_GameContext);
 		SafeDelete(m_GameContext.sceneManager);
+		SafeDelete(m_GameContext.threadPool);
 		SafeDelete(m_GameContext.inputManager);
 		SafeDelete(m_DefaultCamera);
 
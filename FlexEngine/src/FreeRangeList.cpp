@@ -0,0 +1,107 @@
+#include "stdafx.hpp"
+
+#include "FreeRangeList.hpp"
+
+#include <cassert>
+#include <iterator>
+
+namespace flex
+{
+	FreeRangeList::FreeRangeList()
+	{
+	}
+
+	void FreeRangeList::Reset(glm::uint capacity)
+	{
+		m_FreeRanges.clear();
+		if (capacity > 0)
+		{
+			m_FreeRanges.insert({ 0, capacity });
+		}
+		m_Capacity = capacity;
+		m_FreeCount = capacity;
+	}
+
+	bool FreeRangeList::Allocate(glm::uint count, glm::uint& outOffset)
+	{
+		if (count == 0 || count > m_FreeCount)
+		{
+			return false;
+		}
+
+		for (auto iter = m_FreeRanges.begin(); iter != m_FreeRanges.end(); ++iter)
+		{
+			if (iter->second < count)
+			{
+				continue;
+			}
+
+			outOffset = iter->first;
+
+			// The remainder stays free, starting right after the allocation
+			const glm::uint remainingCount = iter->second - count;
+			m_FreeRanges.erase(iter);
+			if (remainingCount > 0)
+			{
+				m_FreeRanges.insert({ outOffset + count, remainingCount });
+			}
+
+			m_FreeCount -= count;
+			return true;
+		}
+
+		return false;
+	}
+
+	void FreeRangeList::Free(glm::uint offset, glm::uint count)
+	{
+		if (count == 0)
+		{
+			return;
+		}
+
+		assert(offset + count <= m_Capacity);
+
+		auto next = m_FreeRanges.lower_bound(offset);
+		assert(next == m_FreeRanges.end() || offset + count <= next->first); // Overlaps a range which is already free
+
+		glm::uint mergedOffset = offset;
+		glm::uint mergedCount = count;
+
+		if (next != m_FreeRanges.begin())
+		{
+			auto previous = std::prev(next);
+			assert(previous->first + previous->second <= offset); // Overlaps a range which is already free
+			if (previous->first + previous->second == offset)
+			{
+				mergedOffset = previous->first;
+				mergedCount += previous->second;
+				m_FreeRanges.erase(previous);
+			}
+		}
+
+		if (next != m_FreeRanges.end() && offset + count == next->first)
+		{
+			mergedCount += next->second;
+			m_FreeRanges.erase(next);
+		}
+
+		m_FreeRanges.insert({ mergedOffset, mergedCount });
+		m_FreeCount += count;
+	}
+
+	glm::uint FreeRangeList::GetCapacity() const
+	{
+		return m_Capacity;
+	}
+
+	glm::uint FreeRangeList::GetFreeCount() const
+	{
+		return m_FreeCount;
+	}
+
+	glm::uint FreeRangeList::GetFreeRangeCount() const
+	{
+		return (glm::uint)m_FreeRanges.size();
+	}
+} // namespace flex
@@ -8,6 +8,8 @@
 
 #include "stb_image.h"
 
+#include "CookedTexture.hpp"
+#include "Graphics/TextureLoader.hpp"
 #include "Helpers.hpp"
 
 namespace flex
@@ -101,6 +103,26 @@ namespace flex
 
 		bool GenerateHDRGLTextureWithParams(glm::uint& textureID, const std::string& filePath, bool flipVertically, bool generateMipMaps, int sWrap, int tWrap, int minFilter, int magFilter)
 		{
+			CookedTexture cookedTexture;
+			CookedTexture::Key cookedKey;
+			if (IsBlockCompressionFormatSupported(BlockCompressionFormat::BC6H) &&
+				CookedTexture::CreateKey(filePath, TextureUsage::HDR, flipVertically, cookedKey) &&
+				cookedTexture.Load(cookedKey))
+			{
+				glGenTextures(1, &textureID);
+				UploadCookedGLTexture(textureID, cookedTexture);
+
+				glBindTexture(GL_TEXTURE_2D, textureID);
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, sWrap);
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, tWrap);
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, minFilter);
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, magFilter);
+				CheckGLErrorMessages();
+				glBindTexture(GL_TEXTURE_2D, 0);
+
+				return true;
+			}
+
 			HDRImage image = {};
 			if (!image.Load(filePath, flipVertically))
 			{
@@ -137,6 +159,79 @@ namespace flex
 			return true;
 		}
 
+		bool GenerateGLTexture_Placeholder(glm::uint& textureID, const glm::vec3& color)
+		{
+			const unsigned char pixel[3] = {
+				(unsigned char)(glm::clamp(color.r, 0.0f, 1.0f) * 255.0f + 0.5f),
+				(unsigned char)(glm::clamp(color.g, 0.0f, 1.0f) * 255.0f + 0.5f),
+				(unsigned char)(glm::clamp(color.b, 0.0f, 1.0f) * 255.0f + 0.5f)
+			};
+
+			glGenTextures(1, &textureID);
+			glBindTexture(GL_TEXTURE_2D, textureID);
+			CheckGLErrorMessages();
+
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, 1, 1, 0, GL_RGB, GL_UNSIGNED_BYTE, pixel);
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+			CheckGLErrorMessages();
+
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			CheckGLErrorMessages();
+
+			glBindTexture(GL_TEXTURE_2D, 0);
+
+			return true;
+		}
+
+		bool IsBlockCompressionFormatSupported(BlockCompressionFormat format)
+		{
+			switch (format)
+			{
+			case BlockCompressionFormat::BC4:
+			case BlockCompressionFormat::BC5:
+				return true;
+			case BlockCompressionFormat::BC6H:
+			case BlockCompressionFormat::BC7:
+				return GLAD_GL_VERSION_4_2 != 0;
+			default:
+				return false;
+			}
+		}
+
+		void UploadCookedGLTexture(glm::uint textureID, const CookedTexture& cookedTexture)
+		{
+			GLenum internalFormat;
+			switch (cookedTexture.GetFormat())
+			{
+			case BlockCompressionFormat::BC4: internalFormat = GL_COMPRESSED_RED_RGTC1; break;
+			case BlockCompressionFormat::BC5: internalFormat = GL_COMPRESSED_RG_RGTC2; break;
+			case BlockCompressionFormat::BC6H: internalFormat = GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT; break;
+			case BlockCompressionFormat::BC7: internalFormat = GL_COMPRESSED_RGBA_BPTC_UNORM; break;
+			default:
+				Logger::LogError("Unhandled block compression format passed to UploadCookedGLTexture");
+				return;
+			}
+
+			glBindTexture(GL_TEXTURE_2D, textureID);
+			CheckGLErrorMessages();
+
+			const glm::uint mipCount = cookedTexture.GetMipCount();
+			for (glm::uint mip = 0; mip < mipCount; ++mip)
+			{
+				glCompressedTexImage2D(GL_TEXTURE_2D, mip, internalFormat, cookedTexture.GetMipWidth(mip), cookedTexture.GetMipHeight(mip), 0,
+					cookedTexture.GetMipSize(mip), cookedTexture.GetMipData(mip));
+			}
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, mipCount - 1);
+			CheckGLErrorMessages();
+
+			glBindTexture(GL_TEXTURE_2D, 0);
+		}
+
 		bool GenerateGLCubemap(GLCubemapCreateInfo& createInfo)
 		{
 			bool success = true;
@@ -174,16 +269,23 @@ namespace flex
 			}
 			else // Load in 6 images to the generated cubemap
 			{
+				// Start decoding every face before uploading any so they're decoded in parallel
+				std::array<std::future<DecodedImage>, 6> faces;
+				for (size_t i = 0; i < createInfo.filePaths.size(); ++i)
+				{
+					faces[i] = DecodeImageAsync(createInfo.threadPool, createInfo.filePaths[i], 3, false);
+				}
+
 				for (size_t i = 0; i < createInfo.filePaths.size(); ++i)
 				{
-					GLFWimage image = LoadGLFWimage(createInfo.filePaths[i]);
+					DecodedImage image = faces[i].get();
 
 					if (image.pixels)
 					{
 						glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, internalFormat, image.width, image.height, 0, format, type, image.pixels);
 						CheckGLErrorMessages();
 
-						DestroyGLFWimage(image);
+						image.Free();
 					}
 					else
 					{
@@ -277,6 +379,67 @@ namespace flex
 			return success;
 		}
 
+		bool ReadGLSLFile(const std::string& filePath, std::vector<char>& outCode, glm::uint includeDepth)
+		{
+			std::vector<char> fileContents;
+			if (!ReadFile(filePath, fileContents))
+			{
+				return false;
+			}
+
+			if (includeDepth == 0)
+			{
+				outCode.clear();
+			}
+
+			const size_t finalSlash = filePath.find_last_of("/\\");
+			const std::string directory = (finalSlash == std::string::npos) ? "" : filePath.substr(0, finalSlash + 1);
+
+			bool success = true;
+			size_t lineStart = 0;
+			while (lineStart < fileContents.size())
+			{
+				size_t lineEnd = lineStart;
+				while (lineEnd < fileContents.size() && fileContents[lineEnd] != '\n') ++lineEnd;
+				if (lineEnd < fileContents.size()) ++lineEnd; // Keep the new line
+
+				const std::string line(fileContents.data() + lineStart, lineEnd - lineStart);
+				lineStart = lineEnd;
+
+				const size_t directiveStart = line.find_first_not_of(" \t");
+				if (directiveStart == std::string::npos || line.compare(directiveStart, 8, "#include") != 0)
+				{
+					outCode.insert(outCode.end(), line.begin(), line.end());
+					continue;
+				}
+
+				const size_t nameStart = line.find('"', directiveStart);
+				const size_t nameEnd = (nameStart == std::string::npos) ? std::string::npos : line.find('"', nameStart + 1);
+				if (nameEnd == std::string::npos)
+				{
+					Logger::LogError("Malformed #include in " + filePath + ": " + line);
+					success = false;
+					continue;
+				}
+
+				if (includeDepth >= MAX_GLSL_INCLUDE_DEPTH)
+				{
+					Logger::LogError("#include nested too deeply in " + filePath + ", is a file including itself?");
+					success = false;
+					continue;
+				}
+
+				const std::string includePath = directory + line.substr(nameStart + 1, nameEnd - nameStart - 1);
+				if (!ReadGLSLFile(includePath, outCode, includeDepth + 1))
+				{
+					success = false;
+				}
+				outCode.push_back('\n');
+			}
+
+			return success;
+		}
+
 		bool LoadGLShaders(glm::uint program, GLShader& shader)
 		{
 			CheckGLErrorMessages();
@@ -295,13 +458,13 @@ namespace flex
 			StripLeadingDirectories(fragFileName);
 			Logger::LogInfo("Loading shaders " + vertFileName + " & " + fragFileName);
 
-			if (!ReadFile(shader.shader.vertexShaderFilePath, shader.shader.vertexShaderCode))
+			if (!ReadGLSLFile(shader.shader.vertexShaderFilePath, shader.shader.vertexShaderCode))
 			{
 				Logger::LogError("Could not find vertex shader " + shader.shader.name);
 			}
 			shader.shader.vertexShaderCode.push_back('\0'); // Signal end of string with terminator character
 
-			if (!ReadFile(shader.shader.fragmentShaderFilePath, shader.shader.fragmentShaderCode))
+			if (!ReadGLSLFile(shader.shader.fragmentShaderFilePath, shader.shader.fragmentShaderCode))
 			{
 				Logger::LogError("Could not find fragment shader " + shader.shader.name);
 			}
@@ -398,6 +561,7 @@ namespace flex
 			else if (type == Renderer::Type::UNSIGNED_INT) glType = GL_UNSIGNED_INT;
 			else if (type == Renderer::Type::FLOAT) glType = GL_FLOAT;
 			else if (type == Renderer::Type::DOUBLE) glType = GL_DOUBLE;
+			else if (type == Renderer::Type::HALF_FLOAT) glType = GL_HALF_FLOAT;
 			else Logger::LogError("Unhandled Type passed to GLRenderer: " + std::to_string((int)type));
 
 			return glType;
@@ -456,6 +620,81 @@ namespace flex
 			default: return GL_FALSE;
 			}
 		}
+
+		void* GetIndexBufferOffset(GLenum indexType, glm::uint firstIndex)
+		{
+			const size_t indexSize = (indexType == GL_UNSIGNED_SHORT) ? sizeof(glm::uint16) : sizeof(glm::uint);
+			return (void*)(firstIndex * indexSize);
+		}
+
+		void RadixSortDrawList(std::vector<DrawListEntry>& entries, std::vector<DrawListEntry>& scratch)
+		{
+			const size_t count = entries.size();
+			if (count < 2) return;
+
+			scratch.resize(count);
+
+			// Count every byte's histogram in one read of the keys
+			glm::uint histograms[8][256] = {};
+			for (const DrawListEntry& entry : entries)
+			{
+				for (glm::uint byte = 0; byte < 8; ++byte)
+				{
+					++histograms[byte][(entry.sortKey >> (byte * 8)) & 0xFF];
+				}
+			}
+
+			std::vector<DrawListEntry>* src = &entries;
+			std::vector<DrawListEntry>* dst = &scratch;
+			for (glm::uint byte = 0; byte < 8; ++byte)
+			{
+				glm::uint* histogram = histograms[byte];
+
+				// Most keys share their upper bytes (few passes & shaders), nothing would move
+				if (histogram[((*src)[0].sortKey >> (byte * 8)) & 0xFF] == count)
+				{
+					continue;
+				}
+
+				glm::uint offset = 0;
+				for (glm::uint bucket = 0; bucket < 256; ++bucket)
+				{
+					const glm::uint bucketCount = histogram[bucket];
+					histogram[bucket] = offset;
+					offset += bucketCount;
+				}
+
+				for (const DrawListEntry& entry : *src)
+				{
+					(*dst)[histogram[(entry.sortKey >> (byte * 8)) & 0xFF]++] = entry;
+				}
+
+				std::swap(src, dst);
+			}
+
+			if (src != &entries)
+			{
+				entries.swap(scratch);
+			}
+		}
+
+		bool SelectVAOForShader(GLRenderObject& renderObject, ShaderID previousShaderID, ShaderID shaderID,
+			const std::function<glm::uint(glm::uint poolIndex, ShaderID shaderID)>& getPoolVAO)
+		{
+			if (shaderID == previousShaderID)
+			{
+				return false;
+			}
+
+			if (renderObject.geometryPool != INVALID_GEOMETRY_POOL)
+			{
+				// Pool VAOs are shared with every other object using the previous shader, so can't be re-described in place
+				renderObject.VAO = getPoolVAO(renderObject.geometryPool, shaderID);
+			}
+
+			// Attribute locations differ between shaders
+			return true;
+		}
 } // namespace gl
 } // namespace flex
 
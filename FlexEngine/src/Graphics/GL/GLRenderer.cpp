@@ -4,10 +4,12 @@
 #include "Graphics/GL/GLRenderer.hpp"
 
 #include <array>
+#include <set>
 #include <algorithm>
 #include <string>
 #include <utility>
 #include <functional>
+#include <chrono>
 
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -37,6 +39,16 @@ namespace flex
 
 			CheckGLErrorMessages();
 
+			glGenBuffers(1, &m_PerFrameUBO);
+			glBindBuffer(GL_UNIFORM_BUFFER, m_PerFrameUBO);
+			glBufferData(GL_UNIFORM_BUFFER, sizeof(PerFrameUBO), nullptr, GL_DYNAMIC_DRAW);
+			glBindBuffer(GL_UNIFORM_BUFFER, 0);
+			glBindBufferBase(GL_UNIFORM_BUFFER, PER_FRAME_UBO_BINDING, m_PerFrameUBO);
+			CheckGLErrorMessages();
+
+			CreatePerObjectBuffer(MIN_PER_OBJECT_SSBO_CAPACITY);
+			CreateIndirectDrawBuffer(MIN_INDIRECT_DRAW_BUFFER_CAPACITY);
+
 			glEnable(GL_DEPTH_TEST);
 			glDepthFunc(GL_LEQUAL);
 			CheckGLErrorMessages();
@@ -207,19 +219,14 @@ namespace flex
 			spriteQuadCreateInfo.transform = &m_SpriteQuadTransform;
 			spriteQuadCreateInfo.enableCulling = false;
 			m_SpriteQuadRenderID = InitializeRenderObject(gameContext, &spriteQuadCreateInfo);
-			GetRenderObject(m_SpriteQuadRenderID)->visible = false;
+			SetRenderObjectVisible(m_SpriteQuadRenderID, false);
 
 			m_SpriteQuadVertexBufferData.DescribeShaderVariables(this, m_SpriteQuadRenderID);
 
 			DrawSpriteQuad(gameContext, m_LoadingTextureHandle.id, m_SpriteMatID);
 			SwapBuffers(gameContext);
 
-			if (m_BRDFTextureHandle.id == 0)
-			{
-				Logger::LogInfo("Generating BRDF LUT");
-				GenerateGLTexture_Empty(m_BRDFTextureHandle.id, m_BRDFTextureSize, false, m_BRDFTextureHandle.internalFormat, m_BRDFTextureHandle.format, m_BRDFTextureHandle.type);
-				GenerateBRDFLUT(gameContext, m_BRDFTextureHandle.id, m_BRDFTextureSize);
-			}
+			CreateBRDFLUT(gameContext);
 		}
 
 		void GLRenderer::DrawSpriteQuad(const GameContext& gameContext, glm::uint textureHandle, MaterialID materialID, bool flipVertically)
@@ -232,7 +239,7 @@ namespace flex
 			GLMaterial* spriteMaterial = &m_Materials[spriteRenderObject->materialID];
 			GLShader* spriteShader = &m_Shaders[spriteMaterial->material.shaderID];
 
-			glUseProgram(spriteShader->program);
+			m_StateCache.UseProgram(spriteShader->program);
 			CheckGLErrorMessages();
 
 			float verticalScale = flipVertically ? -1.0f : 1.0f;
@@ -250,31 +257,29 @@ namespace flex
 			glBindFramebuffer(GL_FRAMEBUFFER, 0);
 			CheckGLErrorMessages();
 
-			glBindVertexArray(spriteRenderObject->VAO);
+			m_StateCache.BindVertexArray(spriteRenderObject->VAO);
 			CheckGLErrorMessages();
-			glBindBuffer(GL_ARRAY_BUFFER, spriteRenderObject->VBO);
+			m_StateCache.BindArrayBuffer(spriteRenderObject->VBO);
 			CheckGLErrorMessages();
 
-			glActiveTexture(GL_TEXTURE0);
-			glBindTexture(GL_TEXTURE_2D, textureHandle);
+			m_StateCache.BindTexture(0, GL_TEXTURE_2D, textureHandle);
 			CheckGLErrorMessages();
 
 			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 			CheckGLErrorMessages();
 
-			if (spriteRenderObject->enableCulling) glEnable(GL_CULL_FACE);
-			else glDisable(GL_CULL_FACE);
+			m_StateCache.SetCullingEnabled(spriteRenderObject->enableCulling);
 
-			glCullFace(spriteRenderObject->cullFace);
+			m_StateCache.CullFace(spriteRenderObject->cullFace);
 			CheckGLErrorMessages();
 
-			glDepthFunc(spriteRenderObject->depthTestReadFunc);
+			m_StateCache.DepthFunc(spriteRenderObject->depthTestReadFunc);
 			CheckGLErrorMessages();
 
-			glDepthMask(spriteRenderObject->depthWriteEnable);
+			m_StateCache.DepthMask(spriteRenderObject->depthWriteEnable);
 			CheckGLErrorMessages();
 
-			glDrawArrays(spriteRenderObject->topology, 0, (GLsizei)spriteRenderObject->vertexBufferData->VertexCount);
+			glDrawArrays(spriteRenderObject->topology, 0, (GLsizei)spriteRenderObject->vertexCount);
 			CheckGLErrorMessages();
 		}
 
@@ -282,6 +287,26 @@ namespace flex
 		{
 			CheckGLErrorMessages();
 
+			for (PendingTextureUpload& pendingUpload : m_PendingTextureUploads)
+			{
+				DecodedImage image = pendingUpload.image.get();
+				image.Free();
+			}
+			m_PendingTextureUploads.clear();
+
+			if (m_TextureUploadPBOs[0] != 0)
+			{
+				glDeleteBuffers(NUM_TEXTURE_UPLOAD_PBOS, m_TextureUploadPBOs);
+			}
+
+			if (m_PerFrameUBO != 0)
+			{
+				glDeleteBuffers(1, &m_PerFrameUBO);
+			}
+
+			DestroyPerObjectBuffer();
+			DestroyIndirectDrawBuffer();
+
 			if (m_1x1_NDC_QuadVertexBufferData.pDataStart)
 			{
 				m_1x1_NDC_QuadVertexBufferData.Destroy();
@@ -301,6 +326,8 @@ namespace flex
 			m_RenderObjects.clear();
 			CheckGLErrorMessages();
 
+			DestroyGeometryPools();
+
 			m_gBufferQuadVertexBufferData.Destroy();
 			m_SpriteQuadVertexBufferData.Destroy();
 
@@ -309,8 +336,6 @@ namespace flex
 
 		MaterialID GLRenderer::InitializeMaterial(const GameContext& gameContext, const MaterialCreateInfo* createInfo)
 		{
-			UNREFERENCED_PARAMETER(gameContext);
-
 			CheckGLErrorMessages();
 
 			MaterialID matID = GetNextAvailableMaterialID();
@@ -333,6 +358,14 @@ namespace flex
 				}
 			}
 
+			// Materials with more than one of these maps sample them packed into a single texture instead, when their shader has a variant that can
+			const int packableMapCount = (createInfo->generateAOSampler ? 1 : 0) + (createInfo->generateRoughnessSampler ? 1 : 0) + (createInfo->generateMetallicSampler ? 1 : 0);
+			ShaderID ormShaderID;
+			if (packableMapCount > 1 && GetShaderID(createInfo->shaderName + "_orm", ormShaderID))
+			{
+				mat.material.shaderID = ormShaderID;
+			}
+
 			glUseProgram(m_Shaders[mat.material.shaderID].program);
 			CheckGLErrorMessages();
 
@@ -359,6 +392,8 @@ namespace flex
 				{ "constAO",						&mat.uniformIDs.constAO },
 				{ "hdrEquirectangularSampler",		&mat.uniformIDs.hdrEquirectangularSampler },
 				{ "enableIrradianceSampler",		&mat.uniformIDs.enableIrradianceSampler },
+				{ "enableIrradianceSH",				&mat.uniformIDs.enableIrradianceSH },
+				{ "irradianceSH",					&mat.uniformIDs.irradianceSH },
 				{ "verticalScale",					&mat.uniformIDs.verticalScale },
 			};
 
@@ -420,29 +455,41 @@ namespace flex
 			mat.material.enableIrradianceSampler = createInfo->enableIrradianceSampler;
 			mat.material.generateIrradianceSampler = createInfo->generateIrradianceSampler;
 			mat.material.irradianceSamplerSize = createInfo->generatedIrradianceCubemapSize;
+			mat.material.generateIrradianceSH = createInfo->generateIrradianceSH && createInfo->generateIrradianceSampler;
 
 			mat.material.environmentMapPath = createInfo->environmentMapPath;
 
 			mat.material.generateReflectionProbeMaps = createInfo->generateReflectionProbeMaps;
 
+			mat.lazyEnvironmentMaps = mat.material.generateIrradianceSampler && !mat.material.generateReflectionProbeMaps && !createInfo->generateCubemapDepthBuffers;
+			mat.enableCubemapTrilinearFiltering = createInfo->enableCubemapTrilinearFiltering;
+
+			// Sampling another material's environment maps counts as using them
+			for (MaterialID environmentMaterialID : { createInfo->irradianceSamplerMatID, createInfo->prefilterMapSamplerMatID })
+			{
+				if (environmentMaterialID < m_Materials.size() && environmentMaterialID != matID &&
+					m_Materials[environmentMaterialID].lazyEnvironmentMaps && !m_Materials[environmentMaterialID].environmentMapsResident)
+				{
+					CreateEnvironmentMapTextures(environmentMaterialID);
+				}
+			}
+
 			if (m_Shaders[mat.material.shaderID].shader.needIrradianceSampler)
 			{
 				mat.irradianceSamplerID = (createInfo->irradianceSamplerMatID < m_Materials.size() ?
 					m_Materials[createInfo->irradianceSamplerMatID].irradianceSamplerID : 0);
+				mat.irradianceSourceMatID = (mat.material.generateIrradianceSampler ? matID : createInfo->irradianceSamplerMatID);
 			}
 			if (m_Shaders[mat.material.shaderID].shader.needBRDFLUT)
 			{
-				if (m_BRDFTextureHandle.id == 0)
-				{
-					GenerateGLTexture_Empty(m_BRDFTextureHandle.id, m_BRDFTextureSize, false, m_BRDFTextureHandle.internalFormat, m_BRDFTextureHandle.format, m_BRDFTextureHandle.type);
-					GenerateBRDFLUT(gameContext, m_BRDFTextureHandle.id, m_BRDFTextureSize);
-				}
+				CreateBRDFLUT(gameContext);
 				mat.brdfLUTSamplerID = m_BRDFTextureHandle.id;
 			}
 			if (m_Shaders[mat.material.shaderID].shader.needPrefilteredMap)
 			{
 				mat.prefilteredMapSamplerID = (createInfo->prefilterMapSamplerMatID < m_Materials.size() ?
 					m_Materials[createInfo->prefilterMapSamplerMatID].prefilteredMapSamplerID : 0);
+				mat.prefilteredMapSourceMatID = (createInfo->generatePrefilteredMap ? matID : createInfo->prefilterMapSamplerMatID);
 			}
 
 			mat.material.enablePrefilteredMap = createInfo->enablePrefilteredMap;
@@ -460,25 +507,37 @@ namespace flex
 				std::string textureName;
 				bool flipVertically;
 				std::function<bool(glm::uint&, const std::string&, bool, bool)> createFunction;
+				bool stream; // If true the file is decoded on a worker thread and createFunction is unused
+				glm::vec3 placeholderColor; // Sampled until a streamed texture has been uploaded
+				TextureUsage usage; // Decides which block compressed format the texture is cooked into
+				const PackedTextureSources* packedFilePaths; // When set the texture is packed from these, filepath is only its name
+			};
+
+			const PackedTextureSources ormFilePaths = {
+				createInfo->generateAOSampler ? createInfo->aoTexturePath : "",
+				createInfo->generateRoughnessSampler ? createInfo->roughnessTexturePath : "",
+				createInfo->generateMetallicSampler ? createInfo->metallicTexturePath : "",
 			};
 
 			// Samplers that need to be loaded from file
 			SamplerCreateInfo samplerCreateInfos[] =
 			{
 				{ m_Shaders[mat.material.shaderID].shader.needAlbedoSampler, mat.material.generateAlbedoSampler, &mat.albedoSamplerID, 
-				createInfo->albedoTexturePath, "albedoSampler", false, GenerateGLTexture },
+				createInfo->albedoTexturePath, "albedoSampler", false, GenerateGLTexture, true, glm::vec3(1.0f), TextureUsage::COLOR, nullptr },
 				{ m_Shaders[mat.material.shaderID].shader.needMetallicSampler, mat.material.generateMetallicSampler, &mat.metallicSamplerID, 
-				createInfo->metallicTexturePath, "metallicSampler", false,GenerateGLTexture },
+				createInfo->metallicTexturePath, "metallicSampler", false,GenerateGLTexture, true, glm::vec3(0.0f), TextureUsage::SINGLE_CHANNEL, nullptr },
 				{ m_Shaders[mat.material.shaderID].shader.needRoughnessSampler, mat.material.generateRoughnessSampler, &mat.roughnessSamplerID, 
-				createInfo->roughnessTexturePath, "roughnessSampler" ,false, GenerateGLTexture },
+				createInfo->roughnessTexturePath, "roughnessSampler" ,false, GenerateGLTexture, true, glm::vec3(1.0f), TextureUsage::SINGLE_CHANNEL, nullptr },
 				{ m_Shaders[mat.material.shaderID].shader.needAOSampler, mat.material.generateAOSampler, &mat.aoSamplerID, 
-				createInfo->aoTexturePath, "aoSampler", false,GenerateGLTexture },
+				createInfo->aoTexturePath, "aoSampler", false,GenerateGLTexture, true, glm::vec3(1.0f), TextureUsage::SINGLE_CHANNEL, nullptr },
+				{ m_Shaders[mat.material.shaderID].shader.needORMSampler, packableMapCount > 0, &mat.ormSamplerID,
+				GetPackedTextureName(ormFilePaths), "ormSampler", false, nullptr, true, glm::vec3(1.0f, 1.0f, 0.0f), TextureUsage::ORM, &ormFilePaths },
 				{ m_Shaders[mat.material.shaderID].shader.needDiffuseSampler, mat.material.generateDiffuseSampler, &mat.diffuseSamplerID, 
-				createInfo->diffuseTexturePath, "diffuseSampler", false,GenerateGLTexture },
+				createInfo->diffuseTexturePath, "diffuseSampler", false,GenerateGLTexture, true, glm::vec3(1.0f), TextureUsage::COLOR, nullptr },
 				{ m_Shaders[mat.material.shaderID].shader.needNormalSampler, mat.material.generateNormalSampler, &mat.normalSamplerID, 
-				createInfo->normalTexturePath, "normalSampler",false, GenerateGLTexture },
+				createInfo->normalTexturePath, "normalSampler",false, GenerateGLTexture, true, glm::vec3(0.5f, 0.5f, 1.0f), TextureUsage::NORMAL, nullptr },
 				{ m_Shaders[mat.material.shaderID].shader.needHDREquirectangularSampler, mat.material.generateHDREquirectangularSampler, &mat.hdrTextureID, 
-				createInfo->hdrEquirectangularTexturePath, "hdrEquirectangularSampler", true, GenerateHDRGLTexture },
+				createInfo->hdrEquirectangularTexturePath, "hdrEquirectangularSampler", true, GenerateHDRGLTexture, false, glm::vec3(0.0f), TextureUsage::HDR, nullptr },
 			};
 
 			int binding = 0;
@@ -491,7 +550,36 @@ namespace flex
 						if (!GetLoadedTexture(samplerCreateInfo.filepath, *samplerCreateInfo.id))
 						{
 							// Texture hasn't been loaded yet, load it now
-							samplerCreateInfo.createFunction(*samplerCreateInfo.id, samplerCreateInfo.filepath, samplerCreateInfo.flipVertically, false);
+							if (samplerCreateInfo.stream)
+							{
+								GenerateGLTexture_Placeholder(*samplerCreateInfo.id, samplerCreateInfo.placeholderColor);
+
+								PendingTextureUpload pendingUpload = {};
+								pendingUpload.textureID = *samplerCreateInfo.id;
+								// Textures are only cooked into formats this context can sample from
+								const TextureUsage usage = (IsBlockCompressionFormatSupported(GetCookedTextureFormat(samplerCreateInfo.usage)) ?
+									samplerCreateInfo.usage : TextureUsage::NONE);
+								if (samplerCreateInfo.packedFilePaths)
+								{
+									pendingUpload.image = DecodePackedImageAsync(gameContext.threadPool, *samplerCreateInfo.packedFilePaths, samplerCreateInfo.flipVertically, usage);
+								}
+								else
+								{
+									pendingUpload.image = DecodeImageAsync(gameContext.threadPool, samplerCreateInfo.filepath, 3, samplerCreateInfo.flipVertically, usage);
+								}
+								pendingUpload.generateMipMaps = false;
+								m_PendingTextureUploads.push_back(std::move(pendingUpload));
+							}
+							else
+							{
+								samplerCreateInfo.createFunction(*samplerCreateInfo.id, samplerCreateInfo.filepath, samplerCreateInfo.flipVertically, false);
+
+								// Cooked in the background so the next run can upload it without decoding
+								if (IsBlockCompressionFormatSupported(GetCookedTextureFormat(samplerCreateInfo.usage)))
+								{
+									CookTextureAsync(gameContext.threadPool, samplerCreateInfo.filepath, samplerCreateInfo.usage, samplerCreateInfo.flipVertically);
+								}
+							}
 							m_LoadedTextures.insert({ samplerCreateInfo.filepath, *samplerCreateInfo.id });
 						}
 
@@ -539,6 +627,7 @@ namespace flex
 				cubemapCreateInfo.generateMipmaps = false;
 				cubemapCreateInfo.enableTrilinearFiltering = createInfo->enableCubemapTrilinearFiltering;
 				cubemapCreateInfo.filePaths = mat.material.cubeMapFilePaths;
+				cubemapCreateInfo.threadPool = gameContext.threadPool;
 
 				if (createInfo->cubeMapFilePaths[0].empty())
 				{
@@ -586,7 +675,7 @@ namespace flex
 			
 				GenerateGLCubemap(cubemapCreateInfo);
 			}
-			else if (createInfo->generateHDRCubemapSampler)
+			else if (createInfo->generateHDRCubemapSampler && !mat.lazyEnvironmentMaps)
 			{
 				GLCubemapCreateInfo cubemapCreateInfo = {};
 				cubemapCreateInfo.program = m_Shaders[mat.material.shaderID].program;
@@ -635,7 +724,7 @@ namespace flex
 				++binding;
 			}
 
-			if (mat.material.generateIrradianceSampler)
+			if (mat.material.generateIrradianceSampler && !mat.material.generateIrradianceSH && !mat.lazyEnvironmentMaps)
 			{
 				GLCubemapCreateInfo cubemapCreateInfo = {};
 				cubemapCreateInfo.program = m_Shaders[mat.material.shaderID].program;
@@ -664,7 +753,7 @@ namespace flex
 				++binding;
 			}
 
-			if (mat.material.generatePrefilteredMap)
+			if (mat.material.generatePrefilteredMap && !mat.lazyEnvironmentMaps)
 			{
 				GLCubemapCreateInfo cubemapCreateInfo = {};
 				cubemapCreateInfo.program = m_Shaders[mat.material.shaderID].program;
@@ -732,34 +821,296 @@ namespace flex
 			glUseProgram(shader.program);
 			CheckGLErrorMessages();
 
+			renderObject->vertexBufferData = createInfo->vertexBufferData;
+			renderObject->vertexCount = createInfo->vertexBufferData ? createInfo->vertexBufferData->VertexCount : 0;
+
+			if (createInfo->indices != nullptr)
+			{
+				renderObject->indices = createInfo->indices;
+				renderObject->indexed = true;
+				renderObject->totalIndexCount = (glm::uint)createInfo->indices->size();
+				renderObject->indexCount = renderObject->totalIndexCount;
+			}
+
+			if (createInfo->bounds)
+			{
+				renderObject->hasBounds = true;
+				renderObject->localBounds = *createInfo->bounds;
+			}
+
 			if (createInfo->vertexBufferData)
 			{
-				glGenVertexArrays(1, &renderObject->VAO);
-				glBindVertexArray(renderObject->VAO);
-				CheckGLErrorMessages();
+				// Objects created from the same data (eg. several instances of one mesh) share buffers
+				renderObject->sharedDataID = createInfo->sharedDataID;
+				const SharedBufferKey sharedBufferKey = GetSharedBufferKey(renderObject);
+				auto sharedBufferIter = m_SharedBuffers.find(sharedBufferKey);
+				if (sharedBufferIter == m_SharedBuffers.end())
+				{
+					sharedBufferIter = m_SharedBuffers.insert({ sharedBufferKey, CreateSharedBuffers(createInfo->vertexBufferData, createInfo->indices) }).first;
+				}
+
+				GLSharedBuffers& sharedBuffers = sharedBufferIter->second;
+				++sharedBuffers.refCount;
+
+				renderObject->VBO = sharedBuffers.VBO;
+				renderObject->meshID = sharedBuffers.meshID;
+				renderObject->geometryPool = sharedBuffers.geometryPool;
+				renderObject->baseVertex = sharedBuffers.baseVertex;
+				renderObject->indexBufferOffset = sharedBuffers.firstIndex;
+
+				if (renderObject->geometryPool != INVALID_GEOMETRY_POOL)
+				{
+					// Its buffers are already bound to the pool's VAO
+					renderObject->VAO = GetGeometryPoolVAO(renderObject->geometryPool, material.material.shaderID);
+					glBindVertexArray(renderObject->VAO);
+					CheckGLErrorMessages();
+				}
+				else
+				{
+					// Otherwise each object has its own VAO
+					glGenVertexArrays(1, &renderObject->VAO);
+					glBindVertexArray(renderObject->VAO);
+					CheckGLErrorMessages();
+
+					if (renderObject->indexed)
+					{
+						glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, sharedBuffers.IBO);
+						CheckGLErrorMessages();
+					}
+				}
 
-				glGenBuffers(1, &renderObject->VBO);
 				glBindBuffer(GL_ARRAY_BUFFER, renderObject->VBO);
-				glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)createInfo->vertexBufferData->BufferSize, createInfo->vertexBufferData->pDataStart, GL_STATIC_DRAW);
 				CheckGLErrorMessages();
+
+				if (renderObject->indexed)
+				{
+					renderObject->IBO = sharedBuffers.IBO;
+					renderObject->indexType = sharedBuffers.indexType;
+				}
+
+				BindObjectIndexAttribute(renderObject);
 			}
 
-			renderObject->vertexBufferData = createInfo->vertexBufferData;
+			glBindVertexArray(0);
+			glUseProgram(0);
 
-			if (createInfo->indices != nullptr)
+			AddToDrawList(renderObject);
+
+			return renderID;
+		}
+
+		GLRenderer::GLSharedBuffers GLRenderer::CreateSharedBuffers(const VertexBufferData* vertexBufferData, const std::vector<glm::uint>* indices)
+		{
+			GLSharedBuffers sharedBuffers = {};
+			sharedBuffers.meshID = m_NextMeshID++;
+
+			if (AllocateFromGeometryPool(vertexBufferData, indices, sharedBuffers))
 			{
-				renderObject->indices = createInfo->indices;
-				renderObject->indexed = true;
+				return sharedBuffers;
+			}
+
+			glGenBuffers(1, &sharedBuffers.VBO);
+			glBindBuffer(GL_ARRAY_BUFFER, sharedBuffers.VBO);
+			glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)vertexBufferData->BufferSize, vertexBufferData->pDataStart, GL_STATIC_DRAW);
+			CheckGLErrorMessages();
+
+			if (indices != nullptr)
+			{
+				// Uploaded through the copy target, binding GL_ELEMENT_ARRAY_BUFFER would change whichever VAO is bound
+				glGenBuffers(1, &sharedBuffers.IBO);
+				glBindBuffer(GL_COPY_WRITE_BUFFER, sharedBuffers.IBO);
+
+				// Halve index memory & bandwidth for meshes whose vertices can all be addressed by 16 bits
+				const bool use16BitIndices = (vertexBufferData->VertexCount <= 65536);
+				if (use16BitIndices)
+				{
+					std::vector<glm::uint16> indices16;
+					indices16.reserve(indices->size());
+					for (glm::uint index : *indices)
+					{
+						indices16.push_back((glm::uint16)index);
+					}
+
+					sharedBuffers.indexType = GL_UNSIGNED_SHORT;
+					glBufferData(GL_COPY_WRITE_BUFFER, (GLsizeiptr)(sizeof(glm::uint16) * indices16.size()), indices16.data(), GL_STATIC_DRAW);
+				}
+				else
+				{
+					sharedBuffers.indexType = GL_UNSIGNED_INT;
+					glBufferData(GL_COPY_WRITE_BUFFER, (GLsizeiptr)(sizeof(glm::uint) * indices->size()), indices->data(), GL_STATIC_DRAW);
+				}
+				glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+				CheckGLErrorMessages();
+			}
+
+			return sharedBuffers;
+		}
+
+		bool GLRenderer::AllocateFromGeometryPool(const VertexBufferData* vertexBufferData, const std::vector<glm::uint>* indices, GLSharedBuffers& outSharedBuffers)
+		{
+			// Positions in their own stream need two vertex buffer bindings with different strides, which pools don't describe
+			if (indices == nullptr || vertexBufferData->SeparatePositions || vertexBufferData->VertexStride == 0)
+			{
+				return false;
+			}
+
+			const glm::uint vertexStride = vertexBufferData->VertexStride;
+			const glm::uint vertexCount = vertexBufferData->VertexCount;
+			const glm::uint indexCount = (glm::uint)indices->size();
+			const glm::uint vertexCapacity = GEOMETRY_POOL_VERTEX_BUFFER_SIZE / vertexStride;
+
+			// As with unpooled buffers, meshes whose vertices can all be addressed by 16 bits keep 16 bit indices. They're pooled
+			// separately from 32 bit ones since an indirect draw reads every command's indices as the same type
+			const GLenum indexType = (vertexCount <= 65536) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+			const glm::uint indexSize = (indexType == GL_UNSIGNED_SHORT) ? sizeof(glm::uint16) : sizeof(glm::uint);
+
+			if (vertexCount == 0 || indexCount == 0 || vertexCount > vertexCapacity || indexCount > GEOMETRY_POOL_INDEX_CAPACITY)
+			{
+				return false;
+			}
+
+			glm::uint poolIndex = INVALID_GEOMETRY_POOL;
+			glm::uint firstVertex = 0;
+			glm::uint firstIndex = 0;
+			for (glm::uint i = 0; i < (glm::uint)m_GeometryPools.size(); ++i)
+			{
+				GLGeometryPool& pool = m_GeometryPools[i];
+				if (pool.attributes != vertexBufferData->Attributes || pool.vertexStride != vertexStride || pool.indexType != indexType)
+				{
+					continue;
+				}
+
+				if (pool.freeVertices.Allocate(vertexCount, firstVertex))
+				{
+					if (pool.freeIndices.Allocate(indexCount, firstIndex))
+					{
+						poolIndex = i;
+						break;
+					}
+					pool.freeVertices.Free(firstVertex, vertexCount);
+				}
+			}
+
+			if (poolIndex == INVALID_GEOMETRY_POOL)
+			{
+				GLGeometryPool pool = {};
+				pool.attributes = vertexBufferData->Attributes;
+				pool.vertexStride = vertexStride;
+				pool.indexType = indexType;
+				pool.freeVertices.Reset(vertexCapacity);
+				pool.freeIndices.Reset(GEOMETRY_POOL_INDEX_CAPACITY);
+				pool.freeVertices.Allocate(vertexCount, firstVertex);
+				pool.freeIndices.Allocate(indexCount, firstIndex);
+
+				glGenBuffers(1, &pool.VBO);
+				glBindBuffer(GL_COPY_WRITE_BUFFER, pool.VBO);
+				glBufferStorage(GL_COPY_WRITE_BUFFER, (GLsizeiptr)vertexStride * vertexCapacity, nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+				glGenBuffers(1, &pool.IBO);
+				glBindBuffer(GL_COPY_WRITE_BUFFER, pool.IBO);
+				glBufferStorage(GL_COPY_WRITE_BUFFER, (GLsizeiptr)indexSize * GEOMETRY_POOL_INDEX_CAPACITY, nullptr, GL_DYNAMIC_STORAGE_BIT);
+				glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+				CheckGLErrorMessages();
+
+				poolIndex = (glm::uint)m_GeometryPools.size();
+				m_GeometryPools.push_back(pool);
+
+				Logger::LogInfo("Created geometry pool " + std::to_string(poolIndex) + " (vertex stride " + std::to_string(vertexStride) +
+					", " + std::to_string(indexSize * 8) + " bit indices)");
+			}
+
+			GLGeometryPool& pool = m_GeometryPools[poolIndex];
+
+			// Copied through the copy target, binding GL_ELEMENT_ARRAY_BUFFER would change whichever VAO is bound
+			glBindBuffer(GL_COPY_WRITE_BUFFER, pool.VBO);
+			glBufferSubData(GL_COPY_WRITE_BUFFER, (GLintptr)firstVertex * vertexStride, (GLsizeiptr)vertexStride * vertexCount, vertexBufferData->pDataStart);
+			glBindBuffer(GL_COPY_WRITE_BUFFER, pool.IBO);
+			if (indexType == GL_UNSIGNED_SHORT)
+			{
+				std::vector<glm::uint16> indices16;
+				indices16.reserve(indexCount);
+				for (glm::uint index : *indices)
+				{
+					indices16.push_back((glm::uint16)index);
+				}
+				glBufferSubData(GL_COPY_WRITE_BUFFER, (GLintptr)indexSize * firstIndex, (GLsizeiptr)indexSize * indexCount, indices16.data());
+			}
+			else
+			{
+				glBufferSubData(GL_COPY_WRITE_BUFFER, (GLintptr)indexSize * firstIndex, (GLsizeiptr)indexSize * indexCount, indices->data());
+			}
+			glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+			CheckGLErrorMessages();
+
+			outSharedBuffers.VBO = pool.VBO;
+			outSharedBuffers.IBO = pool.IBO;
+			outSharedBuffers.indexType = indexType;
+			outSharedBuffers.geometryPool = poolIndex;
+			outSharedBuffers.baseVertex = (GLint)firstVertex;
+			outSharedBuffers.firstIndex = firstIndex;
+			outSharedBuffers.vertexCount = vertexCount;
+			outSharedBuffers.indexCount = indexCount;
+
+			++pool.meshCount;
+
+			return true;
+		}
+
+		GLRenderer::SharedBufferKey GLRenderer::GetSharedBufferKey(const GLRenderObject* renderObject)
+		{
+			if (renderObject->sharedDataID != 0)
+			{
+				return SharedBufferKey(renderObject->sharedDataID, 0);
+			}
+			return SharedBufferKey(0, renderObject->renderID);
+		}
+
+		void GLRenderer::ReleaseFromGeometryPool(const GLSharedBuffers& sharedBuffers)
+		{
+			GLGeometryPool& pool = m_GeometryPools[sharedBuffers.geometryPool];
+			assert(pool.meshCount > 0);
+			--pool.meshCount;
+
+			// The data is left in place, nothing reads it until the ranges are allocated again & overwritten
+			pool.freeVertices.Free((glm::uint)sharedBuffers.baseVertex, sharedBuffers.vertexCount);
+			pool.freeIndices.Free(sharedBuffers.firstIndex, sharedBuffers.indexCount);
+		}
 
-				glGenBuffers(1, &renderObject->IBO);
-				glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, renderObject->IBO);
-				glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr)(sizeof(createInfo->indices->at(0)) * createInfo->indices->size()), createInfo->indices->data(), GL_STATIC_DRAW);
+		glm::uint GLRenderer::GetGeometryPoolVAO(glm::uint poolIndex, ShaderID shaderID)
+		{
+			GLGeometryPool& pool = m_GeometryPools[poolIndex];
+
+			auto VAOIter = pool.VAOs.find(shaderID);
+			if (VAOIter != pool.VAOs.end())
+			{
+				return VAOIter->second;
 			}
 
+			// Attribute formats are set with glVertexAttribFormat (see DescribeShaderVariable) & all read from one binding
+			glm::uint VAO;
+			glGenVertexArrays(1, &VAO);
+			glBindVertexArray(VAO);
+			glBindVertexBuffer(GEOMETRY_POOL_VERTEX_BINDING, pool.VBO, 0, (GLsizei)pool.vertexStride);
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, pool.IBO);
 			glBindVertexArray(0);
-			glUseProgram(0);
+			CheckGLErrorMessages();
 
-			return renderID;
+			pool.VAOs.insert({ shaderID, VAO });
+			return VAO;
+		}
+
+		void GLRenderer::DestroyGeometryPools()
+		{
+			for (GLGeometryPool& pool : m_GeometryPools)
+			{
+				for (auto& VAOPair : pool.VAOs)
+				{
+					glDeleteVertexArrays(1, &VAOPair.second);
+				}
+				glDeleteBuffers(1, &pool.VBO);
+				glDeleteBuffers(1, &pool.IBO);
+			}
+			m_GeometryPools.clear();
 		}
 
 		void GLRenderer::PostInitializeRenderObject(const GameContext& gameContext, RenderID renderID)
@@ -787,92 +1138,317 @@ namespace flex
 			}
 			else if (m_Materials[renderObject->materialID].material.generateIrradianceSampler)
 			{
-				GenerateCubemapFromHDREquirectangular(gameContext, renderObject->materialID, m_Materials[renderObject->materialID].material.environmentMapPath);
-				GenerateIrradianceSamplerFromCubemap(gameContext, renderObject->materialID);
-				GeneratePrefilteredMapFromCubemap(gameContext, renderObject->materialID);
+				MaterializeEnvironmentMaps(gameContext, renderObject->materialID);
 			}
 		}
 
-		void GLRenderer::GenerateCubemapFromHDREquirectangular(const GameContext& gameContext, MaterialID cubemapMaterialID, const std::string& environmentMapPath)
+		void GLRenderer::CreateEnvironmentMapTextures(MaterialID materialID)
 		{
-			GLint last_viewport[4]; glGetIntegerv(GL_VIEWPORT, last_viewport);
+			GLMaterial& material = m_Materials[materialID];
 
-			MaterialCreateInfo equirectangularToCubeMatCreateInfo = {};
-			equirectangularToCubeMatCreateInfo.name = "Equirectangular to Cube";
-			equirectangularToCubeMatCreateInfo.shaderName = "equirectangular_to_cube";
-			equirectangularToCubeMatCreateInfo.enableHDREquirectangularSampler = true;
-			equirectangularToCubeMatCreateInfo.generateHDREquirectangularSampler = true;
-			// TODO: Make cyclable at runtime
-			equirectangularToCubeMatCreateInfo.hdrEquirectangularTexturePath = environmentMapPath;
-			MaterialID equirectangularToCubeMatID = InitializeMaterial(gameContext, &equirectangularToCubeMatCreateInfo);
+			GLCubemapCreateInfo cubemapCreateInfo = {};
+			cubemapCreateInfo.program = m_Shaders[material.material.shaderID].program;
+			cubemapCreateInfo.HDR = true;
+			cubemapCreateInfo.enableTrilinearFiltering = material.enableCubemapTrilinearFiltering;
 
-			GLShader* equirectangularToCubemapShader = &m_Shaders[m_Materials[equirectangularToCubeMatID].material.shaderID];
-			GLMaterial* equirectangularToCubemapMaterial = &m_Materials[equirectangularToCubeMatID];
+			if (material.material.generateHDRCubemapSampler)
+			{
+				cubemapCreateInfo.textureID = &material.cubemapSamplerID;
+				cubemapCreateInfo.textureGBufferIDs = &material.cubemapSamplerGBuffersIDs;
+				cubemapCreateInfo.depthTextureID = &material.cubemapDepthSamplerID;
+				cubemapCreateInfo.generateMipmaps = false;
+				cubemapCreateInfo.textureSize = material.material.cubemapSamplerSize;
+				GenerateGLCubemap(cubemapCreateInfo);
+			}
 
-			if (!m_SkyBoxMesh)
+			if (material.material.generateIrradianceSampler && !material.material.generateIrradianceSH)
 			{
-				GenerateSkybox(gameContext);
+				cubemapCreateInfo.textureID = &material.irradianceSamplerID;
+				cubemapCreateInfo.textureGBufferIDs = nullptr;
+				cubemapCreateInfo.depthTextureID = nullptr;
+				cubemapCreateInfo.generateMipmaps = false;
+				cubemapCreateInfo.textureSize = material.material.irradianceSamplerSize;
+				GenerateGLCubemap(cubemapCreateInfo);
 			}
 
-			GLRenderObject* skyboxRenderObject = GetRenderObject(m_SkyBoxMesh->GetRenderID());
-			GLMaterial* skyboxGLMaterial = &m_Materials[skyboxRenderObject->materialID];
+			if (material.material.generatePrefilteredMap)
+			{
+				cubemapCreateInfo.textureID = &material.prefilteredMapSamplerID;
+				cubemapCreateInfo.textureGBufferIDs = nullptr;
+				cubemapCreateInfo.depthTextureID = nullptr;
+				cubemapCreateInfo.generateMipmaps = true;
+				cubemapCreateInfo.textureSize = material.material.prefilteredMapSize;
+				GenerateGLCubemap(cubemapCreateInfo);
+			}
 
-			glUseProgram(equirectangularToCubemapShader->program);
-			CheckGLErrorMessages();
+			material.environmentMapsResident = true;
+			material.environmentMapsGenerated = false;
+		}
 
-			// TODO: Store what location this texture is at (might not be 0)
-			glActiveTexture(GL_TEXTURE0);
-			glBindTexture(GL_TEXTURE_2D, m_Materials[equirectangularToCubeMatID].hdrTextureID);
-			CheckGLErrorMessages();
+		void GLRenderer::DestroyEnvironmentMapTextures(MaterialID materialID)
+		{
+			GLMaterial& material = m_Materials[materialID];
 
-			// Update object's uniforms under this shader's program
-			glUniformMatrix4fv(equirectangularToCubemapMaterial->uniformIDs.model, 1, false, &m_SkyBoxMesh->GetTransform().GetModelMatrix()[0][0]);
+			glDeleteTextures(1, &material.cubemapSamplerID);
+			glDeleteTextures(1, &material.irradianceSamplerID);
+			glDeleteTextures(1, &material.prefilteredMapSamplerID);
 			CheckGLErrorMessages();
 
-			glUniformMatrix4fv(equirectangularToCubemapMaterial->uniformIDs.projection, 1, false, &m_CaptureProjection[0][0]);
-			CheckGLErrorMessages();
+			material.cubemapSamplerID = 0;
+			material.irradianceSamplerID = 0;
+			material.prefilteredMapSamplerID = 0;
 
-			glm::uvec2 cubemapSize = skyboxGLMaterial->material.cubemapSamplerSize;
+			material.environmentMapsResident = false;
+			material.environmentMapsGenerated = false;
+		}
 
-			glBindFramebuffer(GL_FRAMEBUFFER, m_CaptureFBO);
-			CheckGLErrorMessages();
-			glBindRenderbuffer(GL_RENDERBUFFER, m_CaptureRBO);
-			CheckGLErrorMessages();
-			glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, cubemapSize.x, cubemapSize.y);
-			CheckGLErrorMessages();
+		void GLRenderer::MaterializeEnvironmentMaps(const GameContext& gameContext, MaterialID materialID)
+		{
+			GLMaterial& material = m_Materials[materialID];
+			material.environmentMapsLastUsedTime = gameContext.elapsedTime;
 
-			glViewport(0, 0, cubemapSize.x, cubemapSize.y);
-			CheckGLErrorMessages();
+			if (material.environmentMapsGenerated)
+			{
+				return;
+			}
 
-			glBindVertexArray(skyboxRenderObject->VAO);
-			CheckGLErrorMessages();
-			glBindBuffer(GL_ARRAY_BUFFER, skyboxRenderObject->VBO);
-			CheckGLErrorMessages();
+			if (material.lazyEnvironmentMaps && !material.environmentMapsResident)
+			{
+				CreateEnvironmentMapTextures(materialID);
 
-			glCullFace(skyboxRenderObject->cullFace);
-			CheckGLErrorMessages();
+				if (materialID == m_SkyBoxMaterialID)
+				{
+					// Point every material sampling the skybox's maps at the new textures
+					SetSkyboxMaterial(materialID);
+				}
+			}
 
-			if (skyboxRenderObject->enableCulling) glEnable(GL_CULL_FACE);
-			else glDisable(GL_CULL_FACE);
+			// Hashed once here and handed to both the load and the background bake
+			glm::uint64 sourceHash = 0;
+			const bool sourceHashed = BakedEnvironment::HashSource(material.material.environmentMapPath, sourceHash);
+			if (!sourceHashed || !LoadBakedEnvironment(materialID, sourceHash))
+			{
+				GenerateCubemapFromHDREquirectangular(gameContext, materialID, material.material.environmentMapPath);
+				GenerateIrradianceSamplerFromCubemap(gameContext, materialID);
+				GeneratePrefilteredMapFromCubemap(gameContext, materialID);
 
-			glDepthFunc(skyboxRenderObject->depthTestReadFunc);
-			CheckGLErrorMessages();
+				if (sourceHashed)
+				{
+					// Rendered this time, but baked in the background so the next launch can load them instead
+					BakedEnvironment::BakeAsync(gameContext.threadPool, material.material.environmentMapPath, sourceHash, GetIBLBakeSettings(material.material, PREFILTERED_MAP_MIP_COUNT));
+				}
+			}
 
-			glDepthMask(skyboxRenderObject->depthWriteEnable);
-			CheckGLErrorMessages();
+			material.environmentMapsGenerated = true;
+		}
 
-			for (unsigned int i = 0; i < 6; ++i)
+		void GLRenderer::MaterializeBatchedEnvironmentMaps(const GameContext& gameContext)
+		{
+			// Batches only hold visible objects, so this is exactly the set of materials EvictUnusedEnvironmentMaps considers used
+			for (const std::vector<DrawBatch>* batches : { &m_DeferredRenderObjectBatches, &m_ForwardRenderObjectBatches })
 			{
-				glUniformMatrix4fv(equirectangularToCubemapMaterial->uniformIDs.view, 1, false, &m_CaptureViews[i][0][0]);
-				CheckGLErrorMessages();
-
-				glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, m_Materials[cubemapMaterialID].cubemapSamplerID, 0);
-				CheckGLErrorMessages();
+				for (const DrawBatch& batch : *batches)
+				{
+					const MaterialID materialID = m_DrawList[batch.firstEntry].renderObject->materialID;
+					GLMaterial& material = m_Materials[materialID];
+
+					for (MaterialID sourceMaterialID : { materialID, material.irradianceSourceMatID, material.prefilteredMapSourceMatID })
+					{
+						auto sourceIter = m_Materials.find(sourceMaterialID);
+						if (sourceIter != m_Materials.end() && sourceIter->second.lazyEnvironmentMaps)
+						{
+							MaterializeEnvironmentMaps(gameContext, sourceMaterialID);
+						}
+					}
+
+					if (material.irradianceSourceMatID != materialID && material.irradianceSourceMatID < m_Materials.size())
+					{
+						material.irradianceSamplerID = m_Materials[material.irradianceSourceMatID].irradianceSamplerID;
+					}
+					if (material.prefilteredMapSourceMatID != materialID && material.prefilteredMapSourceMatID < m_Materials.size())
+					{
+						material.prefilteredMapSamplerID = m_Materials[material.prefilteredMapSourceMatID].prefilteredMapSamplerID;
+					}
+				}
+			}
+		}
+
+		void GLRenderer::EvictUnusedEnvironmentMaps(const GameContext& gameContext)
+		{
+			// Checked at most once a second since every render object is visited
+			if (m_EnvironmentMapEvictionDelay <= 0.0f || gameContext.elapsedTime - m_LastEnvironmentMapEvictionCheckTime < 1.0f)
+			{
+				return;
+			}
+			m_LastEnvironmentMapEvictionCheckTime = gameContext.elapsedTime;
+
+			std::set<glm::uint> usedTextureIDs;
+			for (auto iter = m_RenderObjects.begin(); iter != m_RenderObjects.end(); ++iter)
+			{
+				GLRenderObject* renderObject = iter->second;
+				if (renderObject && renderObject->visible)
+				{
+					const GLMaterial& material = m_Materials[renderObject->materialID];
+					usedTextureIDs.insert(material.cubemapSamplerID);
+					usedTextureIDs.insert(material.irradianceSamplerID);
+					usedTextureIDs.insert(material.prefilteredMapSamplerID);
+				}
+			}
+			usedTextureIDs.erase(0); // Maps which were never created, like irradiance cubemaps of materials using SH instead
+
+			for (auto iter = m_Materials.begin(); iter != m_Materials.end(); ++iter)
+			{
+				GLMaterial& material = iter->second;
+				if (!material.lazyEnvironmentMaps || !material.environmentMapsResident || iter->first == m_SkyBoxMaterialID)
+				{
+					continue;
+				}
+
+				if (usedTextureIDs.find(material.cubemapSamplerID) != usedTextureIDs.end() ||
+					usedTextureIDs.find(material.irradianceSamplerID) != usedTextureIDs.end() ||
+					usedTextureIDs.find(material.prefilteredMapSamplerID) != usedTextureIDs.end())
+				{
+					material.environmentMapsLastUsedTime = gameContext.elapsedTime;
+				}
+				else if (gameContext.elapsedTime - material.environmentMapsLastUsedTime > m_EnvironmentMapEvictionDelay)
+				{
+					Logger::LogInfo("Evicting unused environment maps of " + material.material.name);
+					DestroyEnvironmentMapTextures(iter->first);
+				}
+			}
+		}
+
+		bool GLRenderer::LoadBakedEnvironment(MaterialID cubemapMaterialID, glm::uint64 sourceHash)
+		{
+			GLMaterial& cubemapMaterial = m_Materials[cubemapMaterialID];
+
+			BakedEnvironment environment;
+			if (!environment.Load(cubemapMaterial.material.environmentMapPath, sourceHash, GetIBLBakeSettings(cubemapMaterial.material, PREFILTERED_MAP_MIP_COUNT)))
+			{
+				return false;
+			}
+
+			const std::pair<BakedEnvironment::Map, glm::uint> maps[] = {
+				{ BakedEnvironment::Map::CUBEMAP, cubemapMaterial.cubemapSamplerID },
+				{ BakedEnvironment::Map::IRRADIANCE, cubemapMaterial.irradianceSamplerID },
+				{ BakedEnvironment::Map::PREFILTERED, cubemapMaterial.prefilteredMapSamplerID },
+			};
+
+			if (cubemapMaterial.material.generateIrradianceSH)
+			{
+				environment.GetIrradianceSH(cubemapMaterial.irradianceSH);
+				cubemapMaterial.irradianceSHGenerated = true;
+			}
+
+			for (const std::pair<BakedEnvironment::Map, glm::uint>& map : maps)
+			{
+				if (map.second == 0)
+				{
+					continue;
+				}
+
+				glBindTexture(GL_TEXTURE_CUBE_MAP, map.second);
+				CheckGLErrorMessages();
+
+				const glm::uint mipCount = environment.GetMipCount(map.first);
+				for (glm::uint mip = 0; mip < mipCount; ++mip)
+				{
+					const GLsizei mipSize = (GLsizei)environment.GetMipSize(map.first, mip);
+					for (glm::uint face = 0; face < 6; ++face)
+					{
+						glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, mip, GL_RGB16F, mipSize, mipSize, 0, GL_RGBA, GL_HALF_FLOAT,
+							environment.GetFaceData(map.first, mip, face));
+					}
+				}
+				glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LEVEL, mipCount - 1);
+				CheckGLErrorMessages();
+			}
+
+			glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+
+			return true;
+		}
+
+		void GLRenderer::GenerateCubemapFromHDREquirectangular(const GameContext& gameContext, MaterialID cubemapMaterialID, const std::string& environmentMapPath)
+		{
+			GLint last_viewport[4]; glGetIntegerv(GL_VIEWPORT, last_viewport);
+
+			MaterialCreateInfo equirectangularToCubeMatCreateInfo = {};
+			equirectangularToCubeMatCreateInfo.name = "Equirectangular to Cube";
+			equirectangularToCubeMatCreateInfo.shaderName = "equirectangular_to_cube";
+			equirectangularToCubeMatCreateInfo.enableHDREquirectangularSampler = true;
+			equirectangularToCubeMatCreateInfo.generateHDREquirectangularSampler = true;
+			// TODO: Make cyclable at runtime
+			equirectangularToCubeMatCreateInfo.hdrEquirectangularTexturePath = environmentMapPath;
+			MaterialID equirectangularToCubeMatID = InitializeMaterial(gameContext, &equirectangularToCubeMatCreateInfo);
+
+			GLShader* equirectangularToCubemapShader = &m_Shaders[m_Materials[equirectangularToCubeMatID].material.shaderID];
+			GLMaterial* equirectangularToCubemapMaterial = &m_Materials[equirectangularToCubeMatID];
+
+			if (!m_SkyBoxMesh)
+			{
+				GenerateSkybox(gameContext);
+			}
+
+			GLRenderObject* skyboxRenderObject = GetRenderObject(m_SkyBoxMesh->GetRenderID());
+			GLMaterial* skyboxGLMaterial = &m_Materials[skyboxRenderObject->materialID];
+
+			glUseProgram(equirectangularToCubemapShader->program);
+			CheckGLErrorMessages();
+
+			// TODO: Store what location this texture is at (might not be 0)
+			glActiveTexture(GL_TEXTURE0);
+			glBindTexture(GL_TEXTURE_2D, m_Materials[equirectangularToCubeMatID].hdrTextureID);
+			CheckGLErrorMessages();
+
+			// Update object's uniforms under this shader's program
+			glUniformMatrix4fv(equirectangularToCubemapMaterial->uniformIDs.model, 1, false, &m_SkyBoxMesh->GetTransform().GetModelMatrix()[0][0]);
+			CheckGLErrorMessages();
+
+			glUniformMatrix4fv(equirectangularToCubemapMaterial->uniformIDs.projection, 1, false, &m_CaptureProjection[0][0]);
+			CheckGLErrorMessages();
+
+			glm::uvec2 cubemapSize = skyboxGLMaterial->material.cubemapSamplerSize;
+
+			glBindFramebuffer(GL_FRAMEBUFFER, m_CaptureFBO);
+			CheckGLErrorMessages();
+			glBindRenderbuffer(GL_RENDERBUFFER, m_CaptureRBO);
+			CheckGLErrorMessages();
+			glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, cubemapSize.x, cubemapSize.y);
+			CheckGLErrorMessages();
+
+			glViewport(0, 0, cubemapSize.x, cubemapSize.y);
+			CheckGLErrorMessages();
+
+			glBindVertexArray(skyboxRenderObject->VAO);
+			CheckGLErrorMessages();
+			glBindBuffer(GL_ARRAY_BUFFER, skyboxRenderObject->VBO);
+			CheckGLErrorMessages();
+
+			glCullFace(skyboxRenderObject->cullFace);
+			CheckGLErrorMessages();
+
+			if (skyboxRenderObject->enableCulling) glEnable(GL_CULL_FACE);
+			else glDisable(GL_CULL_FACE);
+
+			glDepthFunc(skyboxRenderObject->depthTestReadFunc);
+			CheckGLErrorMessages();
+
+			glDepthMask(skyboxRenderObject->depthWriteEnable);
+			CheckGLErrorMessages();
+
+			for (unsigned int i = 0; i < 6; ++i)
+			{
+				glUniformMatrix4fv(equirectangularToCubemapMaterial->uniformIDs.view, 1, false, &m_CaptureViews[i][0][0]);
+				CheckGLErrorMessages();
+
+				glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, m_Materials[cubemapMaterialID].cubemapSamplerID, 0);
+				CheckGLErrorMessages();
 
 				glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 				CheckGLErrorMessages();
 
-				glDrawArrays(skyboxRenderObject->topology, 0, (GLsizei)skyboxRenderObject->vertexBufferData->VertexCount);
+				glDrawArrays(skyboxRenderObject->topology, 0, (GLsizei)skyboxRenderObject->vertexCount);
 				CheckGLErrorMessages();
 			}
 
@@ -939,7 +1515,7 @@ namespace flex
 			glDepthMask(skybox->depthWriteEnable);
 			CheckGLErrorMessages();
 
-			unsigned int maxMipLevels = 5;
+			unsigned int maxMipLevels = PREFILTERED_MAP_MIP_COUNT;
 			for (unsigned int mip = 0; mip < maxMipLevels; ++mip)
 			{
 				unsigned int mipWidth = (unsigned int)(m_Materials[cubemapMaterialID].material.prefilteredMapSize.x * pow(0.5f, mip));
@@ -965,7 +1541,7 @@ namespace flex
 						GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, m_Materials[cubemapMaterialID].prefilteredMapSamplerID, mip);
 					CheckGLErrorMessages();
 					
-					glDrawArrays(skybox->topology, 0, (GLsizei)skybox->vertexBufferData->VertexCount);
+					glDrawArrays(skybox->topology, 0, (GLsizei)skybox->vertexCount);
 					CheckGLErrorMessages();
 				}
 			}
@@ -1031,7 +1607,7 @@ namespace flex
 				else
 				{
 					SetTopologyMode(quadRenderID, TopologyMode::TRIANGLE_STRIP);
-					m_1x1_NDC_Quad->visible = false; // Don't render this normally, we'll draw it manually
+					SetRenderObjectVisible(quadRenderID, false); // Don't render this normally, we'll draw it manually
 					m_1x1_NDC_QuadVertexBufferData.DescribeShaderVariables(gameContext.renderer, quadRenderID);
 				}
 			}
@@ -1068,7 +1644,7 @@ namespace flex
 			CheckGLErrorMessages();
 
 			// Render quad
-			glDrawArrays(m_1x1_NDC_Quad->topology, 0, (GLsizei)m_1x1_NDC_Quad->vertexBufferData->VertexCount);
+			glDrawArrays(m_1x1_NDC_Quad->topology, 0, (GLsizei)m_1x1_NDC_Quad->vertexCount);
 			CheckGLErrorMessages();
 			
 			glBindVertexArray(0);
@@ -1078,8 +1654,39 @@ namespace flex
 			glViewport(last_viewport[0], last_viewport[1], last_viewport[2], last_viewport[3]);
 		}
 
+		void GLRenderer::CreateBRDFLUT(const GameContext& gameContext)
+		{
+			if (m_BRDFTextureHandle.id != 0)
+			{
+				return;
+			}
+
+			GenerateGLTexture_Empty(m_BRDFTextureHandle.id, m_BRDFTextureSize, false, m_BRDFTextureHandle.internalFormat, m_BRDFTextureHandle.format, m_BRDFTextureHandle.type);
+
+			BakedBRDFLUT bakedBRDFLUT;
+			if (bakedBRDFLUT.Load(m_BRDFTextureSize))
+			{
+				glBindTexture(GL_TEXTURE_2D, m_BRDFTextureHandle.id);
+				glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_BRDFTextureSize.x, m_BRDFTextureSize.y, m_BRDFTextureHandle.format, GL_HALF_FLOAT, bakedBRDFLUT.GetData());
+				glBindTexture(GL_TEXTURE_2D, 0);
+				CheckGLErrorMessages();
+				return;
+			}
+
+			Logger::LogInfo("Generating BRDF LUT");
+			GenerateBRDFLUT(gameContext, m_BRDFTextureHandle.id, m_BRDFTextureSize);
+
+			BakedBRDFLUT::BakeAsync(gameContext.threadPool, m_BRDFTextureSize);
+		}
+
 		void GLRenderer::GenerateIrradianceSamplerFromCubemap(const GameContext& gameContext, MaterialID cubemapMaterialID)
 		{
+			if (m_Materials[cubemapMaterialID].material.generateIrradianceSH)
+			{
+				GenerateIrradianceSHFromCubemap(cubemapMaterialID);
+				return;
+			}
+
 			GLint last_viewport[4]; glGetIntegerv(GL_VIEWPORT, last_viewport);
 
 			// Irradiance sampler generation
@@ -1145,7 +1752,7 @@ namespace flex
 				CheckGLErrorMessages();
 
 				// Should be drawing cube here, not object (relfection probe's sphere is being drawn
-				glDrawArrays(skybox->topology, 0, (GLsizei)skybox->vertexBufferData->VertexCount);
+				glDrawArrays(skybox->topology, 0, (GLsizei)skybox->vertexCount);
 				CheckGLErrorMessages();
 			}
 
@@ -1156,11 +1763,57 @@ namespace flex
 			glViewport(last_viewport[0], last_viewport[1], last_viewport[2], last_viewport[3]);
 		}
 
+		void GLRenderer::GenerateIrradianceSHFromCubemap(MaterialID cubemapMaterialID)
+		{
+			GLMaterial& cubemapMaterial = m_Materials[cubemapMaterialID];
+
+			glBindTexture(GL_TEXTURE_CUBE_MAP, cubemapMaterial.cubemapSamplerID);
+			CheckGLErrorMessages();
+
+			// Reflection probe captures have no mips of their own, and only low frequencies matter to irradiance
+			glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+			CheckGLErrorMessages();
+
+			GLint size = 0;
+			glGetTexLevelParameteriv(GL_TEXTURE_CUBE_MAP_POSITIVE_X, 0, GL_TEXTURE_WIDTH, &size);
+			GLint mipLevel = 0;
+			while (size > (GLint)IRRADIANCE_SH_SOURCE_SIZE)
+			{
+				size /= 2;
+				++mipLevel;
+			}
+
+			const size_t faceFloatCount = (size_t)size * size * 4;
+			std::vector<float> texels(faceFloatCount * 6);
+			const float* faces[6];
+			for (glm::uint face = 0; face < 6; ++face)
+			{
+				glGetTexImage(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, mipLevel, GL_RGBA, GL_FLOAT, texels.data() + faceFloatCount * face);
+				faces[face] = texels.data() + faceFloatCount * face;
+			}
+			CheckGLErrorMessages();
+
+			glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+
+			ProjectIrradianceSH9(faces, (glm::uint)size, cubemapMaterial.irradianceSH);
+			cubemapMaterial.irradianceSHGenerated = true;
+		}
+
 		void GLRenderer::CaptureSceneToCubemap(const GameContext& gameContext, RenderID cubemapRenderID)
 		{
+			// Reflection probes are only captured occasionally, so make sure they see every texture's final contents
+			UploadPendingTextures(true);
+
+			// Called outside of Draw, after who knows what state changes
+			m_StateCache.Invalidate();
+
+			// Lights may have changed since the last frame, the camera matrices are replaced per face below
+			UpdatePerFrameUBO(gameContext);
+
 			GLint last_viewport[4]; glGetIntegerv(GL_VIEWPORT, last_viewport);
 
 			BatchRenderObjects(gameContext);
+			UpdatePerObjectBuffer();
 
 			DrawCallInfo drawCallInfo = {};
 			drawCallInfo.renderToCubemap = true;
@@ -1215,6 +1868,7 @@ namespace flex
 			drawCallInfo.deferred = false;
 			DrawGBufferQuad(gameContext, drawCallInfo);
 			DrawForwardObjects(gameContext, drawCallInfo);
+			FencePerObjectBuffer();
 			
 			glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
@@ -1337,11 +1991,7 @@ namespace flex
 
 			GenerateGBuffer(gameContext);
 			
-			if (m_BRDFTextureHandle.id == 0)
-			{
-				GenerateGLTexture_Empty(m_BRDFTextureHandle.id, m_BRDFTextureSize, false, m_BRDFTextureHandle.internalFormat, m_BRDFTextureHandle.format, m_BRDFTextureHandle.type);
-				GenerateBRDFLUT(gameContext, m_BRDFTextureHandle.id, m_BRDFTextureSize);
-			}
+			CreateBRDFLUT(gameContext);
 
 			CheckGLErrorMessages();
 
@@ -1395,73 +2045,470 @@ namespace flex
 					}
 				}
 			}
+
+			EvictUnusedEnvironmentMaps(gameContext);
 		}
 
 		void GLRenderer::Draw(const GameContext& gameContext)
 		{
 			CheckGLErrorMessages();
 
-			DrawCallInfo drawCallInfo = {};
+			UploadPendingTextures(false);
+
+			if (m_SkyBoxMaterialID != INVALID_MATERIAL_ID && m_Materials[m_SkyBoxMaterialID].lazyEnvironmentMaps)
+			{
+				MaterializeEnvironmentMaps(gameContext, m_SkyBoxMaterialID);
+			}
 
-			// TODO: Don't sort render objects frame! Only when things are added/removed
+			// Only touches CPU side data, but materializing the batches' environment maps renders into them
 			BatchRenderObjects(gameContext);
+			MaterializeBatchedEnvironmentMaps(gameContext);
+
+			// Everything above may change state directly, from here on all frequently changed state goes through the cache
+			m_StateCache.BeginFrame();
+
+			UpdatePerFrameUBO(gameContext);
+
+			DrawCallInfo drawCallInfo = {};
+
+			m_DrawCallCount = 0;
+
+			UpdatePerObjectBuffer();
+			CullRenderObjectMeshlets(gameContext);
 			DrawDeferredObjects(gameContext, drawCallInfo);
 			DrawGBufferQuad(gameContext, drawCallInfo);
 			DrawForwardObjects(gameContext, drawCallInfo);
+			FencePerObjectBuffer();
+			m_LastFrameDrawCallCount = m_DrawCallCount;
 			DrawOffscreenTexture(gameContext);
 			DrawUI();
 
 			SwapBuffers(gameContext);
 		}
 
-		void GLRenderer::BatchRenderObjects(const GameContext& gameContext)
+		void GLRenderer::CullRenderObjectMeshlets(const GameContext& gameContext)
 		{
-			/*
-			TODO: Don't create two nested vectors every call, just sort things by deferred/forward, then by material ID
-			
+			const glm::mat4 viewProjection = gameContext.camera->GetViewProjection();
+			const glm::vec3 cameraPosition = gameContext.camera->GetPosition();
 
-			Eg. deferred | matID
-			yes		 0
-			yes		 2
-			no		 1
-			no		 3
-			no		 5
-			*/
-			m_DeferredRenderObjectBatches.clear();
-			m_ForwardRenderObjectBatches.clear();
-			
-			// Sort render objects into deferred + forward buckets
-			for (size_t i = 0; i < m_Materials.size(); ++i)
+			for (auto& renderObjectPair : m_RenderObjects)
 			{
-				GLShader* shader = &m_Shaders[m_Materials[i].material.shaderID];
+				GLRenderObject* renderObject = renderObjectPair.second;
+				if (!renderObject || !renderObject->meshlets || !renderObject->visible) continue;
+
+				const glm::mat4 model = renderObject->transform ? renderObject->transform->GetModelMatrix() : glm::mat4(1.0f);
+				CullMeshlets(viewProjection, cameraPosition, model, *renderObject->meshlets, renderObject->visibleIndexRanges);
+			}
+		}
 
-				UpdateMaterialUniforms(gameContext, i);
+		void GLRenderer::UploadPendingTextures(bool waitForAll)
+		{
+			size_t bytesUploaded = 0;
 
-				if (shader->shader.deferred)
+			auto iter = m_PendingTextureUploads.begin();
+			while (iter != m_PendingTextureUploads.end())
+			{
+				if (!waitForAll)
 				{
-					m_DeferredRenderObjectBatches.push_back({});
-					for (size_t j = 0; j < m_RenderObjects.size(); ++j)
+					if (bytesUploaded >= MAX_TEXTURE_UPLOAD_BYTES_PER_FRAME)
 					{
-						GLRenderObject* renderObject = GetRenderObject(j);
-						if (renderObject && renderObject->visible && renderObject->materialID == i)
-						{
-							m_DeferredRenderObjectBatches.back().push_back(renderObject);
-						}
+						break;
+					}
+
+					if (iter->image.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+					{
+						++iter;
+						continue;
 					}
 				}
-				else
+
+				DecodedImage image = iter->image.get();
+				if (image.cooked)
+				{
+					UploadCookedGLTexture(iter->textureID, *image.cooked);
+
+					// Every mip level was cooked, so sample from them
+					glBindTexture(GL_TEXTURE_2D, iter->textureID);
+					glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+					glBindTexture(GL_TEXTURE_2D, 0);
+					CheckGLErrorMessages();
+
+					bytesUploaded += image.cooked->GetDataSize();
+				}
+				else if (image.pixels)
 				{
-					m_ForwardRenderObjectBatches.push_back({});
-					for (size_t j = 0; j < m_RenderObjects.size(); ++j)
+					UploadDecodedTexture(iter->textureID, image, iter->generateMipMaps);
+					bytesUploaded += (size_t)image.width * image.height * image.channels;
+				}
+				// Images which failed to decode have already been logged, their placeholders are left in place
+				image.Free();
+
+				iter = m_PendingTextureUploads.erase(iter);
+			}
+		}
+
+		void GLRenderer::UploadDecodedTexture(glm::uint textureID, const DecodedImage& image, bool generateMipMaps)
+		{
+			if (m_TextureUploadPBOs[0] == 0)
+			{
+				glGenBuffers(NUM_TEXTURE_UPLOAD_PBOS, m_TextureUploadPBOs);
+				CheckGLErrorMessages();
+			}
+
+			const GLsizeiptr imageSize = (GLsizeiptr)image.width * image.height * image.channels;
+			const GLenum format = (image.channels == 4 ? GL_RGBA : GL_RGB);
+
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_TextureUploadPBOs[m_NextTextureUploadPBO]);
+			m_NextTextureUploadPBO = (m_NextTextureUploadPBO + 1) % NUM_TEXTURE_UPLOAD_PBOS;
+
+			// Orphan the buffer's previous storage so mapping it never stalls on a transfer which is still in flight
+			glBufferData(GL_PIXEL_UNPACK_BUFFER, imageSize, nullptr, GL_STREAM_DRAW);
+			void* mappedData = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, imageSize, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+			CheckGLErrorMessages();
+
+			const void* pixels = nullptr; // Offset into the bound unpack buffer
+			if (mappedData)
+			{
+				memcpy(mappedData, image.pixels, imageSize);
+				glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+			}
+			else
+			{
+				// Fall back to uploading straight from client memory
+				glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+				pixels = image.pixels;
+			}
+
+			glBindTexture(GL_TEXTURE_2D, textureID);
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+			glTexImage2D(GL_TEXTURE_2D, 0, format, image.width, image.height, 0, format, GL_UNSIGNED_BYTE, pixels);
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+			CheckGLErrorMessages();
+
+			if (generateMipMaps)
+			{
+				glGenerateMipmap(GL_TEXTURE_2D);
+				CheckGLErrorMessages();
+			}
+
+			glBindTexture(GL_TEXTURE_2D, 0);
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		}
+
+		void GLRenderer::AddToDrawList(GLRenderObject* renderObject)
+		{
+			if (renderObject->drawListIndex != INVALID_DRAW_LIST_INDEX) return;
+
+			renderObject->drawListIndex = (glm::uint)m_DrawList.size();
+			m_DrawList.push_back({ CalculateSortKey(renderObject, m_DrawListCameraPosition), renderObject });
+			m_DrawListDirty = true;
+		}
+
+		void GLRenderer::RemoveFromDrawList(GLRenderObject* renderObject)
+		{
+			if (renderObject->drawListIndex == INVALID_DRAW_LIST_INDEX) return;
+
+			// Order doesn't matter until the next sort, fill the gap with the last entry
+			const glm::uint index = renderObject->drawListIndex;
+			if (index != m_DrawList.size() - 1)
+			{
+				m_DrawList[index] = m_DrawList.back();
+				m_DrawList[index].renderObject->drawListIndex = index;
+			}
+			m_DrawList.pop_back();
+
+			renderObject->drawListIndex = INVALID_DRAW_LIST_INDEX;
+			m_DrawListDirty = true;
+		}
+
+		void GLRenderer::UpdateDrawListEntry(GLRenderObject* renderObject)
+		{
+			if (renderObject->drawListIndex == INVALID_DRAW_LIST_INDEX) return;
+
+			m_DrawList[renderObject->drawListIndex].sortKey = CalculateSortKey(renderObject, m_DrawListCameraPosition);
+			m_DrawListDirty = true;
+		}
+
+		glm::uint64 GLRenderer::CalculateSortKey(const GLRenderObject* renderObject, const glm::vec3& cameraPosition) const
+		{
+			auto materialIter = m_Materials.find(renderObject->materialID);
+			if (materialIter == m_Materials.end())
+			{
+				// Will be skipped when batching, sort to the very end
+				return ~0ull;
+			}
+
+			const ShaderID shaderID = materialIter->second.material.shaderID;
+			const glm::uint64 pass = m_Shaders[shaderID].shader.deferred ? 0 : 1;
+			const glm::uint64 mesh = renderObject->vertexBufferData ? renderObject->meshID : 0;
+
+			// Front to back, to make the most of early depth testing
+			glm::uint64 depthBucket = 0;
+			if (renderObject->transform)
+			{
+				const float distance = glm::distance(renderObject->transform->GetGlobalPosition(), cameraPosition);
+				depthBucket = (glm::uint64)(glm::clamp(distance / DRAW_LIST_MAX_SORT_DEPTH, 0.0f, 1.0f) * 0xFFFF);
+			}
+
+			return
+				(pass << 62) |
+				(((glm::uint64)shaderID & 0x3FF) << 52) |
+				(((glm::uint64)renderObject->materialID & 0xFFFF) << 36) |
+				((mesh & 0xFFFFF) << 16) |
+				depthBucket;
+		}
+
+		void GLRenderer::BatchRenderObjects(const GameContext& gameContext)
+		{
+			const glm::vec3 cameraPosition = gameContext.camera->GetPosition();
+			if (!m_DrawListDirty && glm::distance(cameraPosition, m_DrawListCameraPosition) < DRAW_LIST_RESORT_DISTANCE)
+			{
+				return;
+			}
+
+			m_DrawListCameraPosition = cameraPosition;
+			for (DrawListEntry& entry : m_DrawList)
+			{
+				entry.sortKey = CalculateSortKey(entry.renderObject, m_DrawListCameraPosition);
+			}
+
+			RadixSortDrawList(m_DrawList, m_DrawListScratch);
+
+			m_DeferredRenderObjectBatches.clear();
+			m_ForwardRenderObjectBatches.clear();
+
+			// Sorting by material puts every batch's entries next to each other
+			MaterialID batchMaterialID = INVALID_MATERIAL_ID;
+			std::vector<DrawBatch>* batches = nullptr;
+			for (glm::uint i = 0; i < (glm::uint)m_DrawList.size(); ++i)
+			{
+				GLRenderObject* renderObject = m_DrawList[i].renderObject;
+				renderObject->drawListIndex = i;
+
+				if (renderObject->materialID != batchMaterialID)
+				{
+					batchMaterialID = renderObject->materialID;
+					batches = nullptr;
+
+					auto materialIter = m_Materials.find(batchMaterialID);
+					if (materialIter != m_Materials.end())
 					{
-						GLRenderObject* renderObject = GetRenderObject(j);
-						if (renderObject && renderObject->visible && renderObject->materialID == i)
-						{
-							m_ForwardRenderObjectBatches.back().push_back(renderObject);
-						}
+						const bool deferred = m_Shaders[materialIter->second.material.shaderID].shader.deferred;
+						batches = deferred ? &m_DeferredRenderObjectBatches : &m_ForwardRenderObjectBatches;
+						batches->push_back({ i, 0 });
 					}
 				}
+
+				if (batches)
+				{
+					++batches->back().entryCount;
+				}
+			}
+
+			m_DrawListDirty = false;
+		}
+
+		void GLRenderer::CreatePerObjectBuffer(glm::uint capacity)
+		{
+			DestroyPerObjectBuffer();
+
+			GLint offsetAlignment = 1;
+			glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &offsetAlignment);
+			offsetAlignment = std::max(offsetAlignment, 1);
+
+			m_PerObjectSSBOCapacity = capacity;
+			const GLsizeiptr dataSize = (GLsizeiptr)(sizeof(PerObjectData) * capacity);
+			m_PerObjectSSBORegionSize = ((dataSize + offsetAlignment - 1) / offsetAlignment) * offsetAlignment;
+			const GLsizeiptr bufferSize = m_PerObjectSSBORegionSize * NUM_PER_OBJECT_SSBO_REGIONS;
+
+			// Coherent, so writes are visible to draws issued after them without any explicit flushes
+			const GLbitfield mapFlags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+			glGenBuffers(1, &m_PerObjectSSBO);
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_PerObjectSSBO);
+			glBufferStorage(GL_SHADER_STORAGE_BUFFER, bufferSize, nullptr, mapFlags);
+			m_PerObjectSSBOMapped = (glm::uint8*)glMapBufferRange(GL_SHADER_STORAGE_BUFFER, 0, bufferSize, mapFlags);
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+			CheckGLErrorMessages();
+
+			if (!m_PerObjectSSBOMapped)
+			{
+				Logger::LogError("Failed to map per object storage buffer!");
+			}
+
+			std::vector<glm::uint> objectIndices(capacity);
+			for (glm::uint i = 0; i < capacity; ++i)
+			{
+				objectIndices[i] = i;
+			}
+
+			glGenBuffers(1, &m_ObjectIndexBuffer);
+			glBindBuffer(GL_ARRAY_BUFFER, m_ObjectIndexBuffer);
+			glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(sizeof(glm::uint) * capacity), objectIndices.data(), GL_STATIC_DRAW);
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+			CheckGLErrorMessages();
+
+			// VAOs created before now still point at the previous index buffer
+			for (auto& renderObjectPair : m_RenderObjects)
+			{
+				if (renderObjectPair.second)
+				{
+					BindObjectIndexAttribute(renderObjectPair.second);
+				}
+			}
+
+			m_StateCache.Invalidate();
+		}
+
+		void GLRenderer::DestroyPerObjectBuffer()
+		{
+			for (GLsync& fence : m_PerObjectSSBOFences)
+			{
+				if (fence)
+				{
+					glDeleteSync(fence);
+					fence = nullptr;
+				}
+			}
+
+			// Buffers are only actually released once the GPU is done with them, unmapping happens implicitly
+			if (m_PerObjectSSBO != 0)
+			{
+				glDeleteBuffers(1, &m_PerObjectSSBO);
+				m_PerObjectSSBO = 0;
+			}
+			m_PerObjectSSBOMapped = nullptr;
+			m_PerObjectSSBOCapacity = 0;
+
+			if (m_ObjectIndexBuffer != 0)
+			{
+				glDeleteBuffers(1, &m_ObjectIndexBuffer);
+				m_ObjectIndexBuffer = 0;
+			}
+		}
+
+		void GLRenderer::CreateIndirectDrawBuffer(glm::uint capacity)
+		{
+			DestroyIndirectDrawBuffer();
+
+			m_IndirectDrawBufferCapacity = capacity;
+			const GLsizeiptr bufferSize = (GLsizeiptr)(sizeof(DrawElementsIndirectCommand) * capacity * NUM_PER_OBJECT_SSBO_REGIONS);
+
+			const GLbitfield mapFlags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+			glGenBuffers(1, &m_IndirectDrawBuffer);
+			glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_IndirectDrawBuffer);
+			glBufferStorage(GL_DRAW_INDIRECT_BUFFER, bufferSize, nullptr, mapFlags);
+			m_IndirectDrawBufferMapped = (DrawElementsIndirectCommand*)glMapBufferRange(GL_DRAW_INDIRECT_BUFFER, 0, bufferSize, mapFlags);
+			CheckGLErrorMessages();
+
+			if (!m_IndirectDrawBufferMapped)
+			{
+				Logger::LogError("Failed to map indirect draw buffer!");
+			}
+		}
+
+		void GLRenderer::DestroyIndirectDrawBuffer()
+		{
+			if (m_IndirectDrawBuffer != 0)
+			{
+				glDeleteBuffers(1, &m_IndirectDrawBuffer);
+				m_IndirectDrawBuffer = 0;
+			}
+			m_IndirectDrawBufferMapped = nullptr;
+			m_IndirectDrawBufferCapacity = 0;
+			m_IndirectDrawCommandCount = 0;
+		}
+
+		void GLRenderer::BindObjectIndexAttribute(GLRenderObject* renderObject)
+		{
+			if (!renderObject->vertexBufferData || m_ObjectIndexBuffer == 0) return;
+
+			glBindVertexArray(renderObject->VAO);
+			glBindBuffer(GL_ARRAY_BUFFER, m_ObjectIndexBuffer);
+			glEnableVertexAttribArray(OBJECT_INDEX_ATTRIBUTE_LOCATION);
+			glVertexAttribIPointer(OBJECT_INDEX_ATTRIBUTE_LOCATION, 1, GL_UNSIGNED_INT, 0, nullptr);
+			glVertexAttribDivisor(OBJECT_INDEX_ATTRIBUTE_LOCATION, 1);
+			CheckGLErrorMessages();
+
+			// DescribeShaderVariable expects the object's own vertex buffer to still be bound
+			glBindBuffer(GL_ARRAY_BUFFER, renderObject->VBO);
+			glBindVertexArray(0);
+		}
+
+		void GLRenderer::UpdatePerObjectBuffer()
+		{
+			const glm::uint objectCount = (glm::uint)m_DrawList.size();
+			if (objectCount > m_PerObjectSSBOCapacity)
+			{
+				CreatePerObjectBuffer(std::max(objectCount, m_PerObjectSSBOCapacity * 2));
+			}
+
+			if (m_IndirectDrawBufferOverflowed)
+			{
+				// Regions still in use by the GPU keep the old buffer alive until it's done with them
+				CreateIndirectDrawBuffer(m_IndirectDrawBufferCapacity * 2);
+				m_IndirectDrawBufferOverflowed = false;
+			}
+			m_IndirectDrawCommandCount = 0;
+
+			if (!m_PerObjectSSBOMapped) return;
+
+			m_PerObjectSSBORegion = (m_PerObjectSSBORegion + 1) % NUM_PER_OBJECT_SSBO_REGIONS;
+
+			// Usually long since signaled, this region was last used NUM_PER_OBJECT_SSBO_REGIONS - 1 frames ago
+			GLsync& fence = m_PerObjectSSBOFences[m_PerObjectSSBORegion];
+			if (fence)
+			{
+				const GLuint64 timeout = 1000000000; // In nanoseconds
+				GLenum waitResult = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+				while (waitResult == GL_TIMEOUT_EXPIRED)
+				{
+					waitResult = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+				}
+
+				if (waitResult == GL_WAIT_FAILED)
+				{
+					Logger::LogError("Failed to wait for per object storage buffer region to become available!");
+				}
+
+				glDeleteSync(fence);
+				fence = nullptr;
 			}
+
+			const GLintptr regionOffset = m_PerObjectSSBORegionSize * m_PerObjectSSBORegion;
+			PerObjectData* regionData = (PerObjectData*)(m_PerObjectSSBOMapped + regionOffset);
+
+			// Transforms are only read here, so large scenes can have their matrices calculated on several threads
+			ParallelFor(objectCount, MIN_PER_OBJECT_DATA_PER_THREAD, [this, regionData](glm::uint begin, glm::uint end)
+			{
+				for (glm::uint i = begin; i < end; ++i)
+				{
+					const GLRenderObject* renderObject = m_DrawList[i].renderObject;
+
+					PerObjectData objectData = {};
+					objectData.model = renderObject->transform ? renderObject->transform->GetModelMatrix() : glm::mat4(1.0f);
+					objectData.modelInvTranspose = glm::transpose(glm::inverse(objectData.model));
+					objectData.materialID = renderObject->materialID;
+
+					// Written in one go, the mapping is likely write-combined memory
+					regionData[i] = objectData;
+				}
+			});
+
+			glBindBufferRange(GL_SHADER_STORAGE_BUFFER, PER_OBJECT_SSBO_BINDING, m_PerObjectSSBO, regionOffset, m_PerObjectSSBORegionSize);
+			glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_IndirectDrawBuffer);
+			CheckGLErrorMessages();
+		}
+
+		void GLRenderer::FencePerObjectBuffer()
+		{
+			if (!m_PerObjectSSBOMapped) return;
+
+			GLsync& fence = m_PerObjectSSBOFences[m_PerObjectSSBORegion];
+			if (fence)
+			{
+				glDeleteSync(fence);
+			}
+			fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
 		}
 
 		void GLRenderer::DrawDeferredObjects(const GameContext& gameContext, const DrawCallInfo& drawCallInfo)
@@ -1502,16 +2549,13 @@ namespace flex
 			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 			CheckGLErrorMessages();
 
-			for (size_t i = 0; i < m_DeferredRenderObjectBatches.size(); ++i)
+			for (const DrawBatch& batch : m_DeferredRenderObjectBatches)
 			{
-				if (!m_DeferredRenderObjectBatches[i].empty())
-				{
-					DrawRenderObjectBatch(gameContext, m_DeferredRenderObjectBatches[i], drawCallInfo);
-				}
+				DrawRenderObjectBatch(gameContext, batch, drawCallInfo);
 			}
 
-			glUseProgram(0);
-			glBindVertexArray(0);
+			m_StateCache.UseProgram(0);
+			m_StateCache.BindVertexArray(0);
 			CheckGLErrorMessages();
 
 			{
@@ -1553,6 +2597,9 @@ namespace flex
 					GenerateSkybox(gameContext);
 				}
 
+				// Generating either of the above changes state behind the cache's back
+				m_StateCache.Invalidate();
+
 				GLRenderObject* skybox = GetRenderObject(m_SkyBoxMesh->GetRenderID());
 
 				GLRenderObject* cubemapObject = GetRenderObject(drawCallInfo.cubemapObjectRenderID);
@@ -1567,11 +2614,11 @@ namespace flex
 				glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, cubemapMaterial->material.cubemapSamplerSize.x, cubemapMaterial->material.cubemapSamplerSize.y);
 				CheckGLErrorMessages();
 
-				glUseProgram(cubemapShader->program);
+				m_StateCache.UseProgram(cubemapShader->program);
 
-				glBindVertexArray(skybox->VAO);
+				m_StateCache.BindVertexArray(skybox->VAO);
 				CheckGLErrorMessages();
-				glBindBuffer(GL_ARRAY_BUFFER, skybox->VBO);
+				m_StateCache.BindArrayBuffer(skybox->VBO);
 				CheckGLErrorMessages();
 
 				UpdateMaterialUniforms(gameContext, cubemapObject->materialID);
@@ -1580,32 +2627,27 @@ namespace flex
 				glm::uint bindingOffset = BindDeferredFrameBufferTextures(cubemapMaterial);
 				BindTextures(&cubemapShader->shader, cubemapMaterial, bindingOffset);
 
-				if (skybox->enableCulling) glEnable(GL_CULL_FACE);
-				else glDisable(GL_CULL_FACE);
+				m_StateCache.SetCullingEnabled(skybox->enableCulling);
 
-				glCullFace(skybox->cullFace);
+				m_StateCache.CullFace(skybox->cullFace);
 				CheckGLErrorMessages();
 
-				glDepthFunc(GL_ALWAYS);
+				m_StateCache.DepthFunc(GL_ALWAYS);
 				CheckGLErrorMessages();
 
-				glDepthMask(GL_FALSE);
+				m_StateCache.DepthMask(GL_FALSE);
 				CheckGLErrorMessages();
 				
-				glUniformMatrix4fv(cubemapMaterial->uniformIDs.projection, 1, false, &m_CaptureProjection[0][0]);
-				CheckGLErrorMessages();
-
 				glBindRenderbuffer(GL_RENDERBUFFER, 0);
 
 				for (int face = 0; face < 6; ++face)
 				{
-					glUniformMatrix4fv(cubemapMaterial->uniformIDs.view, 1, false, &m_CaptureViews[face][0][0]);
-					CheckGLErrorMessages();
+					UpdatePerFrameUBOCamera(m_CaptureViews[face], m_CaptureProjection);
 
 					glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, cubemapMaterial->cubemapSamplerID, 0);
 					CheckGLErrorMessages();
 
-					glDrawArrays(skybox->topology, 0, (GLsizei)skybox->vertexBufferData->VertexCount);
+					glDrawArrays(skybox->topology, 0, (GLsizei)skybox->vertexCount);
 					CheckGLErrorMessages();
 				}
 
@@ -1627,10 +2669,10 @@ namespace flex
 				GLMaterial* material = &m_Materials[gBufferQuad->materialID];
 				GLShader* glShader = &m_Shaders[material->material.shaderID];
 				Shader* shader = &glShader->shader;
-				glUseProgram(glShader->program);
+				m_StateCache.UseProgram(glShader->program);
 
-				glBindVertexArray(gBufferQuad->VAO);
-				glBindBuffer(GL_ARRAY_BUFFER, gBufferQuad->VBO);
+				m_StateCache.BindVertexArray(gBufferQuad->VAO);
+				m_StateCache.BindArrayBuffer(gBufferQuad->VBO);
 				CheckGLErrorMessages();
 
 				UpdateMaterialUniforms(gameContext, gBufferQuad->materialID);
@@ -1639,19 +2681,18 @@ namespace flex
 				glm::uint bindingOffset = BindFrameBufferTextures(material);
 				BindTextures(shader, material, bindingOffset);
 
-				if (gBufferQuad->enableCulling) glEnable(GL_CULL_FACE);
-				else glDisable(GL_CULL_FACE);
+				m_StateCache.SetCullingEnabled(gBufferQuad->enableCulling);
 
-				glCullFace(gBufferQuad->cullFace);
+				m_StateCache.CullFace(gBufferQuad->cullFace);
 				CheckGLErrorMessages();
 
-				glDepthFunc(gBufferQuad->depthTestReadFunc);
+				m_StateCache.DepthFunc(gBufferQuad->depthTestReadFunc);
 				CheckGLErrorMessages();
 
-				glDepthMask(gBufferQuad->depthWriteEnable);
+				m_StateCache.DepthMask(gBufferQuad->depthWriteEnable);
 				CheckGLErrorMessages();
 
-				glDrawArrays(gBufferQuad->topology, 0, (GLsizei)gBufferQuad->vertexBufferData->VertexCount);
+				glDrawArrays(gBufferQuad->topology, 0, (GLsizei)gBufferQuad->vertexCount);
 				CheckGLErrorMessages();
 			}
 		}
@@ -1663,12 +2704,9 @@ namespace flex
 			glBindRenderbuffer(GL_RENDERBUFFER, m_OffscreenRBO);
 			CheckGLErrorMessages();
 
-			for (size_t i = 0; i < m_ForwardRenderObjectBatches.size(); ++i)
+			for (const DrawBatch& batch : m_ForwardRenderObjectBatches)
 			{
-				if (!m_ForwardRenderObjectBatches[i].empty())
-				{
-					DrawRenderObjectBatch(gameContext, m_ForwardRenderObjectBatches[i], drawCallInfo);
-				}
+				DrawRenderObjectBatch(gameContext, batch, drawCallInfo);
 			}
 		}
 
@@ -1778,39 +2816,70 @@ namespace flex
 
 		}
 
-		void GLRenderer::DrawRenderObjectBatch(const GameContext& gameContext, const std::vector<GLRenderObject*>& batchedRenderObjects, const DrawCallInfo& drawCallInfo)
+		void GLRenderer::DrawRenderObjectBatch(const GameContext& gameContext, const DrawBatch& batch, const DrawCallInfo& drawCallInfo)
 		{
-			assert(!batchedRenderObjects.empty());
+			assert(batch.entryCount > 0);
 
-			GLMaterial* material = &m_Materials[batchedRenderObjects[0]->materialID];
+			const MaterialID materialID = m_DrawList[batch.firstEntry].renderObject->materialID;
+			GLMaterial* material = &m_Materials[materialID];
 			GLShader* glShader = &m_Shaders[material->material.shaderID];
 			Shader* shader = &glShader->shader;
-			glUseProgram(glShader->program);
+
+			// Only materials which are drawn need their uniforms updated, right before they're used (materials may share programs)
+			UpdateMaterialUniforms(gameContext, materialID);
+
+			m_StateCache.UseProgram(glShader->program);
 			CheckGLErrorMessages();
 
-			for (size_t i = 0; i < batchedRenderObjects.size(); ++i)
+			const glm::uint batchEnd = batch.firstEntry + batch.entryCount;
+			glm::uint i = batch.firstEntry;
+			while (i < batchEnd)
 			{
-				GLRenderObject* renderObject = batchedRenderObjects[i];
-				if (!renderObject->visible) continue;
+				GLRenderObject* renderObject = m_DrawList[i].renderObject;
 
-				glBindVertexArray(renderObject->VAO);
+				// Following entries which draw the same mesh the same way are drawn along with this one, as instances
+				// Each instance's data is then found at its own draw list index (base instance + gl_InstanceID) in PerObjectBuffer
+				glm::uint instanceCount = 1;
+				if (glShader->usesPerObjectBuffer)
+				{
+					while (i + instanceCount < batchEnd && CanDrawInstanced(renderObject, m_DrawList[i + instanceCount].renderObject))
+					{
+						++instanceCount;
+					}
+				}
+
+				// Following entries in the same geometry pool (so using the same VAO) can all be submitted through one indirect draw,
+				// whatever meshes they draw. Captures draw every object once per face & are rare enough to not be worth it
+				glm::uint multiDrawEnd = i;
+				if (glShader->usesPerObjectBuffer && !drawCallInfo.renderToCubemap && renderObject->geometryPool != INVALID_GEOMETRY_POOL)
+				{
+					multiDrawEnd = i + 1;
+					while (multiDrawEnd < batchEnd && CanMultiDrawIndirect(renderObject, m_DrawList[multiDrawEnd].renderObject))
+					{
+						++multiDrawEnd;
+					}
+				}
+
+				m_StateCache.BindVertexArray(renderObject->VAO);
 				CheckGLErrorMessages();
-				glBindBuffer(GL_ARRAY_BUFFER, renderObject->VBO);
+				m_StateCache.BindArrayBuffer(renderObject->VBO);
 				CheckGLErrorMessages();
 
-				if (renderObject->enableCulling) glEnable(GL_CULL_FACE);
-				else glDisable(GL_CULL_FACE);
+				m_StateCache.SetCullingEnabled(renderObject->enableCulling);
 
-				glCullFace(renderObject->cullFace);
+				m_StateCache.CullFace(renderObject->cullFace);
 				CheckGLErrorMessages();
 
-				glDepthFunc(renderObject->depthTestReadFunc);
+				m_StateCache.DepthFunc(renderObject->depthTestReadFunc);
 				CheckGLErrorMessages();
 
-				glDepthMask(renderObject->depthWriteEnable);
+				m_StateCache.DepthMask(renderObject->depthWriteEnable);
 				CheckGLErrorMessages();
 
-				UpdatePerObjectUniforms(renderObject->renderID, gameContext);
+				if (!glShader->usesPerObjectBuffer)
+				{
+					UpdatePerObjectUniforms(renderObject->renderID, gameContext);
+				}
 
 				BindTextures(shader, material);
 
@@ -1832,8 +2901,13 @@ namespace flex
 					CheckGLErrorMessages();
 
 					// Use capture projection matrix
-					glUniformMatrix4fv(material->uniformIDs.projection, 1, false, &m_CaptureProjection[0][0]);
-					CheckGLErrorMessages();
+					const bool hasProjectionUniform = shader->constantBufferUniforms.HasUniform("projection");
+					const bool hasViewUniform = shader->constantBufferUniforms.HasUniform("view");
+					if (hasProjectionUniform)
+					{
+						glUniformMatrix4fv(material->uniformIDs.projection, 1, false, &m_CaptureProjection[0][0]);
+						CheckGLErrorMessages();
+					}
 					
 					// TODO: Test if this is actually correct
 					glm::vec3 cubemapTranslation = -cubemapRenderObject->transform->GetGlobalPosition();
@@ -1845,8 +2919,12 @@ namespace flex
 						// Flip vertically to match cubemap, cubemap shouldn't even be captured here eventually?
 						//glm::mat4 view = glm::translate(glm::scale(m_CaptureViews[face], glm::vec3(1.0f, -1.0f, 1.0f)), cubemapTranslation);
 						
-						glUniformMatrix4fv(material->uniformIDs.view, 1, false, &view[0][0]);
-						CheckGLErrorMessages();
+						UpdatePerFrameUBOCamera(view, m_CaptureProjection);
+						if (hasViewUniform)
+						{
+							glUniformMatrix4fv(material->uniformIDs.view, 1, false, &view[0][0]);
+							CheckGLErrorMessages();
+						}
 
 						if (drawCallInfo.deferred)
 						{
@@ -1871,31 +2949,154 @@ namespace flex
 
 						if (renderObject->indexed)
 						{
-							glDrawElements(renderObject->topology, (GLsizei)renderObject->indices->size(), GL_UNSIGNED_INT, (void*)renderObject->indices->data());
+							glDrawElementsInstancedBaseVertexBaseInstance(renderObject->topology, (GLsizei)renderObject->indexCount, renderObject->indexType,
+								GetIndexBufferOffset(renderObject->indexType, renderObject->indexBufferOffset + renderObject->firstIndex), (GLsizei)instanceCount,
+								renderObject->baseVertex, i);
 							CheckGLErrorMessages();
 						}
 						else
 						{
-							glDrawArrays(renderObject->topology, 0, (GLsizei)renderObject->vertexBufferData->VertexCount);
+							glDrawArraysInstancedBaseInstance(renderObject->topology, 0, (GLsizei)renderObject->vertexCount, (GLsizei)instanceCount, i);
 							CheckGLErrorMessages();
 						}
+						++m_DrawCallCount;
+					}
+				}
+				else if (multiDrawEnd > i && MultiDrawIndirect(i, multiDrawEnd))
+				{
+					instanceCount = multiDrawEnd - i;
+					++m_DrawCallCount;
+				}
+				else
+				{
+					// The base instance selects this entry's data in PerObjectBuffer (through the object index attribute)
+					if (renderObject->indexed && renderObject->meshlets)
+					{
+						for (const MeshLOD& range : renderObject->visibleIndexRanges)
+						{
+							glDrawElementsInstancedBaseVertexBaseInstance(renderObject->topology, (GLsizei)range.indexCount, renderObject->indexType,
+								GetIndexBufferOffset(renderObject->indexType, renderObject->indexBufferOffset + range.firstIndex), 1, renderObject->baseVertex, i);
+							++m_DrawCallCount;
+						}
+						CheckGLErrorMessages();
+					}
+					else if (renderObject->indexed)
+					{
+						glDrawElementsInstancedBaseVertexBaseInstance(renderObject->topology, (GLsizei)renderObject->indexCount, renderObject->indexType,
+							GetIndexBufferOffset(renderObject->indexType, renderObject->indexBufferOffset + renderObject->firstIndex), (GLsizei)instanceCount,
+							renderObject->baseVertex, i);
+						CheckGLErrorMessages();
+						++m_DrawCallCount;
+					}
+					else
+					{
+						glDrawArraysInstancedBaseInstance(renderObject->topology, 0, (GLsizei)renderObject->vertexCount, (GLsizei)instanceCount, i);
+						CheckGLErrorMessages();
+						++m_DrawCallCount;
+					}
+				}
+
+				i += instanceCount;
+			}
+		}
+
+		bool GLRenderer::CanDrawInstanced(const GLRenderObject* renderObject, const GLRenderObject* other) const
+		{
+			// Meshlets are culled per object, so each object draws different ranges
+			if (renderObject->meshlets || other->meshlets) return false;
+
+			// Objects in the same batch share a material (and so a shader), sharing buffers too means their VAOs are interchangeable
+			return
+				renderObject->vertexBufferData && renderObject->VBO == other->VBO &&
+				renderObject->baseVertex == other->baseVertex &&
+				renderObject->indexed == other->indexed &&
+				renderObject->IBO == other->IBO &&
+				renderObject->indexBufferOffset == other->indexBufferOffset &&
+				renderObject->firstIndex == other->firstIndex &&
+				renderObject->indexCount == other->indexCount &&
+				renderObject->vertexCount == other->vertexCount &&
+				renderObject->topology == other->topology &&
+				renderObject->enableCulling == other->enableCulling &&
+				renderObject->cullFace == other->cullFace &&
+				renderObject->depthTestReadFunc == other->depthTestReadFunc &&
+				renderObject->depthWriteEnable == other->depthWriteEnable;
+		}
+
+		bool GLRenderer::CanMultiDrawIndirect(const GLRenderObject* renderObject, const GLRenderObject* other) const
+		{
+			// Only the state set per draw needs to match, each command names its own mesh & meshlets' ranges become commands of their own
+			return
+				other->geometryPool != INVALID_GEOMETRY_POOL &&
+				renderObject->geometryPool == other->geometryPool &&
+				renderObject->indexType == other->indexType &&
+				renderObject->VAO == other->VAO &&
+				renderObject->topology == other->topology &&
+				renderObject->enableCulling == other->enableCulling &&
+				renderObject->cullFace == other->cullFace &&
+				renderObject->depthTestReadFunc == other->depthTestReadFunc &&
+				renderObject->depthWriteEnable == other->depthWriteEnable;
+		}
+
+		bool GLRenderer::MultiDrawIndirect(glm::uint first, glm::uint end)
+		{
+			if (!m_IndirectDrawBufferMapped || !m_PerObjectSSBOMapped) return false;
+
+			// Upper bound, instances of the same mesh are merged into one command below
+			glm::uint maxCommandCount = 0;
+			for (glm::uint i = first; i < end; ++i)
+			{
+				const GLRenderObject* renderObject = m_DrawList[i].renderObject;
+				maxCommandCount += renderObject->meshlets ? (glm::uint)renderObject->visibleIndexRanges.size() : 1;
+			}
+
+			if (m_IndirectDrawCommandCount + maxCommandCount > m_IndirectDrawBufferCapacity)
+			{
+				m_IndirectDrawBufferOverflowed = true;
+				return false;
+			}
+
+			// The region's fence was waited on in UpdatePerObjectBuffer, so the GPU is done reading any commands in it
+			const glm::uint firstCommand = m_PerObjectSSBORegion * m_IndirectDrawBufferCapacity + m_IndirectDrawCommandCount;
+			DrawElementsIndirectCommand* commands = m_IndirectDrawBufferMapped + firstCommand;
+			glm::uint commandCount = 0;
+
+			glm::uint i = first;
+			while (i < end)
+			{
+				const GLRenderObject* renderObject = m_DrawList[i].renderObject;
+
+				// As with direct draws, the base instance selects each entry's data in PerObjectBuffer
+				if (renderObject->meshlets)
+				{
+					for (const MeshLOD& range : renderObject->visibleIndexRanges)
+					{
+						commands[commandCount++] = { range.indexCount, 1, renderObject->indexBufferOffset + range.firstIndex, renderObject->baseVertex, i };
 					}
+					++i;
 				}
 				else
 				{
-					if (renderObject->indexed)
-					{
-						glDrawElements(renderObject->topology, (GLsizei)renderObject->indices->size(), GL_UNSIGNED_INT, (void*)renderObject->indices->data());
-						CheckGLErrorMessages();
-					}
-					else
+					glm::uint instanceCount = 1;
+					while (i + instanceCount < end && CanDrawInstanced(renderObject, m_DrawList[i + instanceCount].renderObject))
 					{
-						glDrawArrays(renderObject->topology, 0, (GLsizei)renderObject->vertexBufferData->VertexCount);
-						CheckGLErrorMessages();
+						++instanceCount;
 					}
+
+					commands[commandCount++] = { renderObject->indexCount, instanceCount, renderObject->indexBufferOffset + renderObject->firstIndex, renderObject->baseVertex, i };
+					i += instanceCount;
 				}
+			}
 
+			if (commandCount > 0)
+			{
+				const GLRenderObject* renderObject = m_DrawList[first].renderObject;
+				glMultiDrawElementsIndirect(renderObject->topology, renderObject->indexType, (void*)(sizeof(DrawElementsIndirectCommand) * firstCommand), (GLsizei)commandCount, 0);
+				CheckGLErrorMessages();
 			}
+
+			m_IndirectDrawCommandCount += commandCount;
+
+			return true;
 		}
 
 		glm::uint GLRenderer::BindTextures(Shader* shader, GLMaterial* glMaterial, glm::uint startingBinding)
@@ -1915,6 +3116,8 @@ namespace flex
 			textures.push_back({ shader->needMetallicSampler, material->enableMetallicSampler, glMaterial->metallicSamplerID, GL_TEXTURE_2D });
 			textures.push_back({ shader->needRoughnessSampler, material->enableRoughnessSampler, glMaterial->roughnessSamplerID, GL_TEXTURE_2D });
 			textures.push_back({ shader->needAOSampler, material->enableAOSampler, glMaterial->aoSamplerID, GL_TEXTURE_2D });
+			textures.push_back({ shader->needORMSampler, material->enableAOSampler || material->enableRoughnessSampler || material->enableMetallicSampler,
+				glMaterial->ormSamplerID, GL_TEXTURE_2D });
 			textures.push_back({ shader->needDiffuseSampler, material->enableDiffuseSampler, glMaterial->diffuseSamplerID, GL_TEXTURE_2D });
 			textures.push_back({ shader->needNormalSampler, material->enableNormalSampler, glMaterial->normalSamplerID, GL_TEXTURE_2D });
 			textures.push_back({ shader->needBRDFLUT, material->enableBRDFLUT, glMaterial->brdfLUTSamplerID, GL_TEXTURE_2D });
@@ -1929,9 +3132,7 @@ namespace flex
 				{
 					if (tex.enabled)
 					{
-						GLenum activeTexture = (GLenum)(GL_TEXTURE0 + (GLuint)binding);
-						glActiveTexture(activeTexture);
-						glBindTexture(tex.target, (GLuint)tex.textureID);
+						m_StateCache.BindTexture(binding, tex.target, (GLuint)tex.textureID);
 						CheckGLErrorMessages();
 					}
 					++binding;
@@ -1961,9 +3162,7 @@ namespace flex
 			glm::uint binding = startingBinding;
 			for (auto& frameBuffer : material->frameBuffers)
 			{
-				GLenum activeTexture = (GLenum)(GL_TEXTURE0 + (GLuint)binding);
-				glActiveTexture(activeTexture);
-				glBindTexture(GL_TEXTURE_2D, *((GLuint*)frameBuffer.second));
+				m_StateCache.BindTexture(binding, GL_TEXTURE_2D, *((GLuint*)frameBuffer.second));
 				CheckGLErrorMessages();
 				++binding;
 			}
@@ -1989,9 +3188,7 @@ namespace flex
 			glm::uint binding = startingBinding;
 			for (auto& cubemapGBuffer : glMaterial->cubemapSamplerGBuffersIDs)
 			{
-				GLenum activeTexture = (GLenum)(GL_TEXTURE0 + (GLuint)binding);
-				glActiveTexture(activeTexture);
-				glBindTexture(GL_TEXTURE_CUBE_MAP, cubemapGBuffer.id);
+				m_StateCache.BindTexture(binding, GL_TEXTURE_CUBE_MAP, cubemapGBuffer.id);
 				CheckGLErrorMessages();
 				++binding;
 			}
@@ -2051,22 +3248,22 @@ namespace flex
 				{ "background", RESOURCE_LOCATION + "shaders/GLSL/background.vert", RESOURCE_LOCATION + "shaders/GLSL/background.frag" },
 				{ "sprite", RESOURCE_LOCATION + "shaders/GLSL/sprite.vert", RESOURCE_LOCATION + "shaders/GLSL/sprite.frag" },
 				{ "post_process", RESOURCE_LOCATION + "shaders/GLSL/post_process.vert", RESOURCE_LOCATION + "shaders/GLSL/post_process.frag" },
+				{ "pbr_compressed", RESOURCE_LOCATION + "shaders/GLSL/pbr_compressed.vert", RESOURCE_LOCATION + "shaders/GLSL/pbr.frag" },
+				{ "pbr_orm", RESOURCE_LOCATION + "shaders/GLSL/pbr.vert", RESOURCE_LOCATION + "shaders/GLSL/pbr_orm.frag" },
+				{ "pbr_compressed_orm", RESOURCE_LOCATION + "shaders/GLSL/pbr_compressed.vert", RESOURCE_LOCATION + "shaders/GLSL/pbr_orm.frag" },
 			};
 
 			ShaderID shaderID = 0;
 
 			// TOOD: Determine this info automatically when parsing shader code
+			// Shaders which declare PerFrameUBO get their camera & lights from it, so don't list those uniforms here
+			// Likewise for model matrices in shaders which declare PerObjectBuffer
 
 			// Deferred Simple
 			m_Shaders[shaderID].shader.deferred = true;
 			m_Shaders[shaderID].shader.needDiffuseSampler = true;
 			m_Shaders[shaderID].shader.needNormalSampler = true;
 
-			m_Shaders[shaderID].shader.constantBufferUniforms.AddUniform("view");
-			m_Shaders[shaderID].shader.constantBufferUniforms.AddUniform("projection");
-
-			m_Shaders[shaderID].shader.dynamicBufferUniforms.AddUniform("model");
-			m_Shaders[shaderID].shader.dynamicBufferUniforms.AddUniform("modelInvTranspose");
 			m_Shaders[shaderID].shader.dynamicBufferUniforms.AddUniform("enableDiffuseSampler");
 			m_Shaders[shaderID].shader.dynamicBufferUniforms.AddUniform("enableNormalSampler");
 			++shaderID;
@@ -2077,14 +3274,13 @@ namespace flex
 			m_Shaders[shaderID].shader.needIrradianceSampler = true;
 			m_Shaders[shaderID].shader.needPrefilteredMap = true;
 
-			m_Shaders[shaderID].shader.constantBufferUniforms.AddUniform("camPos");
-			m_Shaders[shaderID].shader.constantBufferUniforms.AddUniform("pointLights");
-			m_Shaders[shaderID].shader.constantBufferUniforms.AddUniform("dirLight");
 			m_Shaders[shaderID].shader.constantBufferUniforms.AddUniform("irradianceSampler");
 			m_Shaders[shaderID].shader.constantBufferUniforms.AddUniform("prefilterMap");
 			m_Shaders[shaderID].shader.constantBufferUniforms.AddUniform("brdfLUT");
 
 			m_Shaders[shaderID].shader.dynamicBufferUniforms.AddUniform("enableIrradianceSampler");
+			m_Shaders[shaderID].shader.dynamicBufferUniforms.AddUniform("enableIrradianceSH");
+			m_Shaders[shaderID].shader.dynamicBufferUniforms.AddUniform("irradianceSH");
 			++shaderID;
 
 			// Deferred combine cubemap
@@ -2093,25 +3289,21 @@ namespace flex
 			m_Shaders[shaderID].shader.needIrradianceSampler = true;
 			m_Shaders[shaderID].shader.needPrefilteredMap = true;
 
-			m_Shaders[shaderID].shader.constantBufferUniforms.AddUniform("view");
-			m_Shaders[shaderID].shader.constantBufferUniforms.AddUniform("projection");
-			m_Shaders[shaderID].shader.constantBufferUniforms.AddUniform("camPos");
-			m_Shaders[shaderID].shader.constantBufferUniforms.AddUniform("pointLights");
-			m_Shaders[shaderID].shader.constantBufferUniforms.AddUniform("dirLight");
 			m_Shaders[shaderID].shader.constantBufferUniforms.AddUniform("irradianceSampler");
 			m_Shaders[shaderID].shader.constantBufferUniforms.AddUniform("prefilterMap");
 			m_Shaders[shaderID].shader.constantBufferUniforms.AddUniform("brdfLUT");
 
 			m_Shaders[shaderID].shader.dynamicBufferUniforms.AddUniform("model");
 			m_Shaders[shaderID].shader.dynamicBufferUniforms.AddUniform("enableIrradianceSampler");
+			m_Shaders[shaderID].shader.dynamicBufferUniforms.AddUniform("enableIrradianceSH");
+			m_Shaders[shaderID].shader.dynamicBufferUniforms.AddUniform("irradianceSH");
 			++shaderID;
 
 			// Color
 			m_Shaders[shaderID].shader.deferred = false;
-			m_Shaders[shaderID].shader.constantBufferUniforms.AddUniform("view");
-			m_Shaders[shaderID].shader.constantBufferUniforms.AddUniform("projection");
+			m_Shaders[shaderID].shader.constantBufferUniforms = {};
 
-			m_Shaders[shaderID].shader.dynamicBufferUniforms.AddUniform("model");
+			m_Shaders[shaderID].shader.dynamicBufferUniforms = {};
 			++shaderID;
 
 			// ImGui
@@ -2129,9 +3321,6 @@ namespace flex
 			m_Shaders[shaderID].shader.needAOSampler = true;
 			m_Shaders[shaderID].shader.needNormalSampler = true;
 
-			m_Shaders[shaderID].shader.constantBufferUniforms.AddUniform("view");
-			m_Shaders[shaderID].shader.constantBufferUniforms.AddUniform("projection");
-
 			m_Shaders[shaderID].shader.dynamicBufferUniforms.AddUniform("constAlbedo");
 			m_Shaders[shaderID].shader.dynamicBufferUniforms.AddUniform("enableAlbedoSampler");
 			m_Shaders[shaderID].shader.dynamicBufferUniforms.AddUniform("albedoSampler");
@@ -2146,7 +3335,6 @@ namespace flex
 			m_Shaders[shaderID].shader.dynamicBufferUniforms.AddUniform("aoSampler");
 			m_Shaders[shaderID].shader.dynamicBufferUniforms.AddUniform("enableNormalSampler");
 			m_Shaders[shaderID].shader.dynamicBufferUniforms.AddUniform("normalSampler");
-			m_Shaders[shaderID].shader.dynamicBufferUniforms.AddUniform("model");
 			++shaderID;
 
 			// Skybox
@@ -2205,11 +3393,9 @@ namespace flex
 			m_Shaders[shaderID].shader.deferred = false;
 			m_Shaders[shaderID].shader.needCubemapSampler = true;
 
-			m_Shaders[shaderID].shader.constantBufferUniforms.AddUniform("view");
-			m_Shaders[shaderID].shader.constantBufferUniforms.AddUniform("projection");
 			m_Shaders[shaderID].shader.constantBufferUniforms.AddUniform("cubemapSampler");
 
-			m_Shaders[shaderID].shader.dynamicBufferUniforms.AddUniform("model");
+			m_Shaders[shaderID].shader.dynamicBufferUniforms = {};
 			++shaderID;
 
 			// Sprite
@@ -2226,6 +3412,53 @@ namespace flex
 			m_Shaders[shaderID].shader.dynamicBufferUniforms = {};
 			++shaderID;
 
+			// PBR (compressed vertex attributes)
+			m_Shaders[shaderID].shader.deferred = true;
+			m_Shaders[shaderID].shader.needAlbedoSampler = true;
+			m_Shaders[shaderID].shader.needMetallicSampler = true;
+			m_Shaders[shaderID].shader.needRoughnessSampler = true;
+			m_Shaders[shaderID].shader.needAOSampler = true;
+			m_Shaders[shaderID].shader.needNormalSampler = true;
+
+			m_Shaders[shaderID].shader.dynamicBufferUniforms.AddUniform("constAlbedo");
+			m_Shaders[shaderID].shader.dynamicBufferUniforms.AddUniform("enableAlbedoSampler");
+			m_Shaders[shaderID].shader.dynamicBufferUniforms.AddUniform("albedoSampler");
+			m_Shaders[shaderID].shader.dynamicBufferUniforms.AddUniform("constMetallic");
+			m_Shaders[shaderID].shader.dynamicBufferUniforms.AddUniform("enableMetallicSampler");
+			m_Shaders[shaderID].shader.dynamicBufferUniforms.AddUniform("metallicSampler");
+			m_Shaders[shaderID].shader.dynamicBufferUniforms.AddUniform("constRoughness");
+			m_Shaders[shaderID].shader.dynamicBufferUniforms.AddUniform("enableRoughnessSampler");
+			m_Shaders[shaderID].shader.dynamicBufferUniforms.AddUniform("roughnessSampler");
+			m_Shaders[shaderID].shader.dynamicBufferUniforms.AddUniform("enableAOSampler");
+			m_Shaders[shaderID].shader.dynamicBufferUniforms.AddUniform("constAO");
+			m_Shaders[shaderID].shader.dynamicBufferUniforms.AddUniform("aoSampler");
+			m_Shaders[shaderID].shader.dynamicBufferUniforms.AddUniform("enableNormalSampler");
+			m_Shaders[shaderID].shader.dynamicBufferUniforms.AddUniform("normalSampler");
+			++shaderID;
+
+			// PBR & PBR (compressed vertex attributes) with packed occlusion, roughness & metallic maps
+			for (glm::uint i = 0; i < 2; ++i)
+			{
+				m_Shaders[shaderID].shader.deferred = true;
+				m_Shaders[shaderID].shader.needAlbedoSampler = true;
+				m_Shaders[shaderID].shader.needORMSampler = true;
+				m_Shaders[shaderID].shader.needNormalSampler = true;
+
+				m_Shaders[shaderID].shader.dynamicBufferUniforms.AddUniform("constAlbedo");
+				m_Shaders[shaderID].shader.dynamicBufferUniforms.AddUniform("enableAlbedoSampler");
+				m_Shaders[shaderID].shader.dynamicBufferUniforms.AddUniform("albedoSampler");
+				m_Shaders[shaderID].shader.dynamicBufferUniforms.AddUniform("constMetallic");
+				m_Shaders[shaderID].shader.dynamicBufferUniforms.AddUniform("enableMetallicSampler");
+				m_Shaders[shaderID].shader.dynamicBufferUniforms.AddUniform("constRoughness");
+				m_Shaders[shaderID].shader.dynamicBufferUniforms.AddUniform("enableRoughnessSampler");
+				m_Shaders[shaderID].shader.dynamicBufferUniforms.AddUniform("enableAOSampler");
+				m_Shaders[shaderID].shader.dynamicBufferUniforms.AddUniform("constAO");
+				m_Shaders[shaderID].shader.dynamicBufferUniforms.AddUniform("ormSampler");
+				m_Shaders[shaderID].shader.dynamicBufferUniforms.AddUniform("enableNormalSampler");
+				m_Shaders[shaderID].shader.dynamicBufferUniforms.AddUniform("normalSampler");
+				++shaderID;
+			}
+
 			for (size_t i = 0; i < m_Shaders.size(); ++i)
 			{
 				m_Shaders[i].program = glCreateProgram();
@@ -2237,6 +3470,19 @@ namespace flex
 				}
 
 				LinkProgram(m_Shaders[i].program);
+
+				const GLuint perFrameBlockIndex = glGetUniformBlockIndex(m_Shaders[i].program, "PerFrameUBO");
+				if (perFrameBlockIndex != GL_INVALID_INDEX)
+				{
+					glUniformBlockBinding(m_Shaders[i].program, perFrameBlockIndex, PER_FRAME_UBO_BINDING);
+				}
+
+				const GLuint perObjectBlockIndex = glGetProgramResourceIndex(m_Shaders[i].program, GL_SHADER_STORAGE_BLOCK, "PerObjectBuffer");
+				m_Shaders[i].usesPerObjectBuffer = (perObjectBlockIndex != GL_INVALID_INDEX);
+				if (m_Shaders[i].usesPerObjectBuffer)
+				{
+					glShaderStorageBlockBinding(m_Shaders[i].program, perObjectBlockIndex, PER_OBJECT_SSBO_BINDING);
+				}
 			}
 
 			glm::uint imGuiShaderID;
@@ -2252,136 +3498,73 @@ namespace flex
 			CheckGLErrorMessages();
 		}
 
-		void GLRenderer::UpdateMaterialUniforms(const GameContext& gameContext, MaterialID materialID)
+		void GLRenderer::UpdatePerFrameUBO(const GameContext& gameContext)
 		{
-			GLint last_program; glGetIntegerv(GL_CURRENT_PROGRAM, &last_program);
-
-			GLMaterial* material = &m_Materials[materialID];
-			GLShader* shader = &m_Shaders[material->material.shaderID];
-			
-			glUseProgram(shader->program);
-
-			glm::mat4 proj = gameContext.camera->GetProjection();
-			glm::mat4 view = gameContext.camera->GetView();
-			glm::mat4 viewInv = glm::inverse(view);
-			glm::mat4 viewProj = proj * view;
-			glm::vec4 camPos = glm::vec4(gameContext.camera->GetPosition(), 0.0f);
-
-
-			if (shader->shader.constantBufferUniforms.HasUniform("view"))
-			{
-				glUniformMatrix4fv(material->uniformIDs.view, 1, false, &view[0][0]);
-				CheckGLErrorMessages();
-			}
-
-			if (shader->shader.constantBufferUniforms.HasUniform("viewInv"))
-			{
-				glUniformMatrix4fv(material->uniformIDs.viewInv, 1, false, &viewInv[0][0]);
-				CheckGLErrorMessages();
-			}
-
-			if (shader->shader.constantBufferUniforms.HasUniform("projection"))
-			{
-				glUniformMatrix4fv(material->uniformIDs.projection, 1, false, &proj[0][0]);
-				CheckGLErrorMessages();
-			}
-
-			if (shader->shader.constantBufferUniforms.HasUniform("viewProjection"))
-			{
-				glUniformMatrix4fv(material->uniformIDs.viewProjection, 1, false, &viewProj[0][0]);
-				CheckGLErrorMessages();
-			}
-
-			if (shader->shader.constantBufferUniforms.HasUniform("camPos"))
+			PerFrameUBO perFrameData = {};
+			perFrameData.view = gameContext.camera->GetView();
+			perFrameData.viewInv = glm::inverse(perFrameData.view);
+			perFrameData.projection = gameContext.camera->GetProjection();
+			perFrameData.viewProjection = perFrameData.projection * perFrameData.view;
+			perFrameData.camPos = glm::vec4(gameContext.camera->GetPosition(), 0.0f);
+			perFrameData.dirLight = m_DirectionalLight;
+
+			// PerFrameUBO has room for MAX_POINT_LIGHTS point lights, the size of the array shaders declare
+			if (m_PointLights.size() > MAX_POINT_LIGHTS && m_PointLights.size() != m_LastWarnedPointLightCount)
 			{
-				glUniform4f(material->uniformIDs.camPos,
-					camPos.x,
-					camPos.y,
-					camPos.z,
-					camPos.w);
-				CheckGLErrorMessages();
+				Logger::LogWarning("Only the first " + std::to_string(MAX_POINT_LIGHTS) + " of " + std::to_string(m_PointLights.size()) +
+					" point lights will be rendered!");
 			}
-
-			if (shader->shader.constantBufferUniforms.HasUniform("dirLight"))
+			m_LastWarnedPointLightCount = m_PointLights.size();
+			const size_t pointLightCount = std::min(m_PointLights.size(), (size_t)MAX_POINT_LIGHTS);
+			for (size_t i = 0; i < pointLightCount; ++i)
 			{
-				if (m_DirectionalLight.enabled)
-				{
-					SetUInt(material->material.shaderID, "dirLight.enabled", 1);
-					CheckGLErrorMessages();
-					SetVec4f(material->material.shaderID, "dirLight.direction", m_DirectionalLight.direction);
-					CheckGLErrorMessages();
-					SetVec4f(material->material.shaderID, "dirLight.color", m_DirectionalLight.color);
-					CheckGLErrorMessages();
-				}
-				else
-				{
-					SetUInt(material->material.shaderID, "dirLight.enabled", 0);
-					CheckGLErrorMessages();
-				}
+				perFrameData.pointLights[i] = m_PointLights[i];
 			}
-
-			if (shader->shader.constantBufferUniforms.HasUniform("pointLights"))
+			for (size_t i = pointLightCount; i < MAX_POINT_LIGHTS; ++i)
 			{
-				for (size_t i = 0; i < m_PointLights.size(); ++i)
-				{
-					const std::string numberStr = std::to_string(i);
-
-					if (m_PointLights[i].enabled)
-					{
-						SetUInt(material->material.shaderID, "pointLights[" + numberStr + "].enabled", 1);
-						CheckGLErrorMessages();
-
-						SetVec4f(material->material.shaderID, "pointLights[" + numberStr + "].position", m_PointLights[i].position);
-						CheckGLErrorMessages();
-
-						SetVec4f(material->material.shaderID, "pointLights[" + numberStr + "].color", m_PointLights[i].color);
-						CheckGLErrorMessages();
-					}
-					else
-					{
-						SetUInt(material->material.shaderID, "pointLights[" + numberStr + "].enabled", 0);
-						CheckGLErrorMessages();
-					}
-				}
+				perFrameData.pointLights[i].enabled = 0;
 			}
 
-			glUseProgram(last_program);
+			glBindBuffer(GL_UNIFORM_BUFFER, m_PerFrameUBO);
+			glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(PerFrameUBO), &perFrameData);
+			glBindBuffer(GL_UNIFORM_BUFFER, 0);
 			CheckGLErrorMessages();
 		}
 
-		void GLRenderer::UpdatePerObjectUniforms(RenderID renderID, const GameContext& gameContext)
+		void GLRenderer::UpdatePerFrameUBOCamera(const glm::mat4& view, const glm::mat4& projection)
 		{
-			GLRenderObject* renderObject = GetRenderObject(renderID);
-			if (!renderObject) return;
+			// The matrices are the first members, in the same order
+			const glm::mat4 matrices[4] = { view, glm::inverse(view), projection, projection * view };
 
-			glm::mat4 model = renderObject->transform->GetModelMatrix();
-			UpdatePerObjectUniforms(renderObject->materialID, model, gameContext);
+			glBindBuffer(GL_UNIFORM_BUFFER, m_PerFrameUBO);
+			glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(matrices), matrices);
+			glBindBuffer(GL_UNIFORM_BUFFER, 0);
+			CheckGLErrorMessages();
 		}
 
-		void GLRenderer::UpdatePerObjectUniforms(MaterialID materialID, const glm::mat4& model, const GameContext& gameContext)
+		void GLRenderer::UpdateMaterialUniforms(const GameContext& gameContext, MaterialID materialID)
 		{
 			GLMaterial* material = &m_Materials[materialID];
 			GLShader* shader = &m_Shaders[material->material.shaderID];
 
-			glm::mat4 modelInv = glm::inverse(model);
-			glm::mat4 proj = gameContext.camera->GetProjection();
-			glm::mat4 view = gameContext.camera->GetView();
-			glm::mat4 MVP = proj * view * model;
+			m_StateCache.UseProgram(shader->program);
 
-			// TODO: Use set functions here (SetFloat, SetMatrix, ...)
-			if (shader->shader.dynamicBufferUniforms.HasUniform("model"))
+			// Only shaders which don't use PerFrameUBO yet (eg. skybox.vert, shared with the cubemap generation shaders) need these
+			if (shader->shader.constantBufferUniforms.HasUniform("view"))
 			{
-				glUniformMatrix4fv(material->uniformIDs.model, 1, false, &model[0][0]);
+				glm::mat4 view = gameContext.camera->GetView();
+				glUniformMatrix4fv(material->uniformIDs.view, 1, false, &view[0][0]);
 				CheckGLErrorMessages();
 			}
 
-			if (shader->shader.dynamicBufferUniforms.HasUniform("modelInvTranspose"))
+			if (shader->shader.constantBufferUniforms.HasUniform("projection"))
 			{
-				// OpenGL will transpose for us if we set the third param to true
-				glUniformMatrix4fv(material->uniformIDs.modelInvTranspose, 1, true, &modelInv[0][0]);
+				glm::mat4 proj = gameContext.camera->GetProjection();
+				glUniformMatrix4fv(material->uniformIDs.projection, 1, false, &proj[0][0]);
 				CheckGLErrorMessages();
 			}
 
+			// These only depend on the material, so are set once per batch rather than per object
 			if (shader->shader.dynamicBufferUniforms.HasUniform("enableDiffuseSampler"))
 			{
 				glUniform1i(material->uniformIDs.enableDiffuseTexture, material->material.enableDiffuseSampler);
@@ -2453,6 +3636,51 @@ namespace flex
 				glUniform1i(material->uniformIDs.enableIrradianceSampler, material->material.enableIrradianceSampler);
 				CheckGLErrorMessages();
 			}
+
+			if (shader->shader.dynamicBufferUniforms.HasUniform("enableIrradianceSH"))
+			{
+				const GLMaterial* irradianceMaterial = (material->irradianceSourceMatID < m_Materials.size() ? &m_Materials[material->irradianceSourceMatID] : nullptr);
+				const bool enableIrradianceSH = (irradianceMaterial && irradianceMaterial->irradianceSHGenerated);
+				glUniform1i(material->uniformIDs.enableIrradianceSH, enableIrradianceSH);
+				if (enableIrradianceSH)
+				{
+					glUniform3fv(material->uniformIDs.irradianceSH, 9, &irradianceMaterial->irradianceSH.coefficients[0].x);
+				}
+				CheckGLErrorMessages();
+			}
+		}
+
+		void GLRenderer::UpdatePerObjectUniforms(RenderID renderID, const GameContext& gameContext)
+		{
+			GLRenderObject* renderObject = GetRenderObject(renderID);
+			if (!renderObject) return;
+
+			glm::mat4 model = renderObject->transform->GetModelMatrix();
+			UpdatePerObjectUniforms(renderObject->materialID, model, gameContext);
+		}
+
+		void GLRenderer::UpdatePerObjectUniforms(MaterialID materialID, const glm::mat4& model, const GameContext& gameContext)
+		{
+			UNREFERENCED_PARAMETER(gameContext);
+
+			GLMaterial* material = &m_Materials[materialID];
+			GLShader* shader = &m_Shaders[material->material.shaderID];
+
+			// TODO: Use set functions here (SetFloat, SetMatrix, ...)
+			if (shader->shader.dynamicBufferUniforms.HasUniform("model"))
+			{
+				glUniformMatrix4fv(material->uniformIDs.model, 1, false, &model[0][0]);
+				CheckGLErrorMessages();
+			}
+
+			if (shader->shader.dynamicBufferUniforms.HasUniform("modelInvTranspose"))
+			{
+				glm::mat4 modelInv = glm::inverse(model);
+
+				// OpenGL will transpose for us if we set the third param to true
+				glUniformMatrix4fv(material->uniformIDs.modelInvTranspose, 1, true, &modelInv[0][0]);
+				CheckGLErrorMessages();
+			}
 		}
 
 		void GLRenderer::OnWindowSize(int width, int height)
@@ -2501,7 +3729,17 @@ namespace flex
 		void GLRenderer::SetRenderObjectVisible(RenderID renderID, bool visible)
 		{
 			GLRenderObject* renderObject = GetRenderObject(renderID);
-			if (renderObject) renderObject->visible = visible;
+			if (!renderObject || renderObject->visible == visible) return;
+
+			renderObject->visible = visible;
+			if (visible)
+			{
+				AddToDrawList(renderObject);
+			}
+			else
+			{
+				RemoveFromDrawList(renderObject);
+			}
 		}
 
 		void GLRenderer::SetVSyncEnabled(bool enableVSync)
@@ -2579,7 +3817,7 @@ namespace flex
 				m_SkyBoxMesh->LoadPrefabShape(gameContext, MeshPrefab::PrefabShape::SKYBOX);
 				m_SkyBoxMesh->Initialize(gameContext);
 				// This object is just used as a framebuffer target, don't render it normally
-				GetRenderObject(m_SkyBoxMesh->GetRenderID())->visible = false;
+				SetRenderObjectVisible(m_SkyBoxMesh->GetRenderID(), false);
 			}
 		}
 
@@ -2664,8 +3902,7 @@ namespace flex
 
 			m_gBufferQuadVertexBufferData.DescribeShaderVariables(this, m_GBufferQuadRenderID);
 
-			GLRenderObject* gBufferRenderObject = GetRenderObject(m_GBufferQuadRenderID);
-			gBufferRenderObject->visible = false; // Don't render the g buffer normally, we'll handle it separately
+			SetRenderObjectVisible(m_GBufferQuadRenderID, false); // Don't render the g buffer normally, we'll handle it separately
 		}
 
 		glm::uint GLRenderer::GetRenderObjectCount() const
@@ -2689,15 +3926,14 @@ namespace flex
 		void GLRenderer::DescribeShaderVariable(RenderID renderID, const std::string& variableName, int size,
 			Renderer::Type renderType, bool normalized, int stride, void* pointer)
 		{
-			GLint last_program; glGetIntegerv(GL_CURRENT_PROGRAM, &last_program);
-
 			GLRenderObject* renderObject = GetRenderObject(renderID);
 			if (!renderObject) return;
 
 			GLMaterial* material = &m_Materials[renderObject->materialID];
 			glm::uint program = m_Shaders[material->material.shaderID].program;
 
-
+			// Called between frames, after code which binds things without going through m_StateCache, so its state can't be
+			// trusted to skip these. It's invalidated instead once they're changed
 			glUseProgram(program);
 
 			glBindVertexArray(renderObject->VAO);
@@ -2708,17 +3944,26 @@ namespace flex
 			{
 				//Logger::LogWarning("Invalid shader variable name: " + variableName);
 				glBindVertexArray(0);
+				m_StateCache.Invalidate();
 				return;
 			}
 			glEnableVertexAttribArray((GLuint)location);
 
 			GLenum glRenderType = TypeToGLType(renderType);
-			glVertexAttribPointer((GLuint)location, size, glRenderType, (GLboolean)normalized, stride, pointer);
+			if (renderObject->geometryPool != INVALID_GEOMETRY_POOL)
+			{
+				// The pool's vertex buffer & stride are already bound to the shared VAO, only the attribute's format is needed
+				glVertexAttribFormat((GLuint)location, size, glRenderType, (GLboolean)normalized, (GLuint)((char*)pointer - (char*)0));
+				glVertexAttribBinding((GLuint)location, GEOMETRY_POOL_VERTEX_BINDING);
+			}
+			else
+			{
+				glVertexAttribPointer((GLuint)location, size, glRenderType, (GLboolean)normalized, stride, pointer);
+			}
 			CheckGLErrorMessages();
 
 			glBindVertexArray(0);
-
-			glUseProgram(last_program);
+			m_StateCache.Invalidate();
 		}
 
 		void GLRenderer::SetSkyboxMaterial(MaterialID skyboxMaterialID)
@@ -2727,6 +3972,13 @@ namespace flex
 
 			m_SkyBoxMaterialID = skyboxMaterialID;
 
+			// Only filled in on the next draw, but must exist now so other materials can be pointed at them
+			GLMaterial& skyboxMaterial = m_Materials[m_SkyBoxMaterialID];
+			if (skyboxMaterial.lazyEnvironmentMaps && !skyboxMaterial.environmentMapsResident)
+			{
+				CreateEnvironmentMapTextures(m_SkyBoxMaterialID);
+			}
+
 			for (glm::uint i = 0; i < m_RenderObjects.size(); ++i)
 			{
 				GLRenderObject* renderObject = GetRenderObject(i);
@@ -2734,17 +3986,37 @@ namespace flex
 				{
 					GLMaterial* mat = &m_Materials[renderObject->materialID];
 					mat->irradianceSamplerID = m_Materials[m_SkyBoxMaterialID].irradianceSamplerID;
+					mat->irradianceSourceMatID = m_SkyBoxMaterialID;
 					mat->prefilteredMapSamplerID = m_Materials[m_SkyBoxMaterialID].prefilteredMapSamplerID;
+					mat->prefilteredMapSourceMatID = m_SkyBoxMaterialID;
 				}
 			}
 		}
 
+		void GLRenderer::SetEnvironmentMapEvictionDelay(float seconds)
+		{
+			m_EnvironmentMapEvictionDelay = seconds;
+		}
+
 		void GLRenderer::SetRenderObjectMaterialID(RenderID renderID, MaterialID materialID)
 		{
 			GLRenderObject* renderObject = GetRenderObject(renderID);
 			if (renderObject)
 			{
+				auto previousMaterialIter = m_Materials.find(renderObject->materialID);
+				auto materialIter = m_Materials.find(materialID);
 				renderObject->materialID = materialID;
+
+				const auto getPoolVAO = [this](glm::uint poolIndex, ShaderID shaderID) { return GetGeometryPoolVAO(poolIndex, shaderID); };
+				if (previousMaterialIter != m_Materials.end() && materialIter != m_Materials.end() && renderObject->vertexBufferData &&
+					SelectVAOForShader(*renderObject, previousMaterialIter->second.material.shaderID, materialIter->second.material.shaderID, getPoolVAO))
+				{
+					// Also leaves the object's vertex buffer bound, as DescribeShaderVariable expects
+					BindObjectIndexAttribute(renderObject);
+					renderObject->vertexBufferData->DescribeShaderVariables(this, renderID);
+				}
+
+				UpdateDrawListEntry(renderObject);
 			}
 			else
 			{
@@ -2752,17 +4024,91 @@ namespace flex
 			}
 		}
 
+		void GLRenderer::SetRenderObjectIndexRange(RenderID renderID, glm::uint firstIndex, glm::uint indexCount)
+		{
+			GLRenderObject* renderObject = GetRenderObject(renderID);
+			if (!renderObject || !renderObject->indexed)
+			{
+				Logger::LogError("SetRenderObjectIndexRange couldn't find indexed render object with ID " + std::to_string(renderID));
+				return;
+			}
+
+			if ((size_t)firstIndex + indexCount > renderObject->totalIndexCount)
+			{
+				Logger::LogError("SetRenderObjectIndexRange called with out of bounds range on render object " + renderObject->name);
+				return;
+			}
+
+			renderObject->firstIndex = firstIndex;
+			renderObject->indexCount = indexCount;
+		}
+
+		void GLRenderer::SetRenderObjectMeshlets(RenderID renderID, const std::vector<Meshlet>* meshlets)
+		{
+			GLRenderObject* renderObject = GetRenderObject(renderID);
+			if (!renderObject || !renderObject->indexed)
+			{
+				Logger::LogError("SetRenderObjectMeshlets couldn't find indexed render object with ID " + std::to_string(renderID));
+				return;
+			}
+
+			renderObject->meshlets = meshlets;
+			renderObject->visibleIndexRanges.clear();
+		}
+
+		bool GLRenderer::GetRenderObjectWorldBounds(RenderID renderID, MeshBounds& worldBounds)
+		{
+			GLRenderObject* renderObject = GetRenderObject(renderID);
+			if (!renderObject || !renderObject->hasBounds)
+			{
+				return false;
+			}
+
+			UpdateWorldBounds(renderObject->transform, renderObject->localBounds, renderObject->worldBounds, renderObject->worldBoundsVersion);
+			worldBounds = renderObject->worldBounds;
+			return true;
+		}
+
+		bool GLRenderer::IsRenderObjectUploaded(RenderID renderID)
+		{
+			// Buffers are filled as soon as the object is created
+			GLRenderObject* renderObject = GetRenderObject(renderID);
+			return renderObject != nullptr;
+		}
+
 		void GLRenderer::Destroy(RenderID renderID)
 		{
 			GLRenderObject* renderObject = GetRenderObject(renderID);
 			if (!renderObject) return;
 
+			RemoveFromDrawList(renderObject);
 			m_RenderObjects[renderObject->renderID] = nullptr;
 
-			glDeleteBuffers(1, &renderObject->VBO);
-			if (renderObject->indexed)
+			if (renderObject->vertexBufferData)
 			{
-				glDeleteBuffers(1, &renderObject->IBO);
+				auto sharedBufferIter = m_SharedBuffers.find(GetSharedBufferKey(renderObject));
+				if (sharedBufferIter != m_SharedBuffers.end() && --sharedBufferIter->second.refCount == 0)
+				{
+					if (sharedBufferIter->second.geometryPool != INVALID_GEOMETRY_POOL)
+					{
+						ReleaseFromGeometryPool(sharedBufferIter->second);
+					}
+					else
+					{
+						glDeleteBuffers(1, &sharedBufferIter->second.VBO);
+						if (sharedBufferIter->second.IBO != 0)
+						{
+							glDeleteBuffers(1, &sharedBufferIter->second.IBO);
+						}
+					}
+					m_SharedBuffers.erase(sharedBufferIter);
+				}
+
+				// Pools' VAOs are shared, they're destroyed along with the pools
+				if (renderObject->geometryPool == INVALID_GEOMETRY_POOL)
+				{
+					glDeleteVertexArrays(1, &renderObject->VAO);
+				}
 			}
 
 			SafeDelete(renderObject);
@@ -2853,6 +4199,16 @@ namespace flex
 				const std::string objectCountStr("Render object count/capacity: " + std::to_string(objectCount) + "/" + std::to_string(objectCapacity));
 				ImGui::Text(objectCountStr.c_str());
 
+				const GLStateCache::Stats& stateCacheStats = m_StateCache.GetLastFrameStats();
+				const std::string stateCallsStr("GL state calls issued/skipped: " + std::to_string(stateCacheStats.issuedCalls) + "/" + std::to_string(stateCacheStats.skippedCalls));
+				ImGui::Text(stateCallsStr.c_str());
+
+				const std::string drawCallsStr("Draw list objects/draw calls: " + std::to_string(m_DrawList.size()) + "/" + std::to_string(m_LastFrameDrawCallCount));
+				ImGui::Text(drawCallsStr.c_str());
+
+				const std::string geometryPoolsStr("Geometry pools: " + std::to_string(m_GeometryPools.size()));
+				ImGui::Text(geometryPoolsStr.c_str());
+
 				if (ImGui::TreeNode("Render Objects"))
 				{
 					for (size_t i = 0; i < m_RenderObjects.size(); ++i)
@@ -2862,7 +4218,11 @@ namespace flex
 						const std::string objectName(renderObject->name + "##" + std::to_string(i));
 
 						const std::string objectID("##" + objectName + "-visble");
-						ImGui::Checkbox(objectID.c_str(), &renderObject->visible);
+						bool visible = renderObject->visible;
+						if (ImGui::Checkbox(objectID.c_str(), &visible))
+						{
+							SetRenderObjectVisible(renderObject->renderID, visible);
+						}
 						ImGui::SameLine();
 						if (ImGui::TreeNode(objectName.c_str()))
 						{
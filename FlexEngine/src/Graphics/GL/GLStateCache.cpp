@@ -0,0 +1,142 @@
+#include "stdafx.hpp"
+#if COMPILE_OPEN_GL
+
+#include "Graphics/GL/GLStateCache.hpp"
+
+namespace flex
+{
+	namespace gl
+	{
+		GLStateCache::GLStateCache()
+		{
+			Invalidate();
+		}
+
+		void GLStateCache::BeginFrame()
+		{
+			m_LastFrameStats = m_FrameStats;
+			m_FrameStats = {};
+			Invalidate();
+		}
+
+		void GLStateCache::Invalidate()
+		{
+			m_Program = UNKNOWN;
+			m_VAO = UNKNOWN;
+			m_ArrayBuffer = UNKNOWN;
+			m_CullingEnabled = UNKNOWN;
+			m_CullFace = UNKNOWN;
+			m_DepthFunc = UNKNOWN;
+			m_DepthMask = UNKNOWN;
+			m_ActiveTextureUnit = UNKNOWN;
+			for (glm::uint i = 0; i < MAX_CACHED_TEXTURE_UNITS; ++i)
+			{
+				m_Textures2D[i] = UNKNOWN;
+				m_TexturesCube[i] = UNKNOWN;
+			}
+		}
+
+		void GLStateCache::UseProgram(GLuint program)
+		{
+			if (Changed(m_Program, program))
+			{
+				glUseProgram(program);
+			}
+		}
+
+		void GLStateCache::BindVertexArray(GLuint VAO)
+		{
+			if (Changed(m_VAO, VAO))
+			{
+				glBindVertexArray(VAO);
+			}
+		}
+
+		void GLStateCache::BindArrayBuffer(GLuint VBO)
+		{
+			if (Changed(m_ArrayBuffer, VBO))
+			{
+				glBindBuffer(GL_ARRAY_BUFFER, VBO);
+			}
+		}
+
+		void GLStateCache::SetCullingEnabled(GLboolean enabled)
+		{
+			if (Changed(m_CullingEnabled, enabled ? GL_TRUE : GL_FALSE))
+			{
+				if (enabled) glEnable(GL_CULL_FACE);
+				else glDisable(GL_CULL_FACE);
+			}
+		}
+
+		void GLStateCache::CullFace(GLenum mode)
+		{
+			if (Changed(m_CullFace, mode))
+			{
+				glCullFace(mode);
+			}
+		}
+
+		void GLStateCache::DepthFunc(GLenum func)
+		{
+			if (Changed(m_DepthFunc, func))
+			{
+				glDepthFunc(func);
+			}
+		}
+
+		void GLStateCache::DepthMask(GLboolean enabled)
+		{
+			if (Changed(m_DepthMask, enabled ? GL_TRUE : GL_FALSE))
+			{
+				glDepthMask(enabled);
+			}
+		}
+
+		void GLStateCache::BindTexture(glm::uint unit, GLenum target, GLuint texture)
+		{
+			GLuint* cachedTexture = nullptr;
+			if (unit < MAX_CACHED_TEXTURE_UNITS)
+			{
+				if (target == GL_TEXTURE_2D) cachedTexture = &m_Textures2D[unit];
+				else if (target == GL_TEXTURE_CUBE_MAP) cachedTexture = &m_TexturesCube[unit];
+			}
+
+			if (cachedTexture && !Changed(*cachedTexture, texture))
+			{
+				return;
+			}
+
+			if (Changed(m_ActiveTextureUnit, unit))
+			{
+				glActiveTexture((GLenum)(GL_TEXTURE0 + unit));
+			}
+
+			glBindTexture(target, texture);
+			if (!cachedTexture)
+			{
+				++m_FrameStats.issuedCalls;
+			}
+		}
+
+		const GLStateCache::Stats& GLStateCache::GetLastFrameStats() const
+		{
+			return m_LastFrameStats;
+		}
+
+		bool GLStateCache::Changed(GLuint& cachedValue, GLuint newValue)
+		{
+			if (cachedValue == newValue)
+			{
+				++m_FrameStats.skippedCalls;
+				return false;
+			}
+
+			cachedValue = newValue;
+			++m_FrameStats.issuedCalls;
+			return true;
+		}
+	} // namespace gl
+} // namespace flex
+
+#endif // COMPILE_OPEN_GL
@@ -2,6 +2,8 @@
 
 #include "Graphics/Renderer.hpp"
 
+#include <glm/gtc/matrix_inverse.hpp>
+
 namespace flex
 {
 	Renderer::Renderer()
@@ -12,6 +14,80 @@ namespace flex
 	{
 	}
 
+	void Renderer::CullMeshlets(const glm::mat4& viewProjection, const glm::vec3& cameraPosition, const glm::mat4& model,
+		const std::vector<Meshlet>& meshlets, std::vector<MeshLOD>& visibleRanges)
+	{
+		visibleRanges.clear();
+
+		// Frustum planes in local space (see Gribb & Hartmann - "Fast Extraction of Viewing Frustum Planes from the World-View-Projection Matrix")
+		const glm::mat4 mvp = glm::transpose(viewProjection * model);
+		glm::vec4 planes[6] = {
+			mvp[3] + mvp[0], // Left
+			mvp[3] - mvp[0], // Right
+			mvp[3] + mvp[1], // Bottom
+			mvp[3] - mvp[1], // Top
+			mvp[3] + mvp[2], // Near
+			mvp[3] - mvp[2], // Far
+		};
+		for (glm::vec4& plane : planes)
+		{
+			plane /= glm::length(glm::vec3(plane));
+		}
+
+		const glm::vec3 localCameraPosition = glm::vec3(glm::affineInverse(model) * glm::vec4(cameraPosition, 1.0f));
+
+		for (const Meshlet& meshlet : meshlets)
+		{
+			bool visible = true;
+			for (const glm::vec4& plane : planes)
+			{
+				if (glm::dot(glm::vec3(plane), meshlet.center) + plane.w < -meshlet.radius)
+				{
+					visible = false;
+					break;
+				}
+			}
+
+			if (visible && meshlet.coneCutoff < 1.0f)
+			{
+				// Back-face culling is preserved by affine transforms, so the cone test holds in local space too
+				const glm::vec3 cameraToApex = meshlet.coneApex - localCameraPosition;
+				const float distance = glm::length(cameraToApex);
+				visible = (distance <= 0.0f || glm::dot(cameraToApex / distance, meshlet.coneAxis) < meshlet.coneCutoff);
+			}
+
+			if (!visible)
+			{
+				continue;
+			}
+
+			// Meshlets are stored contiguously, so runs of visible ones can be drawn together
+			if (!visibleRanges.empty() && visibleRanges.back().firstIndex + visibleRanges.back().indexCount == meshlet.firstIndex)
+			{
+				visibleRanges.back().indexCount += meshlet.indexCount;
+			}
+			else
+			{
+				visibleRanges.push_back({ meshlet.firstIndex, meshlet.indexCount });
+			}
+		}
+	}
+
+	void Renderer::SetEnvironmentMapEvictionDelay(float seconds)
+	{
+		UNREFERENCED_PARAMETER(seconds);
+	}
+
+	IBLBakeSettings Renderer::GetIBLBakeSettings(const Material& material, glm::uint prefilteredMipCount)
+	{
+		IBLBakeSettings settings = {};
+		settings.cubemapSize = material.cubemapSamplerSize.x;
+		settings.irradianceSize = material.irradianceSamplerSize.x;
+		settings.prefilteredSize = material.prefilteredMapSize.x;
+		settings.prefilteredMipCount = prefilteredMipCount;
+		return settings;
+	}
+
 	inline bool Renderer::Uniforms::HasUniform(const std::string& name) const
 	{
 		return (types.find(name) != types.end());
@@ -65,4 +141,20 @@ namespace flex
 
 		return size;
 	}
-} // namespace flex
\ No newline at end of file
+
+	void Renderer::UpdateWorldBounds(Transform* transform, const MeshBounds& localBounds, MeshBounds& worldBounds, glm::uint& worldBoundsVersion)
+	{
+		if (!transform)
+		{
+			worldBounds = localBounds;
+			return;
+		}
+
+		const glm::uint transformVersion = transform->GetVersion();
+		if (worldBoundsVersion != transformVersion)
+		{
+			worldBounds = TransformMeshBounds(localBounds, transform->GetModelMatrix());
+			worldBoundsVersion = transformVersion;
+		}
+	}
+} // namespace flex
@@ -0,0 +1,229 @@
+#include "stdafx.hpp"
+
+#include "Graphics/TextureLoader.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "stb_image.h"
+
+#include "Helpers.hpp"
+#include "Logger.hpp"
+#include "ThreadPool.hpp"
+
+namespace flex
+{
+	void DecodedImage::Free()
+	{
+		if (pixels)
+		{
+			stbi_image_free(pixels);
+			pixels = nullptr;
+		}
+		cooked.reset();
+	}
+
+	namespace
+	{
+		bool LoadCookedImage(const CookedTexture::Key& cookedKey, DecodedImage& result)
+		{
+			std::shared_ptr<CookedTexture> cooked = std::make_shared<CookedTexture>();
+			if (!cooked->Load(cookedKey))
+			{
+				return false;
+			}
+
+			result.width = (int)cooked->GetWidth();
+			result.height = (int)cooked->GetHeight();
+			result.cooked = cooked;
+			return true;
+		}
+
+		void CookImageAsync(ThreadPool* cookThreadPool, const CookedTexture::Key& cookedKey, const DecodedImage& image)
+		{
+			// Compressing takes far longer than decoding, so it's done on a copy in its own job rather than holding up this texture
+			auto pixelsCopy = std::make_shared<std::vector<unsigned char>>(image.pixels, image.pixels + (size_t)image.width * image.height * image.channels);
+			const glm::uint width = (glm::uint)image.width;
+			const glm::uint height = (glm::uint)image.height;
+			const int channels = image.channels;
+			cookThreadPool->Enqueue([cookedKey, pixelsCopy, width, height, channels]()
+			{
+				CookedTexture::Save(cookedKey, pixelsCopy->data(), width, height, (glm::uint)channels);
+			});
+		}
+
+		// Runs decode on threadPool, or immediately when threadPool is null
+		std::future<DecodedImage> RunDecodeTask(ThreadPool* threadPool, const std::function<DecodedImage()>& decode)
+		{
+			auto task = std::make_shared<std::packaged_task<DecodedImage()>>(decode);
+			std::future<DecodedImage> result = task->get_future();
+
+			if (threadPool)
+			{
+				threadPool->Enqueue([task]() { (*task)(); });
+			}
+			else
+			{
+				(*task)();
+			}
+
+			return result;
+		}
+	} // namespace
+
+	DecodedImage DecodeImage(const std::string& filePath, int channels, bool flipVertically, TextureUsage usage, ThreadPool* cookThreadPool)
+	{
+		DecodedImage result = {};
+		result.filePath = filePath;
+		result.channels = channels;
+
+		CookedTexture::Key cookedKey;
+		const bool cookable = (usage != TextureUsage::NONE && CookedTexture::CreateKey(filePath, usage, flipVertically, cookedKey));
+		if (cookable && LoadCookedImage(cookedKey, result))
+		{
+			return result;
+		}
+
+		std::string fileName = filePath;
+		StripLeadingDirectories(fileName);
+		Logger::LogInfo("Loading texture " + fileName);
+
+		int fileChannels;
+		result.pixels = stbi_load(filePath.c_str(), &result.width, &result.height, &fileChannels, channels);
+		if (!result.pixels)
+		{
+			const char* failureReasonStr = stbi_failure_reason();
+			Logger::LogError("Couldn't load image, failure reason: " + std::string(failureReasonStr ? failureReasonStr : "unknown") + " filepath: " + filePath);
+			return result;
+		}
+
+		if (flipVertically)
+		{
+			FlipImageVertically(result.pixels, result.width, result.height, channels);
+		}
+
+		if (cookable && cookThreadPool)
+		{
+			CookImageAsync(cookThreadPool, cookedKey, result);
+		}
+
+		return result;
+	}
+
+	std::future<DecodedImage> DecodeImageAsync(ThreadPool* threadPool, const std::string& filePath, int channels, bool flipVertically, TextureUsage usage)
+	{
+		return RunDecodeTask(threadPool, [=]()
+		{
+			return DecodeImage(filePath, channels, flipVertically, usage, threadPool);
+		});
+	}
+
+	std::string GetPackedTextureName(const PackedTextureSources& filePaths)
+	{
+		std::string name = "packed";
+		for (const std::string& filePath : filePaths)
+		{
+			name += ":" + filePath;
+		}
+		return name;
+	}
+
+	DecodedImage DecodePackedImage(const PackedTextureSources& filePaths, bool flipVertically, TextureUsage usage, ThreadPool* cookThreadPool)
+	{
+		const int channels = (int)filePaths.size();
+
+		DecodedImage result = {};
+		result.filePath = GetPackedTextureName(filePaths);
+		result.channels = channels;
+
+		CookedTexture::Key cookedKey;
+		const bool cookable = (usage != TextureUsage::NONE && CookedTexture::CreatePackedKey(filePaths.data(), (glm::uint)filePaths.size(), usage, flipVertically, cookedKey));
+		if (cookable && LoadCookedImage(cookedKey, result))
+		{
+			return result;
+		}
+
+		std::array<DecodedImage, 3> sources;
+		for (size_t i = 0; i < filePaths.size(); ++i)
+		{
+			if (!filePaths[i].empty())
+			{
+				sources[i] = DecodeImage(filePaths[i], 1, flipVertically);
+				result.width = std::max(result.width, sources[i].width);
+				result.height = std::max(result.height, sources[i].height);
+			}
+		}
+
+		if (result.width == 0 || result.height == 0)
+		{
+			return result;
+		}
+
+		// stb_image allocates with malloc, so this is freed like any other decoded image
+		const size_t pixelCount = (size_t)result.width * result.height;
+		result.pixels = (unsigned char*)malloc(pixelCount * channels);
+		memset(result.pixels, 0, pixelCount * channels);
+
+		for (int c = 0; c < channels; ++c)
+		{
+			const DecodedImage& source = sources[c];
+			if (!source.pixels)
+			{
+				continue;
+			}
+
+			// Nearest neighbour is plenty for maps which only differ in size because one was authored at a lower resolution
+			for (int y = 0; y < result.height; ++y)
+			{
+				const unsigned char* sourceRow = source.pixels + (size_t)(y * source.height / result.height) * source.width;
+				unsigned char* row = result.pixels + (size_t)y * result.width * channels;
+				for (int x = 0; x < result.width; ++x)
+				{
+					row[x * channels + c] = sourceRow[x * source.width / result.width];
+				}
+			}
+		}
+
+		for (DecodedImage& source : sources)
+		{
+			source.Free();
+		}
+
+		if (cookable && cookThreadPool)
+		{
+			CookImageAsync(cookThreadPool, cookedKey, result);
+		}
+
+		return result;
+	}
+
+	std::future<DecodedImage> DecodePackedImageAsync(ThreadPool* threadPool, const PackedTextureSources& filePaths, bool flipVertically, TextureUsage usage)
+	{
+		return RunDecodeTask(threadPool, [=]()
+		{
+			return DecodePackedImage(filePaths, flipVertically, usage, threadPool);
+		});
+	}
+
+	void CookTextureAsync(ThreadPool* threadPool, const std::string& filePath, TextureUsage usage, bool flipVertically)
+	{
+		CookedTexture::Key cookedKey;
+		if (!threadPool || !CookedTexture::CreateKey(filePath, usage, flipVertically, cookedKey))
+		{
+			return;
+		}
+
+		threadPool->Enqueue([cookedKey]()
+		{
+			CookedTexture existing;
+			if (!existing.Load(cookedKey))
+			{
+				CookedTexture::Cook(cookedKey);
+			}
+		});
+	}
+} // namespace flex
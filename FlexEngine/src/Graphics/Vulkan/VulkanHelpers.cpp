@@ -12,10 +12,10 @@ namespace flex
 {
 	namespace vk
 	{
-		VkVertexInputBindingDescription GetVertexBindingDescription(glm::uint vertexStride)
+		VkVertexInputBindingDescription GetVertexBindingDescription(glm::uint vertexStride, uint32_t binding)
 		{
 			VkVertexInputBindingDescription bindingDesc = {};
-			bindingDesc.binding = 0;
+			bindingDesc.binding = binding;
 			bindingDesc.stride = vertexStride;
 			bindingDesc.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
 
@@ -23,19 +23,20 @@ namespace flex
 		}
 
 		void GetVertexAttributeDescriptions(VertexAttributes vertexAttributes,
-			std::vector<VkVertexInputAttributeDescription>& attributeDescriptions)
+			std::vector<VkVertexInputAttributeDescription>& attributeDescriptions, bool separatePositions)
 		{
 			attributeDescriptions.clear();
 
 			uint32_t offset = 0;
 			uint32_t location = 0;
+			uint32_t binding = 0;
 
 			// TODO: Roll into iteration over array
 
 			if (vertexAttributes & (glm::uint)VertexAttribute::POSITION)
 			{
 				VkVertexInputAttributeDescription attributeDescription = {};
-				attributeDescription.binding = 0;
+				attributeDescription.binding = binding;
 				attributeDescription.format = VK_FORMAT_R32G32B32_SFLOAT;
 				attributeDescription.location = location;
 				attributeDescription.offset = offset;
@@ -43,12 +44,19 @@ namespace flex
 
 				offset += sizeof(glm::vec3);
 				++location;
+
+				if (separatePositions)
+				{
+					// All remaining attributes are interleaved in the second stream
+					binding = 1;
+					offset = 0;
+				}
 			}
 
 			if (vertexAttributes & (glm::uint)VertexAttribute::POSITION_2D)
 			{
 				VkVertexInputAttributeDescription attributeDescription = {};
-				attributeDescription.binding = 0;
+				attributeDescription.binding = binding;
 				attributeDescription.format = VK_FORMAT_R32G32_SFLOAT;
 				attributeDescription.location = location;
 				attributeDescription.offset = offset;
@@ -61,7 +69,7 @@ namespace flex
 			if (vertexAttributes & (glm::uint)VertexAttribute::UV)
 			{
 				VkVertexInputAttributeDescription attributeDescription = {};
-				attributeDescription.binding = 0;
+				attributeDescription.binding = binding;
 				attributeDescription.format = VK_FORMAT_R32G32_SFLOAT;
 				attributeDescription.location = location;
 				attributeDescription.offset = offset;
@@ -74,7 +82,7 @@ namespace flex
 			if (vertexAttributes & (glm::uint)VertexAttribute::UVW)
 			{
 				VkVertexInputAttributeDescription attributeDescription = {};
-				attributeDescription.binding = 0;
+				attributeDescription.binding = binding;
 				attributeDescription.format = VK_FORMAT_R32G32B32_SFLOAT;
 				attributeDescription.location = location;
 				attributeDescription.offset = offset;
@@ -86,7 +94,7 @@ namespace flex
 			if (vertexAttributes & (glm::uint)VertexAttribute::COLOR_R8G8B8A8_UNORM)
 			{
 				VkVertexInputAttributeDescription attributeDescription = {};
-				attributeDescription.binding = 0;
+				attributeDescription.binding = binding;
 				attributeDescription.format = VK_FORMAT_R8G8B8A8_UNORM;
 				attributeDescription.location = location;
 				attributeDescription.offset = offset;
@@ -99,7 +107,7 @@ namespace flex
 			if (vertexAttributes & (glm::uint)VertexAttribute::COLOR_R32G32B32A32_SFLOAT)
 			{
 				VkVertexInputAttributeDescription attributeDescription = {};
-				attributeDescription.binding = 0;
+				attributeDescription.binding = binding;
 				attributeDescription.format = VK_FORMAT_R32G32B32A32_SFLOAT;
 				attributeDescription.location = location;
 				attributeDescription.offset = offset;
@@ -112,7 +120,7 @@ namespace flex
 			if (vertexAttributes & (glm::uint)VertexAttribute::TANGENT)
 			{
 				VkVertexInputAttributeDescription attributeDescription = {};
-				attributeDescription.binding = 0;
+				attributeDescription.binding = binding;
 				attributeDescription.format = VK_FORMAT_R32G32B32_SFLOAT;
 				attributeDescription.location = location;
 				attributeDescription.offset = offset;
@@ -125,7 +133,7 @@ namespace flex
 			if (vertexAttributes & (glm::uint)VertexAttribute::BITANGENT)
 			{
 				VkVertexInputAttributeDescription attributeDescription = {};
-				attributeDescription.binding = 0;
+				attributeDescription.binding = binding;
 				attributeDescription.format = VK_FORMAT_R32G32B32_SFLOAT;
 				attributeDescription.location = location;
 				attributeDescription.offset = offset;
@@ -138,7 +146,7 @@ namespace flex
 			if (vertexAttributes & (glm::uint)VertexAttribute::NORMAL)
 			{
 				VkVertexInputAttributeDescription attributeDescription = {};
-				attributeDescription.binding = 0;
+				attributeDescription.binding = binding;
 				attributeDescription.format = VK_FORMAT_R32G32B32_SFLOAT;
 				attributeDescription.location = location;
 				attributeDescription.offset = offset;
@@ -147,6 +155,45 @@ namespace flex
 				offset += sizeof(glm::vec3);
 				++location;
 			}
+
+			if (vertexAttributes & (glm::uint)VertexAttribute::UV_HALF)
+			{
+				VkVertexInputAttributeDescription attributeDescription = {};
+				attributeDescription.binding = binding;
+				attributeDescription.format = VK_FORMAT_R16G16_SFLOAT;
+				attributeDescription.location = location;
+				attributeDescription.offset = offset;
+				attributeDescriptions.push_back(attributeDescription);
+
+				offset += sizeof(glm::uint16) * 2;
+				++location;
+			}
+
+			if (vertexAttributes & (glm::uint)VertexAttribute::NORMAL_OCT)
+			{
+				VkVertexInputAttributeDescription attributeDescription = {};
+				attributeDescription.binding = binding;
+				attributeDescription.format = VK_FORMAT_R16G16_SNORM;
+				attributeDescription.location = location;
+				attributeDescription.offset = offset;
+				attributeDescriptions.push_back(attributeDescription);
+
+				offset += sizeof(glm::int16) * 2;
+				++location;
+			}
+
+			if (vertexAttributes & (glm::uint)VertexAttribute::TANGENT_FRAME)
+			{
+				VkVertexInputAttributeDescription attributeDescription = {};
+				attributeDescription.binding = binding;
+				attributeDescription.format = VK_FORMAT_R16G16B16A16_SNORM;
+				attributeDescription.location = location;
+				attributeDescription.offset = offset;
+				attributeDescriptions.push_back(attributeDescription);
+
+				offset += sizeof(glm::int16) * 4;
+				++location;
+			}
 		}
 
 		UniformBuffer::UniformBuffer(const VDeleter<VkDevice>& device) :
@@ -516,6 +563,18 @@ namespace flex
 			}
 		}
 
+		VkFormat BlockCompressionFormatToVkFormat(BlockCompressionFormat format)
+		{
+			switch (format)
+			{
+			case BlockCompressionFormat::BC4: return VK_FORMAT_BC4_UNORM_BLOCK;
+			case BlockCompressionFormat::BC5: return VK_FORMAT_BC5_UNORM_BLOCK;
+			case BlockCompressionFormat::BC6H: return VK_FORMAT_BC6H_UFLOAT_BLOCK;
+			case BlockCompressionFormat::BC7: return VK_FORMAT_BC7_UNORM_BLOCK;
+			default: return VK_FORMAT_UNDEFINED;
+			}
+		}
+
 
 		VkResult CreateDebugReportCallbackEXT(VkInstance instance, const VkDebugReportCallbackCreateInfoEXT* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkDebugReportCallbackEXT* pCallback)
 		{
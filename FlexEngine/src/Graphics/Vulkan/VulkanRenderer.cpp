@@ -12,6 +12,7 @@
 #include "stb_image.h"
 
 #include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/packing.hpp>
 
 #include "FreeCamera.hpp"
 #include "Helpers.hpp"
@@ -95,6 +96,13 @@ namespace flex
 
 		VulkanRenderer::~VulkanRenderer()
 		{
+			for (PendingTextureUpload& pendingUpload : m_PendingTextureUploads)
+			{
+				DecodedImage image = pendingUpload.image.get();
+				image.Free();
+			}
+			m_PendingTextureUploads.clear();
+
 			{
 				auto iter = m_RenderObjects.begin();
 				while (iter != m_RenderObjects.end())
@@ -119,6 +127,8 @@ namespace flex
 				SafeDelete(m_VertexIndexBufferPairs[i].indexBuffer);
 			}
 
+			SafeDelete(m_IndirectDrawBuffer);
+
 			if (m_SkyBoxMesh)
 			{
 				Destroy(m_SkyBoxMesh->GetRenderID());
@@ -236,6 +246,10 @@ namespace flex
 			}
 
 
+			// Every material's textures have been decoding in parallel since it was initialized, upload them all before they're referenced
+			FinishPendingTextureUploads();
+			m_PostInitialized = true;
+
 			for (size_t i = 0; i < m_RenderObjects.size(); ++i)
 			{
 				CreateDescriptorSet(i);
@@ -247,6 +261,15 @@ namespace flex
 			CreateStaticVertexBuffers();
 			CreateStaticIndexBuffers();
 
+			// Objects' data has now been copied into their shader's static buffers
+			for (VulkanRenderObject* renderObject : m_RenderObjects)
+			{
+				if (renderObject && m_VertexIndexBufferPairs[m_LoadedMaterials[renderObject->materialID].material.shaderID].useStagingBuffer)
+				{
+					renderObject->uploaded = true;
+				}
+			}
+
 			CreateCommandBuffers();
 			CreateSemaphores();
 
@@ -283,15 +306,138 @@ namespace flex
 				//else 
 				if (m_LoadedMaterials[renderObject->materialID].material.generateIrradianceSampler)
 				{
-					GenerateCubemapFromHDR(gameContext, renderObject);
-					GenerateIrradianceSampler(gameContext, renderObject);
-					GeneratePrefilteredCube(gameContext, renderObject);
+					// Hashed once here and handed to both the load and the background bake
+					const VulkanMaterial& material = m_LoadedMaterials[renderObject->materialID];
+					glm::uint64 sourceHash = 0;
+					const bool sourceHashed = BakedEnvironment::HashSource(material.material.environmentMapPath, sourceHash);
+					if (!sourceHashed || !LoadBakedEnvironment(renderObject, sourceHash))
+					{
+						GenerateCubemapFromHDR(gameContext, renderObject);
+						GenerateIrradianceSampler(gameContext, renderObject);
+						GeneratePrefilteredCube(gameContext, renderObject);
+
+						if (sourceHashed)
+						{
+							// Rendered this time, but baked in the background so the next launch can load them instead
+							BakedEnvironment::BakeAsync(gameContext.threadPool, material.material.environmentMapPath, sourceHash,
+								GetIBLBakeSettings(material.material, material.prefilterTexture->mipLevels));
+						}
+					}
 				}
 			}
 
 			Logger::LogInfo("Ready!\n");
 		}
 
+		bool VulkanRenderer::LoadBakedEnvironment(VulkanRenderObject* renderObject, glm::uint64 sourceHash)
+		{
+			VulkanMaterial& material = m_LoadedMaterials[renderObject->materialID];
+			if (!material.cubemapTexture || !material.irradianceTexture || !material.prefilterTexture)
+			{
+				return false;
+			}
+
+			BakedEnvironment environment;
+			if (!environment.Load(material.material.environmentMapPath, sourceHash, GetIBLBakeSettings(material.material, material.prefilterTexture->mipLevels)))
+			{
+				return false;
+			}
+
+			struct BakedMap
+			{
+				BakedEnvironment::Map map;
+				VulkanTexture* texture;
+				bool fullFloat; // Half float texels are expanded for R32G32B32A32 images
+			};
+			const BakedMap maps[] = {
+				{ BakedEnvironment::Map::CUBEMAP, material.cubemapTexture, true },
+				{ BakedEnvironment::Map::IRRADIANCE, material.irradianceTexture, true },
+				{ BakedEnvironment::Map::PREFILTERED, material.prefilterTexture, false },
+			};
+
+			VkDeviceSize stagingBufferSize = 0;
+			for (const BakedMap& bakedMap : maps)
+			{
+				const glm::uint mipCount = std::min(environment.GetMipCount(bakedMap.map), bakedMap.texture->mipLevels);
+				for (glm::uint mip = 0; mip < mipCount; ++mip)
+				{
+					stagingBufferSize += environment.GetFaceDataSize(bakedMap.map, mip) * 6 * (bakedMap.fullFloat ? 2 : 1);
+				}
+			}
+
+			VulkanBuffer stagingBuffer(m_VulkanDevice->m_LogicalDevice);
+			CreateAndAllocateBuffer(stagingBufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &stagingBuffer);
+			VK_CHECK_RESULT(stagingBuffer.Map(stagingBufferSize));
+
+			VkCommandBuffer commandBuffer = BeginSingleTimeCommands();
+			VkDeviceSize stagingOffset = 0;
+
+			std::vector<VkBufferImageCopy> regions;
+			for (const BakedMap& bakedMap : maps)
+			{
+				regions.clear();
+
+				// Every face is a whole number of texels, so offsets stay multiples of the texel size
+				const glm::uint mipCount = std::min(environment.GetMipCount(bakedMap.map), bakedMap.texture->mipLevels);
+				for (glm::uint mip = 0; mip < mipCount; ++mip)
+				{
+					const glm::uint mipSize = environment.GetMipSize(bakedMap.map, mip);
+					const size_t faceDataSize = environment.GetFaceDataSize(bakedMap.map, mip);
+					for (glm::uint face = 0; face < 6; ++face)
+					{
+						VkBufferImageCopy region = {};
+						region.bufferOffset = stagingOffset;
+						region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+						region.imageSubresource.mipLevel = mip;
+						region.imageSubresource.baseArrayLayer = face;
+						region.imageSubresource.layerCount = 1;
+						region.imageExtent = { mipSize, mipSize, 1 };
+						regions.push_back(region);
+
+						unsigned char* dst = (unsigned char*)stagingBuffer.m_Mapped + stagingOffset;
+						const void* faceData = environment.GetFaceData(bakedMap.map, mip, face);
+						if (bakedMap.fullFloat)
+						{
+							const glm::uint16* halfs = (const glm::uint16*)faceData;
+							float* floats = (float*)dst;
+							const size_t valueCount = faceDataSize / sizeof(glm::uint16);
+							for (size_t i = 0; i < valueCount; ++i)
+							{
+								floats[i] = glm::unpackHalf1x16(halfs[i]);
+							}
+							stagingOffset += valueCount * sizeof(float);
+						}
+						else
+						{
+							memcpy(dst, faceData, faceDataSize);
+							stagingOffset += faceDataSize;
+						}
+					}
+				}
+
+				VkImageSubresourceRange subresourceRange = {};
+				subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+				subresourceRange.baseMipLevel = 0;
+				subresourceRange.levelCount = bakedMap.texture->mipLevels;
+				subresourceRange.layerCount = 6;
+
+				SetImageLayout(commandBuffer, bakedMap.texture, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, subresourceRange);
+				vkCmdCopyBufferToImage(commandBuffer, stagingBuffer.m_Buffer, bakedMap.texture->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, (glm::uint32)regions.size(), regions.data());
+				SetImageLayout(commandBuffer, bakedMap.texture, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, subresourceRange);
+			}
+
+			EndSingleTimeCommands(commandBuffer);
+			stagingBuffer.Unmap();
+
+			for (const BakedMap& bakedMap : maps)
+			{
+				bakedMap.texture->UpdateImageDescriptor();
+			}
+
+			return true;
+		}
+
 		void VulkanRenderer::GenerateCubemapFromHDR(const GameContext& gameContext, VulkanRenderObject* renderObject)
 		{
 			VulkanRenderObject* skyboxRenderObject = GetRenderObject(m_SkyBoxMesh->GetRenderID());
@@ -658,12 +804,12 @@ namespace flex
 					vkCmdBindVertexBuffers(cmdBuf, 0, 1, &m_VertexIndexBufferPairs[shaderID].vertexBuffer->m_Buffer, offsets);
 					if (skyboxRenderObject->indexed)
 					{
-						vkCmdBindIndexBuffer(cmdBuf, m_VertexIndexBufferPairs[shaderID].indexBuffer->m_Buffer, 0, VK_INDEX_TYPE_UINT32);
+						vkCmdBindIndexBuffer(cmdBuf, m_VertexIndexBufferPairs[shaderID].indexBuffer->m_Buffer, 0, m_VertexIndexBufferPairs[shaderID].indexType);
 						vkCmdDrawIndexed(cmdBuf, m_VertexIndexBufferPairs[shaderID].indexCount, 1, 0, 0, 0);
 					}
 					else
 					{
-						vkCmdDraw(cmdBuf, skyboxRenderObject->vertexBufferData->VertexCount, 1, 0, 0);
+						vkCmdDraw(cmdBuf, skyboxRenderObject->vertexCount, 1, 0, 0);
 					}
 
 					vkCmdEndRenderPass(cmdBuf);
@@ -1112,12 +1258,12 @@ namespace flex
 					vkCmdBindVertexBuffers(cmdBuf, 0, 1, &m_VertexIndexBufferPairs[shaderID].vertexBuffer->m_Buffer, offsets);
 					if (skyboxRenderObject->indexed)
 					{
-						vkCmdBindIndexBuffer(cmdBuf, m_VertexIndexBufferPairs[shaderID].indexBuffer->m_Buffer, 0, VK_INDEX_TYPE_UINT32);
+						vkCmdBindIndexBuffer(cmdBuf, m_VertexIndexBufferPairs[shaderID].indexBuffer->m_Buffer, 0, m_VertexIndexBufferPairs[shaderID].indexType);
 						vkCmdDrawIndexed(cmdBuf, m_VertexIndexBufferPairs[shaderID].indexCount, 1, 0, 0, 0);
 					}
 					else
 					{
-						vkCmdDraw(cmdBuf, skyboxRenderObject->vertexBufferData->VertexCount, 1, 0, 0);
+						vkCmdDraw(cmdBuf, skyboxRenderObject->vertexCount, 1, 0, 0);
 					}
 
 					vkCmdEndRenderPass(cmdBuf);
@@ -1535,7 +1681,7 @@ namespace flex
 					vkCmdBindVertexBuffers(cmdBuf, 0, 1, &m_VertexIndexBufferPairs[m_LoadedMaterials[skyboxRenderObject->materialID].material.shaderID].vertexBuffer->m_Buffer, offsets);
 					if (skyboxRenderObject->indexed)
 					{
-						vkCmdBindIndexBuffer(cmdBuf, m_VertexIndexBufferPairs[shaderID].indexBuffer->m_Buffer, 0, VK_INDEX_TYPE_UINT32);
+						vkCmdBindIndexBuffer(cmdBuf, m_VertexIndexBufferPairs[shaderID].indexBuffer->m_Buffer, 0, m_VertexIndexBufferPairs[shaderID].indexType);
 						vkCmdDrawIndexed(cmdBuf, m_VertexIndexBufferPairs[shaderID].indexCount, 1, 0, 0, 0);
 					}
 					else
@@ -1608,6 +1754,54 @@ namespace flex
 			vkDestroyPipelineLayout(m_VulkanDevice->m_LogicalDevice, pipelinelayout, nullptr);
 		}
 
+		void VulkanRenderer::CreateBRDFLUT(const GameContext& gameContext)
+		{
+			if (m_BRDFTexture)
+			{
+				return;
+			}
+
+			const VkFormat format = VK_FORMAT_R16G16_SFLOAT;
+			const glm::uvec2 size((glm::uint)m_BRDFSize.x, (glm::uint)m_BRDFSize.y);
+
+			BakedBRDFLUT bakedBRDFLUT;
+			if (bakedBRDFLUT.Load(size))
+			{
+				m_BRDFTexture = new VulkanTexture(m_VulkanDevice->m_LogicalDevice);
+				m_BRDFTexture->width = size.x;
+				m_BRDFTexture->height = size.y;
+
+				const VkDeviceSize imageSize = CreateImage(size.x, size.y, format, VK_IMAGE_TILING_OPTIMAL,
+					VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VK_IMAGE_LAYOUT_PREINITIALIZED,
+					m_BRDFTexture->image.replace(), m_BRDFTexture->imageMemory.replace(), 1, 1);
+
+				VulkanBuffer stagingBuffer(m_VulkanDevice->m_LogicalDevice);
+				CreateAndAllocateBuffer(imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+					VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &stagingBuffer);
+				VK_CHECK_RESULT(stagingBuffer.Map(imageSize));
+				memcpy(stagingBuffer.m_Mapped, bakedBRDFLUT.GetData(), (size_t)size.x * size.y * 2 * sizeof(glm::uint16));
+				stagingBuffer.Unmap();
+
+				TransitionImageLayout(m_BRDFTexture->image, format, VK_IMAGE_LAYOUT_PREINITIALIZED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1);
+				CopyBufferToImage(stagingBuffer.m_Buffer, m_BRDFTexture->image, size.x, size.y);
+				TransitionImageLayout(m_BRDFTexture->image, format, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, 1);
+
+				CreateTextureImageView(m_BRDFTexture, format);
+				CreateTextureSampler(m_BRDFTexture, 16.0f, 0.0f, 1.0f, VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE, VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE);
+				m_BRDFTexture->imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+				m_BRDFTexture->UpdateImageDescriptor();
+				m_LoadedTextures.push_back(m_BRDFTexture);
+				return;
+			}
+
+			Logger::LogInfo("Generating BRDF LUT");
+			CreateVulkanTexture_Empty(size.x, size.y, format, 1, &m_BRDFTexture);
+			m_LoadedTextures.push_back(m_BRDFTexture);
+			GenerateBRDFLUT(gameContext, m_BRDFTexture);
+
+			BakedBRDFLUT::BakeAsync(gameContext.threadPool, size);
+		}
+
 		void VulkanRenderer::GenerateBRDFLUT(const GameContext& gameContext, VulkanTexture* brdfTexture)
 		{
 			UNREFERENCED_PARAMETER(gameContext);
@@ -1868,8 +2062,6 @@ namespace flex
 
 		MaterialID VulkanRenderer::InitializeMaterial(const GameContext& gameContext, const MaterialCreateInfo* createInfo)
 		{
-			UNREFERENCED_PARAMETER(gameContext);
-
 			VulkanMaterial mat = {};
 			mat.material = {};
 
@@ -1938,13 +2130,7 @@ namespace flex
 			}
 			if (m_Shaders[mat.material.shaderID].shader.needBRDFLUT)
 			{
-				if (!m_BRDFTexture)
-				{
-					Logger::LogInfo("Generating BRDF LUT");
-					CreateVulkanTexture_Empty(m_BRDFSize.x, m_BRDFSize.y, VK_FORMAT_R16G16_SFLOAT, 1, &m_BRDFTexture);
-					m_LoadedTextures.push_back(m_BRDFTexture);
-					GenerateBRDFLUT(gameContext, m_BRDFTexture);
-				}
+				CreateBRDFLUT(gameContext);
 				mat.brdfLUT = m_BRDFTexture;
 			}
 			if (m_Shaders[mat.material.shaderID].shader.needPrefilteredMap)
@@ -1969,17 +2155,19 @@ namespace flex
 				VkFormat format;
 				glm::uint mipLevels;
 				VulkanTextureCreateFunction createFunction;
+				bool stream; // If true the file is decoded on a worker thread and uploaded by FinishPendingTextureUploads, createFunction is unused
+				TextureUsage usage; // Decides which block compressed format a streamed texture is cooked into
 			};
 
 			TextureInfo textureInfos[] =
 			{
-				{ createInfo->diffuseTexturePath, &mat.diffuseTexture, &mat.material.generateDiffuseSampler, VK_FORMAT_R8G8B8A8_UNORM, 1, &VulkanRenderer::CreateVulkanTexture },
-				{ createInfo->normalTexturePath, &mat.normalTexture, &mat.material.generateNormalSampler, VK_FORMAT_R8G8B8A8_UNORM, 1, &VulkanRenderer::CreateVulkanTexture },
-				{ createInfo->albedoTexturePath, &mat.albedoTexture, &mat.material.generateAlbedoSampler, VK_FORMAT_R8G8B8A8_UNORM, 1, &VulkanRenderer::CreateVulkanTexture },
-				{ createInfo->metallicTexturePath, &mat.metallicTexture, &mat.material.generateMetallicSampler, VK_FORMAT_R8G8B8A8_UNORM, 1, &VulkanRenderer::CreateVulkanTexture },
-				{ createInfo->roughnessTexturePath, &mat.roughnessTexture, &mat.material.generateRoughnessSampler, VK_FORMAT_R8G8B8A8_UNORM, 1, &VulkanRenderer::CreateVulkanTexture },
-				{ createInfo->aoTexturePath, &mat.aoTexture, &mat.material.generateAOSampler, VK_FORMAT_R8G8B8A8_UNORM, 1, &VulkanRenderer::CreateVulkanTexture },
-				{ createInfo->hdrEquirectangularTexturePath, &mat.hdrEquirectangularTexture, &mat.material.generateHDREquirectangularSampler, VK_FORMAT_R32G32B32A32_SFLOAT, 1, &VulkanRenderer::CreateVulkanTexture_HDR },
+				{ createInfo->diffuseTexturePath, &mat.diffuseTexture, &mat.material.generateDiffuseSampler, VK_FORMAT_R8G8B8A8_UNORM, 1, &VulkanRenderer::CreateVulkanTexture, true, TextureUsage::COLOR },
+				{ createInfo->normalTexturePath, &mat.normalTexture, &mat.material.generateNormalSampler, VK_FORMAT_R8G8B8A8_UNORM, 1, &VulkanRenderer::CreateVulkanTexture, true, TextureUsage::NORMAL },
+				{ createInfo->albedoTexturePath, &mat.albedoTexture, &mat.material.generateAlbedoSampler, VK_FORMAT_R8G8B8A8_UNORM, 1, &VulkanRenderer::CreateVulkanTexture, true, TextureUsage::COLOR },
+				{ createInfo->metallicTexturePath, &mat.metallicTexture, &mat.material.generateMetallicSampler, VK_FORMAT_R8G8B8A8_UNORM, 1, &VulkanRenderer::CreateVulkanTexture, true, TextureUsage::SINGLE_CHANNEL },
+				{ createInfo->roughnessTexturePath, &mat.roughnessTexture, &mat.material.generateRoughnessSampler, VK_FORMAT_R8G8B8A8_UNORM, 1, &VulkanRenderer::CreateVulkanTexture, true, TextureUsage::SINGLE_CHANNEL },
+				{ createInfo->aoTexturePath, &mat.aoTexture, &mat.material.generateAOSampler, VK_FORMAT_R8G8B8A8_UNORM, 1, &VulkanRenderer::CreateVulkanTexture, true, TextureUsage::SINGLE_CHANNEL },
+				{ createInfo->hdrEquirectangularTexturePath, &mat.hdrEquirectangularTexture, &mat.material.generateHDREquirectangularSampler, VK_FORMAT_R32G32B32A32_SFLOAT, 1, &VulkanRenderer::CreateVulkanTexture_HDR, false, TextureUsage::NONE },
 			};
 			const size_t textureCount = sizeof(textureInfos) / sizeof(textureInfos[0]);
 
@@ -1996,11 +2184,29 @@ namespace flex
 					if (*textureInfo.texture == nullptr)
 					{
 						// Texture hasn't been loaded yet, load it now
-						std::invoke(textureInfo.createFunction, this, textureInfo.filePath, textureInfo.format, textureInfo.mipLevels, textureInfo.texture);
-						m_LoadedTextures.push_back(*textureInfo.texture);
+						if (textureInfo.stream)
+						{
+							*textureInfo.texture = new VulkanTexture(m_VulkanDevice->m_LogicalDevice);
+							(*textureInfo.texture)->filePath = textureInfo.filePath;
+							(*textureInfo.texture)->mipLevels = textureInfo.mipLevels;
+							m_LoadedTextures.push_back(*textureInfo.texture);
+
+							PendingTextureUpload pendingUpload = {};
+							pendingUpload.texture = *textureInfo.texture;
+							pendingUpload.format = textureInfo.format;
+							// Cooked copies can only be sampled from when the device supports BC formats
+							const TextureUsage usage = (m_VulkanDevice->m_PhysicalDeviceFeatures.textureCompressionBC ? textureInfo.usage : TextureUsage::NONE);
+							pendingUpload.image = DecodeImageAsync(gameContext.threadPool, textureInfo.filePath, 4, false, usage);
+							m_PendingTextureUploads.push_back(std::move(pendingUpload));
+						}
+						else
+						{
+							std::invoke(textureInfo.createFunction, this, textureInfo.filePath, textureInfo.format, textureInfo.mipLevels, textureInfo.texture);
+							m_LoadedTextures.push_back(*textureInfo.texture);
 
-						(*textureInfo.texture)->imageLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-						(*textureInfo.texture)->UpdateImageDescriptor();
+							(*textureInfo.texture)->imageLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+							(*textureInfo.texture)->UpdateImageDescriptor();
+						}
 					}
 				}
 			}
@@ -2021,7 +2227,7 @@ namespace flex
 
 					if (mat.cubemapTexture == nullptr)
 					{
-						CreateVulkanCubemap(createInfo->cubeMapFilePaths, VK_FORMAT_R8G8B8A8_UNORM, &mat.cubemapTexture, true);
+						CreateVulkanCubemap(createInfo->cubeMapFilePaths, VK_FORMAT_R8G8B8A8_UNORM, &mat.cubemapTexture, true, gameContext.threadPool);
 						m_LoadedTextures.push_back(mat.cubemapTexture);
 					}
 				}
@@ -2071,6 +2277,12 @@ namespace flex
 
 			m_LoadedMaterials.push_back(mat);
 
+			if (m_PostInitialized)
+			{
+				// Descriptor sets which will reference these textures may be created at any point from now on
+				FinishPendingTextureUploads();
+			}
+
 			return m_LoadedMaterials.size() - 1;
 		}
 
@@ -2083,6 +2295,7 @@ namespace flex
 			InsertNewRenderObject(renderObject);
 
 			renderObject->vertexBufferData = createInfo->vertexBufferData;
+			renderObject->vertexCount = createInfo->vertexBufferData ? createInfo->vertexBufferData->VertexCount : 0;
 			renderObject->materialID = createInfo->materialID;
 			renderObject->cullMode = CullFaceToVkCullMode(createInfo->cullFace);
 			renderObject->enableCulling = createInfo->enableCulling;
@@ -2095,6 +2308,14 @@ namespace flex
 			{
 				renderObject->indices = createInfo->indices;
 				renderObject->indexed = true;
+				renderObject->totalIndexCount = (glm::uint)createInfo->indices->size();
+				renderObject->indexCount = renderObject->totalIndexCount;
+			}
+
+			if (createInfo->bounds)
+			{
+				renderObject->hasBounds = true;
+				renderObject->localBounds = *createInfo->bounds;
 			}
 
 			return renderID;
@@ -2156,6 +2377,8 @@ namespace flex
 			// Update uniform buffer
 			UpdateConstantUniformBuffers(gameContext);
 
+			UpdateObjectMatrices();
+
 			// TODO: Only update when things have changed
 			for (size_t i = 0; i < m_RenderObjects.size(); ++i)
 			{
@@ -2164,10 +2387,54 @@ namespace flex
 
 			// Update g-buffer uniforms
 			UpdateDynamicUniformBuffer(gameContext, m_GBufferQuadRenderID);
+
+			FlushDynamicUniformBuffers();
+		}
+
+		void VulkanRenderer::UpdateObjectMatrices()
+		{
+			const glm::uint renderObjectCount = (glm::uint)m_RenderObjects.size();
+			m_ObjectMatrices.resize(renderObjectCount);
+
+			// Transforms are only read here, so large scenes can have their matrices calculated on several threads
+			ParallelFor(renderObjectCount, MIN_OBJECT_MATRICES_PER_THREAD, [this](glm::uint begin, glm::uint end)
+			{
+				for (glm::uint i = begin; i < end; ++i)
+				{
+					const VulkanRenderObject* renderObject = m_RenderObjects[i];
+
+					ObjectMatrices& matrices = m_ObjectMatrices[i];
+					matrices.model = (renderObject && renderObject->transform) ? renderObject->transform->GetModelMatrix() : glm::mat4(1.0f);
+					matrices.modelInvTranspose = glm::transpose(glm::inverse(matrices.model));
+				}
+			});
+		}
+
+		void VulkanRenderer::FlushDynamicUniformBuffers()
+		{
+			// Dynamic buffers aren't host coherent, flush each one once after every object has been written to it
+			std::vector<VkMappedMemoryRange> mappedMemoryRanges;
+			for (VulkanShader& shader : m_Shaders)
+			{
+				if (shader.uniformBuffer.dynamicBuffer.m_Size == 0) continue;
+
+				VkMappedMemoryRange mappedMemoryRange{};
+				mappedMemoryRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+				mappedMemoryRange.memory = shader.uniformBuffer.dynamicBuffer.m_Memory;
+				mappedMemoryRange.offset = 0;
+				mappedMemoryRange.size = VK_WHOLE_SIZE;
+				mappedMemoryRanges.push_back(mappedMemoryRange);
+			}
+
+			if (!mappedMemoryRanges.empty())
+			{
+				vkFlushMappedMemoryRanges(m_VulkanDevice->m_LogicalDevice, (uint32_t)mappedMemoryRanges.size(), mappedMemoryRanges.data());
+			}
 		}
 
 		void VulkanRenderer::Draw(const GameContext& gameContext)
 		{
+			CullRenderObjectMeshlets(gameContext);
 			BuildCommandBuffers(gameContext); // TODO: Only call this when objects change
 			BuildDeferredCommandBuffer(gameContext); // TODO: Only call this once at startup?
 
@@ -2383,6 +2650,58 @@ namespace flex
 			}
 		}
 
+		void VulkanRenderer::SetRenderObjectIndexRange(RenderID renderID, glm::uint firstIndex, glm::uint indexCount)
+		{
+			VulkanRenderObject* renderObject = GetRenderObject(renderID);
+			if (!renderObject || !renderObject->indexed)
+			{
+				Logger::LogError("SetRenderObjectIndexRange couldn't find indexed render object with ID " + std::to_string(renderID));
+				return;
+			}
+
+			if ((size_t)firstIndex + indexCount > renderObject->totalIndexCount)
+			{
+				Logger::LogError("SetRenderObjectIndexRange called with out of bounds range on render object " + renderObject->name);
+				return;
+			}
+
+			// Command buffers are rebuilt every frame, so the new range is picked up by the next draw
+			renderObject->firstIndex = firstIndex;
+			renderObject->indexCount = indexCount;
+		}
+
+		void VulkanRenderer::SetRenderObjectMeshlets(RenderID renderID, const std::vector<Meshlet>* meshlets)
+		{
+			VulkanRenderObject* renderObject = GetRenderObject(renderID);
+			if (!renderObject || !renderObject->indexed)
+			{
+				Logger::LogError("SetRenderObjectMeshlets couldn't find indexed render object with ID " + std::to_string(renderID));
+				return;
+			}
+
+			renderObject->meshlets = meshlets;
+			renderObject->visibleIndexRanges.clear();
+		}
+
+		bool VulkanRenderer::GetRenderObjectWorldBounds(RenderID renderID, MeshBounds& worldBounds)
+		{
+			VulkanRenderObject* renderObject = GetRenderObject(renderID);
+			if (!renderObject || !renderObject->hasBounds)
+			{
+				return false;
+			}
+
+			UpdateWorldBounds(renderObject->transform, renderObject->localBounds, renderObject->worldBounds, renderObject->worldBoundsVersion);
+			worldBounds = renderObject->worldBounds;
+			return true;
+		}
+
+		bool VulkanRenderer::IsRenderObjectUploaded(RenderID renderID)
+		{
+			VulkanRenderObject* renderObject = GetRenderObject(renderID);
+			return renderObject != nullptr && renderObject->uploaded;
+		}
+
 		void VulkanRenderer::Destroy(RenderID renderID)
 		{
 			for (auto iter = m_RenderObjects.begin(); iter != m_RenderObjects.end(); ++iter)
@@ -2834,8 +3153,14 @@ namespace flex
 				queueCreateInfos.push_back(queueCreateInfo);
 			}
 
+			m_VulkanDevice = new VulkanDevice(physicalDevice);
+
 			VkPhysicalDeviceFeatures deviceFeatures = {};
 			deviceFeatures.samplerAnisotropy = VK_TRUE;
+			// Cooked textures are only used when this is supported
+			deviceFeatures.textureCompressionBC = m_VulkanDevice->m_PhysicalDeviceFeatures.textureCompressionBC;
+			// Otherwise each indirect draw is recorded one command at a time
+			deviceFeatures.multiDrawIndirect = m_VulkanDevice->m_PhysicalDeviceFeatures.multiDrawIndirect;
 
 			VkDeviceCreateInfo createInfo = {};
 			createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -2858,8 +3183,6 @@ namespace flex
 				createInfo.enabledLayerCount = 0;
 			}
 
-			m_VulkanDevice = new VulkanDevice(physicalDevice);
-
 			VK_CHECK_RESULT(vkCreateDevice(physicalDevice, &createInfo, nullptr, m_VulkanDevice->m_LogicalDevice.replace()));
 
 			vkGetPhysicalDeviceProperties(physicalDevice, &m_VulkanDevice->m_PhysicalDeviceProperties);
@@ -3437,6 +3760,7 @@ namespace flex
 			GraphicsPipelineCreateInfo pipelineCreateInfo = {};
 			pipelineCreateInfo.shaderID = material->material.shaderID;
 			pipelineCreateInfo.vertexAttributes = renderObject->vertexBufferData->Attributes;
+			pipelineCreateInfo.separatePositionStream = renderObject->vertexBufferData->SeparatePositions;
 			pipelineCreateInfo.topology = renderObject->topology;
 			pipelineCreateInfo.cullMode = renderObject->cullMode;
 			pipelineCreateInfo.enableCulling = renderObject->enableCulling;
@@ -3494,15 +3818,24 @@ namespace flex
 			std::array<VkPipelineShaderStageCreateInfo, 2> shaderStages = { vertShaderStageInfo, fragShaderStageInfo };
 
 			const glm::uint vertexStride = CalculateVertexStride(createInfo->vertexAttributes);
-			VkVertexInputBindingDescription bindingDescription = GetVertexBindingDescription(vertexStride);
+			std::vector<VkVertexInputBindingDescription> bindingDescriptions;
+			if (createInfo->separatePositionStream)
+			{
+				bindingDescriptions.push_back(GetVertexBindingDescription(sizeof(glm::vec3), 0));
+				bindingDescriptions.push_back(GetVertexBindingDescription(vertexStride - sizeof(glm::vec3), 1));
+			}
+			else
+			{
+				bindingDescriptions.push_back(GetVertexBindingDescription(vertexStride));
+			}
 			std::vector<VkVertexInputAttributeDescription> attributeDescriptions;
-			GetVertexAttributeDescriptions(createInfo->vertexAttributes, attributeDescriptions);
+			GetVertexAttributeDescriptions(createInfo->vertexAttributes, attributeDescriptions, createInfo->separatePositionStream);
 
 			VkPipelineVertexInputStateCreateInfo vertexInputInfo = {};
 			vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-			vertexInputInfo.vertexBindingDescriptionCount = 1;
+			vertexInputInfo.vertexBindingDescriptionCount = bindingDescriptions.size();
 			vertexInputInfo.vertexAttributeDescriptionCount = attributeDescriptions.size();
-			vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
+			vertexInputInfo.pVertexBindingDescriptions = bindingDescriptions.data();
 			vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
 
 			VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
@@ -4046,7 +4379,7 @@ namespace flex
 			(*texture)->height = height;
 		}
 
-		void VulkanRenderer::CreateVulkanCubemap(const std::array<std::string, 6>& filePaths, VkFormat format, VulkanTexture** texture, bool generateMipMaps) const
+		void VulkanRenderer::CreateVulkanCubemap(const std::array<std::string, 6>& filePaths, VkFormat format, VulkanTexture** texture, bool generateMipMaps, ThreadPool* threadPool) const
 		{
 			int textureWidth = 0;
 			int textureHeight = 0;
@@ -4068,26 +4401,42 @@ namespace flex
 			StripLeadingDirectories(fileName);
 			Logger::LogInfo("Loading cubemap textures " + filePaths[0] + " , " + filePaths[1] + " , " + filePaths[2] + " , " + filePaths[3] + " , " + filePaths[4] + " , " + filePaths[5]);
 
+			// Start decoding every face before waiting on any so they're decoded in parallel
+			std::array<std::future<DecodedImage>, 6> faces;
+			for (size_t i = 0; i < filePaths.size(); ++i)
+			{
+				faces[i] = DecodeImageAsync(threadPool, filePaths[i], 4, false);
+			}
+
 			images.reserve(filePaths.size());
-			for (const std::string& filePath : filePaths)
+			bool facesLoaded = true;
+			for (size_t i = 0; i < filePaths.size(); ++i)
 			{
-				unsigned char* pixels = stbi_load(filePath.c_str(), &textureWidth, &textureHeight, &textureChannels, STBI_rgb_alpha);
-				if (!pixels)
+				DecodedImage face = faces[i].get();
+				if (!face.pixels)
 				{
-					const char* failureReasonStr = stbi_failure_reason();
-					Logger::LogError("Couldn't load image, failure reason: " + std::string(failureReasonStr) + " filepath: " + filePath);
-					return;
+					facesLoaded = false;
+					continue;
 				}
 
-				// The load function returns the original channel count, 
-				// but it was forced to 4 because of the last parameter
-				textureChannels = 4;
+				textureWidth = face.width;
+				textureHeight = face.height;
+				textureChannels = face.channels;
 
 				int size = textureWidth * textureHeight * textureChannels * sizeof(unsigned char);
-				images.push_back({ pixels, textureWidth, textureHeight, textureChannels, size });
+				images.push_back({ face.pixels, textureWidth, textureHeight, textureChannels, size });
 				totalSize += size;
 			}
 
+			if (!facesLoaded)
+			{
+				for (Image& image : images)
+				{
+					stbi_image_free(image.pixels);
+				}
+				return;
+			}
+
 			unsigned char* pixels = (unsigned char*)malloc(totalSize);
 			unsigned char* pixelData = pixels;
 			for (Image& image : images)
@@ -4298,6 +4647,138 @@ namespace flex
 			TransitionImageLayout((*texture)->image, format, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, mipLevels);
 		}
 
+		void VulkanRenderer::FinishPendingTextureUploads()
+		{
+			if (m_PendingTextureUploads.empty())
+			{
+				return;
+			}
+
+			// Substituted for images which failed to decode (already logged) so their textures are still valid to sample
+			static const unsigned char whitePixel[4] = { 255, 255, 255, 255 };
+
+			// Satisfies vkCmdCopyBufferToImage's requirement that offsets be multiples of both 4 and the texel block size
+			const VkDeviceSize stagingAlignment = 16;
+
+			std::vector<DecodedImage> images;
+			images.reserve(m_PendingTextureUploads.size());
+			VkDeviceSize largestImageSize = sizeof(whitePixel);
+			for (PendingTextureUpload& pendingUpload : m_PendingTextureUploads)
+			{
+				images.push_back(pendingUpload.image.get());
+				const DecodedImage& image = images.back();
+				if (image.cooked)
+				{
+					largestImageSize = std::max(largestImageSize, (VkDeviceSize)image.cooked->GetDataSize() + image.cooked->GetMipCount() * stagingAlignment);
+				}
+				else if (image.pixels)
+				{
+					largestImageSize = std::max(largestImageSize, (VkDeviceSize)image.width * image.height * 4);
+				}
+			}
+
+			const VkDeviceSize stagingBufferSize = (largestImageSize > TEXTURE_STAGING_BUFFER_SIZE ? largestImageSize : TEXTURE_STAGING_BUFFER_SIZE);
+			VulkanBuffer stagingBuffer(m_VulkanDevice->m_LogicalDevice);
+			CreateAndAllocateBuffer(stagingBufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &stagingBuffer);
+			VK_CHECK_RESULT(stagingBuffer.Map(stagingBufferSize));
+
+			VkCommandBuffer commandBuffer = BeginSingleTimeCommands();
+			VkDeviceSize stagingOffset = 0;
+
+			std::vector<VkBufferImageCopy> regions;
+
+			for (size_t i = 0; i < m_PendingTextureUploads.size(); ++i)
+			{
+				VulkanTexture* texture = m_PendingTextureUploads[i].texture;
+				const DecodedImage& image = images[i];
+				const CookedTexture* cooked = image.cooked.get();
+
+				if (cooked)
+				{
+					// Cooked textures are uploaded in their block compressed format, with every mip level
+					m_PendingTextureUploads[i].format = BlockCompressionFormatToVkFormat(cooked->GetFormat());
+				}
+				const VkFormat format = m_PendingTextureUploads[i].format;
+
+				const unsigned char* pixels = image.pixels ? image.pixels : whitePixel;
+				const glm::uint32 width = (cooked || image.pixels) ? (glm::uint32)image.width : 1;
+				const glm::uint32 height = (cooked || image.pixels) ? (glm::uint32)image.height : 1;
+				const glm::uint32 mipLevels = cooked ? cooked->GetMipCount() : 1;
+				const VkDeviceSize imageSize = cooked ?
+					(VkDeviceSize)cooked->GetDataSize() + mipLevels * stagingAlignment :
+					(VkDeviceSize)width * height * 4;
+
+				if (stagingOffset + imageSize > stagingBufferSize)
+				{
+					// Staging buffer is full, its contents must be consumed before being overwritten
+					EndSingleTimeCommands(commandBuffer);
+					commandBuffer = BeginSingleTimeCommands();
+					stagingOffset = 0;
+				}
+
+				regions.clear();
+				for (glm::uint32 mip = 0; mip < mipLevels; ++mip)
+				{
+					VkBufferImageCopy region = {};
+					region.bufferOffset = stagingOffset;
+					region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+					region.imageSubresource.mipLevel = mip;
+					region.imageSubresource.baseArrayLayer = 0;
+					region.imageSubresource.layerCount = 1;
+
+					if (cooked)
+					{
+						region.imageExtent = { cooked->GetMipWidth(mip), cooked->GetMipHeight(mip), 1 };
+						memcpy((unsigned char*)stagingBuffer.m_Mapped + stagingOffset, cooked->GetMipData(mip), cooked->GetMipSize(mip));
+						stagingOffset += (cooked->GetMipSize(mip) + stagingAlignment - 1) & ~(stagingAlignment - 1);
+					}
+					else
+					{
+						region.imageExtent = { width, height, 1 };
+						memcpy((unsigned char*)stagingBuffer.m_Mapped + stagingOffset, pixels, (size_t)imageSize);
+						stagingOffset += (imageSize + stagingAlignment - 1) & ~(stagingAlignment - 1);
+					}
+
+					regions.push_back(region);
+				}
+
+				texture->width = width;
+				texture->height = height;
+				texture->mipLevels = mipLevels;
+				CreateImage(width, height, format, VK_IMAGE_TILING_OPTIMAL,
+					VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VK_IMAGE_LAYOUT_PREINITIALIZED,
+					texture->image.replace(), texture->imageMemory.replace(), 1, mipLevels);
+
+				VkImageSubresourceRange subresourceRange = {};
+				subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+				subresourceRange.baseMipLevel = 0;
+				subresourceRange.levelCount = mipLevels;
+				subresourceRange.layerCount = 1;
+
+				SetImageLayout(commandBuffer, texture->image, VK_IMAGE_LAYOUT_PREINITIALIZED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, subresourceRange);
+				vkCmdCopyBufferToImage(commandBuffer, stagingBuffer.m_Buffer, texture->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, (glm::uint32)regions.size(), regions.data());
+				SetImageLayout(commandBuffer, texture->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, subresourceRange);
+			}
+
+			EndSingleTimeCommands(commandBuffer);
+			stagingBuffer.Unmap();
+
+			for (size_t i = 0; i < m_PendingTextureUploads.size(); ++i)
+			{
+				VulkanTexture* texture = m_PendingTextureUploads[i].texture;
+				CreateTextureImageView(texture, m_PendingTextureUploads[i].format);
+				CreateTextureSampler(texture, 16.0f, 0.0f, (float)(texture->mipLevels - 1));
+
+				texture->imageLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+				texture->UpdateImageDescriptor();
+
+				images[i].Free();
+			}
+
+			m_PendingTextureUploads.clear();
+		}
+
 		void VulkanRenderer::CreateTextureImage_Empty(glm::uint width, glm::uint height, VkFormat format, glm::uint mipLevels, VulkanTexture** texture) const
 		{
 			*texture = new VulkanTexture(m_VulkanDevice->m_LogicalDevice);
@@ -4435,7 +4916,7 @@ namespace flex
 				vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, gBufferObject->graphicsPipeline);
 				VkDeviceSize offsets[1] = { 0 };
 				vkCmdBindVertexBuffers(commandBuffer, 0, 1, &m_VertexIndexBufferPairs[gBufferMaterial->material.shaderID].vertexBuffer->m_Buffer, offsets);
-				vkCmdBindIndexBuffer(commandBuffer, m_VertexIndexBufferPairs[gBufferMaterial->material.shaderID].indexBuffer->m_Buffer, 0, VK_INDEX_TYPE_UINT32);
+				vkCmdBindIndexBuffer(commandBuffer, m_VertexIndexBufferPairs[gBufferMaterial->material.shaderID].indexBuffer->m_Buffer, 0, m_VertexIndexBufferPairs[gBufferMaterial->material.shaderID].indexType);
 				vkCmdDrawIndexed(commandBuffer, m_VertexIndexBufferPairs[gBufferMaterial->material.shaderID].indexCount, 1, 0, 0, 1);
 
 
@@ -4455,11 +4936,11 @@ namespace flex
 					// Only render non-deferred (forward) objects in this pass
 					if (m_Shaders[material->material.shaderID].shader.deferred) continue;
 
-					vkCmdBindVertexBuffers(commandBuffer, 0, 1, &m_VertexIndexBufferPairs[material->material.shaderID].vertexBuffer->m_Buffer, offsets);
+					const glm::uint vertexOffset = BindVertexBuffers(commandBuffer, renderObject);
 
 					if (m_VertexIndexBufferPairs[material->material.shaderID].indexBuffer->m_Size != 0)
 					{
-						vkCmdBindIndexBuffer(commandBuffer, m_VertexIndexBufferPairs[material->material.shaderID].indexBuffer->m_Buffer, 0, VK_INDEX_TYPE_UINT32);
+						vkCmdBindIndexBuffer(commandBuffer, m_VertexIndexBufferPairs[material->material.shaderID].indexBuffer->m_Buffer, 0, m_VertexIndexBufferPairs[material->material.shaderID].indexType);
 					}
 
 					vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, renderObject->graphicsPipeline);
@@ -4478,11 +4959,11 @@ namespace flex
 
 					if (renderObject->indexed)
 					{
-						vkCmdDrawIndexed(commandBuffer, m_VertexIndexBufferPairs[material->material.shaderID].indexCount, 1, renderObject->indexOffset, 0, 0);
+						DrawIndexed(commandBuffer, renderObject, vertexOffset);
 					}
 					else
 					{
-						vkCmdDraw(commandBuffer, renderObject->vertexBufferData->VertexCount, 1, renderObject->vertexOffset, 0);
+						vkCmdDraw(commandBuffer, renderObject->vertexCount, 1, vertexOffset, 0);
 					}
 				}
 
@@ -4540,8 +5021,6 @@ namespace flex
 			VkRect2D scissor = VkRect2D{ { 0u, 0u },{ offScreenFrameBuf->width, offScreenFrameBuf->height } };
 			vkCmdSetScissor(offScreenCmdBuffer, 0, 1, &scissor);
 
-			VkDeviceSize offsets[1] = { 0 };
-
 			// TODO: Batch objects with same materials together like in GL renderer
 			for (size_t i = 0; i < m_RenderObjects.size(); ++i)
 			{
@@ -4553,11 +5032,11 @@ namespace flex
 				// Only render deferred objects in this pass
 				if (!m_Shaders[material->material.shaderID].shader.deferred) continue;
 
-				vkCmdBindVertexBuffers(offScreenCmdBuffer, 0, 1, &m_VertexIndexBufferPairs[material->material.shaderID].vertexBuffer->m_Buffer, offsets);
+				const glm::uint vertexOffset = BindVertexBuffers(offScreenCmdBuffer, renderObject);
 
 				if (m_VertexIndexBufferPairs[material->material.shaderID].indexBuffer->m_Size != 0)
 				{
-					vkCmdBindIndexBuffer(offScreenCmdBuffer, m_VertexIndexBufferPairs[material->material.shaderID].indexBuffer->m_Buffer, 0, VK_INDEX_TYPE_UINT32);
+					vkCmdBindIndexBuffer(offScreenCmdBuffer, m_VertexIndexBufferPairs[material->material.shaderID].indexBuffer->m_Buffer, 0, m_VertexIndexBufferPairs[material->material.shaderID].indexType);
 				}
 
 				vkCmdBindPipeline(offScreenCmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, renderObject->graphicsPipeline);
@@ -4576,11 +5055,11 @@ namespace flex
 
 				if (renderObject->indexed)
 				{
-					vkCmdDrawIndexed(offScreenCmdBuffer, m_VertexIndexBufferPairs[m_LoadedMaterials[renderObject->materialID].material.shaderID].indexCount, 1, renderObject->indexOffset, 0, 0);
+					DrawIndexed(offScreenCmdBuffer, renderObject, vertexOffset);
 				}
 				else
 				{
-					vkCmdDraw(offScreenCmdBuffer, renderObject->vertexBufferData->VertexCount, 1, renderObject->vertexOffset, 0);
+					vkCmdDraw(offScreenCmdBuffer, renderObject->vertexCount, 1, vertexOffset, 0);
 				}
 			}
 
@@ -4874,6 +5353,115 @@ namespace flex
 			EndSingleTimeCommands(commandBuffer);
 		}
 
+		void VulkanRenderer::CullRenderObjectMeshlets(const GameContext& gameContext)
+		{
+			const glm::mat4 viewProjection = gameContext.camera->GetViewProjection();
+			const glm::vec3 cameraPosition = gameContext.camera->GetPosition();
+
+			m_IndirectDrawCommands.clear();
+
+			for (VulkanRenderObject* renderObject : m_RenderObjects)
+			{
+				if (!renderObject || !renderObject->meshlets || !renderObject->visible) continue;
+
+				const glm::mat4 model = renderObject->transform ? renderObject->transform->GetModelMatrix() : glm::mat4(1.0f);
+				CullMeshlets(viewProjection, cameraPosition, model, *renderObject->meshlets, renderObject->visibleIndexRanges);
+
+				// Must match the vertex offset BindVertexBuffers returns for this object
+				const bool separatePositions = (renderObject->vertexBufferData && renderObject->vertexBufferData->SeparatePositions);
+				const int32_t vertexOffset = separatePositions ? 0 : (int32_t)renderObject->vertexOffset;
+
+				renderObject->firstIndirectCommand = (glm::uint)m_IndirectDrawCommands.size();
+				renderObject->indirectCommandCount = (glm::uint)renderObject->visibleIndexRanges.size();
+				for (const MeshLOD& range : renderObject->visibleIndexRanges)
+				{
+					VkDrawIndexedIndirectCommand command = {};
+					command.indexCount = range.indexCount;
+					command.instanceCount = 1;
+					command.firstIndex = renderObject->indexOffset + range.firstIndex;
+					command.vertexOffset = vertexOffset;
+					command.firstInstance = 0;
+					m_IndirectDrawCommands.push_back(command);
+				}
+			}
+
+			UploadIndirectDrawCommands();
+		}
+
+		void VulkanRenderer::UploadIndirectDrawCommands()
+		{
+			if (m_IndirectDrawCommands.empty()) return;
+
+			const VkDeviceSize size = sizeof(VkDrawIndexedIndirectCommand) * m_IndirectDrawCommands.size();
+			if (!m_IndirectDrawBuffer || m_IndirectDrawBuffer->m_Size < size)
+			{
+				VkDeviceSize capacity = size;
+				if (m_IndirectDrawBuffer)
+				{
+					capacity = std::max(size, m_IndirectDrawBuffer->m_Size * 2);
+					m_IndirectDrawBuffer->Unmap();
+					SafeDelete(m_IndirectDrawBuffer);
+				}
+
+				m_IndirectDrawBuffer = new VulkanBuffer(m_VulkanDevice->m_LogicalDevice);
+				CreateAndAllocateBuffer(capacity, VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+					VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, m_IndirectDrawBuffer);
+				VK_CHECK_RESULT(m_IndirectDrawBuffer->Map());
+			}
+
+			memcpy(m_IndirectDrawBuffer->m_Mapped, m_IndirectDrawCommands.data(), (size_t)size);
+		}
+
+		void VulkanRenderer::DrawIndexed(VkCommandBuffer commandBuffer, VulkanRenderObject* renderObject, glm::uint vertexOffset)
+		{
+			if (renderObject->meshlets)
+			{
+				// Adjacent visible meshlets have already been merged, each command draws one run of them
+				// Per object uniforms are selected through dynamic offsets when descriptor sets are bound, so commands can't span objects
+				if (renderObject->indirectCommandCount == 0) return;
+
+				const VkDeviceSize offset = sizeof(VkDrawIndexedIndirectCommand) * renderObject->firstIndirectCommand;
+				const uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+				if (m_VulkanDevice->m_PhysicalDeviceFeatures.multiDrawIndirect)
+				{
+					vkCmdDrawIndexedIndirect(commandBuffer, m_IndirectDrawBuffer->m_Buffer, offset, renderObject->indirectCommandCount, stride);
+				}
+				else
+				{
+					for (glm::uint i = 0; i < renderObject->indirectCommandCount; ++i)
+					{
+						vkCmdDrawIndexedIndirect(commandBuffer, m_IndirectDrawBuffer->m_Buffer, offset + stride * i, 1, stride);
+					}
+				}
+			}
+			else
+			{
+				vkCmdDrawIndexed(commandBuffer, renderObject->indexCount, 1, renderObject->indexOffset + renderObject->firstIndex, vertexOffset, 0);
+			}
+		}
+
+		glm::uint VulkanRenderer::BindVertexBuffers(VkCommandBuffer commandBuffer, VulkanRenderObject* renderObject)
+		{
+			VulkanBuffer* vertexBuffer = m_VertexIndexBufferPairs[m_LoadedMaterials[renderObject->materialID].material.shaderID].vertexBuffer;
+			VertexBufferData* vertexBufferData = renderObject->vertexBufferData;
+
+			if (vertexBufferData && vertexBufferData->SeparatePositions)
+			{
+				// Each stream is bound at this object's own data, so its vertices start at zero
+				VkBuffer buffers[2] = { vertexBuffer->m_Buffer, vertexBuffer->m_Buffer };
+				VkDeviceSize offsets[2] = {
+					renderObject->vertexBufferOffset + vertexBufferData->GetStreamOffset(0),
+					renderObject->vertexBufferOffset + vertexBufferData->GetStreamOffset(1)
+				};
+				vkCmdBindVertexBuffers(commandBuffer, 0, 2, buffers, offsets);
+				return 0;
+			}
+
+			VkDeviceSize offsets[1] = { 0 };
+			vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vertexBuffer->m_Buffer, offsets);
+			return renderObject->vertexOffset;
+		}
+
 		void VulkanRenderer::CreateStaticVertexBuffers()
 		{
 			for (size_t i = 0; i < m_VertexIndexBufferPairs.size(); ++i)
@@ -4882,9 +5470,11 @@ namespace flex
 				{
 					size_t requiredMemory = 0;
 
+					std::set<const VertexBufferData*> uniqueVertexBufferDatas;
 					for (VulkanRenderObject* renderObject : m_RenderObjects)
 					{
-						if (renderObject && renderObject->vertexBufferData && m_LoadedMaterials[renderObject->materialID].material.shaderID == i)
+						if (renderObject && renderObject->vertexBufferData && m_LoadedMaterials[renderObject->materialID].material.shaderID == i &&
+							uniqueVertexBufferDatas.insert(renderObject->vertexBufferData).second)
 						{
 							requiredMemory += renderObject->vertexBufferData->BufferSize;
 						}
@@ -4914,15 +5504,29 @@ namespace flex
 
 			glm::uint vertexCount = 0;
 			glm::uint vertexBufferSize = 0;
+
+			// Objects created from the same data (eg. several instances of one mesh) all read the first one's copy
+			std::map<const VertexBufferData*, VulkanRenderObject*> firstUsers;
+
 			for (VulkanRenderObject* renderObject : m_RenderObjects)
 			{
 				if (renderObject && renderObject->vertexBufferData && m_LoadedMaterials[renderObject->materialID].material.shaderID == shaderID)
 				{
+					auto firstUserIter = firstUsers.find(renderObject->vertexBufferData);
+					if (firstUserIter != firstUsers.end())
+					{
+						renderObject->vertexOffset = firstUserIter->second->vertexOffset;
+						renderObject->vertexBufferOffset = firstUserIter->second->vertexBufferOffset;
+						continue;
+					}
+					firstUsers[renderObject->vertexBufferData] = renderObject;
+
 					renderObject->vertexOffset = vertexCount;
+					renderObject->vertexBufferOffset = vertexBufferSize;
 
 					memcpy(vertexBufferData, renderObject->vertexBufferData->pDataStart, renderObject->vertexBufferData->BufferSize);
 
-					vertexCount += renderObject->vertexBufferData->VertexCount;
+					vertexCount += renderObject->vertexCount;
 					vertexBufferSize += renderObject->vertexBufferData->BufferSize;
 
 					vertexBufferData = (char*)vertexBufferData + renderObject->vertexBufferData->BufferSize;
@@ -4961,20 +5565,40 @@ namespace flex
 		{
 			for (size_t i = 0; i < m_VertexIndexBufferPairs.size(); ++i)
 			{
-				m_VertexIndexBufferPairs[i].indexCount = CreateStaticIndexBuffer(m_VertexIndexBufferPairs[i].indexBuffer, i);
+				m_VertexIndexBufferPairs[i].indexCount = CreateStaticIndexBuffer(m_VertexIndexBufferPairs[i].indexBuffer, i, &m_VertexIndexBufferPairs[i].indexType);
 			}
 		}
 
-		glm::uint VulkanRenderer::CreateStaticIndexBuffer(VulkanBuffer* indexBuffer, ShaderID shaderID)
+		glm::uint VulkanRenderer::CreateStaticIndexBuffer(VulkanBuffer* indexBuffer, ShaderID shaderID, VkIndexType* outIndexType)
 		{
 			std::vector<glm::uint> indices;
 
+			// Indices are relative to each object's vertexOffset, so 16-bit indices can be
+			// used as long as no single indexed object has more vertices than they can address
+			bool use16BitIndices = true;
+
+			// Objects sharing index data also share vertex data (see CreateStaticVertexBuffer), so can share indices too
+			std::map<const std::vector<glm::uint>*, glm::uint> indexOffsets;
+
 			for (VulkanRenderObject* renderObject : m_RenderObjects)
 			{
 				if (renderObject && m_LoadedMaterials[renderObject->materialID].material.shaderID == shaderID && renderObject->indexed)
 				{
+					auto indexOffsetIter = indexOffsets.find(renderObject->indices);
+					if (indexOffsetIter != indexOffsets.end())
+					{
+						renderObject->indexOffset = indexOffsetIter->second;
+						continue;
+					}
+
 					renderObject->indexOffset = indices.size();
+					indexOffsets[renderObject->indices] = renderObject->indexOffset;
 					indices.insert(indices.end(), renderObject->indices->begin(), renderObject->indices->end());
+
+					if (!renderObject->vertexBufferData || renderObject->vertexCount > 65536)
+					{
+						use16BitIndices = false;
+					}
 				}
 			}
 
@@ -4984,21 +5608,35 @@ namespace flex
 				return 0;
 			}
 
-			CreateStaticIndexBuffer(indexBuffer, indices);
+			if (use16BitIndices)
+			{
+				std::vector<glm::uint16> indices16;
+				indices16.reserve(indices.size());
+				for (glm::uint index : indices)
+				{
+					indices16.push_back((glm::uint16)index);
+				}
+
+				*outIndexType = VK_INDEX_TYPE_UINT16;
+				CreateStaticIndexBuffer(indexBuffer, indices16.data(), sizeof(indices16[0]) * indices16.size());
+			}
+			else
+			{
+				*outIndexType = VK_INDEX_TYPE_UINT32;
+				CreateStaticIndexBuffer(indexBuffer, indices.data(), sizeof(indices[0]) * indices.size());
+			}
 
 			return indices.size();
 		}
 
-		void VulkanRenderer::CreateStaticIndexBuffer(VulkanBuffer* indexBuffer, const std::vector<glm::uint>& indices)
+		void VulkanRenderer::CreateStaticIndexBuffer(VulkanBuffer* indexBuffer, const void* indexData, size_t bufferSize)
 		{
-			const size_t bufferSize = sizeof(indices[0]) * indices.size();
-
 			VulkanBuffer stagingBuffer(m_VulkanDevice->m_LogicalDevice);
 			CreateAndAllocateBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
 				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &stagingBuffer);
 
 			stagingBuffer.Map(bufferSize);
-			memcpy(stagingBuffer.m_Mapped, indices.data(), bufferSize);
+			memcpy(stagingBuffer.m_Mapped, indexData, bufferSize);
 			stagingBuffer.Unmap();
 
 			CreateAndAllocateBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
@@ -5464,8 +6102,19 @@ namespace flex
 
 			bool updateMVP = false; // This is set to true when either the view or projection matrix get overriden
 
-			glm::mat4 model = renderObject->transform->GetModelMatrix();
-			glm::mat4 modelInvTranspose = glm::transpose(glm::inverse(model));
+			// Calculated for every object at once by UpdateObjectMatrices
+			glm::mat4 model;
+			glm::mat4 modelInvTranspose;
+			if (renderID < m_ObjectMatrices.size())
+			{
+				model = m_ObjectMatrices[renderID].model;
+				modelInvTranspose = m_ObjectMatrices[renderID].modelInvTranspose;
+			}
+			else
+			{
+				model = renderObject->transform->GetModelMatrix();
+				modelInvTranspose = glm::transpose(glm::inverse(model));
+			}
 			glm::mat4 projection = gameContext.camera->GetProjection();
 			glm::mat4 view = gameContext.camera->GetView();
 			glm::mat4 modelViewProjection = projection * view * model;
@@ -5545,15 +6194,8 @@ namespace flex
 				modelInvTranspose = glm::transpose(glm::inverse(model));
 			}
 
-			glm::uint offset = 0;
-			for (VulkanRenderObject* renderObj : m_RenderObjects)
-			{
-				if (renderObj->renderID != renderObject->renderID &&
-					m_LoadedMaterials[renderObj->materialID].material.shaderID == m_LoadedMaterials[renderObject->materialID].material.shaderID)
-				{
-					offset += uniformBuffer.dynamicData.size;
-				}
-			}
+			// Written straight into this object's slot in the mapped buffer, flushed along with every other object's by FlushDynamicUniformBuffers
+			float* dest = (float*)((glm::uint8*)uniformBuffer.dynamicBuffer.m_Mapped + renderID * m_DynamicAlignment);
 			glm::uint index = 0;
 
 			struct UniformInfo
@@ -5586,30 +6228,15 @@ namespace flex
 			{
 				if (dynamicUniforms.HasUniform(uniformInfo.uniformName))
 				{
-					memcpy(&uniformBuffer.dynamicData.data[offset + index], uniformInfo.dataStart, uniformInfo.copySize);
+					memcpy(&dest[index], uniformInfo.dataStart, uniformInfo.copySize);
 					index += uniformInfo.moveInBytes;
 				}
 			}
 
-			// Aligned offset
-			glm::uint size = uniformBuffer.dynamicData.size;
-
 #if  _DEBUG
 			glm::uint calculatedSize1 = index * 4;
-			assert(calculatedSize1 == size);
+			assert(calculatedSize1 == uniformBuffer.dynamicData.size);
 #endif // _DEBUG
-
-			void* firstIndex = uniformBuffer.dynamicBuffer.m_Mapped;
-			uint64_t dest = (uint64_t)firstIndex + (renderID * m_DynamicAlignment);
-			memcpy((void*)(dest), &uniformBuffer.dynamicData.data[offset], size);
-
-			// Flush to make changes visible to the host 
-			VkMappedMemoryRange mappedMemoryRange{};
-			mappedMemoryRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-			mappedMemoryRange.offset = offset;
-			mappedMemoryRange.memory = uniformBuffer.dynamicBuffer.m_Memory;
-			mappedMemoryRange.size = uniformBuffer.dynamicData.size;
-			vkFlushMappedMemoryRanges(m_VulkanDevice->m_LogicalDevice, 1, &mappedMemoryRange);
 		}
 
 		void VulkanRenderer::LoadDefaultShaderCode()
@@ -5627,6 +6254,7 @@ namespace flex
 				{ "brdf", shaderDirectory + "vk_brdf_vert.spv", shaderDirectory + "vk_brdf_frag.spv", m_VulkanDevice->m_LogicalDevice },
 				{ "background", shaderDirectory + "vk_background_vert.spv", shaderDirectory + "vk_background_frag.spv", m_VulkanDevice->m_LogicalDevice },
 				{ "deferred_combine", shaderDirectory + "vk_deferred_combine_vert.spv", shaderDirectory + "vk_deferred_combine_frag.spv", m_VulkanDevice->m_LogicalDevice },
+				{ "pbr_compressed", shaderDirectory + "vk_pbr_compressed_vert.spv", shaderDirectory + "vk_pbr_frag.spv", m_VulkanDevice->m_LogicalDevice },
 				//{ "deferred_combine_cubemap", shaderDirectory + "vk_deferred_combine_cubemap_vert.spv", shaderDirectory + "vk_deferred_combine_cubemap_frag.spv", m_VulkanDevice->m_LogicalDevice },
 				//{ "post_process", shaderDirectory + "vk_post_process_vert.spv", shaderDirectory + "vk_post_process_frag.spv", m_VulkanDevice->m_LogicalDevice },
 			};
@@ -5793,6 +6421,37 @@ namespace flex
 			m_Shaders[shaderID].shader.dynamicBufferUniforms.AddUniform("uniformBufferDynamic");
 			m_Shaders[shaderID].shader.dynamicBufferUniforms.AddUniform("enableIrradianceSampler");
 			++shaderID;
+
+			// PBR (compressed vertex attributes)
+			m_Shaders[shaderID].shader.numAttachments = 3;
+			m_Shaders[shaderID].shader.deferred = true;
+			m_Shaders[shaderID].shader.subpass = 0;
+			m_Shaders[shaderID].shader.needAlbedoSampler = true;
+			m_Shaders[shaderID].shader.needMetallicSampler = true;
+			m_Shaders[shaderID].shader.needRoughnessSampler = true;
+			m_Shaders[shaderID].shader.needAOSampler = true;
+			m_Shaders[shaderID].shader.needNormalSampler = true;
+
+			m_Shaders[shaderID].shader.constantBufferUniforms.AddUniform("uniformBufferConstant");
+			m_Shaders[shaderID].shader.constantBufferUniforms.AddUniform("viewProjection");
+
+			m_Shaders[shaderID].shader.dynamicBufferUniforms.AddUniform("uniformBufferDynamic");
+			m_Shaders[shaderID].shader.dynamicBufferUniforms.AddUniform("model");
+			m_Shaders[shaderID].shader.dynamicBufferUniforms.AddUniform("enableAlbedoSampler");
+			m_Shaders[shaderID].shader.dynamicBufferUniforms.AddUniform("albedoSampler");
+			m_Shaders[shaderID].shader.dynamicBufferUniforms.AddUniform("constAlbedo");
+			m_Shaders[shaderID].shader.dynamicBufferUniforms.AddUniform("enableMetallicSampler");
+			m_Shaders[shaderID].shader.dynamicBufferUniforms.AddUniform("metallicSampler");
+			m_Shaders[shaderID].shader.dynamicBufferUniforms.AddUniform("constMetallic");
+			m_Shaders[shaderID].shader.dynamicBufferUniforms.AddUniform("enableRoughnessSampler");
+			m_Shaders[shaderID].shader.dynamicBufferUniforms.AddUniform("roughnessSampler");
+			m_Shaders[shaderID].shader.dynamicBufferUniforms.AddUniform("constRoughness");
+			m_Shaders[shaderID].shader.dynamicBufferUniforms.AddUniform("enableAOSampler");
+			m_Shaders[shaderID].shader.dynamicBufferUniforms.AddUniform("aoSampler");
+			m_Shaders[shaderID].shader.dynamicBufferUniforms.AddUniform("constAO");
+			m_Shaders[shaderID].shader.dynamicBufferUniforms.AddUniform("enableNormalSampler");
+			m_Shaders[shaderID].shader.dynamicBufferUniforms.AddUniform("normalSampler");
+			++shaderID;
 			
 
 			const size_t shaderCount = m_Shaders.size();
@@ -2,15 +2,21 @@
 
 #include "Helpers.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
 #include <sstream>
 #include <iomanip>
 #include <fstream>
+#include <memory>
+#include <mutex>
 
 #include <imgui.h>
 
 #include <glm/gtx/matrix_decompose.hpp>
 
 #include "Logger.hpp"
+#include "ThreadPool.hpp"
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
@@ -25,8 +31,6 @@ namespace flex
 		StripLeadingDirectories(fileName);
 		Logger::LogInfo("Loading texture " + fileName);
 
-		stbi_set_flip_vertically_on_load(flipVertically);
-
 		int channels;
 		unsigned char* data = stbi_load(filePath.c_str(), &result.width, &result.height, &channels, alpha ? STBI_rgb_alpha : STBI_rgb);
 
@@ -41,6 +45,11 @@ namespace flex
 			result.pixels = static_cast<unsigned char*>(data);
 		}
 
+		if (flipVertically)
+		{
+			FlipImageVertically(result.pixels, result.width, result.height, alpha ? 4 : 3);
+		}
+
 		return result;
 	}
 
@@ -50,6 +59,28 @@ namespace flex
 		image.pixels = nullptr;
 	}
 
+	void FlipImageVertically(void* pixels, int width, int height, int bytesPerPixel)
+	{
+		if (height < 2)
+		{
+			return;
+		}
+
+		const size_t rowSize = (size_t)width * bytesPerPixel;
+		std::vector<unsigned char> row(rowSize);
+
+		unsigned char* top = (unsigned char*)pixels;
+		unsigned char* bottom = top + (height - 1) * rowSize;
+		while (top < bottom)
+		{
+			memcpy(row.data(), top, rowSize);
+			memcpy(top, bottom, rowSize);
+			memcpy(bottom, row.data(), rowSize);
+			top += rowSize;
+			bottom -= rowSize;
+		}
+	}
+
 	std::string FloatToString(float f, int precision)
 	{
 		std::stringstream stream;
@@ -95,6 +126,79 @@ namespace flex
 		}
 	}
 
+	namespace
+	{
+		// Created on first use & kept for the lifetime of the program, so calls made every frame don't start threads of their own
+		ThreadPool& GetParallelForThreadPool()
+		{
+			static ThreadPool threadPool;
+			return threadPool;
+		}
+
+		// Shared with the pool's jobs, which may only start once every range has been claimed & the call has returned
+		struct ParallelForState
+		{
+			const std::function<void(glm::uint begin, glm::uint end)>* function;
+			glm::uint count;
+			glm::uint countPerRange;
+			glm::uint rangeCount;
+
+			std::atomic<glm::uint> nextRange;
+			std::atomic<glm::uint> finishedRangeCount;
+			std::mutex mutex;
+			std::condition_variable finished;
+		};
+
+		void RunParallelForRanges(ParallelForState& state)
+		{
+			glm::uint range;
+			while ((range = state.nextRange++) < state.rangeCount)
+			{
+				const glm::uint begin = range * state.countPerRange;
+				const glm::uint end = std::min(begin + state.countPerRange, state.count);
+				(*state.function)(begin, end);
+
+				if (++state.finishedRangeCount == state.rangeCount)
+				{
+					std::lock_guard<std::mutex> lock(state.mutex);
+					state.finished.notify_all();
+				}
+			}
+		}
+	} // namespace
+
+	void ParallelFor(glm::uint count, glm::uint minCountPerThread, const std::function<void(glm::uint begin, glm::uint end)>& function)
+	{
+		ThreadPool& threadPool = GetParallelForThreadPool();
+
+		// Pool threads plus this one
+		const glm::uint threadCount = std::max(std::min(threadPool.GetThreadCount() + 1, count / std::max(minCountPerThread, 1u)), 1u);
+		if (threadCount == 1)
+		{
+			function(0, count);
+			return;
+		}
+
+		std::shared_ptr<ParallelForState> state = std::make_shared<ParallelForState>();
+		state->function = &function;
+		state->count = count;
+		state->countPerRange = (count + threadCount - 1) / threadCount;
+		state->rangeCount = (count + state->countPerRange - 1) / state->countPerRange;
+		state->nextRange = 0;
+		state->finishedRangeCount = 0;
+
+		for (glm::uint i = 1; i < state->rangeCount; ++i)
+		{
+			threadPool.Enqueue([state]() { RunParallelForRanges(*state); });
+		}
+
+		// This thread takes ranges rather than sitting idle, and any not yet picked up by the pool once it runs out
+		RunParallelForRanges(*state);
+
+		std::unique_lock<std::mutex> lock(state->mutex);
+		state->finished.wait(lock, [&state]() { return state->finishedRangeCount == state->rangeCount; });
+	}
+
 	float Lerp(float a, float b, float t)
 	{
 		return a * (1.0f - t) + b * t;
@@ -194,8 +298,6 @@ namespace flex
 		StripLeadingDirectories(fileName);
 		Logger::LogInfo("Loading HDR texture " + fileName);
 
-		stbi_set_flip_vertically_on_load(flipVertically);
-
 		int channelCount;
 		pixels = stbi_loadf(filePath.c_str(), &width, &height, &channelCount, STBI_rgb_alpha);
 
@@ -205,6 +307,11 @@ namespace flex
 			return false;
 		}
 
+		if (flipVertically)
+		{
+			FlipImageVertically(pixels, width, height, 4 * sizeof(float));
+		}
+
 		return true;
 	}
 
@@ -0,0 +1,1021 @@
+#include "stdafx.hpp"
+
+#include "IBLBaker.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#include <windows.h>
+#endif
+
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+#include <glm/vec3.hpp>
+#include <glm/gtc/packing.hpp>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define FLEX_SSE2 1
+#else
+#define FLEX_SSE2 0
+#endif
+
+#include "Helpers.hpp"
+#include "Logger.hpp"
+#include "MipGenerator.hpp"
+#include "ThreadPool.hpp"
+
+namespace flex
+{
+	namespace
+	{
+		const float PI = 3.14159265358979f;
+
+		const std::string IBL_CACHE_DIRECTORY = RESOURCE_LOCATION + "textures/cooked/";
+
+		const glm::uint PREFILTER_SAMPLE_COUNT = 1024;
+		const glm::uint BRDF_SAMPLE_COUNT = 1024;
+
+		// Largest face size the environment is projected onto spherical harmonics from, lower frequencies are all irradiance keeps
+		const glm::uint IRRADIANCE_SOURCE_SIZE = 64;
+
+		const glm::uint MIN_ROWS_PER_THREAD = 8;
+
+		// Largest finite half float, brighter texels (like the sun) would otherwise become infinite
+		const float MAX_HALF_FLOAT = 65504.0f;
+
+		// A linear RGBA cubemap, each level holding its six faces consecutively
+		struct FloatCubemap
+		{
+			FloatCubemap(glm::uint size, glm::uint levelCount) :
+				size(size)
+			{
+				levels.resize(levelCount);
+				for (glm::uint level = 0; level < levelCount; ++level)
+				{
+					const size_t levelSize = GetLevelSize(level);
+					levels[level].resize(levelSize * levelSize * 6 * 4);
+				}
+			}
+
+			glm::uint GetLevelSize(glm::uint level) const
+			{
+				return std::max(size >> level, 1u);
+			}
+
+			float* GetFace(glm::uint level, glm::uint face)
+			{
+				const size_t levelSize = GetLevelSize(level);
+				return levels[level].data() + levelSize * levelSize * 4 * face;
+			}
+
+			const float* GetFace(glm::uint level, glm::uint face) const
+			{
+				const size_t levelSize = GetLevelSize(level);
+				return levels[level].data() + levelSize * levelSize * 4 * face;
+			}
+
+			glm::uint size;
+			std::vector<std::vector<float>> levels;
+		};
+
+		// Direction through the center of a texel, following the GL cube map face conventions
+		glm::vec3 GetTexelDirection(glm::uint face, glm::uint x, glm::uint y, glm::uint size)
+		{
+			const float s = ((float)x + 0.5f) / (float)size * 2.0f - 1.0f;
+			const float t = ((float)y + 0.5f) / (float)size * 2.0f - 1.0f;
+
+			glm::vec3 direction;
+			switch (face)
+			{
+			case 0: direction = glm::vec3(1.0f, -t, -s); break;
+			case 1: direction = glm::vec3(-1.0f, -t, s); break;
+			case 2: direction = glm::vec3(s, 1.0f, t); break;
+			case 3: direction = glm::vec3(s, -1.0f, -t); break;
+			case 4: direction = glm::vec3(s, -t, 1.0f); break;
+			default: direction = glm::vec3(-s, -t, -1.0f); break;
+			}
+			return glm::normalize(direction);
+		}
+
+		// Inverse of GetTexelDirection, s & t are in [0, 1]
+		void GetFaceCoordinates(const glm::vec3& direction, glm::uint& face, float& s, float& t)
+		{
+			const glm::vec3 absDirection = glm::abs(direction);
+
+			float majorAxis, sc, tc;
+			if (absDirection.x >= absDirection.y && absDirection.x >= absDirection.z)
+			{
+				face = (direction.x > 0.0f ? 0 : 1);
+				majorAxis = absDirection.x;
+				sc = (direction.x > 0.0f ? -direction.z : direction.z);
+				tc = -direction.y;
+			}
+			else if (absDirection.y >= absDirection.z)
+			{
+				face = (direction.y > 0.0f ? 2 : 3);
+				majorAxis = absDirection.y;
+				sc = direction.x;
+				tc = (direction.y > 0.0f ? direction.z : -direction.z);
+			}
+			else
+			{
+				face = (direction.z > 0.0f ? 4 : 5);
+				majorAxis = absDirection.z;
+				sc = (direction.z > 0.0f ? direction.x : -direction.x);
+				tc = -direction.y;
+			}
+
+			s = (sc / majorAxis + 1.0f) * 0.5f;
+			t = (tc / majorAxis + 1.0f) * 0.5f;
+		}
+
+		// Bilinearly samples a width x height RGBA image at (x, y) in texels, weighted result is added to result
+		// Columns wrap around when wrapX is set (for equirectangular images), otherwise every edge is clamped
+		inline void AccumulateBilinear(const float* pixels, glm::uint width, glm::uint height, float x, float y, bool wrapX, float weight, float* result)
+		{
+			x -= 0.5f;
+			y -= 0.5f;
+			const float floorX = std::floor(x);
+			const float floorY = std::floor(y);
+			const float fracX = x - floorX;
+			const float fracY = y - floorY;
+
+			int x0 = (int)floorX;
+			int x1 = x0 + 1;
+			if (wrapX)
+			{
+				x0 = (x0 % (int)width + (int)width) % (int)width;
+				x1 = (x1 % (int)width + (int)width) % (int)width;
+			}
+			else
+			{
+				x0 = glm::clamp(x0, 0, (int)width - 1);
+				x1 = glm::clamp(x1, 0, (int)width - 1);
+			}
+			const int y0 = glm::clamp((int)floorY, 0, (int)height - 1);
+			const int y1 = glm::clamp((int)floorY + 1, 0, (int)height - 1);
+
+			const float* p00 = pixels + ((size_t)y0 * width + x0) * 4;
+			const float* p10 = pixels + ((size_t)y0 * width + x1) * 4;
+			const float* p01 = pixels + ((size_t)y1 * width + x0) * 4;
+			const float* p11 = pixels + ((size_t)y1 * width + x1) * 4;
+
+			const float w00 = (1.0f - fracX) * (1.0f - fracY) * weight;
+			const float w10 = fracX * (1.0f - fracY) * weight;
+			const float w01 = (1.0f - fracX) * fracY * weight;
+			const float w11 = fracX * fracY * weight;
+
+#if FLEX_SSE2
+			__m128 sum = _mm_loadu_ps(result);
+			sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(p00), _mm_set1_ps(w00)));
+			sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(p10), _mm_set1_ps(w10)));
+			sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(p01), _mm_set1_ps(w01)));
+			sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(p11), _mm_set1_ps(w11)));
+			_mm_storeu_ps(result, sum);
+#else
+			for (glm::uint c = 0; c < 4; ++c)
+			{
+				result[c] += p00[c] * w00 + p10[c] * w10 + p01[c] * w01 + p11[c] * w11;
+			}
+#endif
+		}
+
+		// Trilinearly samples cubemap, weighted result is added to result
+		void AccumulateCubemapSample(const FloatCubemap& cubemap, const glm::vec3& direction, float lod, float weight, float* result)
+		{
+			glm::uint face;
+			float s, t;
+			GetFaceCoordinates(direction, face, s, t);
+
+			const float maxLod = (float)(cubemap.levels.size() - 1);
+			lod = glm::clamp(lod, 0.0f, maxLod);
+			const glm::uint level0 = (glm::uint)lod;
+			const glm::uint level1 = std::min(level0 + 1, (glm::uint)maxLod);
+			const float levelFrac = lod - (float)level0;
+
+			const glm::uint size0 = cubemap.GetLevelSize(level0);
+			AccumulateBilinear(cubemap.GetFace(level0, face), size0, size0, s * size0, t * size0, false, weight * (1.0f - levelFrac), result);
+			if (levelFrac > 0.0f)
+			{
+				const glm::uint size1 = cubemap.GetLevelSize(level1);
+				AccumulateBilinear(cubemap.GetFace(level1, face), size1, size1, s * size1, t * size1, false, weight * levelFrac, result);
+			}
+		}
+
+		// Fills every level below the first by averaging each 2x2 square of the level above
+		void GenerateCubemapMips(FloatCubemap& cubemap)
+		{
+			for (glm::uint level = 1; level < (glm::uint)cubemap.levels.size(); ++level)
+			{
+				const glm::uint srcSize = cubemap.GetLevelSize(level - 1);
+				const glm::uint dstSize = cubemap.GetLevelSize(level);
+				for (glm::uint face = 0; face < 6; ++face)
+				{
+					const float* src = cubemap.GetFace(level - 1, face);
+					float* dst = cubemap.GetFace(level, face);
+					for (glm::uint y = 0; y < dstSize; ++y)
+					{
+						const glm::uint y0 = std::min(y * 2, srcSize - 1);
+						const glm::uint y1 = std::min(y * 2 + 1, srcSize - 1);
+						for (glm::uint x = 0; x < dstSize; ++x)
+						{
+							const glm::uint x0 = std::min(x * 2, srcSize - 1);
+							const glm::uint x1 = std::min(x * 2 + 1, srcSize - 1);
+							for (glm::uint c = 0; c < 4; ++c)
+							{
+								dst[((size_t)y * dstSize + x) * 4 + c] = 0.25f * (
+									src[((size_t)y0 * srcSize + x0) * 4 + c] + src[((size_t)y0 * srcSize + x1) * 4 + c] +
+									src[((size_t)y1 * srcSize + x0) * 4 + c] + src[((size_t)y1 * srcSize + x1) * 4 + c]);
+							}
+						}
+					}
+				}
+			}
+		}
+
+		// Must stay in the same order as EvaluateIrradianceSH in sh_irradiance.glsl, which evaluates the coefficients
+		void EvaluateSH9Basis(const glm::vec3& n, float* basis)
+		{
+			basis[0] = 0.282095f;
+			basis[1] = 0.488603f * n.y;
+			basis[2] = 0.488603f * n.z;
+			basis[3] = 0.488603f * n.x;
+			basis[4] = 1.092548f * n.x * n.y;
+			basis[5] = 1.092548f * n.y * n.z;
+			basis[6] = 0.315392f * (3.0f * n.z * n.z - 1.0f);
+			basis[7] = 1.092548f * n.x * n.z;
+			basis[8] = 0.546274f * (n.x * n.x - n.y * n.y);
+		}
+
+		// Fills the first level of irradiance with the cosine weighted average radiance around each texel's direction,
+		// matching irradiance.frag, by way of the environment's projection onto the first nine spherical harmonics
+		void BakeIrradiance(const FloatCubemap& environment, FloatCubemap& irradiance, IrradianceSH9& irradianceSH)
+		{
+			glm::uint sourceLevel = 0;
+			while (environment.GetLevelSize(sourceLevel) > IRRADIANCE_SOURCE_SIZE && sourceLevel + 1 < (glm::uint)environment.levels.size())
+			{
+				++sourceLevel;
+			}
+
+			const float* faces[6];
+			for (glm::uint face = 0; face < 6; ++face)
+			{
+				faces[face] = environment.GetFace(sourceLevel, face);
+			}
+			ProjectIrradianceSH9(faces, environment.GetLevelSize(sourceLevel), irradianceSH);
+
+			const glm::uint size = irradiance.size;
+			for (glm::uint face = 0; face < 6; ++face)
+			{
+				float* texels = irradiance.GetFace(0, face);
+				for (glm::uint y = 0; y < size; ++y)
+				{
+					for (glm::uint x = 0; x < size; ++x)
+					{
+						const glm::vec3 result = EvaluateIrradianceSH9(irradianceSH, GetTexelDirection(face, x, y, size));
+
+						float* texel = texels + ((size_t)y * size + x) * 4;
+						texel[0] = result.x;
+						texel[1] = result.y;
+						texel[2] = result.z;
+						texel[3] = 1.0f;
+					}
+				}
+			}
+		}
+
+		float RadicalInverse(glm::uint bits)
+		{
+			bits = (bits << 16u) | (bits >> 16u);
+			bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+			bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+			bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+			bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+			return (float)bits * 2.3283064365386963e-10f;
+		}
+
+		// GGX distributed half vector around +Z for the ith of sampleCount Hammersley points
+		glm::vec3 ImportanceSampleGGX(glm::uint i, glm::uint sampleCount, float roughness)
+		{
+			const float a = roughness * roughness;
+			const float phi = 2.0f * PI * (float)i / (float)sampleCount;
+			const float xi = RadicalInverse(i);
+			const float cosTheta = std::sqrt((1.0f - xi) / (1.0f + (a * a - 1.0f) * xi));
+			const float sinTheta = std::sqrt(1.0f - cosTheta * cosTheta);
+			return glm::vec3(std::cos(phi) * sinTheta, std::sin(phi) * sinTheta, cosTheta);
+		}
+
+		// Matches prefilter.frag, sampling lower environment mips for less likely directions to avoid noise
+		void BakePrefilteredLevel(const FloatCubemap& environment, FloatCubemap& prefiltered, glm::uint level, float roughness)
+		{
+			const glm::uint size = prefiltered.GetLevelSize(level);
+
+			if (roughness == 0.0f)
+			{
+				// A perfect mirror, so this level is just the environment at this resolution
+				const float lod = std::log2((float)environment.size / (float)size);
+				ParallelFor(size * 6, MIN_ROWS_PER_THREAD, [&](glm::uint begin, glm::uint end)
+				{
+					for (glm::uint row = begin; row < end; ++row)
+					{
+						const glm::uint face = row / size;
+						const glm::uint y = row % size;
+						float* texels = prefiltered.GetFace(level, face) + (size_t)y * size * 4;
+						for (glm::uint x = 0; x < size; ++x)
+						{
+							float* texel = texels + x * 4;
+							memset(texel, 0, sizeof(float) * 4);
+							AccumulateCubemapSample(environment, GetTexelDirection(face, x, y, size), lod, 1.0f, texel);
+						}
+					}
+				});
+				return;
+			}
+
+			// With N = V = R every texel uses the same samples relative to its own direction, so they're only computed once
+			struct Sample
+			{
+				glm::vec3 direction; // Around +Z
+				float weight;
+				float lod;
+			};
+			std::vector<Sample> samples;
+			samples.reserve(PREFILTER_SAMPLE_COUNT);
+
+			const float a2 = roughness * roughness * roughness * roughness;
+			const float texelSolidAngle = 4.0f * PI / (6.0f * environment.size * environment.size);
+			float totalWeight = 0.0f;
+			for (glm::uint i = 0; i < PREFILTER_SAMPLE_COUNT; ++i)
+			{
+				const glm::vec3 H = ImportanceSampleGGX(i, PREFILTER_SAMPLE_COUNT, roughness);
+				const glm::vec3 L = 2.0f * H.z * H - glm::vec3(0.0f, 0.0f, 1.0f);
+				if (L.z <= 0.0f)
+				{
+					continue;
+				}
+
+				const float NdotH = H.z;
+				const float denominator = NdotH * NdotH * (a2 - 1.0f) + 1.0f;
+				const float D = a2 / (PI * denominator * denominator);
+				const float pdf = D * 0.25f + 0.0001f;
+				const float sampleSolidAngle = 1.0f / ((float)PREFILTER_SAMPLE_COUNT * pdf + 0.0001f);
+
+				Sample sample;
+				sample.direction = L;
+				sample.weight = L.z;
+				sample.lod = 0.5f * std::log2(sampleSolidAngle / texelSolidAngle);
+				samples.push_back(sample);
+				totalWeight += L.z;
+			}
+
+			for (Sample& sample : samples)
+			{
+				sample.weight /= totalWeight;
+			}
+
+			ParallelFor(size * 6, MIN_ROWS_PER_THREAD, [&](glm::uint begin, glm::uint end)
+			{
+				for (glm::uint row = begin; row < end; ++row)
+				{
+					const glm::uint face = row / size;
+					const glm::uint y = row % size;
+					float* texels = prefiltered.GetFace(level, face) + (size_t)y * size * 4;
+					for (glm::uint x = 0; x < size; ++x)
+					{
+						const glm::vec3 N = GetTexelDirection(face, x, y, size);
+						const glm::vec3 up = (std::abs(N.z) < 0.999f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(1.0f, 0.0f, 0.0f));
+						const glm::vec3 tangent = glm::normalize(glm::cross(up, N));
+						const glm::vec3 bitangent = glm::cross(N, tangent);
+
+						float* texel = texels + x * 4;
+						memset(texel, 0, sizeof(float) * 4);
+						for (const Sample& sample : samples)
+						{
+							const glm::vec3 L = tangent * sample.direction.x + bitangent * sample.direction.y + N * sample.direction.z;
+							AccumulateCubemapSample(environment, L, sample.lod, sample.weight, texel);
+						}
+						texel[3] = 1.0f;
+					}
+				}
+			});
+		}
+
+		void AppendAsHalfFloats(const std::vector<float>& values, std::vector<glm::uint16>& data)
+		{
+			const size_t offset = data.size();
+			data.resize(offset + values.size());
+			for (size_t i = 0; i < values.size(); ++i)
+			{
+				data[offset + i] = glm::packHalf1x16(std::min(values[i], MAX_HALF_FLOAT));
+			}
+		}
+
+		// FNV-1a over each 8 bytes at a time, identifies an HDR image by its contents rather than its path or modification time
+		// Reads the whole file, so go through BakedEnvironment::HashSource which only does so once per version of each file
+		bool HashFileContents(const std::string& filePath, glm::uint64& hash)
+		{
+			MappedFile file;
+			if (!file.Open(filePath))
+			{
+				return false;
+			}
+
+			const unsigned char* bytes = (const unsigned char*)file.GetData();
+			const size_t size = file.GetSize();
+			const glm::uint64 prime = 1099511628211ull;
+
+			hash = 14695981039346656037ull;
+			size_t i = 0;
+			for (; i + sizeof(glm::uint64) <= size; i += sizeof(glm::uint64))
+			{
+				glm::uint64 word;
+				memcpy(&word, bytes + i, sizeof(word));
+				hash = (hash ^ word) * prime;
+			}
+			for (; i < size; ++i)
+			{
+				hash = (hash ^ bytes[i]) * prime;
+			}
+			hash ^= (glm::uint64)size;
+
+			return true;
+		}
+
+		// Written to a temporary file first and then moved into place, as with cooked assets
+		bool WriteCacheFile(const std::string& filePath, const void* header, size_t headerSize, const std::vector<glm::uint16>& data)
+		{
+#ifdef _WIN32
+			_mkdir(IBL_CACHE_DIRECTORY.c_str());
+#else
+			mkdir(IBL_CACHE_DIRECTORY.c_str(), 0755);
+#endif
+
+			const std::string tempFilePath = filePath + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+			std::ofstream file(tempFilePath, std::ios::out | std::ios::binary | std::ios::trunc);
+			if (!file.is_open())
+			{
+				Logger::LogWarning("Failed to write IBL cache file " + filePath);
+				return false;
+			}
+
+			file.write((const char*)header, headerSize);
+			file.write((const char*)data.data(), data.size() * sizeof(glm::uint16));
+
+			const bool written = file.good();
+			file.close();
+
+			if (!written)
+			{
+				Logger::LogWarning("Failed to write IBL cache file " + filePath);
+				remove(tempFilePath.c_str());
+				return false;
+			}
+
+#ifdef _WIN32
+			const bool moved = (MoveFileExA(tempFilePath.c_str(), filePath.c_str(), MOVEFILE_REPLACE_EXISTING) != 0);
+#else
+			const bool moved = (rename(tempFilePath.c_str(), filePath.c_str()) == 0);
+#endif
+			if (!moved)
+			{
+				remove(tempFilePath.c_str());
+				return false;
+			}
+
+			return true;
+		}
+
+		// Prevents the same cache file from being baked by several jobs at once
+		std::mutex s_BakesInFlightMutex;
+		std::set<std::string> s_BakesInFlight;
+
+		struct SourceHashCacheEntry
+		{
+			glm::uint64 modifiedTime;
+			glm::uint64 size;
+			glm::uint64 hash;
+		};
+		std::mutex s_SourceHashCacheMutex;
+		std::map<std::string, SourceHashCacheEntry> s_SourceHashCache; // Key is file path
+
+		void BakeOnce(ThreadPool* threadPool, const std::string& bakeKey, const std::function<void()>& bake)
+		{
+			if (!threadPool)
+			{
+				return;
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(s_BakesInFlightMutex);
+				if (!s_BakesInFlight.insert(bakeKey).second)
+				{
+					return;
+				}
+			}
+
+			threadPool->Enqueue([bakeKey, bake]()
+			{
+				bake();
+
+				std::lock_guard<std::mutex> lock(s_BakesInFlightMutex);
+				s_BakesInFlight.erase(bakeKey);
+			});
+		}
+	} // namespace
+
+	void ProjectIrradianceSH9(const float* const faces[6], glm::uint size, IrradianceSH9& irradianceSH)
+	{
+		struct Sums
+		{
+			glm::vec3 coefficients[9];
+			float totalSolidAngle;
+		};
+
+		Sums total = {};
+		for (glm::vec3& coefficient : total.coefficients)
+		{
+			coefficient = glm::vec3(0.0f);
+		}
+		std::mutex totalMutex;
+
+		// Each range of rows is summed on its own then added to the total, so threads only contend once each
+		ParallelFor(size * 6, MIN_ROWS_PER_THREAD, [&](glm::uint begin, glm::uint end)
+		{
+			Sums sums = {};
+			for (glm::vec3& coefficient : sums.coefficients)
+			{
+				coefficient = glm::vec3(0.0f);
+			}
+
+			float basis[9];
+			for (glm::uint row = begin; row < end; ++row)
+			{
+				const glm::uint face = row / size;
+				const glm::uint y = row % size;
+				const float* texels = faces[face] + (size_t)y * size * 4;
+				for (glm::uint x = 0; x < size; ++x)
+				{
+					const float s = ((float)x + 0.5f) / (float)size * 2.0f - 1.0f;
+					const float t = ((float)y + 0.5f) / (float)size * 2.0f - 1.0f;
+					const float solidAngle = 1.0f / std::pow(1.0f + s * s + t * t, 1.5f);
+
+					const float* texel = texels + x * 4;
+					const glm::vec3 radiance(texel[0], texel[1], texel[2]);
+
+					EvaluateSH9Basis(GetTexelDirection(face, x, y, size), basis);
+					for (glm::uint i = 0; i < 9; ++i)
+					{
+						sums.coefficients[i] += radiance * (basis[i] * solidAngle);
+					}
+					sums.totalSolidAngle += solidAngle;
+				}
+			}
+
+			std::lock_guard<std::mutex> lock(totalMutex);
+			for (glm::uint i = 0; i < 9; ++i)
+			{
+				total.coefficients[i] += sums.coefficients[i];
+			}
+			total.totalSolidAngle += sums.totalSolidAngle;
+		});
+
+		// Convolution with the clamped cosine lobe, divided by PI: 1, 2/3 & 1/4 per band
+		const float bandScales[9] = { 1.0f, 2.0f / 3.0f, 2.0f / 3.0f, 2.0f / 3.0f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f };
+		const float normalization = 4.0f * PI / total.totalSolidAngle;
+		for (glm::uint i = 0; i < 9; ++i)
+		{
+			irradianceSH.coefficients[i] = total.coefficients[i] * (normalization * bandScales[i]);
+		}
+	}
+
+	glm::vec3 EvaluateIrradianceSH9(const IrradianceSH9& irradianceSH, const glm::vec3& normal)
+	{
+		float basis[9];
+		EvaluateSH9Basis(normal, basis);
+
+		glm::vec3 result(0.0f);
+		for (glm::uint i = 0; i < 9; ++i)
+		{
+			result += irradianceSH.coefficients[i] * basis[i];
+		}
+
+		// Nine coefficients can't represent very bright, small lights without ringing below zero on the far side
+		return glm::max(result, glm::vec3(0.0f));
+	}
+
+	const glm::uint BakedEnvironment::MAGIC = 0x4C424946; // "FIBL" in little-endian
+	const glm::uint BakedEnvironment::VERSION = 2; // Increment whenever cache files' contents change
+
+	BakedEnvironment::BakedEnvironment()
+	{
+	}
+
+	BakedEnvironment::~BakedEnvironment()
+	{
+		Unload();
+	}
+
+	bool BakedEnvironment::HashSource(const std::string& hdrFilePath, glm::uint64& outSourceHash)
+	{
+		struct stat fileStat;
+		if (stat(hdrFilePath.c_str(), &fileStat) != 0)
+		{
+			return false;
+		}
+		const glm::uint64 modifiedTime = (glm::uint64)fileStat.st_mtime;
+		const glm::uint64 size = (glm::uint64)fileStat.st_size;
+
+		{
+			std::lock_guard<std::mutex> lock(s_SourceHashCacheMutex);
+			auto iter = s_SourceHashCache.find(hdrFilePath);
+			if (iter != s_SourceHashCache.end() && iter->second.modifiedTime == modifiedTime && iter->second.size == size)
+			{
+				outSourceHash = iter->second.hash;
+				return true;
+			}
+		}
+
+		// Hashed without holding the lock, two threads may both hash a new file but they'll agree on the result
+		glm::uint64 hash;
+		if (!HashFileContents(hdrFilePath, hash))
+		{
+			return false;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(s_SourceHashCacheMutex);
+			s_SourceHashCache[hdrFilePath] = { modifiedTime, size, hash };
+		}
+
+		outSourceHash = hash;
+		return true;
+	}
+
+	bool BakedEnvironment::Bake(const std::string& hdrFilePath, glm::uint64 sourceHash, const IBLBakeSettings& settings)
+	{
+		HDRImage image = {};
+		if (!image.Load(hdrFilePath, false))
+		{
+			return false;
+		}
+
+		std::string fileName = hdrFilePath;
+		StripLeadingDirectories(fileName);
+		Logger::LogInfo("Baking image based lighting maps for " + fileName);
+
+		// Environment cubemap, sampled from the equirectangular image as equirectangular_to_cube.frag does
+		FloatCubemap environment(settings.cubemapSize, CalculateMipCount(settings.cubemapSize, settings.cubemapSize));
+		const glm::uint cubemapSize = settings.cubemapSize;
+		ParallelFor(cubemapSize * 6, MIN_ROWS_PER_THREAD, [&](glm::uint begin, glm::uint end)
+		{
+			for (glm::uint row = begin; row < end; ++row)
+			{
+				const glm::uint face = row / cubemapSize;
+				const glm::uint y = row % cubemapSize;
+				float* texels = environment.GetFace(0, face) + (size_t)y * cubemapSize * 4;
+				for (glm::uint x = 0; x < cubemapSize; ++x)
+				{
+					const glm::vec3 direction = GetTexelDirection(face, x, y, cubemapSize);
+					const float u = std::atan2(direction.z, direction.x) / (2.0f * PI) + 0.5f;
+					const float v = 0.5f - std::asin(glm::clamp(direction.y, -1.0f, 1.0f)) / PI; // Image rows go from top to bottom
+
+					float* texel = texels + x * 4;
+					memset(texel, 0, sizeof(float) * 4);
+					AccumulateBilinear(image.pixels, (glm::uint)image.width, (glm::uint)image.height, u * image.width, v * image.height, true, 1.0f, texel);
+					texel[3] = 1.0f;
+				}
+			}
+		});
+		image.Free();
+		GenerateCubemapMips(environment);
+
+		FloatCubemap irradiance(settings.irradianceSize, CalculateMipCount(settings.irradianceSize, settings.irradianceSize));
+		IrradianceSH9 irradianceSH;
+		BakeIrradiance(environment, irradiance, irradianceSH);
+		GenerateCubemapMips(irradiance);
+
+		const glm::uint prefilteredMipCount = glm::clamp(settings.prefilteredMipCount, 1u, CalculateMipCount(settings.prefilteredSize, settings.prefilteredSize));
+		FloatCubemap prefiltered(settings.prefilteredSize, prefilteredMipCount);
+		for (glm::uint level = 0; level < prefilteredMipCount; ++level)
+		{
+			const float roughness = (prefilteredMipCount > 1 ? (float)level / (float)(prefilteredMipCount - 1) : 0.0f);
+			BakePrefilteredLevel(environment, prefiltered, level, roughness);
+		}
+
+		std::vector<glm::uint16> data;
+		for (const FloatCubemap* cubemap : { &environment, &irradiance, &prefiltered })
+		{
+			for (const std::vector<float>& level : cubemap->levels)
+			{
+				AppendAsHalfFloats(level, data);
+			}
+		}
+
+		Header header = {};
+		header.magic = MAGIC;
+		header.version = VERSION;
+		header.sourceHash = sourceHash;
+		header.cubemapSize = settings.cubemapSize;
+		header.irradianceSize = settings.irradianceSize;
+		header.prefilteredSize = settings.prefilteredSize;
+		header.prefilteredMipCount = prefilteredMipCount;
+		for (glm::uint i = 0; i < 9; ++i)
+		{
+			header.irradianceSH[i * 3 + 0] = irradianceSH.coefficients[i].x;
+			header.irradianceSH[i * 3 + 1] = irradianceSH.coefficients[i].y;
+			header.irradianceSH[i * 3 + 2] = irradianceSH.coefficients[i].z;
+		}
+
+		return WriteCacheFile(GetCacheFilePath(hdrFilePath, sourceHash, settings), &header, sizeof(header), data);
+	}
+
+	void BakedEnvironment::BakeAsync(ThreadPool* threadPool, const std::string& hdrFilePath, glm::uint64 sourceHash, const IBLBakeSettings& settings)
+	{
+		const std::string bakeKey = hdrFilePath + "_" + std::to_string(settings.cubemapSize) + "_" + std::to_string(settings.irradianceSize) + "_" +
+			std::to_string(settings.prefilteredSize) + "_" + std::to_string(settings.prefilteredMipCount);
+
+		BakeOnce(threadPool, bakeKey, [hdrFilePath, sourceHash, settings]()
+		{
+			BakedEnvironment existing;
+			if (!existing.Load(hdrFilePath, sourceHash, settings))
+			{
+				Bake(hdrFilePath, sourceHash, settings);
+			}
+		});
+	}
+
+	bool BakedEnvironment::Load(const std::string& hdrFilePath, glm::uint64 sourceHash, const IBLBakeSettings& settings)
+	{
+		Unload();
+
+		if (!m_File.Open(GetCacheFilePath(hdrFilePath, sourceHash, settings)))
+		{
+			return false;
+		}
+
+		const Header* header = (const Header*)m_File.GetData();
+		const glm::uint prefilteredMipCount = glm::clamp(settings.prefilteredMipCount, 1u, CalculateMipCount(settings.prefilteredSize, settings.prefilteredSize));
+
+		bool valid =
+			m_File.GetSize() >= sizeof(Header) &&
+			header->magic == MAGIC &&
+			header->version == VERSION &&
+			header->sourceHash == sourceHash &&
+			header->cubemapSize == settings.cubemapSize &&
+			header->irradianceSize == settings.irradianceSize &&
+			header->prefilteredSize == settings.prefilteredSize &&
+			header->prefilteredMipCount == prefilteredMipCount;
+
+		if (valid)
+		{
+			m_Header = header;
+			valid = (m_File.GetSize() == GetMapOffset(Map::NONE));
+		}
+
+		if (!valid)
+		{
+			m_Header = nullptr;
+			m_File.Close();
+			return false;
+		}
+
+		return true;
+	}
+
+	void BakedEnvironment::Unload()
+	{
+		m_File.Close();
+		m_Header = nullptr;
+	}
+
+	bool BakedEnvironment::IsLoaded() const
+	{
+		return m_Header != nullptr;
+	}
+
+	glm::uint BakedEnvironment::GetMipCount(Map map) const
+	{
+		switch (map)
+		{
+		case Map::CUBEMAP: return CalculateMipCount(m_Header->cubemapSize, m_Header->cubemapSize);
+		case Map::IRRADIANCE: return CalculateMipCount(m_Header->irradianceSize, m_Header->irradianceSize);
+		case Map::PREFILTERED: return m_Header->prefilteredMipCount;
+		default: return 0;
+		}
+	}
+
+	glm::uint BakedEnvironment::GetMipSize(Map map, glm::uint mipLevel) const
+	{
+		switch (map)
+		{
+		case Map::CUBEMAP: return std::max(m_Header->cubemapSize >> mipLevel, 1u);
+		case Map::IRRADIANCE: return std::max(m_Header->irradianceSize >> mipLevel, 1u);
+		case Map::PREFILTERED: return std::max(m_Header->prefilteredSize >> mipLevel, 1u);
+		default: return 0;
+		}
+	}
+
+	void BakedEnvironment::GetIrradianceSH(IrradianceSH9& irradianceSH) const
+	{
+		for (glm::uint i = 0; i < 9; ++i)
+		{
+			irradianceSH.coefficients[i] = glm::vec3(m_Header->irradianceSH[i * 3 + 0], m_Header->irradianceSH[i * 3 + 1], m_Header->irradianceSH[i * 3 + 2]);
+		}
+	}
+
+	const void* BakedEnvironment::GetFaceData(Map map, glm::uint mipLevel, glm::uint face) const
+	{
+		size_t offset = GetMapOffset(map);
+		for (glm::uint i = 0; i < mipLevel; ++i)
+		{
+			offset += GetFaceDataSize(map, i) * 6;
+		}
+		offset += GetFaceDataSize(map, mipLevel) * face;
+
+		return (const char*)m_File.GetData() + offset;
+	}
+
+	size_t BakedEnvironment::GetFaceDataSize(Map map, glm::uint mipLevel) const
+	{
+		const size_t size = GetMipSize(map, mipLevel);
+		return size * size * 4 * sizeof(glm::uint16);
+	}
+
+	std::string BakedEnvironment::GetCacheFilePath(const std::string& hdrFilePath, glm::uint64 sourceHash, const IBLBakeSettings& settings)
+	{
+		std::string fileName = hdrFilePath;
+		StripLeadingDirectories(fileName);
+
+		char suffix[96];
+		snprintf(suffix, sizeof(suffix), "_%016llx_%u_%u_%ux%u.ibl", (unsigned long long)sourceHash,
+			settings.cubemapSize, settings.irradianceSize, settings.prefilteredSize, settings.prefilteredMipCount);
+
+		return IBL_CACHE_DIRECTORY + fileName + suffix;
+	}
+
+	size_t BakedEnvironment::GetMapOffset(Map map) const
+	{
+		size_t offset = sizeof(Header);
+		for (glm::uint i = 0; i < (glm::uint)map; ++i)
+		{
+			offset += GetMapSize((Map)i);
+		}
+		return offset;
+	}
+
+	size_t BakedEnvironment::GetMapSize(Map map) const
+	{
+		size_t size = 0;
+		const glm::uint mipCount = GetMipCount(map);
+		for (glm::uint i = 0; i < mipCount; ++i)
+		{
+			size += GetFaceDataSize(map, i) * 6;
+		}
+		return size;
+	}
+
+	const glm::uint BakedBRDFLUT::MAGIC = 0x44524246; // "FBRD" in little-endian
+	const glm::uint BakedBRDFLUT::VERSION = 1;
+
+	BakedBRDFLUT::BakedBRDFLUT()
+	{
+	}
+
+	BakedBRDFLUT::~BakedBRDFLUT()
+	{
+		Unload();
+	}
+
+	bool BakedBRDFLUT::Bake(const glm::uvec2& size)
+	{
+		Logger::LogInfo("Baking BRDF LUT");
+
+		std::vector<float> texels((size_t)size.x * size.y * 2);
+
+		ParallelFor(size.y, MIN_ROWS_PER_THREAD, [&](glm::uint begin, glm::uint end)
+		{
+			for (glm::uint y = begin; y < end; ++y)
+			{
+				const float roughness = ((float)y + 0.5f) / (float)size.y;
+				const float k = roughness * roughness * 0.5f;
+
+				for (glm::uint x = 0; x < size.x; ++x)
+				{
+					const float NdotV = ((float)x + 0.5f) / (float)size.x;
+					const glm::vec3 V(std::sqrt(1.0f - NdotV * NdotV), 0.0f, NdotV);
+					const float GV = NdotV / (NdotV * (1.0f - k) + k);
+
+					float scale = 0.0f;
+					float bias = 0.0f;
+					for (glm::uint i = 0; i < BRDF_SAMPLE_COUNT; ++i)
+					{
+						const glm::vec3 H = ImportanceSampleGGX(i, BRDF_SAMPLE_COUNT, roughness);
+						const float VdotH = glm::dot(V, H);
+						const glm::vec3 L = 2.0f * VdotH * H - V;
+
+						const float NdotL = L.z;
+						if (NdotL > 0.0f)
+						{
+							const float NdotH = std::max(H.z, 0.0f);
+							const float G = GV * (NdotL / (NdotL * (1.0f - k) + k));
+							const float GVis = (G * std::max(VdotH, 0.0f)) / (NdotH * NdotV);
+							const float Fc = std::pow(1.0f - std::max(VdotH, 0.0f), 5.0f);
+
+							scale += (1.0f - Fc) * GVis;
+							bias += Fc * GVis;
+						}
+					}
+
+					float* texel = &texels[((size_t)y * size.x + x) * 2];
+					texel[0] = scale / (float)BRDF_SAMPLE_COUNT;
+					texel[1] = bias / (float)BRDF_SAMPLE_COUNT;
+				}
+			}
+		});
+
+		std::vector<glm::uint16> data;
+		AppendAsHalfFloats(texels, data);
+
+		Header header = {};
+		header.magic = MAGIC;
+		header.version = VERSION;
+		header.width = size.x;
+		header.height = size.y;
+
+		return WriteCacheFile(GetCacheFilePath(size), &header, sizeof(header), data);
+	}
+
+	void BakedBRDFLUT::BakeAsync(ThreadPool* threadPool, const glm::uvec2& size)
+	{
+		BakeOnce(threadPool, GetCacheFilePath(size), [size]()
+		{
+			BakedBRDFLUT existing;
+			if (!existing.Load(size))
+			{
+				Bake(size);
+			}
+		});
+	}
+
+	bool BakedBRDFLUT::Load(const glm::uvec2& size)
+	{
+		Unload();
+
+		if (!m_File.Open(GetCacheFilePath(size)))
+		{
+			return false;
+		}
+
+		const Header* header = (const Header*)m_File.GetData();
+		const bool valid =
+			m_File.GetSize() == sizeof(Header) + (size_t)size.x * size.y * 2 * sizeof(glm::uint16) &&
+			header->magic == MAGIC &&
+			header->version == VERSION &&
+			header->width == size.x &&
+			header->height == size.y;
+
+		if (!valid)
+		{
+			m_File.Close();
+			return false;
+		}
+
+		m_Header = header;
+		return true;
+	}
+
+	void BakedBRDFLUT::Unload()
+	{
+		m_File.Close();
+		m_Header = nullptr;
+	}
+
+	bool BakedBRDFLUT::IsLoaded() const
+	{
+		return m_Header != nullptr;
+	}
+
+	const void* BakedBRDFLUT::GetData() const
+	{
+		return (const char*)m_File.GetData() + sizeof(Header);
+	}
+
+	std::string BakedBRDFLUT::GetCacheFilePath(const glm::uvec2& size)
+	{
+		return IBL_CACHE_DIRECTORY + "brdf_lut_" + std::to_string(size.x) + "x" + std::to_string(size.y) + ".ibl";
+	}
+} // namespace flex
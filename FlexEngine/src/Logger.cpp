@@ -14,6 +14,8 @@ namespace flex
 	int Logger::m_SuppressedWarningCount = 0;
 	int Logger::m_SuppressedErrorCount = 0;
 
+	std::mutex Logger::m_Mutex;
+
 #ifdef _WIN32
 	HANDLE Logger::m_ConsoleHandle;
 #endif
@@ -27,6 +29,8 @@ namespace flex
 
 	void Logger::Log(const std::string& message, LogLevel logLevel, bool newline)
 	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
 		switch (logLevel)
 		{
 		case Logger::LogLevel::LOG_INFO:
@@ -80,6 +84,8 @@ namespace flex
 
 	void Logger::Log(const std::wstring& message, LogLevel logLevel, bool newline)
 	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
 		switch (logLevel)
 		{
 		case Logger::LogLevel::LOG_INFO:
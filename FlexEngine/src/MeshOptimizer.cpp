@@ -0,0 +1,912 @@
+#include "stdafx.hpp"
+
+#include "MeshOptimizer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+#include <glm/common.hpp>
+#include <glm/exponential.hpp>
+#include <glm/geometric.hpp>
+#include <glm/vec3.hpp>
+
+namespace flex
+{
+	// Forsyth scoring parameters (see https://tomforsyth1000.github.io/papers/fast_vert_cache_opt.html)
+	static const glm::uint FORSYTH_CACHE_SIZE = 32;
+	static const float FORSYTH_CACHE_DECAY_POWER = 1.5f;
+	static const float FORSYTH_LAST_TRIANGLE_SCORE = 0.75f;
+	static const float FORSYTH_VALENCE_BOOST_SCALE = 2.0f;
+	static const float FORSYTH_VALENCE_BOOST_POWER = 0.5f;
+
+	static float CalculateForsythVertexScore(int cachePosition, glm::uint remainingTriangleCount)
+	{
+		if (remainingTriangleCount == 0)
+		{
+			// Vertex isn't used by any more triangles
+			return -1.0f;
+		}
+
+		float score = 0.0f;
+		if (cachePosition >= 0)
+		{
+			if (cachePosition < 3)
+			{
+				// Vertices used by the last triangle get a fixed score so that the next triangle doesn't
+				// depend on the order the previous triangle's vertices were submitted in
+				score = FORSYTH_LAST_TRIANGLE_SCORE;
+			}
+			else
+			{
+				const float scaler = 1.0f / (FORSYTH_CACHE_SIZE - 3);
+				score = std::pow(1.0f - (cachePosition - 3) * scaler, FORSYTH_CACHE_DECAY_POWER);
+			}
+		}
+
+		// Boost vertices with few remaining triangles to avoid leaving lone triangles behind
+		score += FORSYTH_VALENCE_BOOST_SCALE * std::pow((float)remainingTriangleCount, -FORSYTH_VALENCE_BOOST_POWER);
+
+		return score;
+	}
+
+	static const glm::vec3& GetPosition(const void* positions, glm::uint vertexStride, glm::uint index)
+	{
+		return *(const glm::vec3*)((const char*)positions + (size_t)index * vertexStride);
+	}
+
+	VertexCacheStatistics AnalyzeVertexCache(const std::vector<glm::uint>& indices, glm::uint vertexCount, glm::uint cacheSize)
+	{
+		VertexCacheStatistics statistics = {};
+
+		const size_t triangleCount = indices.size() / 3;
+		if (triangleCount == 0 || vertexCount == 0)
+		{
+			return statistics;
+		}
+
+		// A vertex is in the FIFO cache if fewer than cacheSize misses have occurred since it was last transformed
+		std::vector<glm::uint> cacheTimestamps(vertexCount, 0);
+		std::vector<bool> referenced(vertexCount, false);
+		glm::uint timestamp = cacheSize + 1;
+		glm::uint missCount = 0;
+		glm::uint referencedCount = 0;
+
+		for (glm::uint index : indices)
+		{
+			if (timestamp - cacheTimestamps[index] > cacheSize)
+			{
+				cacheTimestamps[index] = timestamp++;
+				++missCount;
+			}
+
+			if (!referenced[index])
+			{
+				referenced[index] = true;
+				++referencedCount;
+			}
+		}
+
+		statistics.ACMR = (float)missCount / (float)triangleCount;
+		statistics.ATVR = (float)missCount / (float)referencedCount;
+
+		return statistics;
+	}
+
+	void OptimizeVertexCache(std::vector<glm::uint>& indices, glm::uint vertexCount)
+	{
+		const size_t indexCount = indices.size();
+		const glm::uint triangleCount = (glm::uint)(indexCount / 3);
+		if (triangleCount == 0 || vertexCount == 0)
+		{
+			return;
+		}
+
+		// Build vertex -> triangle adjacency, stored contiguously per vertex
+		std::vector<glm::uint> remainingTriangleCounts(vertexCount, 0);
+		for (size_t i = 0; i < triangleCount * 3; ++i)
+		{
+			++remainingTriangleCounts[indices[i]];
+		}
+
+		std::vector<glm::uint> adjacencyOffsets(vertexCount);
+		glm::uint adjacencyOffset = 0;
+		for (glm::uint i = 0; i < vertexCount; ++i)
+		{
+			adjacencyOffsets[i] = adjacencyOffset;
+			adjacencyOffset += remainingTriangleCounts[i];
+		}
+
+		std::vector<glm::uint> adjacentTriangles(triangleCount * 3);
+		std::vector<glm::uint> adjacencyFill(vertexCount, 0);
+		for (glm::uint t = 0; t < triangleCount; ++t)
+		{
+			for (glm::uint k = 0; k < 3; ++k)
+			{
+				const glm::uint vertex = indices[t * 3 + k];
+				adjacentTriangles[adjacencyOffsets[vertex] + adjacencyFill[vertex]++] = t;
+			}
+		}
+
+		std::vector<float> vertexScores(vertexCount);
+		for (glm::uint i = 0; i < vertexCount; ++i)
+		{
+			vertexScores[i] = CalculateForsythVertexScore(-1, remainingTriangleCounts[i]);
+		}
+
+		std::vector<bool> triangleAdded(triangleCount, false);
+		int bestTriangle = -1;
+		float bestTriangleScore = -1.0f;
+		for (glm::uint t = 0; t < triangleCount; ++t)
+		{
+			const float score = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+			if (score > bestTriangleScore)
+			{
+				bestTriangleScore = score;
+				bestTriangle = (int)t;
+			}
+		}
+
+		std::vector<glm::uint> cache;
+		std::vector<glm::uint> newCache;
+		cache.reserve(FORSYTH_CACHE_SIZE + 3);
+		newCache.reserve(FORSYTH_CACHE_SIZE + 3);
+
+		std::vector<glm::uint> result;
+		result.reserve(triangleCount * 3);
+
+		glm::uint fallbackTriangle = 0;
+
+		for (glm::uint emittedCount = 0; emittedCount < triangleCount; ++emittedCount)
+		{
+			if (bestTriangle == -1)
+			{
+				// No triangle touches the cache, continue with the next unused triangle in input order
+				while (triangleAdded[fallbackTriangle]) ++fallbackTriangle;
+				bestTriangle = (int)fallbackTriangle;
+			}
+
+			const glm::uint triangle = (glm::uint)bestTriangle;
+			const glm::uint* triangleVertices = &indices[triangle * 3];
+			triangleAdded[triangle] = true;
+
+			newCache.clear();
+			for (glm::uint k = 0; k < 3; ++k)
+			{
+				const glm::uint vertex = triangleVertices[k];
+				result.push_back(vertex);
+
+				// Remove triangle from this vertex's remaining adjacency
+				glm::uint* vertexTriangles = &adjacentTriangles[adjacencyOffsets[vertex]];
+				const glm::uint remainingCount = remainingTriangleCounts[vertex];
+				for (glm::uint i = 0; i < remainingCount; ++i)
+				{
+					if (vertexTriangles[i] == triangle)
+					{
+						vertexTriangles[i] = vertexTriangles[remainingCount - 1];
+						break;
+					}
+				}
+				--remainingTriangleCounts[vertex];
+
+				if (std::find(newCache.begin(), newCache.end(), vertex) == newCache.end())
+				{
+					newCache.push_back(vertex);
+				}
+			}
+
+			// Move this triangle's vertices to the front of the LRU cache
+			for (glm::uint vertex : cache)
+			{
+				if (vertex != triangleVertices[0] && vertex != triangleVertices[1] && vertex != triangleVertices[2])
+				{
+					newCache.push_back(vertex);
+				}
+			}
+
+			for (size_t i = FORSYTH_CACHE_SIZE; i < newCache.size(); ++i)
+			{
+				const glm::uint evictedVertex = newCache[i];
+				vertexScores[evictedVertex] = CalculateForsythVertexScore(-1, remainingTriangleCounts[evictedVertex]);
+			}
+			if (newCache.size() > FORSYTH_CACHE_SIZE)
+			{
+				newCache.resize(FORSYTH_CACHE_SIZE);
+			}
+			cache.swap(newCache);
+
+			for (size_t i = 0; i < cache.size(); ++i)
+			{
+				const glm::uint vertex = cache[i];
+				vertexScores[vertex] = CalculateForsythVertexScore((int)i, remainingTriangleCounts[vertex]);
+			}
+
+			// Only triangles touching the cache changed score, so the next best triangle must be one of them
+			bestTriangle = -1;
+			bestTriangleScore = -1.0f;
+			for (glm::uint vertex : cache)
+			{
+				const glm::uint* vertexTriangles = &adjacentTriangles[adjacencyOffsets[vertex]];
+				for (glm::uint i = 0; i < remainingTriangleCounts[vertex]; ++i)
+				{
+					const glm::uint t = vertexTriangles[i];
+					const float score = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+
+					if (score > bestTriangleScore)
+					{
+						bestTriangleScore = score;
+						bestTriangle = (int)t;
+					}
+				}
+			}
+		}
+
+		// Any trailing indices which don't form a full triangle are left as is
+		for (size_t i = triangleCount * 3; i < indexCount; ++i)
+		{
+			result.push_back(indices[i]);
+		}
+
+		indices.swap(result);
+	}
+
+	void OptimizeOverdraw(std::vector<glm::uint>& indices, const void* positions, glm::uint vertexCount, glm::uint vertexStride)
+	{
+		const size_t triangleCount = indices.size() / 3;
+		if (triangleCount < 2 || vertexCount == 0 || !positions)
+		{
+			return;
+		}
+
+		// Split the (cache optimized) triangle list into clusters at "hard" boundaries, where
+		// every vertex of a triangle misses the cache. Reordering whole clusters then costs very little locality
+		const glm::uint cacheSize = 16;
+		std::vector<glm::uint> cacheTimestamps(vertexCount, 0);
+		glm::uint timestamp = cacheSize + 1;
+
+		std::vector<size_t> clusterStarts;
+		for (size_t t = 0; t < triangleCount; ++t)
+		{
+			glm::uint triangleMissCount = 0;
+			for (size_t k = 0; k < 3; ++k)
+			{
+				const glm::uint index = indices[t * 3 + k];
+				if (timestamp - cacheTimestamps[index] > cacheSize)
+				{
+					cacheTimestamps[index] = timestamp++;
+					++triangleMissCount;
+				}
+			}
+
+			if (t == 0 || triangleMissCount == 3)
+			{
+				clusterStarts.push_back(t);
+			}
+		}
+
+		if (clusterStarts.size() < 2)
+		{
+			return;
+		}
+
+		glm::vec3 meshCentroid(0.0f);
+		for (glm::uint i = 0; i < vertexCount; ++i)
+		{
+			meshCentroid += GetPosition(positions, vertexStride, i);
+		}
+		meshCentroid /= (float)vertexCount;
+
+		struct Cluster
+		{
+			size_t firstTriangle;
+			size_t triangleCount;
+			float sortKey;
+		};
+
+		std::vector<Cluster> clusters(clusterStarts.size());
+		for (size_t c = 0; c < clusterStarts.size(); ++c)
+		{
+			Cluster& cluster = clusters[c];
+			cluster.firstTriangle = clusterStarts[c];
+			cluster.triangleCount = (c + 1 < clusterStarts.size() ? clusterStarts[c + 1] : triangleCount) - cluster.firstTriangle;
+
+			// Area weighted centroid & normal
+			glm::vec3 centroid(0.0f);
+			glm::vec3 normal(0.0f);
+			float totalArea = 0.0f;
+			for (size_t t = cluster.firstTriangle; t < cluster.firstTriangle + cluster.triangleCount; ++t)
+			{
+				const glm::vec3& p0 = GetPosition(positions, vertexStride, indices[t * 3]);
+				const glm::vec3& p1 = GetPosition(positions, vertexStride, indices[t * 3 + 1]);
+				const glm::vec3& p2 = GetPosition(positions, vertexStride, indices[t * 3 + 2]);
+
+				const glm::vec3 areaNormal = glm::cross(p1 - p0, p2 - p0);
+				const float area = glm::length(areaNormal);
+
+				centroid += (p0 + p1 + p2) * (area / 3.0f);
+				normal += areaNormal;
+				totalArea += area;
+			}
+
+			if (totalArea > 0.0f) centroid /= totalArea;
+			const float normalLength = glm::length(normal);
+			if (normalLength > 0.0f) normal /= normalLength;
+
+			// Clusters far out from the center & facing away from it are most likely to occlude others, so draw those first
+			cluster.sortKey = glm::dot(centroid - meshCentroid, normal);
+		}
+
+		std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster& a, const Cluster& b)
+		{
+			return a.sortKey > b.sortKey;
+		});
+
+		std::vector<glm::uint> result;
+		result.reserve(indices.size());
+		for (const Cluster& cluster : clusters)
+		{
+			result.insert(result.end(),
+				indices.begin() + cluster.firstTriangle * 3,
+				indices.begin() + (cluster.firstTriangle + cluster.triangleCount) * 3);
+		}
+		result.insert(result.end(), indices.begin() + triangleCount * 3, indices.end());
+
+		indices.swap(result);
+	}
+
+	glm::uint OptimizeVertexFetch(std::vector<glm::uint>& indices, void* vertexData, glm::uint vertexCount, glm::uint vertexStride)
+	{
+		if (indices.empty() || vertexCount == 0 || !vertexData)
+		{
+			return vertexCount;
+		}
+
+		const glm::uint unusedVertex = (glm::uint)-1;
+		std::vector<glm::uint> remap(vertexCount, unusedVertex);
+		glm::uint newVertexCount = 0;
+
+		for (glm::uint& index : indices)
+		{
+			if (remap[index] == unusedVertex)
+			{
+				remap[index] = newVertexCount++;
+			}
+			index = remap[index];
+		}
+
+		const size_t bufferSize = (size_t)vertexCount * vertexStride;
+		std::vector<char> originalVertexData((const char*)vertexData, (const char*)vertexData + bufferSize);
+		for (glm::uint i = 0; i < vertexCount; ++i)
+		{
+			if (remap[i] != unusedVertex)
+			{
+				memcpy((char*)vertexData + (size_t)remap[i] * vertexStride, originalVertexData.data() + (size_t)i * vertexStride, vertexStride);
+			}
+		}
+
+		return newVertexCount;
+	}
+
+	// Symmetric 4x4 matrix of the sum of squared distances to a set of planes, weighted by triangle area
+	struct Quadric
+	{
+		double a2, ab, ac, ad;
+		double b2, bc, bd;
+		double c2, cd;
+		double d2;
+		double weight;
+	};
+
+	static void AddPlane(Quadric& q, const glm::vec3& normal, float distance, double weight)
+	{
+		const double a = normal.x;
+		const double b = normal.y;
+		const double c = normal.z;
+		const double d = distance;
+
+		q.a2 += a * a * weight; q.ab += a * b * weight; q.ac += a * c * weight; q.ad += a * d * weight;
+		q.b2 += b * b * weight; q.bc += b * c * weight; q.bd += b * d * weight;
+		q.c2 += c * c * weight; q.cd += c * d * weight;
+		q.d2 += d * d * weight;
+		q.weight += weight;
+	}
+
+	static void AddQuadric(Quadric& q, const Quadric& other)
+	{
+		q.a2 += other.a2; q.ab += other.ab; q.ac += other.ac; q.ad += other.ad;
+		q.b2 += other.b2; q.bc += other.bc; q.bd += other.bd;
+		q.c2 += other.c2; q.cd += other.cd;
+		q.d2 += other.d2;
+		q.weight += other.weight;
+	}
+
+	// Returns the weighted sum of squared distances from p to every plane in q
+	static double EvaluateQuadric(const Quadric& q, const glm::vec3& p)
+	{
+		const double x = p.x;
+		const double y = p.y;
+		const double z = p.z;
+
+		return
+			q.a2 * x * x + 2.0 * q.ab * x * y + 2.0 * q.ac * x * z + 2.0 * q.ad * x +
+			q.b2 * y * y + 2.0 * q.bc * y * z + 2.0 * q.bd * y +
+			q.c2 * z * z + 2.0 * q.cd * z +
+			q.d2;
+	}
+
+	// Root mean squared distance from position to the planes around both vertices of a collapse
+	static float CalculateCollapseError(const Quadric& from, const Quadric& to, const glm::vec3& position)
+	{
+		Quadric combined = from;
+		AddQuadric(combined, to);
+
+		if (combined.weight <= 0.0)
+		{
+			return 0.0f;
+		}
+
+		const double error = std::max(EvaluateQuadric(combined, position), 0.0) / combined.weight;
+		return (float)std::sqrt(error);
+	}
+
+	static glm::uint64 MakeEdgeKey(glm::uint a, glm::uint b)
+	{
+		return a < b ? (((glm::uint64)a << 32) | b) : (((glm::uint64)b << 32) | a);
+	}
+
+	float SimplifyMesh(const std::vector<glm::uint>& indices, const void* positions, glm::uint vertexCount, glm::uint vertexStride,
+		size_t targetIndexCount, float maxError, std::vector<glm::uint>& result)
+	{
+		result = indices;
+
+		if (result.size() <= targetIndexCount || vertexCount == 0)
+		{
+			return 0.0f;
+		}
+
+		// Vertices which can never be the source of a collapse
+		std::vector<bool> locked(vertexCount, false);
+
+		// Attribute seams: several vertices at the same position with differing normals/UVs would tear apart if moved independently
+		{
+			std::vector<glm::uint> sortedVertices(vertexCount);
+			for (glm::uint i = 0; i < vertexCount; ++i)
+			{
+				sortedVertices[i] = i;
+			}
+
+			auto PositionLess = [&](glm::uint a, glm::uint b)
+			{
+				const glm::vec3& pa = GetPosition(positions, vertexStride, a);
+				const glm::vec3& pb = GetPosition(positions, vertexStride, b);
+				if (pa.x != pb.x) return pa.x < pb.x;
+				if (pa.y != pb.y) return pa.y < pb.y;
+				return pa.z < pb.z;
+			};
+			std::sort(sortedVertices.begin(), sortedVertices.end(), PositionLess);
+
+			for (glm::uint i = 1; i < vertexCount; ++i)
+			{
+				if (!PositionLess(sortedVertices[i - 1], sortedVertices[i]))
+				{
+					locked[sortedVertices[i - 1]] = true;
+					locked[sortedVertices[i]] = true;
+				}
+			}
+		}
+
+		// Borders & non-manifold edges: any edge not shared by exactly two triangles
+		{
+			std::unordered_map<glm::uint64, glm::uint> edgeUseCounts;
+			edgeUseCounts.reserve(result.size());
+			for (size_t i = 0; i < result.size(); i += 3)
+			{
+				for (glm::uint e = 0; e < 3; ++e)
+				{
+					++edgeUseCounts[MakeEdgeKey(result[i + e], result[i + (e + 1) % 3])];
+				}
+			}
+
+			for (const auto& edgeUseCount : edgeUseCounts)
+			{
+				if (edgeUseCount.second != 2)
+				{
+					locked[(glm::uint)(edgeUseCount.first >> 32)] = true;
+					locked[(glm::uint)(edgeUseCount.first & 0xFFFFFFFF)] = true;
+				}
+			}
+		}
+
+		std::vector<Quadric> quadrics(vertexCount, Quadric{});
+		for (size_t i = 0; i < result.size(); i += 3)
+		{
+			const glm::vec3& p0 = GetPosition(positions, vertexStride, result[i + 0]);
+			const glm::vec3& p1 = GetPosition(positions, vertexStride, result[i + 1]);
+			const glm::vec3& p2 = GetPosition(positions, vertexStride, result[i + 2]);
+
+			glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+			const float doubleArea = glm::length(normal);
+			if (doubleArea <= 0.0f)
+			{
+				continue;
+			}
+			normal /= doubleArea;
+
+			const float distance = -glm::dot(normal, p0);
+			for (glm::uint v = 0; v < 3; ++v)
+			{
+				AddPlane(quadrics[result[i + v]], normal, distance, doubleArea * 0.5);
+			}
+		}
+
+		struct Collapse
+		{
+			glm::uint from;
+			glm::uint to;
+			float error;
+		};
+
+		std::vector<glm::uint> triangleOffsets;
+		std::vector<glm::uint> adjacentTriangles;
+		std::vector<Collapse> collapses;
+		std::vector<bool> touched;
+		float largestError = 0.0f;
+
+		// Each pass collapses the cheapest edges whose neighbourhoods don't overlap, so every cost
+		// and flip test in a pass is made against unmodified triangles
+		while (result.size() > targetIndexCount)
+		{
+			const glm::uint triangleCount = (glm::uint)(result.size() / 3);
+
+			// Vertex -> triangle adjacency
+			triangleOffsets.assign(vertexCount + 1, 0);
+			for (glm::uint index : result)
+			{
+				++triangleOffsets[index + 1];
+			}
+			for (glm::uint i = 0; i < vertexCount; ++i)
+			{
+				triangleOffsets[i + 1] += triangleOffsets[i];
+			}
+			adjacentTriangles.resize(result.size());
+			std::vector<glm::uint> fillCounts(vertexCount, 0);
+			for (glm::uint t = 0; t < triangleCount; ++t)
+			{
+				for (glm::uint v = 0; v < 3; ++v)
+				{
+					const glm::uint index = result[t * 3 + v];
+					adjacentTriangles[triangleOffsets[index] + fillCounts[index]++] = t;
+				}
+			}
+
+			collapses.clear();
+			for (glm::uint t = 0; t < triangleCount; ++t)
+			{
+				for (glm::uint e = 0; e < 3; ++e)
+				{
+					const glm::uint a = result[t * 3 + e];
+					const glm::uint b = result[t * 3 + (e + 1) % 3];
+
+					// Interior edges are seen from both of their triangles, only consider each direction once
+					if (!locked[a])
+					{
+						collapses.push_back({ a, b, CalculateCollapseError(quadrics[a], quadrics[b], GetPosition(positions, vertexStride, b)) });
+					}
+				}
+			}
+
+			std::sort(collapses.begin(), collapses.end(), [](const Collapse& lhs, const Collapse& rhs) { return lhs.error < rhs.error; });
+
+			touched.assign(vertexCount, false);
+			const size_t trianglesToRemove = (result.size() - targetIndexCount + 2) / 3;
+			size_t removedTriangleCount = 0;
+			glm::uint collapseCount = 0;
+
+			for (const Collapse& collapse : collapses)
+			{
+				if (collapse.error > maxError || removedTriangleCount >= trianglesToRemove)
+				{
+					break;
+				}
+
+				if (touched[collapse.from] || touched[collapse.to])
+				{
+					continue;
+				}
+
+				const glm::vec3& target = GetPosition(positions, vertexStride, collapse.to);
+
+				// Reject collapses which would flip any surviving triangle
+				bool flips = false;
+				glm::uint collapsedTriangles = 0;
+				for (glm::uint a = triangleOffsets[collapse.from]; a < triangleOffsets[collapse.from + 1] && !flips; ++a)
+				{
+					const glm::uint* triangle = &result[adjacentTriangles[a] * 3];
+					if (triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to)
+					{
+						++collapsedTriangles;
+						continue;
+					}
+
+					glm::vec3 before[3];
+					glm::vec3 after[3];
+					for (glm::uint v = 0; v < 3; ++v)
+					{
+						before[v] = GetPosition(positions, vertexStride, triangle[v]);
+						after[v] = (triangle[v] == collapse.from) ? target : before[v];
+					}
+
+					const glm::vec3 normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+					const glm::vec3 normalAfter = glm::cross(after[1] - after[0], after[2] - after[0]);
+					flips = (glm::dot(normalBefore, normalAfter) <= 0.0f);
+				}
+
+				if (flips)
+				{
+					continue;
+				}
+
+				for (glm::uint a = triangleOffsets[collapse.from]; a < triangleOffsets[collapse.from + 1]; ++a)
+				{
+					glm::uint* triangle = &result[adjacentTriangles[a] * 3];
+					for (glm::uint v = 0; v < 3; ++v)
+					{
+						touched[triangle[v]] = true;
+						if (triangle[v] == collapse.from)
+						{
+							triangle[v] = collapse.to;
+						}
+					}
+				}
+
+				AddQuadric(quadrics[collapse.to], quadrics[collapse.from]);
+				largestError = std::max(largestError, collapse.error);
+				removedTriangleCount += collapsedTriangles;
+				++collapseCount;
+			}
+
+			if (collapseCount == 0)
+			{
+				break;
+			}
+
+			// Remove triangles which have become degenerate
+			size_t writeIndex = 0;
+			for (size_t i = 0; i < result.size(); i += 3)
+			{
+				const glm::uint i0 = result[i + 0];
+				const glm::uint i1 = result[i + 1];
+				const glm::uint i2 = result[i + 2];
+				if (i0 != i1 && i1 != i2 && i0 != i2)
+				{
+					result[writeIndex++] = i0;
+					result[writeIndex++] = i1;
+					result[writeIndex++] = i2;
+				}
+			}
+			result.resize(writeIndex);
+		}
+
+		return largestError;
+	}
+
+	static void CalculateMeshletBounds(const std::vector<glm::uint>& indices, const void* positions, glm::uint vertexStride, Meshlet& meshlet)
+	{
+		const glm::uint* meshletIndices = &indices[meshlet.firstIndex];
+		const glm::uint triangleCount = meshlet.indexCount / 3;
+
+		glm::vec3 boundsMin = GetPosition(positions, vertexStride, meshletIndices[0]);
+		glm::vec3 boundsMax = boundsMin;
+		for (glm::uint i = 1; i < meshlet.indexCount; ++i)
+		{
+			const glm::vec3& p = GetPosition(positions, vertexStride, meshletIndices[i]);
+			boundsMin = glm::min(boundsMin, p);
+			boundsMax = glm::max(boundsMax, p);
+		}
+
+		meshlet.center = (boundsMin + boundsMax) * 0.5f;
+		meshlet.radius = 0.0f;
+		for (glm::uint i = 0; i < meshlet.indexCount; ++i)
+		{
+			meshlet.radius = glm::max(meshlet.radius, glm::length(GetPosition(positions, vertexStride, meshletIndices[i]) - meshlet.center));
+		}
+
+		// Normal cone (see Shirman & Abi-Ezzi - "The Cone of Normals Technique for Fast Processing of Curved Patches")
+		std::vector<glm::vec3> normals;
+		normals.reserve(triangleCount);
+		glm::vec3 axis(0.0f);
+		for (glm::uint t = 0; t < triangleCount; ++t)
+		{
+			const glm::vec3& p0 = GetPosition(positions, vertexStride, meshletIndices[t * 3 + 0]);
+			const glm::vec3& p1 = GetPosition(positions, vertexStride, meshletIndices[t * 3 + 1]);
+			const glm::vec3& p2 = GetPosition(positions, vertexStride, meshletIndices[t * 3 + 2]);
+
+			const glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+			const float length = glm::length(normal);
+			normals.push_back(length > 0.0f ? normal / length : glm::vec3(0.0f));
+			axis += normals.back();
+		}
+
+		meshlet.coneApex = meshlet.center;
+		meshlet.coneAxis = glm::vec3(0.0f);
+		meshlet.coneCutoff = 1.0f;
+
+		const float axisLength = glm::length(axis);
+		if (axisLength <= 0.0f)
+		{
+			return;
+		}
+		axis /= axisLength;
+
+		float minDot = 1.0f;
+		for (const glm::vec3& normal : normals)
+		{
+			minDot = glm::min(minDot, glm::dot(normal, axis));
+		}
+
+		// Normals spread over (nearly) a hemisphere or more can't be culled, and would push the apex off to infinity
+		static const float MIN_CONE_DOT = 0.1f;
+		if (minDot <= MIN_CONE_DOT)
+		{
+			return;
+		}
+
+		// Move the apex back along the axis until every triangle's plane is in front of it
+		float maxT = 0.0f;
+		for (glm::uint t = 0; t < triangleCount; ++t)
+		{
+			const glm::vec3& p0 = GetPosition(positions, vertexStride, meshletIndices[t * 3 + 0]);
+			const float normalDotAxis = glm::dot(normals[t], axis);
+			if (normalDotAxis > 0.0f)
+			{
+				maxT = glm::max(maxT, glm::dot(meshlet.center - p0, normals[t]) / normalDotAxis);
+			}
+		}
+
+		meshlet.coneApex = meshlet.center - axis * maxT;
+		meshlet.coneAxis = axis;
+		meshlet.coneCutoff = glm::sqrt(1.0f - minDot * minDot);
+	}
+
+	void BuildMeshlets(std::vector<glm::uint>& indices, const void* positions, glm::uint vertexCount, glm::uint vertexStride,
+		std::vector<Meshlet>& meshlets, glm::uint maxVertices, glm::uint maxTriangles)
+	{
+		meshlets.clear();
+
+		const glm::uint triangleCount = (glm::uint)(indices.size() / 3);
+		if (triangleCount == 0 || maxVertices < 3 || maxTriangles == 0)
+		{
+			return;
+		}
+
+		// Vertex -> triangle adjacency
+		std::vector<glm::uint> triangleOffsets(vertexCount + 1, 0);
+		for (glm::uint index : indices)
+		{
+			++triangleOffsets[index + 1];
+		}
+		for (glm::uint i = 0; i < vertexCount; ++i)
+		{
+			triangleOffsets[i + 1] += triangleOffsets[i];
+		}
+		std::vector<glm::uint> adjacentTriangles(indices.size());
+		{
+			std::vector<glm::uint> fillCounts(vertexCount, 0);
+			for (glm::uint t = 0; t < triangleCount; ++t)
+			{
+				for (glm::uint v = 0; v < 3; ++v)
+				{
+					const glm::uint index = indices[t * 3 + v];
+					adjacentTriangles[triangleOffsets[index] + fillCounts[index]++] = t;
+				}
+			}
+		}
+
+		std::vector<bool> triangleEmitted(triangleCount, false);
+		std::vector<glm::uint> vertexMeshlet(vertexCount, (glm::uint)-1); // Which meshlet each vertex was last added to
+		std::vector<glm::uint> meshletVertices;
+		meshletVertices.reserve(maxVertices);
+
+		std::vector<glm::uint> result;
+		result.reserve(indices.size());
+
+		glm::uint nextSeedTriangle = 0;
+		glm::uint meshletTriangleCount = 0;
+		Meshlet meshlet = {};
+
+		auto FinishMeshlet = [&]()
+		{
+			meshlet.indexCount = (glm::uint)result.size() - meshlet.firstIndex;
+			meshlets.push_back(meshlet);
+
+			meshlet = {};
+			meshlet.firstIndex = (glm::uint)result.size();
+			meshletVertices.clear();
+			meshletTriangleCount = 0;
+		};
+
+		glm::uint emittedTriangleCount = 0;
+		while (emittedTriangleCount < triangleCount)
+		{
+			const glm::uint meshletIndex = (glm::uint)meshlets.size();
+
+			// Of the unemitted triangles sharing a vertex with this meshlet, pick the one adding the fewest new vertices
+			// Ties go to the earliest triangle, which keeps the incoming (cache optimized) order as much as possible
+			glm::uint bestTriangle = (glm::uint)-1;
+			glm::uint bestNewVertexCount = 3;
+			for (glm::uint meshletVertex : meshletVertices)
+			{
+				for (glm::uint a = triangleOffsets[meshletVertex]; a < triangleOffsets[meshletVertex + 1]; ++a)
+				{
+					const glm::uint t = adjacentTriangles[a];
+					if (triangleEmitted[t])
+					{
+						continue;
+					}
+
+					glm::uint newVertexCount = 0;
+					for (glm::uint v = 0; v < 3; ++v)
+					{
+						newVertexCount += (vertexMeshlet[indices[t * 3 + v]] != meshletIndex) ? 1 : 0;
+					}
+
+					if (newVertexCount < bestNewVertexCount || (newVertexCount == bestNewVertexCount && t < bestTriangle))
+					{
+						bestTriangle = t;
+						bestNewVertexCount = newVertexCount;
+					}
+				}
+			}
+
+			if (bestTriangle == (glm::uint)-1)
+			{
+				// Nothing connected is left, continue from the next unemitted triangle in order
+				while (triangleEmitted[nextSeedTriangle])
+				{
+					++nextSeedTriangle;
+				}
+				bestTriangle = nextSeedTriangle;
+
+				bestNewVertexCount = 0;
+				for (glm::uint v = 0; v < 3; ++v)
+				{
+					bestNewVertexCount += (vertexMeshlet[indices[bestTriangle * 3 + v]] != meshletIndex) ? 1 : 0;
+				}
+			}
+
+			if (meshletVertices.size() + bestNewVertexCount > maxVertices || meshletTriangleCount + 1 > maxTriangles)
+			{
+				FinishMeshlet();
+				continue; // Reselect, as the best triangle for an empty meshlet is simply the next seed
+			}
+
+			for (glm::uint v = 0; v < 3; ++v)
+			{
+				const glm::uint index = indices[bestTriangle * 3 + v];
+				if (vertexMeshlet[index] != meshletIndex)
+				{
+					vertexMeshlet[index] = meshletIndex;
+					meshletVertices.push_back(index);
+				}
+				result.push_back(index);
+			}
+
+			triangleEmitted[bestTriangle] = true;
+			++meshletTriangleCount;
+			++emittedTriangleCount;
+		}
+
+		if (meshletTriangleCount > 0)
+		{
+			FinishMeshlet();
+		}
+
+		indices.swap(result);
+
+		for (Meshlet& m : meshlets)
+		{
+			CalculateMeshletBounds(indices, positions, vertexStride, m);
+		}
+	}
+} // namespace flex
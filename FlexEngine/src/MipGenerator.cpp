@@ -0,0 +1,317 @@
+#include "stdafx.hpp"
+
+#include "MipGenerator.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <functional>
+
+#include <glm/common.hpp>
+
+#include "Helpers.hpp"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define FLEX_SSE2 1
+#else
+#define FLEX_SSE2 0
+#endif
+
+namespace flex
+{
+	namespace
+	{
+		const float PI = 3.14159265358979f;
+
+		// Kaiser filter's half width, in destination pixels, and the sharpness of its window
+		const float KAISER_RADIUS = 3.0f;
+		const float KAISER_ALPHA = 4.0f;
+
+		// Levels with fewer rows than this per thread aren't worth splitting up
+		const glm::uint MIN_ROWS_PER_THREAD = 32;
+
+		// Weights of every source pixel which contributes to each destination pixel along one axis
+		struct FilterKernel
+		{
+			glm::uint tapCount;
+			std::vector<glm::uint> indices; // tapCount per destination pixel, already clamped to the source's edges
+			std::vector<float> weights; // Normalized, tapCount per destination pixel
+		};
+
+		// Zeroth order modified Bessel function of the first kind
+		float BesselI0(float x)
+		{
+			float sum = 1.0f;
+			float term = 1.0f;
+			const float halfXSquared = x * x * 0.25f;
+			for (int k = 1; k < 32; ++k)
+			{
+				term *= halfXSquared / (float)(k * k);
+				sum += term;
+				if (term < sum * 1e-8f)
+				{
+					break;
+				}
+			}
+			return sum;
+		}
+
+		// x is the distance from the destination pixel's center, in destination pixels
+		float EvaluateFilter(MipFilter filter, float x)
+		{
+			x = std::abs(x);
+
+			switch (filter)
+			{
+			case MipFilter::BOX:
+				return (x < 0.5f ? 1.0f : 0.0f);
+			case MipFilter::KAISER:
+			{
+				if (x >= KAISER_RADIUS)
+				{
+					return 0.0f;
+				}
+
+				const float sinc = (x < 1e-5f ? 1.0f : std::sin(PI * x) / (PI * x));
+				const float t = x / KAISER_RADIUS;
+				const float window = BesselI0(KAISER_ALPHA * std::sqrt(1.0f - t * t)) / BesselI0(KAISER_ALPHA);
+				return sinc * window;
+			}
+			default:
+				return 0.0f;
+			}
+		}
+
+		FilterKernel BuildFilterKernel(MipFilter filter, glm::uint srcSize, glm::uint dstSize)
+		{
+			const float scale = (float)srcSize / (float)dstSize;
+			const float support = (filter == MipFilter::KAISER ? KAISER_RADIUS : 0.5f) * scale;
+
+			FilterKernel kernel = {};
+			kernel.tapCount = (glm::uint)std::ceil(support * 2.0f) + 1;
+			kernel.indices.resize((size_t)dstSize * kernel.tapCount);
+			kernel.weights.resize((size_t)dstSize * kernel.tapCount);
+
+			for (glm::uint i = 0; i < dstSize; ++i)
+			{
+				const float center = ((float)i + 0.5f) * scale;
+				const int first = (int)std::floor(center - support);
+
+				float weightSum = 0.0f;
+				for (glm::uint tap = 0; tap < kernel.tapCount; ++tap)
+				{
+					const int src = first + (int)tap;
+					const float weight = EvaluateFilter(filter, ((float)src + 0.5f - center) / scale);
+
+					const size_t index = (size_t)i * kernel.tapCount + tap;
+					kernel.indices[index] = (glm::uint)glm::clamp(src, 0, (int)srcSize - 1);
+					kernel.weights[index] = weight;
+					weightSum += weight;
+				}
+
+				for (glm::uint tap = 0; tap < kernel.tapCount; ++tap)
+				{
+					kernel.weights[(size_t)i * kernel.tapCount + tap] /= weightSum;
+				}
+			}
+
+			return kernel;
+		}
+
+		// Accumulates tapCount 4 channel pixels from src (stride apart, in floats) into dst
+		inline void FilterPixel(const float* src, size_t stride, const glm::uint* indices, const float* weights, glm::uint tapCount, float* dst)
+		{
+#if FLEX_SSE2
+			__m128 sum = _mm_setzero_ps();
+			for (glm::uint tap = 0; tap < tapCount; ++tap)
+			{
+				const __m128 pixel = _mm_loadu_ps(src + indices[tap] * stride);
+				sum = _mm_add_ps(sum, _mm_mul_ps(pixel, _mm_set1_ps(weights[tap])));
+			}
+			_mm_storeu_ps(dst, sum);
+#else
+			float sum[4] = {};
+			for (glm::uint tap = 0; tap < tapCount; ++tap)
+			{
+				const float* pixel = src + indices[tap] * stride;
+				for (glm::uint c = 0; c < 4; ++c)
+				{
+					sum[c] += pixel[c] * weights[tap];
+				}
+			}
+			memcpy(dst, sum, sizeof(sum));
+#endif
+		}
+
+		// Filters a linear 4 channel image into the next level down, separably
+		void DownsampleLevel(const float* src, glm::uint srcWidth, glm::uint srcHeight, float* dst, glm::uint dstWidth, glm::uint dstHeight,
+			const MipGenerationSettings& settings, float maxValue)
+		{
+			const FilterKernel horizontalKernel = BuildFilterKernel(settings.filter, srcWidth, dstWidth);
+			const FilterKernel verticalKernel = BuildFilterKernel(settings.filter, srcHeight, dstHeight);
+
+			std::vector<float> horizontal((size_t)dstWidth * srcHeight * 4);
+
+			ParallelFor(srcHeight, MIN_ROWS_PER_THREAD, [&](glm::uint begin, glm::uint end)
+			{
+				for (glm::uint y = begin; y < end; ++y)
+				{
+					const float* srcRow = src + (size_t)y * srcWidth * 4;
+					float* dstRow = horizontal.data() + (size_t)y * dstWidth * 4;
+					for (glm::uint x = 0; x < dstWidth; ++x)
+					{
+						const size_t first = (size_t)x * horizontalKernel.tapCount;
+						FilterPixel(srcRow, 4, &horizontalKernel.indices[first], &horizontalKernel.weights[first], horizontalKernel.tapCount, dstRow + x * 4);
+					}
+				}
+			});
+
+			ParallelFor(dstHeight, MIN_ROWS_PER_THREAD, [&](glm::uint begin, glm::uint end)
+			{
+#if FLEX_SSE2
+				const __m128 minimum = _mm_setzero_ps();
+				const __m128 maximum = _mm_set1_ps(maxValue);
+#endif
+				for (glm::uint y = begin; y < end; ++y)
+				{
+					const size_t first = (size_t)y * verticalKernel.tapCount;
+					float* dstRow = dst + (size_t)y * dstWidth * 4;
+					for (glm::uint x = 0; x < dstWidth; ++x)
+					{
+						float* pixel = dstRow + x * 4;
+						FilterPixel(horizontal.data() + x * 4, (size_t)dstWidth * 4, &verticalKernel.indices[first], &verticalKernel.weights[first], verticalKernel.tapCount, pixel);
+
+						// The Kaiser filter's negative lobes can ring past the representable range
+#if FLEX_SSE2
+						_mm_storeu_ps(pixel, _mm_min_ps(_mm_max_ps(_mm_loadu_ps(pixel), minimum), maximum));
+#else
+						for (glm::uint c = 0; c < 4; ++c)
+						{
+							pixel[c] = glm::clamp(pixel[c], 0.0f, maxValue);
+						}
+#endif
+
+						if (settings.normalMap)
+						{
+							const float nx = pixel[0] * 2.0f - 1.0f;
+							const float ny = pixel[1] * 2.0f - 1.0f;
+							const float nz = pixel[2] * 2.0f - 1.0f;
+							const float length = std::sqrt(nx * nx + ny * ny + nz * nz);
+							if (length > 1e-6f)
+							{
+								pixel[0] = (nx / length) * 0.5f + 0.5f;
+								pixel[1] = (ny / length) * 0.5f + 0.5f;
+								pixel[2] = (nz / length) * 0.5f + 0.5f;
+							}
+						}
+					}
+				}
+			});
+		}
+
+		float SRGBToLinear(float c)
+		{
+			return (c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f));
+		}
+
+		float LinearToSRGB(float c)
+		{
+			return (c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f);
+		}
+
+		// Generates each level in turn, handing it to storeLevel before filtering the next one from it
+		void GenerateLinearMipChain(std::vector<float> level, glm::uint width, glm::uint height, const MipGenerationSettings& settings, float maxValue,
+			const std::function<void(const std::vector<float>& level, glm::uint width, glm::uint height)>& storeLevel)
+		{
+			const glm::uint mipCount = CalculateMipCount(width, height);
+
+			std::vector<float> nextLevel;
+			for (glm::uint mip = 1; mip < mipCount; ++mip)
+			{
+				const glm::uint nextWidth = std::max(width / 2, 1u);
+				const glm::uint nextHeight = std::max(height / 2, 1u);
+				nextLevel.resize((size_t)nextWidth * nextHeight * 4);
+				DownsampleLevel(level.data(), width, height, nextLevel.data(), nextWidth, nextHeight, settings, maxValue);
+
+				level.swap(nextLevel);
+				width = nextWidth;
+				height = nextHeight;
+
+				storeLevel(level, width, height);
+			}
+		}
+	} // namespace
+
+	glm::uint CalculateMipCount(glm::uint width, glm::uint height)
+	{
+		glm::uint mipCount = 1;
+		glm::uint size = std::max(width, height);
+		while (size > 1)
+		{
+			size /= 2;
+			++mipCount;
+		}
+		return mipCount;
+	}
+
+	void GenerateMipChain(const unsigned char* pixels, glm::uint width, glm::uint height, const MipGenerationSettings& settings,
+		std::vector<std::vector<unsigned char>>& levels)
+	{
+		const size_t pixelCount = (size_t)width * height;
+
+		levels.clear();
+		levels.reserve(CalculateMipCount(width, height));
+		levels.emplace_back(pixels, pixels + pixelCount * 4);
+
+		if (settings.filter == MipFilter::NONE)
+		{
+			return;
+		}
+
+		float toLinear[256];
+		for (glm::uint i = 0; i < 256; ++i)
+		{
+			toLinear[i] = settings.sRGB ? SRGBToLinear(i / 255.0f) : i / 255.0f;
+		}
+
+		std::vector<float> level(pixelCount * 4);
+		for (size_t i = 0; i < pixelCount * 4; ++i)
+		{
+			// Alpha is always linear
+			level[i] = ((i & 3) == 3 ? pixels[i] / 255.0f : toLinear[pixels[i]]);
+		}
+
+		GenerateLinearMipChain(std::move(level), width, height, settings, 1.0f, [&](const std::vector<float>& linearLevel, glm::uint, glm::uint)
+		{
+			levels.emplace_back(linearLevel.size());
+			std::vector<unsigned char>& encodedLevel = levels.back();
+			for (size_t i = 0; i < linearLevel.size(); ++i)
+			{
+				const float value = ((i & 3) != 3 && settings.sRGB) ? LinearToSRGB(linearLevel[i]) : linearLevel[i];
+				encodedLevel[i] = (unsigned char)(value * 255.0f + 0.5f);
+			}
+		});
+	}
+
+	void GenerateMipChain(const float* pixels, glm::uint width, glm::uint height, const MipGenerationSettings& settings,
+		std::vector<std::vector<float>>& levels)
+	{
+		const size_t pixelCount = (size_t)width * height;
+
+		levels.clear();
+		levels.reserve(CalculateMipCount(width, height));
+		levels.emplace_back(pixels, pixels + pixelCount * 4);
+
+		if (settings.filter == MipFilter::NONE)
+		{
+			return;
+		}
+
+		GenerateLinearMipChain(levels.front(), width, height, settings, FLT_MAX, [&](const std::vector<float>& linearLevel, glm::uint, glm::uint)
+		{
+			levels.push_back(linearLevel);
+		});
+	}
+} // namespace flex
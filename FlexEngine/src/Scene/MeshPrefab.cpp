@@ -2,20 +2,148 @@
 
 #include "Scene/MeshPrefab.hpp"
 
+#include <algorithm>
+#include <chrono>
+
 #include <assimp/vector3.h>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 
+#include <glm/common.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
 #include "Colors.hpp"
+#include "FreeCamera.hpp"
 #include "GameContext.hpp"
 #include "Helpers.hpp"
 #include "Logger.hpp"
+#include "MeshOptimizer.hpp"
+#include "ThreadPool.hpp"
+#include "VertexBufferWriter.hpp"
 
 namespace flex
 {
-	std::map<std::string, MeshPrefab::LoadedMesh> MeshPrefab::m_LoadedMeshes;
+	// Reads vertices straight out of an aiMesh, applying import settings as they're written
+	struct AssimpVertexSource
+	{
+		const aiMesh* mesh;
+		VertexAttributes ignoredAttributes;
+		bool hasColors;
+		bool hasTangents;
+		bool hasNormals;
+		bool hasTexCoords;
+
+		bool flipNormalYZ;
+		bool flipZ;
+		bool flipU;
+		bool flipV;
+		glm::vec2 uvScale;
+
+		glm::vec4 defaultColor;
+		glm::vec3 defaultTangent;
+		glm::vec3 defaultBitangent;
+		glm::vec3 defaultNormal;
+		glm::vec2 defaultTexCoord;
+
+		void SetMesh(const aiMesh* newMesh)
+		{
+			mesh = newMesh;
+			hasColors = mesh->HasVertexColors(0) && !(ignoredAttributes & (glm::uint)VertexAttribute::COLOR_R32G32B32A32_SFLOAT);
+			hasTangents = mesh->HasTangentsAndBitangents();
+			hasNormals = mesh->HasNormals() && !(ignoredAttributes & (glm::uint)VertexAttribute::NORMAL);
+			hasTexCoords = mesh->HasTextureCoords(0) && !(ignoredAttributes & (glm::uint)VertexAttribute::UV);
+		}
+
+		glm::vec3 Position(glm::uint i) const
+		{
+			const aiVector3D& pos = mesh->mVertices[i];
+			return glm::vec3(pos.x, pos.z, -pos.y); // Rotate +90 deg around x axis
+		}
+
+		// Never part of an imported layout
+		glm::vec2 Position2D(glm::uint) const { return glm::vec2(0.0f); }
+		glm::vec3 UVW(glm::uint) const { return glm::vec3(0.0f); }
+		glm::int32 Color32(glm::uint) const { return 0; }
+
+		glm::vec4 Color(glm::uint i) const
+		{
+			return hasColors ? ToVec4(mesh->mColors[0][i]) : defaultColor;
+		}
+
+		glm::vec3 Tangent(glm::uint i) const
+		{
+			return hasTangents ? ToVec3(mesh->mTangents[i]) : defaultTangent;
+		}
+
+		glm::vec3 Bitangent(glm::uint i) const
+		{
+			return hasTangents ? ToVec3(mesh->mBitangents[i]) : defaultBitangent;
+		}
+
+		glm::vec3 Normal(glm::uint i) const
+		{
+			if (!hasNormals)
+			{
+				return defaultNormal;
+			}
+
+			glm::vec3 norm = ToVec3(mesh->mNormals[i]);
+			if (flipNormalYZ) std::swap(norm.y, norm.z);
+			if (flipZ) norm.z = -norm.z;
+			return norm;
+		}
+
+		glm::vec2 UV(glm::uint i) const
+		{
+			if (!hasTexCoords)
+			{
+				return defaultTexCoord;
+			}
+
+			// Truncate w component
+			const aiVector3D& uvw = mesh->mTextureCoords[0][i];
+			glm::vec2 texCoord = glm::vec2(uvw.x, uvw.y) * uvScale;
+			if (flipU) texCoord.x = 1.0f - texCoord.x;
+			if (flipV) texCoord.y = 1.0f - texCoord.y;
+			return texCoord;
+		}
+	};
+
+	// Approximate bytes Assimp holds for a scene's vertex & face data, which makes up the vast majority of it
+	static size_t EstimateSceneSize(const aiScene* scene)
+	{
+		size_t size = 0;
+		for (glm::uint i = 0; i < scene->mNumMeshes; ++i)
+		{
+			const aiMesh* mesh = scene->mMeshes[i];
+
+			size_t vectorsPerVertex = 1;
+			if (mesh->HasNormals()) vectorsPerVertex += 1;
+			if (mesh->HasTangentsAndBitangents()) vectorsPerVertex += 2;
+			vectorsPerVertex += mesh->GetNumUVChannels();
+
+			size += mesh->mNumVertices * (vectorsPerVertex * sizeof(aiVector3D) + mesh->GetNumColorChannels() * sizeof(aiColor4D));
+			size += mesh->mNumFaces * (sizeof(aiFace) + 3 * sizeof(unsigned int));
+		}
+		return size;
+	}
+
+	std::map<std::string, std::shared_ptr<MeshPrefab::LoadedMesh>> MeshPrefab::m_LoadedMeshes;
+	std::mutex MeshPrefab::m_LoadedMeshesMutex;
+	size_t MeshPrefab::m_LoadedMeshesSize = 0;
+	size_t MeshPrefab::m_LoadedMeshesBudget = 128 * 1024 * 1024;
+	glm::uint64 MeshPrefab::m_LoadedMeshesUseCount = 0;
+	std::map<std::string, MeshPrefab::SharedMeshData> MeshPrefab::m_SharedMeshData;
+	std::mutex MeshPrefab::m_SharedMeshDataMutex;
+	std::atomic<glm::uint64> MeshPrefab::m_NextMeshDataID(1);
+	std::vector<MeshPrefab*> MeshPrefab::m_PendingLoads;
+
+	const glm::uint MeshPrefab::m_ImportPostProcessFlags =
+		aiProcess_FindInvalidData |
+		aiProcess_GenNormals |
+		aiProcess_CalcTangentSpace |
+		aiProcess_Triangulate |
+		aiProcess_JoinIdenticalVertices; // Weld identical vertices so meshes can be drawn indexed
 
 	std::string MeshPrefab::m_DefaultName = "Game Object";
 	glm::vec4 MeshPrefab::m_DefaultColor_4(1.0f, 1.0f, 1.0f, 1.0f);
@@ -40,7 +168,34 @@ namespace flex
 
 	MeshPrefab::~MeshPrefab()
 	{
-		m_VertexBufferData.Destroy();
+		if (m_PendingLoadData.valid())
+		{
+			// The worker is still writing into this object
+			m_PendingLoadData.wait();
+
+			auto iter = std::find(m_PendingLoads.begin(), m_PendingLoads.end(), this);
+			if (iter != m_PendingLoads.end()) m_PendingLoads.erase(iter);
+		}
+	}
+
+	MeshPrefab::MeshData::MeshData() :
+		id(m_NextMeshDataID++)
+	{
+	}
+
+	MeshPrefab::MeshData::~MeshData()
+	{
+		vertexBufferData.Destroy();
+
+		if (!sharedKey.empty())
+		{
+			std::lock_guard<std::mutex> lock(m_SharedMeshDataMutex);
+			auto iter = m_SharedMeshData.find(sharedKey);
+			if (iter != m_SharedMeshData.end() && iter->second.requestCount == 0 && iter->second.meshData.expired())
+			{
+				m_SharedMeshData.erase(iter);
+			}
+		}
 	}
 
 	void MeshPrefab::ForceAttributes(VertexAttributes attributes)
@@ -53,164 +208,340 @@ namespace flex
 		m_IgnoredAttributes |= attributes;
 	}
 
-	bool MeshPrefab::GetLoadedMesh(const std::string& filePath, const aiScene** scene)
+	std::shared_ptr<const aiScene> MeshPrefab::GetLoadedScene(const std::string& filePath)
 	{
-		auto location = m_LoadedMeshes.find(filePath);
-		if (location == m_LoadedMeshes.end())
-		{
-			return false;
-		}
-		else
+		std::shared_ptr<LoadedMesh> loadedMesh;
 		{
-			*scene = location->second.scene;
-			return true;
+			std::lock_guard<std::mutex> lock(m_LoadedMeshesMutex);
+			std::shared_ptr<LoadedMesh>& entry = m_LoadedMeshes[filePath];
+			if (!entry)
+			{
+				entry = std::make_shared<LoadedMesh>();
+			}
+			entry->lastUse = ++m_LoadedMeshesUseCount;
+			loadedMesh = entry;
 		}
-	}
 
-	bool MeshPrefab::LoadFromFile(const GameContext& gameContext, const std::string& filepath, bool flipNormalYZ, bool flipZ, bool flipU, bool flipV)
-	{
-		VertexBufferData::CreateInfo vertexBufferDataCreateInfo = {};
-
-		const aiScene* pScene = nullptr;
-		if (!GetLoadedMesh(filepath, &pScene))
+		// Other threads requesting the same file wait here until it has been imported once
+		std::lock_guard<std::mutex> lock(loadedMesh->mutex);
+		if (!loadedMesh->attemptedLoad)
 		{
-			// Mesh hasn't been loaded before, load it now
+			loadedMesh->attemptedLoad = true;
 
-			std::string fileName = filepath;
+			std::string fileName = filePath;
 			StripLeadingDirectories(fileName);
 			Logger::LogInfo("Loading mesh " + fileName);
 
-			auto meshObj = m_LoadedMeshes.insert({ filepath, LoadedMesh{ {}, nullptr } });
-			LoadedMesh& loadedMesh = meshObj.first->second;
+			loadedMesh->scene = loadedMesh->importer.ReadFile(filePath, m_ImportPostProcessFlags);
+			if (!loadedMesh->scene)
+			{
+				Logger::LogError(loadedMesh->importer.GetErrorString());
+			}
+			else
+			{
+				const size_t size = EstimateSceneSize(loadedMesh->scene);
 
-			loadedMesh.scene = loadedMesh.importer.ReadFile(filepath,
-				aiProcess_FindInvalidData |
-				aiProcess_GenNormals |
-				aiProcess_CalcTangentSpace
-			);
+				std::lock_guard<std::mutex> mapLock(m_LoadedMeshesMutex);
+				auto iter = m_LoadedMeshes.find(filePath);
+				if (iter != m_LoadedMeshes.end() && iter->second == loadedMesh)
+				{
+					loadedMesh->size = size;
+					m_LoadedMeshesSize += size;
+					EvictLoadedScenes(loadedMesh.get());
+				}
+			}
+		}
 
-			pScene = loadedMesh.scene;
+		if (!loadedMesh->scene)
+		{
+			return nullptr;
+		}
+
+		// Shares ownership with the cache entry, so an evicted scene lives until its last user is done with it
+		return std::shared_ptr<const aiScene>(loadedMesh, loadedMesh->scene);
+	}
 
-			if (!pScene)
+	void MeshPrefab::EvictLoadedScenes(const LoadedMesh* keep)
+	{
+		while (m_LoadedMeshesSize > m_LoadedMeshesBudget)
+		{
+			auto leastRecentlyUsed = m_LoadedMeshes.end();
+			for (auto iter = m_LoadedMeshes.begin(); iter != m_LoadedMeshes.end(); ++iter)
 			{
-				Logger::LogError(loadedMesh.importer.GetErrorString());
-				return false;
+				// Entries without a size are still being imported (or failed to be)
+				if (iter->second.get() == keep || iter->second->size == 0)
+				{
+					continue;
+				}
+
+				if (leastRecentlyUsed == m_LoadedMeshes.end() || iter->second->lastUse < leastRecentlyUsed->second->lastUse)
+				{
+					leastRecentlyUsed = iter;
+				}
 			}
+
+			if (leastRecentlyUsed == m_LoadedMeshes.end())
+			{
+				break;
+			}
+
+			m_LoadedMeshesSize -= leastRecentlyUsed->second->size;
+			m_LoadedMeshes.erase(leastRecentlyUsed);
 		}
+	}
 
+	void MeshPrefab::SetImportedSceneCacheBudget(size_t bytes)
+	{
+		std::lock_guard<std::mutex> lock(m_LoadedMeshesMutex);
+		m_LoadedMeshesBudget = bytes;
+		EvictLoadedScenes(nullptr);
+	}
 
-		if (!pScene->HasMeshes())
+	bool MeshPrefab::LoadFromFile(const GameContext& gameContext, const std::string& filepath, bool flipNormalYZ, bool flipZ, bool flipU, bool flipV)
+	{
+		const ImportSettings settings = GetImportSettings(flipNormalYZ, flipZ, flipU, flipV);
+		CookedMesh::Key cookedMeshKey = {};
+		const bool sourceFileExists = CookedMesh::CreateKey(filepath, CalculateImportFlags(settings), cookedMeshKey);
+
+		if (!LoadMeshData(filepath, cookedMeshKey, sourceFileExists, settings))
 		{
-			Logger::LogWarning("Loaded mesh file has no meshes! " + filepath);
 			return false;
 		}
 
-		std::vector<aiMesh*> meshes(pScene->mNumMeshes);
-		for (size_t i = 0; i < pScene->mNumMeshes; ++i)
+		CreateRenderObject(gameContext);
+
+		return true;
+	}
+
+	std::shared_future<bool> MeshPrefab::LoadFromFileAsync(const GameContext& gameContext, const std::string& filepath, bool flipNormalYZ, bool flipZ, bool flipU, bool flipV)
+	{
+		if (m_PendingLoadData.valid())
 		{
-			meshes[i] = pScene->mMeshes[i];
+			Logger::LogError("Attempted to load " + filepath + " into mesh prefab " + m_Name + " while a previous load is still pending");
+			std::promise<bool> failed;
+			failed.set_value(false);
+			return failed.get_future().share();
 		}
 
-		std::string meshName(meshes[0]->mName.C_Str());
-		if (m_Name.empty()) m_Name = meshName;
+		// Import settings are copied here, on the main thread, so they can't change underneath the worker
+		const ImportSettings settings = GetImportSettings(flipNormalYZ, flipZ, flipU, flipV);
+		CookedMesh::Key cookedMeshKey = {};
+		const bool sourceFileExists = CookedMesh::CreateKey(filepath, CalculateImportFlags(settings), cookedMeshKey);
 
-		size_t totalVertCount = 0;
+		auto task = std::make_shared<std::packaged_task<bool()>>([this, filepath, cookedMeshKey, sourceFileExists, settings]()
+		{
+			return LoadMeshData(filepath, cookedMeshKey, sourceFileExists, settings);
+		});
+		m_PendingLoadData = task->get_future();
 
-		for (aiMesh* mesh : meshes)
+		m_LoadPromise = std::promise<bool>();
+		std::shared_future<bool> loaded = m_LoadPromise.get_future().share();
+
+		m_PendingLoads.push_back(this);
+
+		if (gameContext.threadPool)
 		{
-			const size_t numMeshVerts = mesh->mNumVertices;
-			totalVertCount += numMeshVerts;
+			gameContext.threadPool->Enqueue([task]() { (*task)(); });
+		}
+		else
+		{
+			(*task)();
+		}
+
+		return loaded;
+	}
+
+	void MeshPrefab::FinishPendingLoads(const GameContext& gameContext, bool waitForAll)
+	{
+		auto iter = m_PendingLoads.begin();
+		while (iter != m_PendingLoads.end())
+		{
+			MeshPrefab* meshPrefab = *iter;
 
-			for (size_t i = 0; i < numMeshVerts; ++i)
+			if (!waitForAll && meshPrefab->m_PendingLoadData.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
 			{
-				// Position
-				glm::vec3 pos = ToVec3(mesh->mVertices[i]);
-				pos = glm::vec3(pos.x, pos.z, -pos.y); // Rotate +90 deg around x axis
-				vertexBufferDataCreateInfo.positions_3D.push_back(pos);
-				vertexBufferDataCreateInfo.attributes |= (glm::uint)VertexAttribute::POSITION;
+				++iter;
+				continue;
+			}
 
-				// Color
-				if (mesh->HasVertexColors(0) && !(m_IgnoredAttributes & (glm::uint)VertexAttribute::COLOR_R32G32B32A32_SFLOAT))
-				{
-					glm::vec4 col = ToVec4(mesh->mColors[0][i]);
-					vertexBufferDataCreateInfo.colors_R32G32B32A32.push_back(col);
-					vertexBufferDataCreateInfo.attributes |= (glm::uint)VertexAttribute::COLOR_R32G32B32A32_SFLOAT;
-				}
-				else if (m_ForcedAttributes & (glm::uint)VertexAttribute::COLOR_R32G32B32A32_SFLOAT)
+			const bool success = meshPrefab->m_PendingLoadData.get();
+			if (success)
+			{
+				meshPrefab->CreateRenderObject(gameContext);
+
+				if (meshPrefab->m_PostInitializeRequested)
 				{
-					vertexBufferDataCreateInfo.colors_R32G32B32A32.push_back(m_DefaultColor_4);
-					vertexBufferDataCreateInfo.attributes |= (glm::uint)VertexAttribute::COLOR_R32G32B32A32_SFLOAT;
+					gameContext.renderer->PostInitializeRenderObject(gameContext, meshPrefab->m_RenderID);
 				}
+			}
+
+			meshPrefab->m_LoadPromise.set_value(success);
+			iter = m_PendingLoads.erase(iter);
+		}
+	}
+
+	bool MeshPrefab::LoadMeshData(const std::string& filepath, const CookedMesh::Key& cookedMeshKey, bool sourceFileExists, const ImportSettings& settings)
+	{
+		if (!sourceFileExists)
+		{
+			// Nothing to share, the import will fail & log why
+			m_MeshData = std::make_shared<MeshData>();
+			return LoadUniqueMeshData(filepath, cookedMeshKey, sourceFileExists, settings);
+		}
 
-				// Tangent & Bitangent
-				if (mesh->HasTangentsAndBitangents())
+		const std::string sharedKey = filepath + "_" + std::to_string(cookedMeshKey.importFlags) + "_" + std::to_string((int)settings.residency);
+		SharedMeshData* sharedMeshData = nullptr;
+		{
+			std::lock_guard<std::mutex> lock(m_SharedMeshDataMutex);
+			sharedMeshData = &m_SharedMeshData[sharedKey]; // Map nodes are never moved & this request keeps it from being erased, so it stays valid after unlocking
+			++sharedMeshData->requestCount;
+		}
+
+		bool success = true;
+		{
+			// Other threads requesting the same data wait here until it has been loaded once
+			std::lock_guard<std::mutex> lock(sharedMeshData->mutex);
+			m_MeshData = sharedMeshData->meshData.lock();
+			if (!m_MeshData)
+			{
+				std::shared_ptr<MeshData> meshData = std::make_shared<MeshData>();
+				meshData->sharedKey = sharedKey;
+				m_MeshData = meshData;
+				if (LoadUniqueMeshData(filepath, cookedMeshKey, sourceFileExists, settings))
 				{
-					if (!(m_IgnoredAttributes & (glm::uint)VertexAttribute::TANGENT))
-					{
-						glm::vec3 tangent = ToVec3(mesh->mTangents[i]);
-						vertexBufferDataCreateInfo.tangents.push_back(tangent);
-						vertexBufferDataCreateInfo.attributes |= (glm::uint)VertexAttribute::TANGENT;
-					}
-
-					if (!(m_IgnoredAttributes & (glm::uint)VertexAttribute::BITANGENT))
-					{
-						glm::vec3 bitangent = ToVec3(mesh->mBitangents[i]);
-						vertexBufferDataCreateInfo.bitangents.push_back(bitangent);
-						vertexBufferDataCreateInfo.attributes |= (glm::uint)VertexAttribute::BITANGENT;
-					}
+					sharedMeshData->meshData = m_MeshData;
 				}
 				else
 				{
-					if (m_ForcedAttributes & (glm::uint)VertexAttribute::TANGENT)
-					{
-						vertexBufferDataCreateInfo.tangents.push_back(m_DefaultTangent);
-						vertexBufferDataCreateInfo.attributes |= (glm::uint)VertexAttribute::TANGENT;
-					}
-					if (m_ForcedAttributes & (glm::uint)VertexAttribute::BITANGENT)
-					{
-						vertexBufferDataCreateInfo.bitangents.push_back(m_DefaultBitangent);
-						vertexBufferDataCreateInfo.attributes |= (glm::uint)VertexAttribute::BITANGENT;
-					}
+					success = false;
 				}
+			}
+		}
 
-				// Normal
-				if (mesh->HasNormals() && !(m_IgnoredAttributes & (glm::uint)VertexAttribute::NORMAL))
-				{
-					glm::vec3 norm = ToVec3(mesh->mNormals[i]);
-					if (flipNormalYZ) std::swap(norm.y, norm.z);
-					if (flipZ) norm.z = -norm.z;
-					vertexBufferDataCreateInfo.normals.push_back(norm);
-					vertexBufferDataCreateInfo.attributes |= (glm::uint)VertexAttribute::NORMAL;
-				}
-				else if (m_ForcedAttributes & (glm::uint)VertexAttribute::NORMAL)
-				{
-					vertexBufferDataCreateInfo.normals.push_back(m_DefaultNormal);
-					vertexBufferDataCreateInfo.attributes |= (glm::uint)VertexAttribute::NORMAL;
-				}
+		std::shared_ptr<MeshData> failedMeshData;
+		if (!success)
+		{
+			// Destroyed below, after the entry's request has been dropped, so it can erase the entry if no one else wants it
+			failedMeshData.swap(m_MeshData);
+		}
 
-				// TexCoord
-				if (mesh->HasTextureCoords(0) && !(m_IgnoredAttributes & (glm::uint)VertexAttribute::UV))
-				{
-					// Truncate w component
-					glm::vec2 texCoord = (glm::vec2)(ToVec3(mesh->mTextureCoords[0][i]));
-					texCoord *= m_UVScale;
-					if (flipU) texCoord.x = 1.0f - texCoord.x;
-					if (flipV) texCoord.y = 1.0f - texCoord.y;
-					vertexBufferDataCreateInfo.texCoords_UV.push_back(texCoord);
-					vertexBufferDataCreateInfo.attributes |= (glm::uint)VertexAttribute::UV;
-				}
-				else if (m_ForcedAttributes & (glm::uint)VertexAttribute::UV)
+		{
+			std::lock_guard<std::mutex> lock(m_SharedMeshDataMutex);
+			--sharedMeshData->requestCount;
+		}
+
+		return success;
+	}
+
+	bool MeshPrefab::LoadUniqueMeshData(const std::string& filepath, const CookedMesh::Key& cookedMeshKey, bool sourceFileExists, const ImportSettings& settings)
+	{
+		m_MeshData->residency = settings.residency;
+		m_MeshData->cookedMeshKey = cookedMeshKey;
+
+		if (sourceFileExists && m_MeshData->cookedMesh.Load(cookedMeshKey))
+		{
+			m_MeshData->hasCookedCopy = true;
+
+			// Cooked data is already in its final layout, use it straight from the mapped file
+			m_MeshData->vertexBufferData.InitializeFromMemory(m_MeshData->cookedMesh.GetVertexData(), m_MeshData->cookedMesh.GetVertexCount(), m_MeshData->cookedMesh.GetVertexAttributes(), settings.separatePositionStream);
+			m_MeshData->indices.assign(m_MeshData->cookedMesh.GetIndices(), m_MeshData->cookedMesh.GetIndices() + m_MeshData->cookedMesh.GetIndexCount());
+			m_MeshData->lods.assign(m_MeshData->cookedMesh.GetLODs(), m_MeshData->cookedMesh.GetLODs() + m_MeshData->cookedMesh.GetLODCount());
+			m_MeshData->meshlets.assign(m_MeshData->cookedMesh.GetMeshlets(), m_MeshData->cookedMesh.GetMeshlets() + m_MeshData->cookedMesh.GetMeshletCount());
+			m_MeshData->bounds = m_MeshData->cookedMesh.GetBounds();
+			return true;
+		}
+
+		if (!ImportMesh(filepath, settings))
+		{
+			return false;
+		}
+
+		if (sourceFileExists)
+		{
+			CookedMesh::Save(cookedMeshKey, m_MeshData->vertexBufferData, m_MeshData->indices, m_MeshData->lods, m_MeshData->meshlets, m_MeshData->bounds);
+
+			if (settings.residency != Residency::KEEP_CPU_COPY)
+			{
+				// Make sure the data can be restored before ever releasing it (saving fails if another thread's identical copy got there first)
+				m_MeshData->hasCookedCopy = m_MeshData->cookedMesh.Load(cookedMeshKey);
+				if (m_MeshData->hasCookedCopy && settings.residency == Residency::RELEASE_AFTER_UPLOAD)
 				{
-					vertexBufferDataCreateInfo.texCoords_UV.push_back(m_DefaultTexCoord);
-					vertexBufferDataCreateInfo.attributes |= (glm::uint)VertexAttribute::UV;
+					m_MeshData->cookedMesh.Unload();
 				}
 			}
 		}
-		
-		m_VertexBufferData.Initialize(&vertexBufferDataCreateInfo);
+
+		return true;
+	}
+
+	bool MeshPrefab::MakeResident()
+	{
+		if (m_MeshData->vertexBufferData.pDataStart || !m_MeshData->hasCookedCopy)
+		{
+			// Still resident, or never released
+			return true;
+		}
+
+		if (!m_MeshData->cookedMesh.IsLoaded() && !m_MeshData->cookedMesh.Load(m_MeshData->cookedMeshKey))
+		{
+			Logger::LogError("Failed to reload released mesh data of " + m_MeshData->cookedMeshKey.sourceFilePath + " for " + m_Name);
+			return false;
+		}
+
+		const CookedMesh& cookedMesh = m_MeshData->cookedMesh;
+		m_MeshData->vertexBufferData.InitializeFromMemory(cookedMesh.GetVertexData(), cookedMesh.GetVertexCount(), cookedMesh.GetVertexAttributes(), m_MeshData->vertexBufferData.SeparatePositions);
+		m_MeshData->indices.assign(cookedMesh.GetIndices(), cookedMesh.GetIndices() + cookedMesh.GetIndexCount());
+
+		return true;
+	}
+
+	void MeshPrefab::ReleaseCPUData()
+	{
+		if (m_MeshData->residency == Residency::KEEP_CPU_COPY || !m_MeshData->hasCookedCopy || !m_MeshData->vertexBufferData.pDataStart ||
+			m_MeshData->pendingUploadCount > 0)
+		{
+			return;
+		}
+
+		// LODs, meshlets & bounds are kept, they're small and used every frame
+		m_MeshData->vertexBufferData.ReleaseData();
+		std::vector<glm::uint>().swap(m_MeshData->indices);
+
+		if (m_MeshData->residency == Residency::RELEASE_AFTER_UPLOAD)
+		{
+			m_MeshData->cookedMesh.Unload();
+		}
+	}
+
+	void MeshPrefab::FinishUpload()
+	{
+		if (!m_UploadPending)
+		{
+			return;
+		}
+
+		m_UploadPending = false;
+		--m_MeshData->pendingUploadCount;
+		ReleaseCPUData();
+	}
+
+	void MeshPrefab::CreateRenderObject(const GameContext& gameContext)
+	{
+		// Data shared with another prefab may already have been released
+		MakeResident();
+
+		// Renderers may only copy the data later on (eg. Vulkan in PostInitialize), keep it until they have
+		if (!m_UploadPending)
+		{
+			m_UploadPending = true;
+			++m_MeshData->pendingUploadCount;
+		}
 
 		Renderer::RenderObjectCreateInfo createInfo = {};
-		createInfo.vertexBufferData = &m_VertexBufferData;
+		createInfo.vertexBufferData = &m_MeshData->vertexBufferData;
+		createInfo.indices = &m_MeshData->indices;
+		createInfo.sharedDataID = m_MeshData->id;
+		createInfo.bounds = (m_MeshData->vertexBufferData.Attributes & (glm::uint)VertexAttribute::POSITION) ? &m_MeshData->bounds : nullptr;
 		createInfo.materialID = m_MaterialID;
 		createInfo.name = m_Name;
 		createInfo.transform = &m_Transform;
@@ -219,15 +550,343 @@ namespace flex
 
 		gameContext.renderer->SetTopologyMode(m_RenderID, Renderer::TopologyMode::TRIANGLE_LIST);
 
-		m_VertexBufferData.DescribeShaderVariables(gameContext.renderer, m_RenderID);
+		// indices holds every LOD, only ever draw one of them
+		m_CurrentLOD = 0;
+		if (!m_MeshData->lods.empty())
+		{
+			gameContext.renderer->SetRenderObjectIndexRange(m_RenderID, m_MeshData->lods[0].firstIndex, m_MeshData->lods[0].indexCount);
+		}
+		if (!m_MeshData->meshlets.empty())
+		{
+			gameContext.renderer->SetRenderObjectMeshlets(m_RenderID, &m_MeshData->meshlets);
+		}
+
+		m_MeshData->vertexBufferData.DescribeShaderVariables(gameContext.renderer, m_RenderID);
 
 		m_Initialized = true;
+	}
+
+	bool MeshPrefab::ImportMesh(const std::string& filepath, const ImportSettings& settings)
+	{
+		// Held until the data has been copied out, the scene may be evicted from the cache by other loads in the meantime
+		const std::shared_ptr<const aiScene> scene = GetLoadedScene(filepath);
+		const aiScene* pScene = scene.get();
+		if (!pScene)
+		{
+			return false;
+		}
+
+		if (!pScene->HasMeshes())
+		{
+			Logger::LogWarning("Loaded mesh file has no meshes! " + filepath);
+			return false;
+		}
+
+		std::vector<aiMesh*> meshes(pScene->mNumMeshes);
+		for (size_t i = 0; i < pScene->mNumMeshes; ++i)
+		{
+			meshes[i] = pScene->mMeshes[i];
+		}
+
+		// Every sub-mesh shares one layout, those missing an attribute another has are filled with defaults
+		VertexAttributes attributes = (glm::uint)VertexAttribute::POSITION;
+		size_t totalVertCount = 0;
+		size_t totalIndexCount = 0;
+		for (aiMesh* mesh : meshes)
+		{
+			totalVertCount += mesh->mNumVertices;
+			totalIndexCount += mesh->mNumFaces * 3;
+
+			if (mesh->HasVertexColors(0)) attributes |= (glm::uint)VertexAttribute::COLOR_R32G32B32A32_SFLOAT;
+			if (mesh->HasTangentsAndBitangents()) attributes |= (glm::uint)VertexAttribute::TANGENT | (glm::uint)VertexAttribute::BITANGENT;
+			if (mesh->HasNormals()) attributes |= (glm::uint)VertexAttribute::NORMAL;
+			if (mesh->HasTextureCoords(0)) attributes |= (glm::uint)VertexAttribute::UV;
+		}
+		attributes &= ~settings.ignoredAttributes;
+		attributes |= settings.forcedAttributes &
+			((glm::uint)VertexAttribute::COLOR_R32G32B32A32_SFLOAT |
+			(glm::uint)VertexAttribute::TANGENT |
+			(glm::uint)VertexAttribute::BITANGENT |
+			(glm::uint)VertexAttribute::NORMAL |
+			(glm::uint)VertexAttribute::UV);
+		attributes |= (glm::uint)VertexAttribute::POSITION;
+
+		if (settings.compressAttributes)
+		{
+			const VertexAttributes uncompressedAttributes = attributes;
+			attributes = CompressVertexAttributes(attributes);
+			if (attributes == uncompressedAttributes)
+			{
+				Logger::LogWarning("Mesh " + settings.name + " has no full tangent frame, its attributes are left uncompressed");
+			}
+		}
+
+		// Vertices are written straight into their final interleaved location, no intermediate per-attribute arrays
+		if (!m_MeshData->vertexBufferData.Initialize((glm::uint)totalVertCount, attributes))
+		{
+			return false;
+		}
+
+		m_MeshData->indices.clear();
+		m_MeshData->indices.reserve(totalIndexCount);
+
+		AssimpVertexSource source = {};
+		source.ignoredAttributes = settings.ignoredAttributes;
+		source.flipNormalYZ = settings.flipNormalYZ;
+		source.flipZ = settings.flipZ;
+		source.flipU = settings.flipU;
+		source.flipV = settings.flipV;
+		source.uvScale = settings.uvScale;
+		source.defaultColor = m_DefaultColor_4;
+		source.defaultTangent = m_DefaultTangent;
+		source.defaultBitangent = m_DefaultBitangent;
+		source.defaultNormal = m_DefaultNormal;
+		source.defaultTexCoord = m_DefaultTexCoord;
+
+		size_t baseVertex = 0;
+		for (aiMesh* mesh : meshes)
+		{
+			const size_t numMeshVerts = mesh->mNumVertices;
+
+			// Indices (offset by the number of vertices in all previous sub-meshes)
+			for (size_t i = 0; i < mesh->mNumFaces; ++i)
+			{
+				const aiFace& face = mesh->mFaces[i];
+				if (face.mNumIndices != 3)
+				{
+					// Points & lines can't be rendered with a triangle list
+					continue;
+				}
+
+				m_MeshData->indices.push_back((glm::uint)(baseVertex + face.mIndices[0]));
+				m_MeshData->indices.push_back((glm::uint)(baseVertex + face.mIndices[1]));
+				m_MeshData->indices.push_back((glm::uint)(baseVertex + face.mIndices[2]));
+			}
+
+			source.SetMesh(mesh);
+			char* meshVertexData = (char*)m_MeshData->vertexBufferData.pDataStart + baseVertex * m_MeshData->vertexBufferData.VertexStride;
+			WriteVertices(attributes, source, (glm::uint)numMeshVerts, meshVertexData);
+
+			baseVertex += numMeshVerts;
+		}
+
+		OptimizeMesh(filepath, settings);
+
+		// After optimizing, which drops unreferenced vertices, but before LODs, whose error limit is relative to the bounds
+		CalculateBounds();
+
+		m_MeshData->meshlets.clear();
+		if (settings.buildMeshlets && !m_MeshData->indices.empty() && (m_MeshData->vertexBufferData.Attributes & (glm::uint)VertexAttribute::POSITION))
+		{
+			// Reorders triangles, so must come before LODs are appended
+			BuildMeshlets(m_MeshData->indices, m_MeshData->vertexBufferData.pDataStart, m_MeshData->vertexBufferData.VertexCount, m_MeshData->vertexBufferData.VertexStride, m_MeshData->meshlets);
+		}
+
+		GenerateLODs(filepath, settings);
+
+		// Must come after optimizing & simplifying, which expect interleaved vertices
+		if (settings.separatePositionStream)
+		{
+			m_MeshData->vertexBufferData.SeparatePositionStream();
+		}
 
 		return true;
 	}
 
+	void MeshPrefab::CalculateBounds()
+	{
+		const VertexBufferData& vertexBufferData = m_MeshData->vertexBufferData;
+		if (!(vertexBufferData.Attributes & (glm::uint)VertexAttribute::POSITION))
+		{
+			m_MeshData->bounds = {};
+			return;
+		}
+
+		// Positions are always first, whether interleaved or in their own stream
+		m_MeshData->bounds = CalculateMeshBounds(vertexBufferData.pDataStart, vertexBufferData.VertexCount, vertexBufferData.GetStreamStride(0));
+	}
+
+	void MeshPrefab::OptimizeMesh(const std::string& filepath, const ImportSettings& settings)
+	{
+		if (m_MeshData->indices.empty())
+		{
+			return;
+		}
+
+		const VertexCacheStatistics statisticsBefore = AnalyzeVertexCache(m_MeshData->indices, m_MeshData->vertexBufferData.VertexCount);
+
+		OptimizeVertexCache(m_MeshData->indices, m_MeshData->vertexBufferData.VertexCount);
+
+		// Positions are always the first attribute in a vertex when present
+		if (settings.optimizeOverdraw && (m_MeshData->vertexBufferData.Attributes & (glm::uint)VertexAttribute::POSITION))
+		{
+			OptimizeOverdraw(m_MeshData->indices, m_MeshData->vertexBufferData.pDataStart, m_MeshData->vertexBufferData.VertexCount, m_MeshData->vertexBufferData.VertexStride);
+		}
+
+		// Must come last as it relies on the final triangle order
+		m_MeshData->vertexBufferData.VertexCount = OptimizeVertexFetch(m_MeshData->indices, m_MeshData->vertexBufferData.pDataStart, m_MeshData->vertexBufferData.VertexCount, m_MeshData->vertexBufferData.VertexStride);
+		m_MeshData->vertexBufferData.BufferSize = m_MeshData->vertexBufferData.VertexCount * m_MeshData->vertexBufferData.VertexStride;
+
+		const VertexCacheStatistics statisticsAfter = AnalyzeVertexCache(m_MeshData->indices, m_MeshData->vertexBufferData.VertexCount);
+
+		std::string fileName = filepath;
+		StripLeadingDirectories(fileName);
+		Logger::LogInfo("Optimized mesh " + fileName +
+			" - ACMR: " + FloatToString(statisticsBefore.ACMR, 3) + " -> " + FloatToString(statisticsAfter.ACMR, 3) +
+			", ATVR: " + FloatToString(statisticsBefore.ATVR, 3) + " -> " + FloatToString(statisticsAfter.ATVR, 3));
+	}
+
+	void MeshPrefab::GenerateLODs(const std::string& filepath, const ImportSettings& settings)
+	{
+		m_MeshData->lods.clear();
+		m_MeshData->lods.push_back({ 0, (glm::uint)m_MeshData->indices.size() });
+
+		if (settings.lodCount <= 1 || m_MeshData->indices.empty() || !(m_MeshData->vertexBufferData.Attributes & (glm::uint)VertexAttribute::POSITION))
+		{
+			return;
+		}
+
+		// Stop once simplification stalls (every remaining collapse is locked or too costly), further LODs would be near duplicates
+		static const float MIN_LOD_REDUCTION = 0.95f;
+
+		const float maxError = glm::length(m_MeshData->bounds.box.maximum - m_MeshData->bounds.box.minimum) * settings.lodMaxErrorFraction;
+
+		std::vector<glm::uint> previousIndices = m_MeshData->indices;
+		std::vector<glm::uint> lodIndices;
+		std::string triangleCounts = std::to_string(m_MeshData->indices.size() / 3);
+
+		for (glm::uint i = 1; i < settings.lodCount; ++i)
+		{
+			const size_t targetIndexCount = (size_t)(previousIndices.size() * settings.lodReduction) / 3 * 3;
+
+			// Simplifying from the previous LOD keeps each LOD's triangles a subset of the collapses made for the last
+			SimplifyMesh(previousIndices, m_MeshData->vertexBufferData.pDataStart, m_MeshData->vertexBufferData.VertexCount, m_MeshData->vertexBufferData.VertexStride,
+				targetIndexCount, maxError, lodIndices);
+
+			if (lodIndices.empty() || lodIndices.size() > previousIndices.size() * MIN_LOD_REDUCTION)
+			{
+				break;
+			}
+
+			OptimizeVertexCache(lodIndices, m_MeshData->vertexBufferData.VertexCount);
+
+			m_MeshData->lods.push_back({ (glm::uint)m_MeshData->indices.size(), (glm::uint)lodIndices.size() });
+			m_MeshData->indices.insert(m_MeshData->indices.end(), lodIndices.begin(), lodIndices.end());
+			triangleCounts += ", " + std::to_string(lodIndices.size() / 3);
+
+			previousIndices.swap(lodIndices);
+		}
+
+		std::string fileName = filepath;
+		StripLeadingDirectories(fileName);
+		Logger::LogInfo("Generated " + std::to_string(m_MeshData->lods.size()) + " LODs for mesh " + fileName + " - triangles: " + triangleCounts);
+	}
+
+	void MeshPrefab::SelectLOD(const GameContext& gameContext)
+	{
+		MeshBounds worldBounds;
+		if (!gameContext.renderer->GetRenderObjectWorldBounds(m_RenderID, worldBounds))
+		{
+			return;
+		}
+
+		const float radius = worldBounds.sphere.radius;
+		const float distance = glm::length(worldBounds.sphere.center - gameContext.camera->GetPosition());
+
+		glm::uint lod = 0;
+		if (distance > radius)
+		{
+			// Fraction of the screen's height covered by the bounding sphere
+			const float screenSize = radius / (distance * glm::tan(gameContext.camera->GetFOV() * 0.5f));
+
+			// Only move past a threshold once clearly beyond it in either direction
+			const glm::uint lodCount = (glm::uint)m_MeshData->lods.size();
+			lod = m_CurrentLOD;
+			while (lod + 1 < lodCount && screenSize < GetLODScreenSize(lod) * (1.0f - m_LODHysteresis))
+			{
+				++lod;
+			}
+			while (lod > 0 && screenSize > GetLODScreenSize(lod - 1) * (1.0f + m_LODHysteresis))
+			{
+				--lod;
+			}
+		}
+
+		if (lod != m_CurrentLOD)
+		{
+			m_CurrentLOD = lod;
+			gameContext.renderer->SetRenderObjectIndexRange(m_RenderID, m_MeshData->lods[lod].firstIndex, m_MeshData->lods[lod].indexCount);
+
+			// Coarser LODs are small enough on screen that culling their parts isn't worth it
+			if (!m_MeshData->meshlets.empty())
+			{
+				gameContext.renderer->SetRenderObjectMeshlets(m_RenderID, lod == 0 ? &m_MeshData->meshlets : nullptr);
+			}
+		}
+	}
+
+	float MeshPrefab::GetLODScreenSize(glm::uint lod) const
+	{
+		if (lod < m_LODScreenSizes.size())
+		{
+			return m_LODScreenSizes[lod];
+		}
+
+		// Triangle count scales with area on screen, so keep the on-screen triangle density of every LOD about the same
+		return 0.5f * glm::pow(glm::sqrt(m_LODReduction), (float)lod);
+	}
+
+	MeshPrefab::ImportSettings MeshPrefab::GetImportSettings(bool flipNormalYZ, bool flipZ, bool flipU, bool flipV) const
+	{
+		ImportSettings settings = {};
+		settings.name = m_Name;
+		settings.flipNormalYZ = flipNormalYZ;
+		settings.flipZ = flipZ;
+		settings.flipU = flipU;
+		settings.flipV = flipV;
+		settings.forcedAttributes = m_ForcedAttributes;
+		settings.ignoredAttributes = m_IgnoredAttributes;
+		settings.optimizeOverdraw = m_OptimizeOverdraw;
+		settings.compressAttributes = m_CompressAttributes;
+		settings.separatePositionStream = m_SeparatePositionStream;
+		settings.buildMeshlets = m_BuildMeshlets;
+		settings.residency = m_Residency;
+		settings.uvScale = m_UVScale;
+		settings.lodCount = m_LODCount;
+		settings.lodReduction = m_LODReduction;
+		settings.lodMaxErrorFraction = m_LODMaxErrorFraction;
+		return settings;
+	}
+
+	glm::uint MeshPrefab::CalculateImportFlags(const ImportSettings& settings)
+	{
+		const glm::uint values[] = {
+			m_ImportPostProcessFlags,
+			(settings.flipNormalYZ ? 1u : 0u) | (settings.flipZ ? 2u : 0u) | (settings.flipU ? 4u : 0u) | (settings.flipV ? 8u : 0u) |
+				(settings.optimizeOverdraw ? 16u : 0u) | (settings.compressAttributes ? 32u : 0u) | (settings.separatePositionStream ? 64u : 0u) | (settings.buildMeshlets ? 128u : 0u),
+			settings.forcedAttributes,
+			settings.ignoredAttributes,
+			glm::floatBitsToUint(settings.uvScale.x),
+			glm::floatBitsToUint(settings.uvScale.y),
+			settings.lodCount,
+			glm::floatBitsToUint(settings.lodReduction),
+			glm::floatBitsToUint(settings.lodMaxErrorFraction),
+		};
+
+		// FNV-1a
+		glm::uint hash = 2166136261u;
+		for (glm::uint value : values)
+		{
+			hash ^= value;
+			hash *= 16777619u;
+		}
+		return hash;
+	}
+
 	bool MeshPrefab::LoadPrefabShape(const GameContext& gameContext, PrefabShape shape)
 	{
+		m_MeshData = std::make_shared<MeshData>();
+
 		Renderer::RenderObjectCreateInfo renderObjectCreateInfo = {};
 		renderObjectCreateInfo.materialID = m_MaterialID;
 		renderObjectCreateInfo.transform = &m_Transform;
@@ -641,16 +1300,16 @@ namespace flex
 			const glm::uint numVerts = vertexBufferDataCreateInfo.positions_3D.size();
 
 			// Indices
-			m_Indices.clear();
+			m_MeshData->indices.clear();
 
 			// Top triangles
 			for (size_t i = 0; i < meridianCount; ++i)
 			{
 				glm::uint a = i + 1;
 				glm::uint b = (i + 1) % meridianCount + 1;
-				m_Indices.push_back(0);
-				m_Indices.push_back(b);
-				m_Indices.push_back(a);
+				m_MeshData->indices.push_back(0);
+				m_MeshData->indices.push_back(b);
+				m_MeshData->indices.push_back(a);
 			}
 
 			// Center quads
@@ -664,13 +1323,13 @@ namespace flex
 					glm::uint a1 = aStart + (i + 1) % meridianCount;
 					glm::uint b = bStart + i;
 					glm::uint b1 = bStart + (i + 1) % meridianCount;
-					m_Indices.push_back(a);
-					m_Indices.push_back(a1);
-					m_Indices.push_back(b1);
+					m_MeshData->indices.push_back(a);
+					m_MeshData->indices.push_back(a1);
+					m_MeshData->indices.push_back(b1);
 
-					m_Indices.push_back(a);
-					m_Indices.push_back(b1);
-					m_Indices.push_back(b);
+					m_MeshData->indices.push_back(a);
+					m_MeshData->indices.push_back(b1);
+					m_MeshData->indices.push_back(b);
 				}
 			}
 
@@ -679,11 +1338,12 @@ namespace flex
 			{
 				glm::uint a = i + meridianCount * (parallelCount - 2) + 1;
 				glm::uint b = (i + 1) % meridianCount + meridianCount * (parallelCount - 2) + 1;
-				m_Indices.push_back(numVerts - 1);
-				m_Indices.push_back(a);
-				m_Indices.push_back(b);
+				m_MeshData->indices.push_back(numVerts - 1);
+				m_MeshData->indices.push_back(a);
+				m_MeshData->indices.push_back(b);
 			}
 
+			renderObjectCreateInfo.indices = &m_MeshData->indices;
 			renderObjectCreateInfo.name = "UV Sphere";
 		} break;
 		case MeshPrefab::PrefabShape::SKYBOX:
@@ -757,15 +1417,23 @@ namespace flex
 		} break;
 		}
 
-		m_VertexBufferData.Initialize(&vertexBufferDataCreateInfo);
+		m_MeshData->vertexBufferData.Initialize(&vertexBufferDataCreateInfo);
+		CalculateBounds();
+
+		if (m_SeparatePositionStream)
+		{
+			m_MeshData->vertexBufferData.SeparatePositionStream();
+		}
 
-		renderObjectCreateInfo.vertexBufferData = &m_VertexBufferData;
+		renderObjectCreateInfo.vertexBufferData = &m_MeshData->vertexBufferData;
+		renderObjectCreateInfo.sharedDataID = m_MeshData->id;
+		renderObjectCreateInfo.bounds = (m_MeshData->vertexBufferData.Attributes & (glm::uint)VertexAttribute::POSITION) ? &m_MeshData->bounds : nullptr;
 		if (!m_Name.empty() && m_Name.compare(m_DefaultName) != 0) renderObjectCreateInfo.name = m_Name;
 
 		m_RenderID = gameContext.renderer->InitializeRenderObject(gameContext, &renderObjectCreateInfo);
 
 		gameContext.renderer->SetTopologyMode(m_RenderID, topologyMode);
-		m_VertexBufferData.DescribeShaderVariables(gameContext.renderer, m_RenderID);
+		m_MeshData->vertexBufferData.DescribeShaderVariables(gameContext.renderer, m_RenderID);
 
 		m_Initialized = true;
 
@@ -779,17 +1447,37 @@ namespace flex
 
 	void MeshPrefab::PostInitialize(const GameContext& gameContext)
 	{
+		if (!m_Initialized)
+		{
+			// Still loading asynchronously, FinishPendingLoads will post-initialize once the render object exists
+			m_PostInitializeRequested = true;
+			return;
+		}
+
 		gameContext.renderer->PostInitializeRenderObject(gameContext, m_RenderID);
 	}
 
 	void MeshPrefab::Update(const GameContext& gameContext)
 	{
-		UNREFERENCED_PARAMETER(gameContext);
+		if (m_Initialized && m_MeshData->lods.size() > 1 && gameContext.camera)
+		{
+			SelectLOD(gameContext);
+		}
+
+		if (m_Initialized && m_UploadPending && gameContext.renderer->IsRenderObjectUploaded(m_RenderID))
+		{
+			// Prefabs sharing this data which are created later on will make it resident again
+			FinishUpload();
+		}
 	}
 
 	void MeshPrefab::Destroy(const GameContext& gameContext)
 	{
-		gameContext.renderer->Destroy(m_RenderID);
+		if (m_Initialized)
+		{
+			gameContext.renderer->Destroy(m_RenderID);
+			FinishUpload();
+		}
 	}
 
 	void MeshPrefab::SetMaterialID(MaterialID materialID, const GameContext& gameContext)
@@ -801,6 +1489,53 @@ namespace flex
 		}
 	}
 
+	void MeshPrefab::EnableOverdrawOptimization(bool enabled)
+	{
+		m_OptimizeOverdraw = enabled;
+	}
+
+	void MeshPrefab::EnableAttributeCompression(bool enabled)
+	{
+		m_CompressAttributes = enabled;
+	}
+
+	void MeshPrefab::EnableSeparatePositionStream(bool enabled)
+	{
+		m_SeparatePositionStream = enabled;
+	}
+
+	void MeshPrefab::EnableMeshlets(bool enabled)
+	{
+		m_BuildMeshlets = enabled;
+	}
+
+	void MeshPrefab::SetResidency(Residency residency)
+	{
+		m_Residency = residency;
+	}
+
+	void MeshPrefab::SetLODs(glm::uint lodCount, float reductionPerLOD, float maxErrorFraction)
+	{
+		m_LODCount = glm::max(lodCount, 1u);
+		m_LODReduction = glm::clamp(reductionPerLOD, 0.05f, 0.95f);
+		m_LODMaxErrorFraction = glm::max(maxErrorFraction, 0.0f);
+	}
+
+	void MeshPrefab::SetLODScreenSizes(const std::vector<float>& screenSizes)
+	{
+		m_LODScreenSizes = screenSizes;
+	}
+
+	void MeshPrefab::SetLODHysteresis(float hysteresis)
+	{
+		m_LODHysteresis = glm::clamp(hysteresis, 0.0f, 0.9f);
+	}
+
+	glm::uint MeshPrefab::GetCurrentLOD() const
+	{
+		return m_CurrentLOD;
+	}
+
 	void MeshPrefab::SetUVScale(float uScale, float vScale)
 	{
 		m_UVScale = glm::vec2(uScale, vScale);
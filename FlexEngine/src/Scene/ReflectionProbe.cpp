@@ -39,6 +39,7 @@ namespace flex
 		probeCaptureMatCreateInfo.enableIrradianceSampler = true;
 		probeCaptureMatCreateInfo.generateIrradianceSampler = true;
 		probeCaptureMatCreateInfo.generatedIrradianceCubemapSize = { 32, 32 };
+		probeCaptureMatCreateInfo.generateIrradianceSH = true;
 		probeCaptureMatCreateInfo.enablePrefilteredMap = true;
 		probeCaptureMatCreateInfo.generatePrefilteredMap = true;
 		probeCaptureMatCreateInfo.generatedPrefilteredCubemapSize = { 128, 128 };
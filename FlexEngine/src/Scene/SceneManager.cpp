@@ -5,6 +5,7 @@
 #include <algorithm>
 
 #include "Logger.hpp"
+#include "Scene/MeshPrefab.hpp"
 
 namespace flex
 {
@@ -25,6 +26,9 @@ namespace flex
 			return;
 		}
 
+		// Meshes loaded asynchronously after their scene was added finish as soon as their data is ready
+		MeshPrefab::FinishPendingLoads(gameContext, false);
+
 		m_Scenes[m_CurrentSceneIndex]->RootUpdate(gameContext);
 	}
 
@@ -34,6 +38,10 @@ namespace flex
 		{
 			m_Scenes.push_back(newScene);
 			newScene->RootInitialize(gameContext);
+
+			// Every render object must exist before post-initialization (probe captures, static Vulkan buffers, etc.)
+			MeshPrefab::FinishPendingLoads(gameContext, true);
+
 			newScene->RootPostInitialize(gameContext);
 		}
 		else
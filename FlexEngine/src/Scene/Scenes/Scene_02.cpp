@@ -50,6 +50,7 @@ namespace flex
 		skyboxHDRMatInfo.generatedCubemapSize = { 512, 512 };
 		skyboxHDRMatInfo.generateIrradianceSampler = true;
 		skyboxHDRMatInfo.generatedIrradianceCubemapSize = { 32, 32 };
+		skyboxHDRMatInfo.generateIrradianceSH = true; // The Vulkan renderer still uses an irradiance cubemap
 		skyboxHDRMatInfo.generatePrefilteredMap = true;
 		skyboxHDRMatInfo.generatedPrefilteredCubemapSize = { 128, 128 };
 		skyboxHDRMatInfo.environmentMapPath = RESOURCE_LOCATION + "textures/hdri/Factory_Catwalk/Factory_Catwalk_2k.hdr";
@@ -79,6 +80,9 @@ namespace flex
 
 		gameContext.renderer->SetSkyboxMaterial(m_SkyboxMatID_1);
 		m_CurrentSkyboxMatID = 0;
+
+		// Only the shown skybox's maps are created, keep recently shown ones around for a minute in case they're cycled back to
+		gameContext.renderer->SetEnvironmentMapEvictionDelay(60.0f);
 #endif
 
 #if 0 // Cornell Box
@@ -131,6 +135,8 @@ namespace flex
 
 #if 0 // Cerebus 1
 		m_Cerberus = new MeshPrefab(cerebusMatID, "Cerberus");
+		m_Cerberus->EnableMeshlets(true);
+		m_Cerberus->SetResidency(MeshPrefab::Residency::COLD_CACHE);
 		m_Cerberus->LoadFromFile(gameContext, RESOURCE_LOCATION + "models/Cerberus_by_Andrew_Maximov/Cerberus_LP_WithB&T.fbx", true, true, false, true);
 		AddChild(gameContext, m_Cerberus);
 		m_Cerberus->GetTransform().Scale(0.075f, 0.075f, 0.075f);
@@ -139,6 +145,8 @@ namespace flex
 
 #if 0 // Cerebus 2
 		MeshPrefab* extraCerberus = new MeshPrefab(cerebusMatID, "Cerberus 2");
+		extraCerberus->EnableMeshlets(true);
+		extraCerberus->SetResidency(MeshPrefab::Residency::COLD_CACHE);
 		extraCerberus->LoadFromFile(gameContext, RESOURCE_LOCATION + "models/Cerberus_by_Andrew_Maximov/Cerberus_LP_WithB&T.fbx", true, true, false, true);
 		AddChild(gameContext, extraCerberus);
 		extraCerberus->GetTransform().Scale(0.075f, 0.075f, 0.075f);
@@ -193,8 +201,9 @@ namespace flex
 			}
 
 			m_Spheres[i] = new MeshPrefab(matID, "Sphere " + iStr);
+			m_Spheres[i]->SetLODs(4);
 
-			m_Spheres[i]->LoadFromFile(gameContext, RESOURCE_LOCATION + "models/sphere.fbx", true, true);
+			m_Spheres[i]->LoadFromFileAsync(gameContext, RESOURCE_LOCATION + "models/sphere.fbx", true, true);
 			m_Spheres[i]->GetTransform().SetLocalPosition(offset + glm::vec3(x * sphereSpacing, y * sphereSpacing, z * sphereSpacing));
 			AddChild(gameContext, m_Spheres[i]);
 		}
@@ -294,7 +303,6 @@ namespace flex
 
 			Logger::LogInfo("index: " + std::to_string(m_CurrentSkyboxMatID) + " new mat id: " + std::to_string(newMatID));
 			gameContext.renderer->SetSkyboxMaterial(newMatID);
-			gameContext.renderer->PostInitializeRenderObject(gameContext, m_Skybox->GetRenderID());
 			m_Skybox->SetMaterialID(newMatID, gameContext);
 		}
 	}
@@ -53,6 +53,7 @@ namespace flex
 		skyboxHDRMatInfo.generatedCubemapSize = { 512, 512 };
 		skyboxHDRMatInfo.generateIrradianceSampler = true;
 		skyboxHDRMatInfo.generatedIrradianceCubemapSize = { 32, 32 };
+		skyboxHDRMatInfo.generateIrradianceSH = true; // The Vulkan renderer still uses an irradiance cubemap
 		skyboxHDRMatInfo.generatePrefilteredMap = true;
 		skyboxHDRMatInfo.generatedPrefilteredCubemapSize = { 128, 128 };
 		const MaterialID skyboxHDRMatID = gameContext.renderer->InitializeMaterial(gameContext, &skyboxHDRMatInfo);
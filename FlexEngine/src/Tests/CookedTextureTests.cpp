@@ -0,0 +1,93 @@
+#include "stdafx.hpp"
+
+#include "UnitTests.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include "CookedTexture.hpp"
+#include "TextureCompression.hpp"
+
+namespace flex
+{
+	namespace UnitTests
+	{
+		namespace
+		{
+			// Gradients & a low frequency wave, so every block has some detail for the encoder to keep
+			std::vector<unsigned char> CreateTestImage(glm::uint width, glm::uint height)
+			{
+				std::vector<unsigned char> pixels((size_t)width * height * 4);
+				for (glm::uint y = 0; y < height; ++y)
+				{
+					for (glm::uint x = 0; x < width; ++x)
+					{
+						unsigned char* pixel = &pixels[((size_t)y * width + x) * 4];
+						pixel[0] = (unsigned char)(x * 255 / std::max(width - 1, 1u));
+						pixel[1] = (unsigned char)(y * 255 / std::max(height - 1, 1u));
+						pixel[2] = (unsigned char)(127.5f + 127.5f * std::sin(x * 0.3f + y * 0.2f));
+						pixel[3] = 255;
+					}
+				}
+				return pixels;
+			}
+
+			void TestCookedTextureRoundTrip()
+			{
+				const glm::uint width = 16;
+				const glm::uint height = 8;
+				const std::vector<unsigned char> pixels = CreateTestImage(width, height);
+
+				// Cooked files are only looked up by key, the source file doesn't need to exist
+				CookedTexture::Key key = {};
+				key.sourceFilePath = RESOURCE_LOCATION + "textures/unit_test_cooked_texture.png";
+				key.sourceModifiedTime = 0x123456789ull;
+				key.usage = TextureUsage::COLOR;
+				key.flipVertically = false;
+
+				Check(CookedTexture::Save(key, pixels.data(), width, height, 4), "cooked texture saved");
+
+				CookedTexture cookedTexture;
+				const bool loaded = cookedTexture.Load(key);
+				Check(loaded, "cooked texture loaded with the key it was saved with");
+				if (loaded)
+				{
+					Check(cookedTexture.GetFormat() == BlockCompressionFormat::BC7 && cookedTexture.GetWidth() == width &&
+						cookedTexture.GetHeight() == height, "cooked texture keeps its format & dimensions");
+					Check(cookedTexture.GetMipCount() == 5, "cooked texture holds every mip down to 1x1");
+
+					bool mipSizesMatch = true;
+					glm::uint dataSize = 0;
+					for (glm::uint mip = 0; mip < cookedTexture.GetMipCount(); ++mip)
+					{
+						const size_t expectedSize = GetBlockCompressedImageSize(BlockCompressionFormat::BC7,
+							std::max(width >> mip, 1u), std::max(height >> mip, 1u));
+						mipSizesMatch = mipSizesMatch && cookedTexture.GetMipSize(mip) == expectedSize;
+						dataSize += cookedTexture.GetMipSize(mip);
+					}
+					Check(mipSizesMatch && cookedTexture.GetDataSize() == dataSize, "cooked mip sizes match their block counts");
+
+					std::vector<unsigned char> expectedMip0(GetBlockCompressedImageSize(BlockCompressionFormat::BC7, width, height));
+					CompressImage(BlockCompressionFormat::BC7, pixels.data(), width, height, expectedMip0.data());
+					Check(memcmp(cookedTexture.GetMipData(0), expectedMip0.data(), expectedMip0.size()) == 0, "cooked top mip holds the source's compressed blocks");
+				}
+				cookedTexture.Unload();
+
+				CookedTexture::Key staleKey = key;
+				++staleKey.sourceModifiedTime;
+				Check(!cookedTexture.Load(staleKey), "cooked texture is stale once its source is modified");
+
+				CookedTexture::Key otherUsageKey = key;
+				otherUsageKey.usage = TextureUsage::NORMAL;
+				Check(!cookedTexture.Load(otherUsageKey), "cooked texture isn't loaded for another usage");
+			}
+		} // namespace
+
+		void RunCookedTextureTests()
+		{
+			Run("Cooked texture round trip", TestCookedTextureRoundTrip);
+		}
+	} // namespace UnitTests
+} // namespace flex
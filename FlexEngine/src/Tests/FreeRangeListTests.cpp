@@ -0,0 +1,96 @@
+#include "stdafx.hpp"
+
+#include "UnitTests.hpp"
+
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "FreeRangeList.hpp"
+
+namespace flex
+{
+	namespace UnitTests
+	{
+		namespace
+		{
+			void TestFreeRangeList()
+			{
+				const glm::uint capacity = 1024;
+				FreeRangeList freeRanges;
+				freeRanges.Reset(capacity);
+
+				std::mt19937 random(25);
+				std::vector<bool> allocated(capacity, false);
+				std::vector<std::pair<glm::uint, glm::uint>> allocations;
+				glm::uint allocatedCount = 0;
+				bool disjoint = true;
+				bool countsMatch = true;
+				for (glm::uint step = 0; step < 20000; ++step)
+				{
+					if (!allocations.empty() && (random() % 2) == 0)
+					{
+						const size_t i = random() % allocations.size();
+						freeRanges.Free(allocations[i].first, allocations[i].second);
+						for (glm::uint j = 0; j < allocations[i].second; ++j)
+						{
+							allocated[allocations[i].first + j] = false;
+						}
+						allocatedCount -= allocations[i].second;
+						allocations[i] = allocations.back();
+						allocations.pop_back();
+					}
+					else
+					{
+						const glm::uint count = 1 + (glm::uint)(random() % 64);
+						glm::uint offset;
+						if (freeRanges.Allocate(count, offset))
+						{
+							for (glm::uint j = 0; j < count; ++j)
+							{
+								if (offset + j >= capacity || allocated[offset + j])
+								{
+									disjoint = false;
+									break;
+								}
+								allocated[offset + j] = true;
+							}
+							allocations.push_back({ offset, count });
+							allocatedCount += count;
+						}
+					}
+
+					countsMatch = countsMatch && freeRanges.GetFreeCount() == capacity - allocatedCount;
+				}
+
+				for (const std::pair<glm::uint, glm::uint>& allocation : allocations)
+				{
+					freeRanges.Free(allocation.first, allocation.second);
+				}
+
+				Check(disjoint, "allocated ranges never overlap or exceed the capacity");
+				Check(countsMatch, "free count tracks allocations");
+				Check(freeRanges.GetFreeCount() == capacity && freeRanges.GetFreeRangeCount() == 1, "freeing everything merges back into one range");
+
+				// Freed ranges only satisfy larger allocations once their neighbours are freed too
+				freeRanges.Reset(256);
+				glm::uint offsets[4];
+				for (glm::uint& offset : offsets)
+				{
+					freeRanges.Allocate(64, offset);
+				}
+				freeRanges.Free(offsets[0], 64);
+				freeRanges.Free(offsets[2], 64);
+				glm::uint offset;
+				Check(!freeRanges.Allocate(100, offset), "fragmented space can't satisfy a larger allocation");
+				freeRanges.Free(offsets[1], 64);
+				Check(freeRanges.Allocate(192, offset) && offset == 0, "freeing the range between two free ones merges all three");
+			}
+		} // namespace
+
+		void RunFreeRangeListTests()
+		{
+			Run("Free range list", TestFreeRangeList);
+		}
+	} // namespace UnitTests
+} // namespace flex
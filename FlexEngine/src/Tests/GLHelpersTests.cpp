@@ -0,0 +1,112 @@
+#include "stdafx.hpp"
+#if COMPILE_OPEN_GL
+
+#include "UnitTests.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "Graphics/GL/GLHelpers.hpp"
+
+namespace flex
+{
+	namespace UnitTests
+	{
+		namespace
+		{
+			void TestRadixSortDrawList()
+			{
+				std::mt19937_64 random(11);
+				const glm::uint count = 5000;
+				std::vector<gl::GLRenderObject> renderObjects(count);
+
+				// Fully random keys, keys which only differ in a few bytes (as most draw lists do) & many duplicates
+				const std::function<glm::uint64()> keyGenerators[] = {
+					[&random]() { return random(); },
+					[&random]() { return (3ull << 62) | (random() & 0xFF00FF); },
+					[&random]() { return random() % 7; },
+				};
+
+				bool sorted = true;
+				for (const std::function<glm::uint64()>& generateKey : keyGenerators)
+				{
+					std::vector<gl::DrawListEntry> entries(count);
+					for (glm::uint i = 0; i < count; ++i)
+					{
+						entries[i] = { generateKey(), &renderObjects[i] };
+					}
+
+					// Stable, so entries with equal keys keep their order
+					std::vector<gl::DrawListEntry> expected = entries;
+					std::stable_sort(expected.begin(), expected.end(), [](const gl::DrawListEntry& a, const gl::DrawListEntry& b)
+					{
+						return a.sortKey < b.sortKey;
+					});
+
+					std::vector<gl::DrawListEntry> scratch;
+					gl::RadixSortDrawList(entries, scratch);
+
+					for (glm::uint i = 0; i < count; ++i)
+					{
+						if (entries[i].sortKey != expected[i].sortKey || entries[i].renderObject != expected[i].renderObject)
+						{
+							sorted = false;
+						}
+					}
+				}
+				Check(sorted, "draw list radix sort matches a stable sort by key");
+			}
+
+			void TestSelectVAOForShader()
+			{
+				// Stands in for GLRenderer's per pool, per shader VAOs
+				std::map<std::pair<glm::uint, ShaderID>, glm::uint> poolVAOs;
+				glm::uint VAOLookupCount = 0;
+				const auto getPoolVAO = [&poolVAOs, &VAOLookupCount](glm::uint poolIndex, ShaderID shaderID)
+				{
+					++VAOLookupCount;
+					auto iter = poolVAOs.insert({ { poolIndex, shaderID }, 100 + (glm::uint)poolVAOs.size() }).first;
+					return iter->second;
+				};
+
+				const ShaderID pbrShaderID = 1;
+				const ShaderID colorShaderID = 2;
+
+				gl::GLRenderObject pooledObject;
+				pooledObject.geometryPool = 0;
+				pooledObject.VAO = getPoolVAO(0, pbrShaderID);
+				const glm::uint pbrVAO = pooledObject.VAO;
+				VAOLookupCount = 0;
+
+				Check(!gl::SelectVAOForShader(pooledObject, pbrShaderID, pbrShaderID, getPoolVAO) && pooledObject.VAO == pbrVAO && VAOLookupCount == 0,
+					"keeping the shader keeps the pooled object's VAO & attributes");
+
+				const bool describeAgain = gl::SelectVAOForShader(pooledObject, pbrShaderID, colorShaderID, getPoolVAO);
+				Check(describeAgain, "switching the shader of a pooled object describes its attributes again");
+				Check(pooledObject.VAO == poolVAOs[{ 0, colorShaderID }] && pooledObject.VAO != pbrVAO,
+					"switching the shader of a pooled object moves it to the pool's VAO for the new shader");
+
+				gl::SelectVAOForShader(pooledObject, colorShaderID, pbrShaderID, getPoolVAO);
+				Check(pooledObject.VAO == pbrVAO, "switching a pooled object back reuses the pool's VAO for its first shader");
+
+				gl::GLRenderObject unpooledObject;
+				unpooledObject.VAO = 7;
+				VAOLookupCount = 0;
+				Check(gl::SelectVAOForShader(unpooledObject, pbrShaderID, colorShaderID, getPoolVAO) && unpooledObject.VAO == 7 && VAOLookupCount == 0,
+					"objects outside pools keep their own VAO but describe their attributes again");
+			}
+		} // namespace
+
+		void RunGLHelpersTests()
+		{
+			Run("Draw list radix sort", TestRadixSortDrawList);
+			Run("VAO selection on shader change", TestSelectVAOForShader);
+		}
+	} // namespace UnitTests
+} // namespace flex
+
+#endif // COMPILE_OPEN_GL
@@ -0,0 +1,321 @@
+#include "stdafx.hpp"
+
+#include "UnitTests.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <glm/geometric.hpp>
+#include <glm/vec3.hpp>
+
+#include "MeshOptimizer.hpp"
+
+namespace flex
+{
+	namespace UnitTests
+	{
+		namespace
+		{
+			struct TestMesh
+			{
+				std::vector<glm::vec3> positions;
+				std::vector<glm::uint> indices;
+			};
+
+			// (size + 1)^2 vertices spaced one unit apart on the XY plane & displaced along Z by height, two triangles per cell facing +Z
+			TestMesh CreateGridMesh(glm::uint size, const std::function<float(float x, float y)>& height)
+			{
+				TestMesh mesh;
+				for (glm::uint y = 0; y <= size; ++y)
+				{
+					for (glm::uint x = 0; x <= size; ++x)
+					{
+						mesh.positions.push_back(glm::vec3((float)x, (float)y, height((float)x, (float)y)));
+					}
+				}
+
+				for (glm::uint y = 0; y < size; ++y)
+				{
+					for (glm::uint x = 0; x < size; ++x)
+					{
+						const glm::uint i0 = y * (size + 1) + x;
+						const glm::uint i1 = i0 + 1;
+						const glm::uint i2 = i0 + size + 1;
+						const glm::uint i3 = i2 + 1;
+						mesh.indices.insert(mesh.indices.end(), { i0, i1, i3, i0, i3, i2 });
+					}
+				}
+
+				return mesh;
+			}
+
+			float FlatHeight(float, float)
+			{
+				return 0.0f;
+			}
+
+			float BumpyHeight(float x, float y)
+			{
+				return 2.0f * std::sin(x * 0.3f) * std::cos(y * 0.2f);
+			}
+
+			void ShuffleTriangles(std::vector<glm::uint>& indices, glm::uint seed)
+			{
+				std::vector<std::array<glm::uint, 3>> triangles(indices.size() / 3);
+				memcpy(triangles.data(), indices.data(), sizeof(glm::uint) * indices.size());
+				std::shuffle(triangles.begin(), triangles.end(), std::mt19937(seed));
+				memcpy(indices.data(), triangles.data(), sizeof(glm::uint) * indices.size());
+			}
+
+			// Each triangle rotated to start at its smallest index, which keeps its winding, then sorted
+			std::vector<std::array<glm::uint, 3>> GetCanonicalTriangles(const std::vector<glm::uint>& indices)
+			{
+				std::vector<std::array<glm::uint, 3>> triangles;
+				triangles.reserve(indices.size() / 3);
+				for (size_t i = 0; i + 2 < indices.size(); i += 3)
+				{
+					std::array<glm::uint, 3> triangle = { indices[i], indices[i + 1], indices[i + 2] };
+					std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()), triangle.end());
+					triangles.push_back(triangle);
+				}
+				std::sort(triangles.begin(), triangles.end());
+				return triangles;
+			}
+
+			void TestOptimizeVertexCache()
+			{
+				TestMesh mesh = CreateGridMesh(64, FlatHeight);
+				const glm::uint vertexCount = (glm::uint)mesh.positions.size();
+				ShuffleTriangles(mesh.indices, 1);
+
+				const std::vector<std::array<glm::uint, 3>> triangles = GetCanonicalTriangles(mesh.indices);
+				const VertexCacheStatistics before = AnalyzeVertexCache(mesh.indices, vertexCount);
+
+				OptimizeVertexCache(mesh.indices, vertexCount);
+				const VertexCacheStatistics after = AnalyzeVertexCache(mesh.indices, vertexCount);
+
+				Check(GetCanonicalTriangles(mesh.indices) == triangles, "vertex cache optimization keeps every triangle & its winding");
+				Check(after.ACMR < before.ACMR * 0.5f, "vertex cache optimization at least halves a shuffled grid's ACMR (" +
+					std::to_string(before.ACMR) + " -> " + std::to_string(after.ACMR) + ")");
+				Check(after.ACMR <= 0.8f, "optimized grid's ACMR is at most 0.8 (" + std::to_string(after.ACMR) + ")");
+
+				OptimizeOverdraw(mesh.indices, mesh.positions.data(), vertexCount, sizeof(glm::vec3));
+				const VertexCacheStatistics afterOverdraw = AnalyzeVertexCache(mesh.indices, vertexCount);
+				Check(GetCanonicalTriangles(mesh.indices) == triangles, "overdraw optimization keeps every triangle & its winding");
+				Check(afterOverdraw.ACMR <= after.ACMR * 1.1f, "overdraw optimization keeps most of the vertex cache locality (" +
+					std::to_string(after.ACMR) + " -> " + std::to_string(afterOverdraw.ACMR) + ")");
+			}
+
+			void TestOptimizeVertexFetch()
+			{
+				TestMesh mesh = CreateGridMesh(16, BumpyHeight);
+				ShuffleTriangles(mesh.indices, 2);
+
+				// Vertices which no triangle references are removed
+				const glm::uint referencedVertexCount = (glm::uint)mesh.positions.size();
+				mesh.positions.push_back(glm::vec3(-1.0f));
+				mesh.positions.insert(mesh.positions.begin(), glm::vec3(-2.0f));
+				for (glm::uint& index : mesh.indices)
+				{
+					++index;
+				}
+
+				std::vector<glm::vec3> cornerPositions;
+				for (glm::uint index : mesh.indices)
+				{
+					cornerPositions.push_back(mesh.positions[index]);
+				}
+
+				const glm::uint vertexCount = OptimizeVertexFetch(mesh.indices, mesh.positions.data(), (glm::uint)mesh.positions.size(), sizeof(glm::vec3));
+				Check(vertexCount == referencedVertexCount, "vertex fetch optimization removes unreferenced vertices");
+
+				bool cornersMatch = true;
+				glm::uint nextNewVertex = 0;
+				bool firstReferenceOrder = true;
+				for (size_t i = 0; i < mesh.indices.size(); ++i)
+				{
+					const glm::uint index = mesh.indices[i];
+					if (index >= vertexCount || mesh.positions[index] != cornerPositions[i])
+					{
+						cornersMatch = false;
+					}
+
+					if (index == nextNewVertex)
+					{
+						++nextNewVertex;
+					}
+					else if (index > nextNewVertex)
+					{
+						firstReferenceOrder = false;
+					}
+				}
+				Check(cornersMatch, "vertex fetch optimization remaps indices to the same vertex data");
+				Check(firstReferenceOrder, "vertices are stored in the order they're first referenced");
+			}
+
+			void TestSimplifyMesh()
+			{
+				const glm::uint size = 32;
+				const TestMesh flat = CreateGridMesh(size, FlatHeight);
+				const glm::uint vertexCount = (glm::uint)flat.positions.size();
+
+				// Collapses on a plane are free, so a quarter of the triangles must be reachable with no error at all
+				const size_t targetIndexCount = flat.indices.size() / 4;
+				std::vector<glm::uint> lod;
+				const float error = SimplifyMesh(flat.indices, flat.positions.data(), vertexCount, sizeof(glm::vec3), targetIndexCount, 0.01f, lod);
+
+				Check(!lod.empty() && lod.size() % 3 == 0, "simplified mesh is a non-empty triangle list");
+				Check(lod.size() <= targetIndexCount, "flat grid simplifies to its target (" + std::to_string(lod.size()) + " of " +
+					std::to_string(targetIndexCount) + " indices)");
+				Check(error <= 0.01f, "simplification error stays within the limit");
+
+				bool validTriangles = true;
+				bool facingUp = true;
+				std::set<glm::uint> referencedVertices;
+				for (size_t i = 0; i + 2 < lod.size(); i += 3)
+				{
+					const glm::uint a = lod[i];
+					const glm::uint b = lod[i + 1];
+					const glm::uint c = lod[i + 2];
+					if (a >= vertexCount || b >= vertexCount || c >= vertexCount || a == b || b == c || a == c)
+					{
+						validTriangles = false;
+						continue;
+					}
+					referencedVertices.insert({ a, b, c });
+
+					const glm::vec3 normal = glm::cross(flat.positions[b] - flat.positions[a], flat.positions[c] - flat.positions[a]);
+					if (normal.z <= 0.0f)
+					{
+						facingUp = false;
+					}
+				}
+				Check(validTriangles, "simplified triangles reference valid & distinct vertices");
+				Check(facingUp, "simplification never flips triangles");
+
+				// Border vertices are never collapsed, so the outline stays intact
+				bool bordersKept = true;
+				for (glm::uint i = 0; i <= size; ++i)
+				{
+					const glm::uint borderVertices[] = { i, size * (size + 1) + i, i * (size + 1), i * (size + 1) + size };
+					for (glm::uint vertex : borderVertices)
+					{
+						if (referencedVertices.find(vertex) == referencedVertices.end())
+						{
+							bordersKept = false;
+						}
+					}
+				}
+				Check(bordersKept, "every border vertex is kept");
+
+				// Curved surfaces stop simplifying once every remaining collapse would exceed the limit
+				const TestMesh bumpy = CreateGridMesh(size, BumpyHeight);
+				std::vector<glm::uint> bumpyLOD;
+				const float maxError = 0.05f;
+				const float bumpyError = SimplifyMesh(bumpy.indices, bumpy.positions.data(), vertexCount, sizeof(glm::vec3), 0, maxError, bumpyLOD);
+				Check(bumpyError <= maxError, "curved simplification error stays within the limit (" + std::to_string(bumpyError) + ")");
+				Check(!bumpyLOD.empty() && bumpyLOD.size() < bumpy.indices.size(), "curved grid is simplified, but not entirely");
+			}
+
+			void TestBuildMeshlets()
+			{
+				TestMesh mesh = CreateGridMesh(48, BumpyHeight);
+				const glm::uint vertexCount = (glm::uint)mesh.positions.size();
+				OptimizeVertexCache(mesh.indices, vertexCount);
+				const std::vector<std::array<glm::uint, 3>> triangles = GetCanonicalTriangles(mesh.indices);
+
+				const glm::uint maxVertices = 64;
+				const glm::uint maxTriangles = 124;
+				std::vector<Meshlet> meshlets;
+				BuildMeshlets(mesh.indices, mesh.positions.data(), vertexCount, sizeof(glm::vec3), meshlets, maxVertices, maxTriangles);
+
+				Check(GetCanonicalTriangles(mesh.indices) == triangles, "meshlet building keeps every triangle & its winding");
+				Check(!meshlets.empty(), "meshlets were built");
+
+				bool contiguous = true;
+				bool withinLimits = true;
+				bool spheresBound = true;
+				bool conesCull = true;
+				glm::uint nextIndex = 0;
+				glm::uint cullableMeshletCount = 0;
+				for (const Meshlet& meshlet : meshlets)
+				{
+					if (meshlet.firstIndex != nextIndex || meshlet.indexCount == 0 || meshlet.indexCount % 3 != 0)
+					{
+						contiguous = false;
+					}
+					nextIndex = meshlet.firstIndex + meshlet.indexCount;
+					if (nextIndex > mesh.indices.size())
+					{
+						contiguous = false;
+						break;
+					}
+
+					std::set<glm::uint> uniqueVertices(mesh.indices.begin() + meshlet.firstIndex, mesh.indices.begin() + nextIndex);
+					if (uniqueVertices.size() > maxVertices || meshlet.indexCount / 3 > maxTriangles)
+					{
+						withinLimits = false;
+					}
+
+					for (glm::uint vertex : uniqueVertices)
+					{
+						if (glm::length(mesh.positions[vertex] - meshlet.center) > meshlet.radius + 1e-3f)
+						{
+							spheresBound = false;
+						}
+					}
+
+					if (meshlet.coneCutoff >= 1.0f)
+					{
+						continue;
+					}
+					++cullableMeshletCount;
+
+					// Viewers anywhere in the cone behind the apex must see the back of every triangle
+					const float coneAngle = std::acos(glm::clamp(meshlet.coneCutoff, -1.0f, 1.0f));
+					const glm::vec3 perpendicular = glm::normalize(glm::cross(meshlet.coneAxis,
+						std::abs(meshlet.coneAxis.x) < 0.9f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f)));
+					for (float angleFraction : { 0.0f, 0.5f, 0.95f })
+					{
+						const float angle = coneAngle * angleFraction;
+						const glm::vec3 direction = meshlet.coneAxis * std::cos(angle) + perpendicular * std::sin(angle);
+						for (float distance : { 0.1f, 10.0f, 1000.0f })
+						{
+							const glm::vec3 viewer = meshlet.coneApex - direction * distance;
+							for (glm::uint i = meshlet.firstIndex; i < nextIndex; i += 3)
+							{
+								const glm::vec3& p0 = mesh.positions[mesh.indices[i]];
+								const glm::vec3 normal = glm::cross(mesh.positions[mesh.indices[i + 1]] - p0, mesh.positions[mesh.indices[i + 2]] - p0);
+								if (glm::dot(normal, p0 - viewer) < -1e-3f * glm::length(normal))
+								{
+									conesCull = false;
+								}
+							}
+						}
+					}
+				}
+
+				Check(contiguous && nextIndex == mesh.indices.size(), "meshlets are contiguous & cover every index");
+				Check(withinLimits, "meshlets respect their vertex & triangle limits");
+				Check(spheresBound, "meshlets' bounding spheres contain all of their vertices");
+				Check(cullableMeshletCount > 0, "gently curved meshlets have normal cones");
+				Check(conesCull, "triangles are back facing to every viewer within their meshlet's cone");
+			}
+		} // namespace
+
+		void RunMeshOptimizerTests()
+		{
+			Run("Vertex cache & overdraw optimization", TestOptimizeVertexCache);
+			Run("Vertex fetch optimization", TestOptimizeVertexFetch);
+			Run("LOD simplification", TestSimplifyMesh);
+			Run("Meshlets", TestBuildMeshlets);
+		}
+	} // namespace UnitTests
+} // namespace flex
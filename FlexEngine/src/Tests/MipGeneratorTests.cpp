@@ -0,0 +1,252 @@
+#include "stdafx.hpp"
+
+#include "UnitTests.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "MipGenerator.hpp"
+
+namespace flex
+{
+	namespace UnitTests
+	{
+		namespace
+		{
+			std::vector<unsigned char> CreateConstantImage(glm::uint width, glm::uint height, const unsigned char color[4])
+			{
+				std::vector<unsigned char> pixels((size_t)width * height * 4);
+				for (size_t i = 0; i < pixels.size(); ++i)
+				{
+					pixels[i] = color[i % 4];
+				}
+				return pixels;
+			}
+
+			// Sum of every channel of every pixel, divided by the pixel count
+			float GetAverage(const std::vector<float>& level)
+			{
+				double sum = 0.0;
+				for (float value : level)
+				{
+					sum += value;
+				}
+				return (float)(sum / (level.size() / 4));
+			}
+
+			void TestCalculateMipCount()
+			{
+				Check(CalculateMipCount(1, 1) == 1, "1x1 image has one level");
+				Check(CalculateMipCount(16, 16) == 5, "16x16 image has five levels");
+				Check(CalculateMipCount(16, 8) == 5, "16x8 image is as deep as its largest side");
+				Check(CalculateMipCount(17, 5) == 5, "17x5 image rounds its sizes down");
+				Check(CalculateMipCount(1, 1024) == 11, "1x1024 image goes down to 1x1");
+			}
+
+			void TestMipChainSizes()
+			{
+				const glm::uint width = 13;
+				const glm::uint height = 6;
+
+				std::mt19937 random(11);
+				std::uniform_int_distribution<int> byteDistribution(0, 255);
+				std::vector<unsigned char> pixels((size_t)width * height * 4);
+				for (unsigned char& value : pixels)
+				{
+					value = (unsigned char)byteDistribution(random);
+				}
+
+				const MipFilter filters[] = { MipFilter::BOX, MipFilter::KAISER };
+				for (MipFilter filter : filters)
+				{
+					const std::string filterName = (filter == MipFilter::BOX ? "box" : "Kaiser");
+
+					MipGenerationSettings settings = {};
+					settings.filter = filter;
+					std::vector<std::vector<unsigned char>> levels;
+					GenerateMipChain(pixels.data(), width, height, settings, levels);
+
+					Check(levels.size() == CalculateMipCount(width, height), filterName + " chain has every level");
+					Check(!levels.empty() && levels[0] == pixels, filterName + " chain's first level is a copy of the image");
+
+					bool sizesMatch = true;
+					glm::uint levelWidth = width;
+					glm::uint levelHeight = height;
+					for (const std::vector<unsigned char>& level : levels)
+					{
+						sizesMatch = sizesMatch && level.size() == (size_t)levelWidth * levelHeight * 4;
+						levelWidth = std::max(levelWidth / 2, 1u);
+						levelHeight = std::max(levelHeight / 2, 1u);
+					}
+					Check(sizesMatch, filterName + " levels halve in size down to 1x1");
+				}
+
+				MipGenerationSettings noFilterSettings = {};
+				noFilterSettings.filter = MipFilter::NONE;
+				std::vector<std::vector<unsigned char>> levels;
+				GenerateMipChain(pixels.data(), width, height, noFilterSettings, levels);
+				Check(levels.size() == 1 && levels[0] == pixels, "no filter only copies the image");
+			}
+
+			void TestConstantImageStaysConstant()
+			{
+				const glm::uint width = 20;
+				const glm::uint height = 12;
+				const unsigned char color[4] = { 200, 90, 17, 128 };
+				const std::vector<unsigned char> pixels = CreateConstantImage(width, height, color);
+
+				const MipFilter filters[] = { MipFilter::BOX, MipFilter::KAISER };
+				for (MipFilter filter : filters)
+				{
+					for (glm::uint sRGB = 0; sRGB < 2; ++sRGB)
+					{
+						MipGenerationSettings settings = {};
+						settings.filter = filter;
+						settings.sRGB = (sRGB != 0);
+						std::vector<std::vector<unsigned char>> levels;
+						GenerateMipChain(pixels.data(), width, height, settings, levels);
+
+						// Converting to linear & back may round each channel by one step
+						int maxError = 0;
+						for (const std::vector<unsigned char>& level : levels)
+						{
+							for (size_t i = 0; i < level.size(); ++i)
+							{
+								maxError = std::max(maxError, std::abs((int)level[i] - (int)color[i % 4]));
+							}
+						}
+						Check(maxError <= 1, std::string(filter == MipFilter::BOX ? "box" : "Kaiser") + (sRGB ? " sRGB" : " linear") +
+							" filtered constant image stays constant (max error " + std::to_string(maxError) + ")");
+					}
+				}
+
+				// Float images aren't clamped to [0, 1], so HDR values must survive
+				const float hdrColor[4] = { 3.5f, 0.25f, 12.0f, 1.0f };
+				std::vector<float> hdrPixels((size_t)width * height * 4);
+				for (size_t i = 0; i < hdrPixels.size(); ++i)
+				{
+					hdrPixels[i] = hdrColor[i % 4];
+				}
+
+				MipGenerationSettings settings = {};
+				std::vector<std::vector<float>> levels;
+				GenerateMipChain(hdrPixels.data(), width, height, settings, levels);
+
+				float maxError = 0.0f;
+				for (const std::vector<float>& level : levels)
+				{
+					for (size_t i = 0; i < level.size(); ++i)
+					{
+						maxError = std::max(maxError, std::abs(level[i] - hdrColor[i % 4]));
+					}
+				}
+				Check(levels.size() == CalculateMipCount(width, height) && maxError < 1e-4f, "Kaiser filtered constant HDR image stays constant");
+			}
+
+			void TestNormalMapLevelsStayNormalized()
+			{
+				const glm::uint width = 32;
+				const glm::uint height = 32;
+
+				std::mt19937 random(5);
+				std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+				std::vector<unsigned char> pixels((size_t)width * height * 4);
+				for (size_t i = 0; i < pixels.size(); i += 4)
+				{
+					// Tangent space normals all point away from the surface
+					float x = distribution(random);
+					float y = distribution(random);
+					float z = 0.5f + 0.5f * std::abs(distribution(random));
+					const float length = std::sqrt(x * x + y * y + z * z);
+					x /= length;
+					y /= length;
+					z /= length;
+
+					pixels[i + 0] = (unsigned char)((x * 0.5f + 0.5f) * 255.0f + 0.5f);
+					pixels[i + 1] = (unsigned char)((y * 0.5f + 0.5f) * 255.0f + 0.5f);
+					pixels[i + 2] = (unsigned char)((z * 0.5f + 0.5f) * 255.0f + 0.5f);
+					pixels[i + 3] = 255;
+				}
+
+				MipGenerationSettings settings = {};
+				settings.normalMap = true;
+				std::vector<std::vector<unsigned char>> levels;
+				GenerateMipChain(pixels.data(), width, height, settings, levels);
+
+				// Averaging unit vectors shortens them, only 8 bit quantization may remain
+				float maxError = 0.0f;
+				for (size_t mip = 1; mip < levels.size(); ++mip)
+				{
+					const std::vector<unsigned char>& level = levels[mip];
+					for (size_t i = 0; i < level.size(); i += 4)
+					{
+						const float x = level[i + 0] / 255.0f * 2.0f - 1.0f;
+						const float y = level[i + 1] / 255.0f * 2.0f - 1.0f;
+						const float z = level[i + 2] / 255.0f * 2.0f - 1.0f;
+						maxError = std::max(maxError, std::abs(std::sqrt(x * x + y * y + z * z) - 1.0f));
+					}
+				}
+				Check(levels.size() == CalculateMipCount(width, height) && maxError < 0.02f,
+					"normal map levels stay normalized (max error " + std::to_string(maxError) + ")");
+			}
+
+			void TestBoxFilterPreservesAverage()
+			{
+				const glm::uint width = 16;
+				const glm::uint height = 8;
+
+				std::mt19937 random(3);
+				std::uniform_real_distribution<float> distribution(0.0f, 4.0f);
+				std::vector<float> pixels((size_t)width * height * 4);
+				for (float& value : pixels)
+				{
+					value = distribution(random);
+				}
+
+				MipGenerationSettings settings = {};
+				settings.filter = MipFilter::BOX;
+				std::vector<std::vector<float>> levels;
+				GenerateMipChain(pixels.data(), width, height, settings, levels);
+
+				const float average = GetAverage(levels[0]);
+				bool averagesMatch = true;
+				for (const std::vector<float>& level : levels)
+				{
+					averagesMatch = averagesMatch && std::abs(GetAverage(level) - average) < 1e-4f * average;
+				}
+				Check(averagesMatch, "box filtered levels keep the image's average");
+
+				// Each pixel of a power of two image is the average of the 2x2 square above it
+				bool squaresMatch = levels.size() > 1;
+				for (glm::uint y = 0; squaresMatch && y < height / 2; ++y)
+				{
+					for (glm::uint x = 0; x < width / 2; ++x)
+					{
+						for (glm::uint c = 0; c < 4; ++c)
+						{
+							const float expected = 0.25f * (
+								pixels[((size_t)(y * 2 + 0) * width + x * 2 + 0) * 4 + c] +
+								pixels[((size_t)(y * 2 + 0) * width + x * 2 + 1) * 4 + c] +
+								pixels[((size_t)(y * 2 + 1) * width + x * 2 + 0) * 4 + c] +
+								pixels[((size_t)(y * 2 + 1) * width + x * 2 + 1) * 4 + c]);
+							squaresMatch = squaresMatch && std::abs(levels[1][((size_t)y * (width / 2) + x) * 4 + c] - expected) < 1e-5f;
+						}
+					}
+				}
+				Check(squaresMatch, "box filter averages each 2x2 square");
+			}
+		} // namespace
+
+		void RunMipGeneratorTests()
+		{
+			Run("Mip counts", TestCalculateMipCount);
+			Run("Mip chain sizes", TestMipChainSizes);
+			Run("Constant image mips", TestConstantImageStaysConstant);
+			Run("Normal map mips", TestNormalMapLevelsStayNormalized);
+			Run("Box filtered mips", TestBoxFilterPreservesAverage);
+		}
+	} // namespace UnitTests
+} // namespace flex
@@ -0,0 +1,469 @@
+#include "stdafx.hpp"
+
+#include "UnitTests.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <glm/gtc/packing.hpp>
+
+#include "TextureCompression.hpp"
+
+namespace flex
+{
+	namespace UnitTests
+	{
+		namespace
+		{
+			// Interpolation weights (out of 64) of every 4 bit index mode of BC6H & BC7
+			const int WEIGHTS_4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+			// Reads values from a 128 bit block starting at the least significant bit
+			class BlockReader
+			{
+			public:
+				explicit BlockReader(const unsigned char* bytes) :
+					m_Bytes(bytes)
+				{
+				}
+
+				glm::uint Read(glm::uint bitCount)
+				{
+					glm::uint value = 0;
+					for (glm::uint i = 0; i < bitCount; ++i, ++m_Position)
+					{
+						value |= (glm::uint)((m_Bytes[m_Position / 8] >> (m_Position % 8)) & 1) << i;
+					}
+					return value;
+				}
+
+			private:
+				const unsigned char* m_Bytes;
+				glm::uint m_Position = 0;
+			};
+
+			// The decoders below follow the formats' specifications rather than sharing code with the encoders,
+			// so mistakes in either's bit layout show up as round trip failures
+
+			void DecodeBC4Block(const unsigned char* block, float values[16])
+			{
+				const float red0 = block[0];
+				const float red1 = block[1];
+
+				float palette[8] = { red0, red1 };
+				if (block[0] > block[1])
+				{
+					for (glm::uint i = 2; i < 8; ++i)
+					{
+						palette[i] = ((8 - i) * red0 + (i - 1) * red1) / 7.0f;
+					}
+				}
+				else
+				{
+					for (glm::uint i = 2; i < 6; ++i)
+					{
+						palette[i] = ((6 - i) * red0 + (i - 1) * red1) / 5.0f;
+					}
+					palette[6] = 0.0f;
+					palette[7] = 255.0f;
+				}
+
+				glm::uint64 indices = 0;
+				for (glm::uint i = 0; i < 6; ++i)
+				{
+					indices |= (glm::uint64)block[2 + i] << (8 * i);
+				}
+
+				for (glm::uint i = 0; i < 16; ++i)
+				{
+					values[i] = palette[(indices >> (3 * i)) & 7];
+				}
+			}
+
+			// Only mode 6, the one CompressImage writes. Returns false for blocks in any other mode
+			bool DecodeBC7Block(const unsigned char* block, int pixels[16][4])
+			{
+				BlockReader reader(block);
+				if (reader.Read(7) != (1u << 6))
+				{
+					return false;
+				}
+
+				int endpoints[2][4];
+				for (glm::uint c = 0; c < 4; ++c)
+				{
+					endpoints[0][c] = (int)reader.Read(7);
+					endpoints[1][c] = (int)reader.Read(7);
+				}
+				for (glm::uint e = 0; e < 2; ++e)
+				{
+					const int pBit = (int)reader.Read(1);
+					for (glm::uint c = 0; c < 4; ++c)
+					{
+						endpoints[e][c] = (endpoints[e][c] << 1) | pBit;
+					}
+				}
+
+				for (glm::uint i = 0; i < 16; ++i)
+				{
+					const int weight = WEIGHTS_4[reader.Read(i == 0 ? 3 : 4)];
+					for (glm::uint c = 0; c < 4; ++c)
+					{
+						pixels[i][c] = ((64 - weight) * endpoints[0][c] + weight * endpoints[1][c] + 32) >> 6;
+					}
+				}
+
+				return true;
+			}
+
+			int UnquantizeBC6HUF16(int value)
+			{
+				if (value == 0) return 0;
+				if (value == 1023) return 0xFFFF;
+				return ((value << 16) + 0x8000) >> 10;
+			}
+
+			// Only mode 11 (one region, 10 bit endpoints), the one CompressImage writes. Returns false for blocks in any other mode
+			bool DecodeBC6HBlock(const unsigned char* block, float pixels[16][3])
+			{
+				BlockReader reader(block);
+				if (reader.Read(5) != 0x03)
+				{
+					return false;
+				}
+
+				int endpoints[2][3];
+				for (glm::uint e = 0; e < 2; ++e)
+				{
+					for (glm::uint c = 0; c < 3; ++c)
+					{
+						endpoints[e][c] = UnquantizeBC6HUF16((int)reader.Read(10));
+					}
+				}
+
+				for (glm::uint i = 0; i < 16; ++i)
+				{
+					const int weight = WEIGHTS_4[reader.Read(i == 0 ? 3 : 4)];
+					for (glm::uint c = 0; c < 3; ++c)
+					{
+						const int interpolated = ((64 - weight) * endpoints[0][c] + weight * endpoints[1][c] + 32) >> 6;
+						pixels[i][c] = glm::unpackHalf1x16((glm::uint16)((interpolated * 31) >> 6));
+					}
+				}
+
+				return true;
+			}
+
+			// Position of pixel i of the block starting at (blockX, blockY), or false when it hangs over the image's edge
+			bool GetBlockPixel(glm::uint blockX, glm::uint blockY, glm::uint i, glm::uint width, glm::uint height, size_t& outPixelIndex)
+			{
+				const glm::uint x = blockX * 4 + i % 4;
+				const glm::uint y = blockY * 4 + i / 4;
+				outPixelIndex = (size_t)y * width + x;
+				return x < width && y < height;
+			}
+
+			std::vector<unsigned char> CreateSmoothImage(glm::uint width, glm::uint height)
+			{
+				std::vector<unsigned char> pixels((size_t)width * height * 4);
+				for (glm::uint y = 0; y < height; ++y)
+				{
+					for (glm::uint x = 0; x < width; ++x)
+					{
+						unsigned char* pixel = &pixels[((size_t)y * width + x) * 4];
+						pixel[0] = (unsigned char)(x * 255 / std::max(width - 1, 1u));
+						pixel[1] = (unsigned char)(y * 255 / std::max(height - 1, 1u));
+						pixel[2] = (unsigned char)(127.5f + 127.5f * std::sin(x * 0.2f) * std::cos(y * 0.15f));
+						pixel[3] = (unsigned char)(255 - pixel[0] / 2);
+					}
+				}
+				return pixels;
+			}
+
+			void TestBlockCompressedImageSizes()
+			{
+				Check(GetBlockCompressedImageSize(BlockCompressionFormat::BC4, 1, 1) == 8, "1x1 BC4 image is one block");
+				Check(GetBlockCompressedImageSize(BlockCompressionFormat::BC7, 6, 6) == 4 * 16, "6x6 BC7 image is 2x2 blocks");
+				Check(GetBlockCompressedImageSize(BlockCompressionFormat::BC6H, 16, 8) == 8 * 16, "16x8 BC6H image is 4x2 blocks");
+				Check(GetBlockCompressedImageSize(BlockCompressionFormat::BC5, 4, 4) == 16, "4x4 BC5 image is one block");
+			}
+
+			void TestBC4RoundTrip()
+			{
+				std::mt19937 random(4);
+				std::uniform_int_distribution<int> byteDistribution(0, 255);
+
+				const glm::uint width = 32;
+				const glm::uint height = 32;
+				std::vector<unsigned char> pixels((size_t)width * height * 4);
+				for (glm::uint y = 0; y < height; ++y)
+				{
+					for (glm::uint x = 0; x < width; ++x)
+					{
+						unsigned char* pixel = &pixels[((size_t)y * width + x) * 4];
+						const glm::uint blockIndex = (y / 4) * (width / 4) + x / 4;
+						switch (blockIndex % 3)
+						{
+						case 0: pixel[0] = (unsigned char)(blockIndex * 7); break; // Constant
+						case 1: pixel[0] = (unsigned char)byteDistribution(random); break; // Noise
+						default: pixel[0] = (unsigned char)((x % 4) * 40 + (y % 4) * 10 + blockIndex); break; // Gradient
+						}
+						pixel[1] = (unsigned char)(255 - pixel[0]);
+					}
+				}
+
+				std::vector<unsigned char> bc4(GetBlockCompressedImageSize(BlockCompressionFormat::BC4, width, height));
+				CompressImage(BlockCompressionFormat::BC4, pixels.data(), width, height, bc4.data());
+				std::vector<unsigned char> bc5(GetBlockCompressedImageSize(BlockCompressionFormat::BC5, width, height));
+				CompressImage(BlockCompressionFormat::BC5, pixels.data(), width, height, bc5.data());
+
+				bool constantBlocksExact = true;
+				bool withinTolerance = true;
+				bool bc5WithinTolerance = true;
+				for (glm::uint blockY = 0; blockY < height / 4; ++blockY)
+				{
+					for (glm::uint blockX = 0; blockX < width / 4; ++blockX)
+					{
+						const glm::uint blockIndex = blockY * (width / 4) + blockX;
+
+						float red[16];
+						float bc5Red[16];
+						float bc5Green[16];
+						DecodeBC4Block(&bc4[blockIndex * 8], red);
+						DecodeBC4Block(&bc5[blockIndex * 16], bc5Red);
+						DecodeBC4Block(&bc5[blockIndex * 16 + 8], bc5Green);
+
+						int minValue = 255;
+						int maxValue = 0;
+						for (glm::uint i = 0; i < 16; ++i)
+						{
+							size_t pixelIndex;
+							GetBlockPixel(blockX, blockY, i, width, height, pixelIndex);
+							minValue = std::min(minValue, (int)pixels[pixelIndex * 4]);
+							maxValue = std::max(maxValue, (int)pixels[pixelIndex * 4]);
+						}
+
+						// Eight evenly spaced levels between the block's extremes, so no value is further than half a step from one
+						const float tolerance = (maxValue - minValue) / 14.0f + 0.5f;
+						for (glm::uint i = 0; i < 16; ++i)
+						{
+							size_t pixelIndex;
+							GetBlockPixel(blockX, blockY, i, width, height, pixelIndex);
+							const float expectedRed = pixels[pixelIndex * 4];
+							const float expectedGreen = pixels[pixelIndex * 4 + 1];
+
+							if (minValue == maxValue && red[i] != expectedRed) constantBlocksExact = false;
+							if (std::abs(red[i] - expectedRed) > tolerance) withinTolerance = false;
+							if (std::abs(bc5Red[i] - expectedRed) > tolerance || std::abs(bc5Green[i] - expectedGreen) > tolerance) bc5WithinTolerance = false;
+						}
+					}
+				}
+
+				Check(constantBlocksExact, "constant BC4 blocks decode exactly");
+				Check(withinTolerance, "BC4 values decode within half a step of their block's eight levels");
+				Check(bc5WithinTolerance, "BC5 red & green decode within half a step of their block's eight levels");
+			}
+
+			void TestBC7RoundTrip()
+			{
+				std::mt19937 random(7);
+				std::uniform_int_distribution<int> byteDistribution(0, 255);
+
+				// Constant blocks only lose the bit which a shared p-bit can't match in every channel
+				bool constantBlocksDecoded = true;
+				for (glm::uint test = 0; test < 64; ++test)
+				{
+					unsigned char pixels[4 * 4 * 4];
+					const unsigned char color[4] = { (unsigned char)byteDistribution(random), (unsigned char)byteDistribution(random),
+						(unsigned char)byteDistribution(random), (unsigned char)byteDistribution(random) };
+					for (glm::uint i = 0; i < 16; ++i)
+					{
+						memcpy(&pixels[i * 4], color, 4);
+					}
+
+					unsigned char block[16];
+					CompressImage(BlockCompressionFormat::BC7, pixels, 4, 4, block);
+
+					int decoded[16][4];
+					if (!DecodeBC7Block(block, decoded))
+					{
+						constantBlocksDecoded = false;
+						continue;
+					}
+
+					for (glm::uint i = 0; i < 16; ++i)
+					{
+						for (glm::uint c = 0; c < 4; ++c)
+						{
+							if (std::abs(decoded[i][c] - color[c]) > 1) constantBlocksDecoded = false;
+						}
+					}
+				}
+				Check(constantBlocksDecoded, "constant BC7 blocks decode within one of their color");
+
+				// Smooth images (gradients, low frequency detail) are what a single region mode handles well
+				const glm::uint width = 64;
+				const glm::uint height = 48;
+				const std::vector<unsigned char> pixels = CreateSmoothImage(width, height);
+				std::vector<unsigned char> bc7(GetBlockCompressedImageSize(BlockCompressionFormat::BC7, width, height));
+				CompressImage(BlockCompressionFormat::BC7, pixels.data(), width, height, bc7.data());
+
+				bool allBlocksDecoded = true;
+				int maxError = 0;
+				double squaredErrorSum = 0.0;
+				for (glm::uint blockY = 0; blockY < height / 4; ++blockY)
+				{
+					for (glm::uint blockX = 0; blockX < width / 4; ++blockX)
+					{
+						int decoded[16][4];
+						if (!DecodeBC7Block(&bc7[(blockY * (width / 4) + blockX) * 16], decoded))
+						{
+							allBlocksDecoded = false;
+							continue;
+						}
+
+						for (glm::uint i = 0; i < 16; ++i)
+						{
+							size_t pixelIndex;
+							GetBlockPixel(blockX, blockY, i, width, height, pixelIndex);
+							for (glm::uint c = 0; c < 4; ++c)
+							{
+								const int error = std::abs(decoded[i][c] - (int)pixels[pixelIndex * 4 + c]);
+								maxError = std::max(maxError, error);
+								squaredErrorSum += error * error;
+							}
+						}
+					}
+				}
+
+				const double meanSquaredError = squaredErrorSum / ((double)width * height * 4);
+				const double psnr = 10.0 * std::log10(255.0 * 255.0 / std::max(meanSquaredError, 1e-6));
+				Check(allBlocksDecoded, "every BC7 block is written in mode 6");
+				Check(maxError <= 16, "smooth image's BC7 texels decode within 16 of their source (largest error " + std::to_string(maxError) + ")");
+				Check(psnr >= 36.0, "smooth image's BC7 PSNR is at least 36dB (" + std::to_string(psnr) + "dB)");
+
+				// Blocks hanging over the image's edge repeat the last row & column
+				const glm::uint edgeSize = 6;
+				const std::vector<unsigned char> edgePixels = CreateSmoothImage(edgeSize, edgeSize);
+				std::vector<unsigned char> edgeBC7(GetBlockCompressedImageSize(BlockCompressionFormat::BC7, edgeSize, edgeSize));
+				CompressImage(BlockCompressionFormat::BC7, edgePixels.data(), edgeSize, edgeSize, edgeBC7.data());
+
+				int cornerBlock[16][4];
+				const bool cornerDecoded = DecodeBC7Block(&edgeBC7[3 * 16], cornerBlock);
+				bool cornerMatches = cornerDecoded;
+				for (glm::uint i = 0; cornerDecoded && i < 16; ++i)
+				{
+					// Texels past the edge must match the edge texel they repeat
+					const glm::uint x = std::min(4 + i % 4, edgeSize - 1) - 4;
+					const glm::uint y = std::min(4 + i / 4, edgeSize - 1) - 4;
+					for (glm::uint c = 0; c < 4; ++c)
+					{
+						if (cornerBlock[i][c] != cornerBlock[y * 4 + x][c]) cornerMatches = false;
+					}
+				}
+				Check(cornerMatches, "BC7 blocks over the image's edge repeat its last row & column");
+			}
+
+			void TestBC6HRoundTrip()
+			{
+				std::mt19937 random(6);
+				std::uniform_real_distribution<float> exposureDistribution(-10.0f, 10.0f);
+				std::uniform_real_distribution<float> unitDistribution(0.0f, 1.0f);
+
+				// Decoded half floats are within roughly one part in 64 of every constant color, from very dark to very bright
+				bool constantBlocksDecoded = true;
+				float maxRelativeError = 0.0f;
+				for (glm::uint test = 0; test < 64; ++test)
+				{
+					const float exposure = std::exp2(exposureDistribution(random));
+					const float color[3] = { exposure * (0.1f + unitDistribution(random)), exposure * (0.1f + unitDistribution(random)),
+						exposure * (0.1f + unitDistribution(random)) };
+
+					float pixels[16 * 4];
+					for (glm::uint i = 0; i < 16; ++i)
+					{
+						memcpy(&pixels[i * 4], color, sizeof(color));
+						pixels[i * 4 + 3] = 1.0f;
+					}
+
+					unsigned char block[16];
+					CompressImage(BlockCompressionFormat::BC6H, pixels, 4, 4, block);
+
+					float decoded[16][3];
+					if (!DecodeBC6HBlock(block, decoded))
+					{
+						constantBlocksDecoded = false;
+						continue;
+					}
+
+					for (glm::uint i = 0; i < 16; ++i)
+					{
+						for (glm::uint c = 0; c < 3; ++c)
+						{
+							maxRelativeError = std::max(maxRelativeError, std::abs(decoded[i][c] - color[c]) / color[c]);
+						}
+					}
+				}
+				Check(constantBlocksDecoded, "every BC6H block is written in mode 11");
+				Check(maxRelativeError <= 1.0f / 64.0f, "constant BC6H blocks decode within 1/64th of their color (" + std::to_string(maxRelativeError) + ")");
+
+				// A gradient spanning two stops within one block
+				float gradient[16 * 4];
+				for (glm::uint i = 0; i < 16; ++i)
+				{
+					const float value = std::exp2(i / 7.5f);
+					gradient[i * 4 + 0] = value;
+					gradient[i * 4 + 1] = value * 0.5f;
+					gradient[i * 4 + 2] = value * 0.25f;
+					gradient[i * 4 + 3] = 1.0f;
+				}
+				unsigned char gradientBlock[16];
+				CompressImage(BlockCompressionFormat::BC6H, gradient, 4, 4, gradientBlock);
+				float decodedGradient[16][3];
+				bool gradientDecoded = DecodeBC6HBlock(gradientBlock, decodedGradient);
+				for (glm::uint i = 0; gradientDecoded && i < 16; ++i)
+				{
+					for (glm::uint c = 0; c < 3; ++c)
+					{
+						if (std::abs(decodedGradient[i][c] - gradient[i * 4 + c]) > gradient[i * 4 + c] * 0.1f) gradientDecoded = false;
+					}
+				}
+				Check(gradientDecoded, "BC6H gradient spanning two stops decodes within 10%");
+
+				// BC6H_UF16 has no negative values, NaNs & negatives are stored as zero
+				float invalid[16 * 4];
+				for (glm::uint i = 0; i < 16; ++i)
+				{
+					invalid[i * 4 + 0] = -1.0f;
+					invalid[i * 4 + 1] = std::nanf("");
+					invalid[i * 4 + 2] = -1000.0f;
+					invalid[i * 4 + 3] = 1.0f;
+				}
+				unsigned char invalidBlock[16];
+				CompressImage(BlockCompressionFormat::BC6H, invalid, 4, 4, invalidBlock);
+				float decodedInvalid[16][3];
+				bool invalidClamped = DecodeBC6HBlock(invalidBlock, decodedInvalid);
+				for (glm::uint i = 0; invalidClamped && i < 16; ++i)
+				{
+					for (glm::uint c = 0; c < 3; ++c)
+					{
+						if (decodedInvalid[i][c] != 0.0f) invalidClamped = false;
+					}
+				}
+				Check(invalidClamped, "negative & NaN BC6H texels decode to zero");
+			}
+		} // namespace
+
+		void RunTextureCompressionTests()
+		{
+			Run("Block compressed image sizes", TestBlockCompressedImageSizes);
+			Run("BC4 & BC5 round trip", TestBC4RoundTrip);
+			Run("BC7 round trip", TestBC7RoundTrip);
+			Run("BC6H round trip", TestBC6HRoundTrip);
+		}
+	} // namespace UnitTests
+} // namespace flex
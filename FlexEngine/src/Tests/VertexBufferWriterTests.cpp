@@ -0,0 +1,143 @@
+#include "stdafx.hpp"
+
+#include "UnitTests.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <glm/geometric.hpp>
+#include <glm/gtc/packing.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "VertexBufferWriter.hpp"
+
+namespace flex
+{
+	namespace UnitTests
+	{
+		namespace
+		{
+			// Mirrors DecodeTangentFrame in pbr_compressed.vert
+			void DecodeTangentFrame(glm::vec4 q, glm::vec3& tangent, glm::vec3& bitangent, glm::vec3& normal)
+			{
+				q = glm::normalize(q);
+				tangent = glm::vec3(1.0f - 2.0f * (q.y * q.y + q.z * q.z), 2.0f * (q.x * q.y + q.w * q.z), 2.0f * (q.x * q.z - q.w * q.y));
+				normal = glm::vec3(2.0f * (q.x * q.z + q.w * q.y), 2.0f * (q.y * q.z - q.w * q.x), 1.0f - 2.0f * (q.x * q.x + q.y * q.y));
+				bitangent = glm::cross(normal, tangent) * (q.w < 0.0f ? -1.0f : 1.0f);
+			}
+
+			glm::vec3 DecodeOctahedral(glm::vec2 e)
+			{
+				glm::vec3 n(e.x, e.y, 1.0f - std::abs(e.x) - std::abs(e.y));
+				if (n.z < 0.0f)
+				{
+					n.x = (1.0f - std::abs(e.y)) * (e.x >= 0.0f ? 1.0f : -1.0f);
+					n.y = (1.0f - std::abs(e.x)) * (e.y >= 0.0f ? 1.0f : -1.0f);
+				}
+				return glm::normalize(n);
+			}
+
+			glm::vec3 RandomUnitVector(std::mt19937& random)
+			{
+				std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+				while (true)
+				{
+					const glm::vec3 v(distribution(random), distribution(random), distribution(random));
+					const float lengthSquared = glm::dot(v, v);
+					if (lengthSquared > 1e-4f && lengthSquared <= 1.0f)
+					{
+						return v / std::sqrt(lengthSquared);
+					}
+				}
+			}
+
+			void TestTangentFrameRoundTrip()
+			{
+				std::mt19937 random(8);
+
+				// Through the same 16 bit snorm quantization the vertex writer applies
+				float minNormalDot = 1.0f;
+				float minTangentDot = 1.0f;
+				float minBitangentDot = 1.0f;
+				for (glm::uint test = 0; test < 4096; ++test)
+				{
+					const glm::vec3 normal = RandomUnitVector(random);
+					const glm::vec3 tangent = glm::normalize(glm::cross(normal, RandomUnitVector(random)));
+					const glm::vec3 bitangent = glm::cross(normal, tangent) * ((test & 1) ? -1.0f : 1.0f);
+
+					const glm::quat q = EncodeTangentFrame(tangent, bitangent, normal);
+					const glm::vec4 quantized = glm::unpackSnorm4x16(glm::packSnorm4x16(glm::vec4(q.x, q.y, q.z, q.w)));
+
+					glm::vec3 decodedTangent;
+					glm::vec3 decodedBitangent;
+					glm::vec3 decodedNormal;
+					DecodeTangentFrame(quantized, decodedTangent, decodedBitangent, decodedNormal);
+
+					minNormalDot = std::min(minNormalDot, glm::dot(decodedNormal, normal));
+					minTangentDot = std::min(minTangentDot, glm::dot(decodedTangent, tangent));
+					minBitangentDot = std::min(minBitangentDot, glm::dot(decodedBitangent, bitangent));
+				}
+
+				// 0.9999 is within roughly 0.8 degrees
+				Check(minNormalDot >= 0.9999f, "QTangent normals survive quantization (min dot " + std::to_string(minNormalDot) + ")");
+				Check(minTangentDot >= 0.9999f, "QTangent tangents survive quantization (min dot " + std::to_string(minTangentDot) + ")");
+				Check(minBitangentDot >= 0.9999f, "QTangent bitangents & their handedness survive quantization (min dot " + std::to_string(minBitangentDot) + ")");
+
+				// A tangent parallel to the normal still produces an orthonormal frame around the normal
+				const glm::vec3 normal(0.0f, 0.0f, 1.0f);
+				const glm::quat degenerate = EncodeTangentFrame(normal, glm::vec3(0.0f, 1.0f, 0.0f), normal);
+				glm::vec3 decodedTangent;
+				glm::vec3 decodedBitangent;
+				glm::vec3 decodedNormal;
+				DecodeTangentFrame(glm::vec4(degenerate.x, degenerate.y, degenerate.z, degenerate.w), decodedTangent, decodedBitangent, decodedNormal);
+				Check(glm::dot(decodedNormal, normal) >= 0.9999f && std::abs(glm::dot(decodedTangent, normal)) <= 1e-3f,
+					"degenerate tangents are replaced by one perpendicular to the normal");
+			}
+
+			void TestOctahedralRoundTrip()
+			{
+				std::mt19937 random(9);
+
+				std::vector<glm::vec3> directions = {
+					glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(-1.0f, 0.0f, 0.0f),
+					glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f),
+					glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 0.0f, -1.0f),
+				};
+				for (glm::uint i = 0; i < 4096; ++i)
+				{
+					directions.push_back(RandomUnitVector(random));
+				}
+
+				float minDot = 1.0f;
+				for (const glm::vec3& direction : directions)
+				{
+					const glm::vec2 quantized = glm::unpackSnorm2x16(glm::packSnorm2x16(EncodeOctahedral(direction)));
+					minDot = std::min(minDot, glm::dot(DecodeOctahedral(quantized), direction));
+				}
+				Check(minDot >= 0.99999f, "octahedral normals survive 16 bit quantization (min dot " + std::to_string(minDot) + ")");
+			}
+
+			void TestPackHalf2()
+			{
+				const glm::vec2 values[] = { glm::vec2(0.0f, 1.0f), glm::vec2(0.5f, -0.25f), glm::vec2(1024.0f, 1.0f / 1024.0f), glm::vec2(-65504.0f, 3.0f) };
+				bool matches = true;
+				for (const glm::vec2& value : values)
+				{
+					// Every value here is exactly representable, and the F16C path must round the same way as glm
+					matches = matches && PackHalf2(value) == glm::packHalf2x16(value) && glm::unpackHalf2x16(PackHalf2(value)) == value;
+				}
+				Check(matches, "PackHalf2 matches glm::packHalf2x16");
+			}
+		} // namespace
+
+		void RunVertexBufferWriterTests()
+		{
+			Run("QTangent round trip", TestTangentFrameRoundTrip);
+			Run("Octahedral normal round trip", TestOctahedralRoundTrip);
+			Run("PackHalf2", TestPackHalf2);
+		}
+	} // namespace UnitTests
+} // namespace flex
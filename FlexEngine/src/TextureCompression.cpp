@@ -0,0 +1,662 @@
+#include "stdafx.hpp"
+
+#include "TextureCompression.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <climits>
+#include <cmath>
+#include <cstring>
+
+#include <glm/common.hpp>
+#include <glm/gtc/packing.hpp>
+
+namespace flex
+{
+	namespace
+	{
+		// Interpolation weights (out of 64) shared by every 4 bit index mode of BC6H & BC7
+		const int WEIGHTS_4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+		// Largest finite half float, BC6H_UF16 can't represent anything above it
+		const float MAX_HALF = 65504.0f;
+
+		// Packs values into a 128 bit block starting at the least significant bit
+		class BlockWriter
+		{
+		public:
+			void Write(glm::uint value, glm::uint bitCount)
+			{
+				for (glm::uint i = 0; i < bitCount; ++i, ++m_Position)
+				{
+					if (value & (1u << i))
+					{
+						m_Bytes[m_Position / 8] |= (unsigned char)(1u << (m_Position % 8));
+					}
+				}
+			}
+
+			void CopyTo(void* dst) const
+			{
+				memcpy(dst, m_Bytes, sizeof(m_Bytes));
+			}
+
+		private:
+			unsigned char m_Bytes[16] = {};
+			glm::uint m_Position = 0;
+		};
+
+		// Gathers the 4x4 block whose top left pixel is (x, y), repeating the last row & column for blocks which hang over the edge
+		template<typename T>
+		void LoadBlock(const T* pixels, glm::uint width, glm::uint height, glm::uint x, glm::uint y, T block[16][4])
+		{
+			for (glm::uint by = 0; by < 4; ++by)
+			{
+				const glm::uint sy = std::min(y + by, height - 1);
+				for (glm::uint bx = 0; bx < 4; ++bx)
+				{
+					const glm::uint sx = std::min(x + bx, width - 1);
+					memcpy(block[by * 4 + bx], pixels + ((size_t)sy * width + sx) * 4, sizeof(T) * 4);
+				}
+			}
+		}
+
+		// Finds the line through points (channelCount dimensional) along which they vary most, by power iteration on their covariance
+		// Outputs the points' mean & the (normalized) direction, returns false if every point is identical
+		bool FindPrincipalAxis(const float points[16][4], glm::uint channelCount, float mean[4], float axis[4])
+		{
+			for (glm::uint c = 0; c < channelCount; ++c)
+			{
+				mean[c] = 0.0f;
+				for (glm::uint i = 0; i < 16; ++i)
+				{
+					mean[c] += points[i][c];
+				}
+				mean[c] /= 16.0f;
+			}
+
+			float covariance[4][4] = {};
+			for (glm::uint i = 0; i < 16; ++i)
+			{
+				for (glm::uint a = 0; a < channelCount; ++a)
+				{
+					const float da = points[i][a] - mean[a];
+					for (glm::uint b = a; b < channelCount; ++b)
+					{
+						covariance[a][b] += da * (points[i][b] - mean[b]);
+					}
+				}
+			}
+			for (glm::uint a = 0; a < channelCount; ++a)
+			{
+				for (glm::uint b = 0; b < a; ++b)
+				{
+					covariance[a][b] = covariance[b][a];
+				}
+			}
+
+			// Start from the diagonal with the largest extent, which is usually close to the answer already
+			float minimum[4] = { FLT_MAX, FLT_MAX, FLT_MAX, FLT_MAX };
+			float maximum[4] = { -FLT_MAX, -FLT_MAX, -FLT_MAX, -FLT_MAX };
+			for (glm::uint i = 0; i < 16; ++i)
+			{
+				for (glm::uint c = 0; c < channelCount; ++c)
+				{
+					minimum[c] = std::min(minimum[c], points[i][c]);
+					maximum[c] = std::max(maximum[c], points[i][c]);
+				}
+			}
+
+			float length = 0.0f;
+			for (glm::uint c = 0; c < channelCount; ++c)
+			{
+				axis[c] = maximum[c] - minimum[c];
+				length += axis[c] * axis[c];
+			}
+			if (length <= 0.0f)
+			{
+				return false;
+			}
+
+			for (glm::uint iteration = 0; iteration < 8; ++iteration)
+			{
+				float next[4] = {};
+				for (glm::uint a = 0; a < channelCount; ++a)
+				{
+					for (glm::uint b = 0; b < channelCount; ++b)
+					{
+						next[a] += covariance[a][b] * axis[b];
+					}
+				}
+
+				length = 0.0f;
+				for (glm::uint c = 0; c < channelCount; ++c)
+				{
+					length += next[c] * next[c];
+				}
+				if (length <= 1e-12f)
+				{
+					break;
+				}
+
+				const float invLength = 1.0f / std::sqrt(length);
+				for (glm::uint c = 0; c < channelCount; ++c)
+				{
+					axis[c] = next[c] * invLength;
+				}
+			}
+
+			length = 0.0f;
+			for (glm::uint c = 0; c < channelCount; ++c)
+			{
+				length += axis[c] * axis[c];
+			}
+			const float invLength = 1.0f / std::sqrt(length);
+			for (glm::uint c = 0; c < channelCount; ++c)
+			{
+				axis[c] *= invLength;
+			}
+
+			return true;
+		}
+
+		// Endpoints spanning the projection of every point onto their principal axis
+		void FindEndpoints(const float points[16][4], glm::uint channelCount, float minValue, float maxValue, float endpoints[2][4])
+		{
+			float mean[4];
+			float axis[4];
+			if (!FindPrincipalAxis(points, channelCount, mean, axis))
+			{
+				memcpy(endpoints[0], points[0], sizeof(float) * 4);
+				memcpy(endpoints[1], points[0], sizeof(float) * 4);
+				return;
+			}
+
+			float minProjection = FLT_MAX;
+			float maxProjection = -FLT_MAX;
+			for (glm::uint i = 0; i < 16; ++i)
+			{
+				float projection = 0.0f;
+				for (glm::uint c = 0; c < channelCount; ++c)
+				{
+					projection += (points[i][c] - mean[c]) * axis[c];
+				}
+				minProjection = std::min(minProjection, projection);
+				maxProjection = std::max(maxProjection, projection);
+			}
+
+			for (glm::uint c = 0; c < channelCount; ++c)
+			{
+				endpoints[0][c] = glm::clamp(mean[c] + axis[c] * minProjection, minValue, maxValue);
+				endpoints[1][c] = glm::clamp(mean[c] + axis[c] * maxProjection, minValue, maxValue);
+			}
+		}
+
+		// Least squares fit of two endpoints to points given the weight (out of 64) each point's index interpolates them by
+		// Returns false if every point uses the same weight, in which case the fit is undefined
+		bool FitEndpoints(const float points[16][4], glm::uint channelCount, const int weights[16], float minValue, float maxValue, float endpoints[2][4])
+		{
+			float aa = 0.0f;
+			float ab = 0.0f;
+			float bb = 0.0f;
+			float ap[4] = {};
+			float bp[4] = {};
+			for (glm::uint i = 0; i < 16; ++i)
+			{
+				const float t = weights[i] / 64.0f;
+				const float s = 1.0f - t;
+				aa += s * s;
+				ab += s * t;
+				bb += t * t;
+				for (glm::uint c = 0; c < channelCount; ++c)
+				{
+					ap[c] += s * points[i][c];
+					bp[c] += t * points[i][c];
+				}
+			}
+
+			const float determinant = aa * bb - ab * ab;
+			if (std::abs(determinant) < 1e-6f)
+			{
+				return false;
+			}
+
+			const float invDeterminant = 1.0f / determinant;
+			for (glm::uint c = 0; c < channelCount; ++c)
+			{
+				endpoints[0][c] = glm::clamp((ap[c] * bb - bp[c] * ab) * invDeterminant, minValue, maxValue);
+				endpoints[1][c] = glm::clamp((bp[c] * aa - ap[c] * ab) * invDeterminant, minValue, maxValue);
+			}
+
+			return true;
+		}
+
+		void EncodeBC4Block(const unsigned char values[16], unsigned char* dst)
+		{
+			unsigned char minValue = 255;
+			unsigned char maxValue = 0;
+			for (glm::uint i = 0; i < 16; ++i)
+			{
+				minValue = std::min(minValue, values[i]);
+				maxValue = std::max(maxValue, values[i]);
+			}
+
+			// Endpoint 0 > endpoint 1 selects eight evenly spaced levels: codes 0 & 1 are the endpoints & 2-7 step from max to min
+			dst[0] = maxValue;
+			dst[1] = minValue;
+
+			glm::uint64 indices = 0;
+			if (maxValue != minValue)
+			{
+				static const glm::uint64 codeForStep[8] = { 1, 7, 6, 5, 4, 3, 2, 0 };
+				const int range = maxValue - minValue;
+				for (glm::uint i = 0; i < 16; ++i)
+				{
+					const int step = ((values[i] - minValue) * 14 + range) / (range * 2);
+					indices |= codeForStep[step] << (3 * i);
+				}
+			}
+
+			for (glm::uint i = 0; i < 6; ++i)
+			{
+				dst[2 + i] = (unsigned char)(indices >> (8 * i));
+			}
+		}
+
+		void EncodeBC5Block(const unsigned char block[16][4], unsigned char* dst)
+		{
+			unsigned char red[16];
+			unsigned char green[16];
+			for (glm::uint i = 0; i < 16; ++i)
+			{
+				red[i] = block[i][0];
+				green[i] = block[i][1];
+			}
+
+			EncodeBC4Block(red, dst);
+			EncodeBC4Block(green, dst + 8);
+		}
+
+		struct BC7Endpoints
+		{
+			glm::uint quantized[2][4]; // 7 bits each
+			glm::uint pBits[2];
+			int values[2][4]; // 8 bit values the quantized endpoints decode to
+		};
+
+		// Mode 6 endpoints are 7 bits per channel plus one shared least significant bit (the "p-bit") per endpoint
+		void QuantizeBC7Endpoints(const float endpoints[2][4], BC7Endpoints& result)
+		{
+			for (glm::uint e = 0; e < 2; ++e)
+			{
+				float bestError = FLT_MAX;
+				for (glm::uint p = 0; p < 2; ++p)
+				{
+					float error = 0.0f;
+					glm::uint quantized[4];
+					for (glm::uint c = 0; c < 4; ++c)
+					{
+						quantized[c] = (glm::uint)glm::clamp((int)std::floor((endpoints[e][c] - p) * 0.5f + 0.5f), 0, 127);
+						const float difference = (float)((quantized[c] << 1) | p) - endpoints[e][c];
+						error += difference * difference;
+					}
+
+					if (error < bestError)
+					{
+						bestError = error;
+						result.pBits[e] = p;
+						for (glm::uint c = 0; c < 4; ++c)
+						{
+							result.quantized[e][c] = quantized[c];
+							result.values[e][c] = (int)((quantized[c] << 1) | p);
+						}
+					}
+				}
+			}
+		}
+
+		// Picks the closest of the 16 interpolated colors for each pixel, returns the total squared error
+		int SelectBC7Indices(const unsigned char block[16][4], const BC7Endpoints& endpoints, glm::uint indices[16])
+		{
+			int palette[16][4];
+			for (glm::uint i = 0; i < 16; ++i)
+			{
+				for (glm::uint c = 0; c < 4; ++c)
+				{
+					palette[i][c] = ((64 - WEIGHTS_4[i]) * endpoints.values[0][c] + WEIGHTS_4[i] * endpoints.values[1][c] + 32) >> 6;
+				}
+			}
+
+			int totalError = 0;
+			for (glm::uint i = 0; i < 16; ++i)
+			{
+				int bestError = INT_MAX;
+				for (glm::uint j = 0; j < 16; ++j)
+				{
+					int error = 0;
+					for (glm::uint c = 0; c < 4; ++c)
+					{
+						const int difference = palette[j][c] - block[i][c];
+						error += difference * difference;
+					}
+
+					if (error < bestError)
+					{
+						bestError = error;
+						indices[i] = j;
+					}
+				}
+				totalError += bestError;
+			}
+
+			return totalError;
+		}
+
+		void EncodeBC7Block(const unsigned char block[16][4], unsigned char* dst)
+		{
+			float points[16][4];
+			for (glm::uint i = 0; i < 16; ++i)
+			{
+				for (glm::uint c = 0; c < 4; ++c)
+				{
+					points[i][c] = block[i][c];
+				}
+			}
+
+			float endpoints[2][4];
+			FindEndpoints(points, 4, 0.0f, 255.0f, endpoints);
+
+			BC7Endpoints best;
+			QuantizeBC7Endpoints(endpoints, best);
+			glm::uint bestIndices[16];
+			int bestError = SelectBC7Indices(block, best, bestIndices);
+
+			// Refit the endpoints to the chosen indices, keeping the result only while it improves
+			for (glm::uint iteration = 0; iteration < 2 && bestError > 0; ++iteration)
+			{
+				int weights[16];
+				for (glm::uint i = 0; i < 16; ++i)
+				{
+					weights[i] = WEIGHTS_4[bestIndices[i]];
+				}
+
+				if (!FitEndpoints(points, 4, weights, 0.0f, 255.0f, endpoints))
+				{
+					break;
+				}
+
+				BC7Endpoints refined;
+				QuantizeBC7Endpoints(endpoints, refined);
+				glm::uint refinedIndices[16];
+				const int refinedError = SelectBC7Indices(block, refined, refinedIndices);
+				if (refinedError >= bestError)
+				{
+					break;
+				}
+
+				best = refined;
+				bestError = refinedError;
+				memcpy(bestIndices, refinedIndices, sizeof(bestIndices));
+			}
+
+			// The first pixel's index has an implicit most significant bit of zero, swapping the endpoints ensures that holds
+			if (bestIndices[0] & 8)
+			{
+				std::swap(best.quantized[0], best.quantized[1]);
+				std::swap(best.pBits[0], best.pBits[1]);
+				for (glm::uint i = 0; i < 16; ++i)
+				{
+					bestIndices[i] = 15 - bestIndices[i];
+				}
+			}
+
+			BlockWriter writer;
+			writer.Write(1u << 6, 7); // Mode 6
+			for (glm::uint c = 0; c < 4; ++c)
+			{
+				writer.Write(best.quantized[0][c], 7);
+				writer.Write(best.quantized[1][c], 7);
+			}
+			writer.Write(best.pBits[0], 1);
+			writer.Write(best.pBits[1], 1);
+			for (glm::uint i = 0; i < 16; ++i)
+			{
+				writer.Write(bestIndices[i], i == 0 ? 3 : 4);
+			}
+			writer.CopyTo(dst);
+		}
+
+		// Expands a 10 bit BC6H_UF16 endpoint to the 16 bit range it's interpolated in
+		int UnquantizeBC6H(int value)
+		{
+			if (value == 0)
+			{
+				return 0;
+			}
+			if (value == 1023)
+			{
+				return 0xFFFF;
+			}
+			return ((value << 16) + 0x8000) >> 10;
+		}
+
+		// Converts an interpolated 16 bit value to the bits of the half float it decodes to
+		int FinishUnquantizeBC6H(int value)
+		{
+			return (value * 31) >> 6;
+		}
+
+		struct BC6HEndpoints
+		{
+			int quantized[2][3]; // 10 bits each
+			int values[2][3]; // Unquantized
+		};
+
+		// Endpoints are fitted in half float bit space, which is close enough to logarithmic to weight errors sensibly across exposures
+		void QuantizeBC6HEndpoints(const float endpoints[2][4], BC6HEndpoints& result)
+		{
+			for (glm::uint e = 0; e < 2; ++e)
+			{
+				for (glm::uint c = 0; c < 3; ++c)
+				{
+					// Every step of the 10 bit value advances the decoded half float by roughly 31, try both neighbours
+					const int estimate = glm::clamp((int)(endpoints[e][c] / 31.0f), 0, 1023);
+					int bestValue = estimate;
+					float bestError = FLT_MAX;
+					for (int candidate = std::max(estimate - 1, 0); candidate <= std::min(estimate + 1, 1023); ++candidate)
+					{
+						const float error = std::abs((float)FinishUnquantizeBC6H(UnquantizeBC6H(candidate)) - endpoints[e][c]);
+						if (error < bestError)
+						{
+							bestError = error;
+							bestValue = candidate;
+						}
+					}
+
+					result.quantized[e][c] = bestValue;
+					result.values[e][c] = UnquantizeBC6H(bestValue);
+				}
+			}
+		}
+
+		float SelectBC6HIndices(const float points[16][4], const BC6HEndpoints& endpoints, glm::uint indices[16])
+		{
+			float palette[16][3];
+			for (glm::uint i = 0; i < 16; ++i)
+			{
+				for (glm::uint c = 0; c < 3; ++c)
+				{
+					const int interpolated = ((64 - WEIGHTS_4[i]) * endpoints.values[0][c] + WEIGHTS_4[i] * endpoints.values[1][c] + 32) >> 6;
+					palette[i][c] = (float)FinishUnquantizeBC6H(interpolated);
+				}
+			}
+
+			float totalError = 0.0f;
+			for (glm::uint i = 0; i < 16; ++i)
+			{
+				float bestError = FLT_MAX;
+				for (glm::uint j = 0; j < 16; ++j)
+				{
+					float error = 0.0f;
+					for (glm::uint c = 0; c < 3; ++c)
+					{
+						const float difference = palette[j][c] - points[i][c];
+						error += difference * difference;
+					}
+
+					if (error < bestError)
+					{
+						bestError = error;
+						indices[i] = j;
+					}
+				}
+				totalError += bestError;
+			}
+
+			return totalError;
+		}
+
+		void EncodeBC6HBlock(const float block[16][4], unsigned char* dst)
+		{
+			// Work with the bits of each channel's half float, negative values aren't representable & are clamped to zero
+			float points[16][4];
+			for (glm::uint i = 0; i < 16; ++i)
+			{
+				for (glm::uint c = 0; c < 3; ++c)
+				{
+					const float value = std::isnan(block[i][c]) ? 0.0f : glm::clamp(block[i][c], 0.0f, MAX_HALF);
+					points[i][c] = (float)glm::packHalf1x16(value);
+				}
+				points[i][3] = 0.0f;
+			}
+
+			float endpoints[2][4];
+			FindEndpoints(points, 3, 0.0f, (float)0x7BFF, endpoints);
+
+			BC6HEndpoints best;
+			QuantizeBC6HEndpoints(endpoints, best);
+			glm::uint bestIndices[16];
+			float bestError = SelectBC6HIndices(points, best, bestIndices);
+
+			for (glm::uint iteration = 0; iteration < 2 && bestError > 0.0f; ++iteration)
+			{
+				int weights[16];
+				for (glm::uint i = 0; i < 16; ++i)
+				{
+					weights[i] = WEIGHTS_4[bestIndices[i]];
+				}
+
+				if (!FitEndpoints(points, 3, weights, 0.0f, (float)0x7BFF, endpoints))
+				{
+					break;
+				}
+
+				BC6HEndpoints refined;
+				QuantizeBC6HEndpoints(endpoints, refined);
+				glm::uint refinedIndices[16];
+				const float refinedError = SelectBC6HIndices(points, refined, refinedIndices);
+				if (refinedError >= bestError)
+				{
+					break;
+				}
+
+				best = refined;
+				bestError = refinedError;
+				memcpy(bestIndices, refinedIndices, sizeof(bestIndices));
+			}
+
+			if (bestIndices[0] & 8)
+			{
+				std::swap(best.quantized[0], best.quantized[1]);
+				for (glm::uint i = 0; i < 16; ++i)
+				{
+					bestIndices[i] = 15 - bestIndices[i];
+				}
+			}
+
+			BlockWriter writer;
+			writer.Write(0x03, 5); // Mode 11: one region, untransformed 10 bit endpoints
+			for (glm::uint e = 0; e < 2; ++e)
+			{
+				for (glm::uint c = 0; c < 3; ++c)
+				{
+					writer.Write((glm::uint)best.quantized[e][c], 10);
+				}
+			}
+			for (glm::uint i = 0; i < 16; ++i)
+			{
+				writer.Write(bestIndices[i], i == 0 ? 3 : 4);
+			}
+			writer.CopyTo(dst);
+		}
+	} // namespace
+
+	glm::uint GetBlockCompressionBlockSize(BlockCompressionFormat format)
+	{
+		switch (format)
+		{
+		case BlockCompressionFormat::BC4:
+			return 8;
+		case BlockCompressionFormat::BC5:
+		case BlockCompressionFormat::BC6H:
+		case BlockCompressionFormat::BC7:
+			return 16;
+		default:
+			return 0;
+		}
+	}
+
+	size_t GetBlockCompressedImageSize(BlockCompressionFormat format, glm::uint width, glm::uint height)
+	{
+		const size_t blockCountX = std::max((width + 3) / 4, 1u);
+		const size_t blockCountY = std::max((height + 3) / 4, 1u);
+		return blockCountX * blockCountY * GetBlockCompressionBlockSize(format);
+	}
+
+	void CompressImage(BlockCompressionFormat format, const void* pixels, glm::uint width, glm::uint height, void* dst)
+	{
+		const glm::uint blockSize = GetBlockCompressionBlockSize(format);
+		unsigned char* block = (unsigned char*)dst;
+
+		for (glm::uint y = 0; y < height; y += 4)
+		{
+			for (glm::uint x = 0; x < width; x += 4)
+			{
+				if (format == BlockCompressionFormat::BC6H)
+				{
+					float blockPixels[16][4];
+					LoadBlock((const float*)pixels, width, height, x, y, blockPixels);
+					EncodeBC6HBlock(blockPixels, block);
+				}
+				else
+				{
+					unsigned char blockPixels[16][4];
+					LoadBlock((const unsigned char*)pixels, width, height, x, y, blockPixels);
+
+					switch (format)
+					{
+					case BlockCompressionFormat::BC4:
+					{
+						unsigned char red[16];
+						for (glm::uint i = 0; i < 16; ++i)
+						{
+							red[i] = blockPixels[i][0];
+						}
+						EncodeBC4Block(red, block);
+					} break;
+					case BlockCompressionFormat::BC5:
+						EncodeBC5Block(blockPixels, block);
+						break;
+					case BlockCompressionFormat::BC7:
+						EncodeBC7Block(blockPixels, block);
+						break;
+					default:
+						break;
+					}
+				}
+
+				block += blockSize;
+			}
+		}
+	}
+} // namespace flex
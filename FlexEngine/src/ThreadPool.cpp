@@ -0,0 +1,91 @@
+#include "stdafx.hpp"
+
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+
+namespace flex
+{
+	ThreadPool::ThreadPool(glm::uint threadCount)
+	{
+		if (threadCount == 0)
+		{
+			const glm::uint hardwareThreadCount = std::thread::hardware_concurrency();
+			threadCount = std::max(hardwareThreadCount, 2u) - 1;
+		}
+
+		m_Threads.reserve(threadCount);
+		for (glm::uint i = 0; i < threadCount; ++i)
+		{
+			m_Threads.emplace_back(&ThreadPool::WorkerLoop, this);
+		}
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Stopping = true;
+		}
+		m_JobAvailable.notify_all();
+
+		for (std::thread& thread : m_Threads)
+		{
+			thread.join();
+		}
+	}
+
+	void ThreadPool::Enqueue(Job job)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Jobs.push(std::move(job));
+		}
+		m_JobAvailable.notify_one();
+	}
+
+	void ThreadPool::WaitForIdle()
+	{
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		m_Idle.wait(lock, [this] { return m_Jobs.empty() && m_ActiveJobCount == 0; });
+	}
+
+	glm::uint ThreadPool::GetThreadCount() const
+	{
+		return (glm::uint)m_Threads.size();
+	}
+
+	void ThreadPool::WorkerLoop()
+	{
+		while (true)
+		{
+			Job job;
+
+			{
+				std::unique_lock<std::mutex> lock(m_Mutex);
+				m_JobAvailable.wait(lock, [this] { return m_Stopping || !m_Jobs.empty(); });
+
+				// Finish any remaining jobs before stopping so nothing waiting on them is left hanging
+				if (m_Jobs.empty())
+				{
+					return;
+				}
+
+				job = std::move(m_Jobs.front());
+				m_Jobs.pop();
+				++m_ActiveJobCount;
+			}
+
+			job();
+
+			{
+				std::lock_guard<std::mutex> lock(m_Mutex);
+				--m_ActiveJobCount;
+				if (m_Jobs.empty() && m_ActiveJobCount == 0)
+				{
+					m_Idle.notify_all();
+				}
+			}
+		}
+	}
+} // namespace flex
@@ -153,6 +153,11 @@ namespace flex
 		return matModel;
 	}
 
+	glm::uint Transform::GetVersion() const
+	{
+		return version;
+	}
+
 	Transform Transform::Identity()
 	{
 		Transform result;
@@ -173,6 +178,7 @@ namespace flex
 			globalPosition = localPosition;
 			globalRotation = localRotation;
 			globalScale = localScale;
+			++version;
 
 			UpdateChildTransforms();
 		}
@@ -187,6 +193,7 @@ namespace flex
 			childTransform->globalPosition = childTransform->localPosition + localPosition;
 			childTransform->globalScale = childTransform->localScale * localScale;
 			childTransform->globalRotation = childTransform->localRotation * localRotation;
+			++childTransform->version;
 
 			childTransform->UpdateChildTransforms();
 		}
@@ -0,0 +1,64 @@
+#include "stdafx.hpp"
+
+#include "UnitTests.hpp"
+
+#include "Logger.hpp"
+
+namespace flex
+{
+	namespace
+	{
+		std::string s_CurrentTest;
+		glm::uint s_CheckCount = 0;
+		glm::uint s_FailureCount = 0;
+	} // namespace
+
+	namespace UnitTests
+	{
+		void Run(const std::string& testName, void(*test)())
+		{
+			s_CurrentTest = testName;
+			const glm::uint failureCountBefore = s_FailureCount;
+			test();
+			Logger::LogInfo((s_FailureCount == failureCountBefore ? "Passed: " : "FAILED: ") + testName);
+		}
+
+		void Check(bool condition, const std::string& description)
+		{
+			++s_CheckCount;
+			if (!condition)
+			{
+				++s_FailureCount;
+				Logger::LogError(s_CurrentTest + ": " + description);
+			}
+		}
+	} // namespace UnitTests
+
+	bool RunUnitTests()
+	{
+		s_CheckCount = 0;
+		s_FailureCount = 0;
+
+		UnitTests::RunMeshOptimizerTests();
+		UnitTests::RunVertexBufferWriterTests();
+		UnitTests::RunTextureCompressionTests();
+		UnitTests::RunCookedTextureTests();
+		UnitTests::RunMipGeneratorTests();
+		UnitTests::RunFreeRangeListTests();
+#if COMPILE_OPEN_GL
+		UnitTests::RunGLHelpersTests();
+#endif
+
+		const std::string summary = std::to_string(s_CheckCount - s_FailureCount) + "/" + std::to_string(s_CheckCount) + " checks passed";
+		if (s_FailureCount == 0)
+		{
+			Logger::LogInfo(summary);
+		}
+		else
+		{
+			Logger::LogError(summary);
+		}
+
+		return s_FailureCount == 0;
+	}
+} // namespace flex
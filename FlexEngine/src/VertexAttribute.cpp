@@ -18,6 +18,9 @@ namespace flex
 		if (vertexAttributes & (glm::uint)VertexAttribute::TANGENT) stride += sizeof(glm::vec3);
 		if (vertexAttributes & (glm::uint)VertexAttribute::BITANGENT) stride += sizeof(glm::vec3);
 		if (vertexAttributes & (glm::uint)VertexAttribute::NORMAL) stride += sizeof(glm::vec3);
+		if (vertexAttributes & (glm::uint)VertexAttribute::UV_HALF) stride += sizeof(glm::uint16) * 2;
+		if (vertexAttributes & (glm::uint)VertexAttribute::NORMAL_OCT) stride += sizeof(glm::int16) * 2;
+		if (vertexAttributes & (glm::uint)VertexAttribute::TANGENT_FRAME) stride += sizeof(glm::int16) * 4;
 
 		if (stride == 0)
 		{
@@ -26,4 +29,31 @@ namespace flex
 
 		return stride;
 	}
+
+	VertexAttributes CompressVertexAttributes(VertexAttributes vertexAttributes)
+	{
+		const VertexAttributes fullTangentFrame =
+			(glm::uint)VertexAttribute::TANGENT |
+			(glm::uint)VertexAttribute::BITANGENT |
+			(glm::uint)VertexAttribute::NORMAL;
+
+		// pbr_compressed only reads in_TangentFrame, no shader decodes NORMAL_OCT yet, so anything else is left as is
+		if ((vertexAttributes & fullTangentFrame) != fullTangentFrame)
+		{
+			return vertexAttributes;
+		}
+
+		VertexAttributes result = vertexAttributes;
+
+		result &= ~fullTangentFrame;
+		result |= (glm::uint)VertexAttribute::TANGENT_FRAME;
+
+		if (result & (glm::uint)VertexAttribute::UV)
+		{
+			result &= ~(glm::uint)VertexAttribute::UV;
+			result |= (glm::uint)VertexAttribute::UV_HALF;
+		}
+
+		return result;
+	}
 } // namespace flex
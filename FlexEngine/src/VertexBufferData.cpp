@@ -7,99 +7,166 @@
 #include <cstdlib>
 
 #include "Logger.hpp"
+#include "VertexBufferWriter.hpp"
 
 namespace flex
 {
+	// Feeds the separate attribute arrays of a CreateInfo to the interleaving writer
+	struct CreateInfoVertexSource
+	{
+		const VertexBufferData::CreateInfo* createInfo;
+
+		glm::vec3 Position(glm::uint i) const { return createInfo->positions_3D[i]; }
+		glm::vec2 Position2D(glm::uint i) const { return createInfo->positions_2D[i]; }
+		glm::vec2 UV(glm::uint i) const { return createInfo->texCoords_UV[i]; }
+		glm::vec3 UVW(glm::uint i) const { return createInfo->texCoords_UVW[i]; }
+		glm::int32 Color32(glm::uint i) const { return createInfo->colors_R8G8B8A8[i]; }
+		glm::vec4 Color(glm::uint i) const { return createInfo->colors_R32G32B32A32[i]; }
+		glm::vec3 Tangent(glm::uint i) const { return createInfo->tangents[i]; }
+		glm::vec3 Bitangent(glm::uint i) const { return createInfo->bitangents[i]; }
+		glm::vec3 Normal(glm::uint i) const { return createInfo->normals[i]; }
+	};
+
 	VertexBufferData::VertexBufferData() :
 		pDataStart(nullptr),
 		BufferSize(0),
 		VertexStride(0),
-		VertexCount(0)
+		VertexCount(0),
+		SeparatePositions(false),
+		m_OwnsData(false)
 	{
 	}
 
 	void VertexBufferData::Initialize(CreateInfo* createInfo)
 	{
-		VertexCount = createInfo->positions_3D.size();
-		if (VertexCount == 0) VertexCount = createInfo->positions_2D.size();
-		Attributes = createInfo->attributes;
+		glm::uint vertexCount = createInfo->positions_3D.size();
+		if (vertexCount == 0) vertexCount = createInfo->positions_2D.size();
+
+		if (!Initialize(vertexCount, createInfo->attributes))
+		{
+			return;
+		}
+
+		CreateInfoVertexSource source = { createInfo };
+		WriteVertices(Attributes, source, VertexCount, pDataStart);
+	}
+
+	bool VertexBufferData::Initialize(glm::uint vertexCount, VertexAttributes attributes)
+	{
+		VertexCount = vertexCount;
+		Attributes = attributes;
 		VertexStride = CalculateVertexStride(Attributes);
 		BufferSize = VertexCount * VertexStride;
+		SeparatePositions = false;
 
 		void *pDataLocation = malloc(BufferSize);
 		if (pDataLocation == nullptr)
 		{
 			Logger::LogWarning("Vertex Buffer Data failed to allocate memory required for vertex buffer data");
-			return;
+			return false;
 		}
 
 		pDataStart = pDataLocation;
+		m_OwnsData = true;
+
+		return true;
+	}
 
-		for (UINT i = 0; i < VertexCount; ++i)
+	void VertexBufferData::InitializeFromMemory(void* data, glm::uint vertexCount, VertexAttributes attributes, bool separatePositions)
+	{
+		VertexCount = vertexCount;
+		Attributes = attributes;
+		VertexStride = CalculateVertexStride(Attributes);
+		BufferSize = VertexCount * VertexStride;
+		SeparatePositions = separatePositions;
+
+		pDataStart = data;
+		m_OwnsData = false;
+	}
+
+	bool VertexBufferData::SeparatePositionStream()
+	{
+		if (SeparatePositions)
 		{
-			if (Attributes & (glm::uint)VertexAttribute::POSITION)
-			{
-				memcpy(pDataLocation, &createInfo->positions_3D[i], sizeof(glm::vec3));
-				pDataLocation = (float*)pDataLocation + 3;
-			}
+			return true;
+		}
 
-			if (Attributes & (glm::uint)VertexAttribute::POSITION_2D)
-			{
-				memcpy(pDataLocation, &createInfo->positions_2D[i], sizeof(glm::vec2));
-				pDataLocation = (float*)pDataLocation + 2;
-			}
+		const glm::uint positionStride = sizeof(glm::vec3);
+		if (!(Attributes & (glm::uint)VertexAttribute::POSITION) || VertexStride <= positionStride || !pDataStart || !m_OwnsData)
+		{
+			return false;
+		}
 
-			if (Attributes & (glm::uint)VertexAttribute::UV)
-			{
-				memcpy(pDataLocation, &createInfo->texCoords_UV[i], sizeof(glm::vec2));
-				pDataLocation = (float*)pDataLocation + 2;
-			}
+		void* separated = malloc(BufferSize);
+		if (separated == nullptr)
+		{
+			Logger::LogWarning("Vertex Buffer Data failed to allocate memory required to separate position stream");
+			return false;
+		}
 
-			if (Attributes & (glm::uint)VertexAttribute::UVW)
-			{
-				memcpy(pDataLocation, &createInfo->texCoords_UVW[i], sizeof(glm::vec3));
-				pDataLocation = (float*)pDataLocation + 3;
-			}
+		// Positions are always the first attribute in an interleaved vertex
+		const glm::uint otherStride = VertexStride - positionStride;
+		const char* src = (const char*)pDataStart;
+		char* positionDst = (char*)separated;
+		char* otherDst = (char*)separated + VertexCount * positionStride;
+		for (glm::uint i = 0; i < VertexCount; ++i)
+		{
+			memcpy(positionDst, src, positionStride);
+			memcpy(otherDst, src + positionStride, otherStride);
+			src += VertexStride;
+			positionDst += positionStride;
+			otherDst += otherStride;
+		}
 
-			if (Attributes & (glm::uint)VertexAttribute::COLOR_R8G8B8A8_UNORM)
-			{
-				memcpy(pDataLocation, &createInfo->colors_R8G8B8A8[i], sizeof(glm::int32));
-				pDataLocation = (float*)pDataLocation + 1;
-			}
+		free(pDataStart);
+		pDataStart = separated;
+		SeparatePositions = true;
 
-			if (Attributes & (glm::uint)VertexAttribute::COLOR_R32G32B32A32_SFLOAT)
-			{
-				memcpy(pDataLocation, &createInfo->colors_R32G32B32A32[i], sizeof(glm::vec4));
-				pDataLocation = (float*)pDataLocation + 4;
-			}
+		return true;
+	}
 
-			if (Attributes & (glm::uint)VertexAttribute::TANGENT)
-			{
-				memcpy(pDataLocation, &createInfo->tangents[i], sizeof(glm::vec3));
-				pDataLocation = (float*)pDataLocation + 3;
-			}
+	glm::uint VertexBufferData::GetStreamStride(glm::uint stream) const
+	{
+		if (!SeparatePositions)
+		{
+			return stream == 0 ? VertexStride : 0;
+		}
 
-			if (Attributes & (glm::uint)VertexAttribute::BITANGENT)
-			{
-				memcpy(pDataLocation, &createInfo->bitangents[i], sizeof(glm::vec3));
-				pDataLocation = (float*)pDataLocation + 3;
-			}
+		return stream == 0 ? (glm::uint)sizeof(glm::vec3) : VertexStride - (glm::uint)sizeof(glm::vec3);
+	}
 
-			if (Attributes & (glm::uint)VertexAttribute::NORMAL)
-			{
-				memcpy(pDataLocation, &createInfo->normals[i], sizeof(glm::vec3));
-				pDataLocation = (float*)pDataLocation + 3;
-			}
+	glm::uint VertexBufferData::GetStreamOffset(glm::uint stream) const
+	{
+		if (!SeparatePositions || stream == 0)
+		{
+			return 0;
 		}
+
+		return VertexCount * (glm::uint)sizeof(glm::vec3);
+	}
+
+	void VertexBufferData::ReleaseData()
+	{
+		if (pDataStart && m_OwnsData)
+		{
+			free(pDataStart);
+		}
+		pDataStart = nullptr;
+		m_OwnsData = false;
 	}
 
 	void VertexBufferData::Destroy()
 	{
 		if (pDataStart)
 		{
-			free(pDataStart);
+			if (m_OwnsData)
+			{
+				free(pDataStart);
+			}
 			pDataStart = nullptr;
 		}
+		m_OwnsData = false;
+		SeparatePositions = false;
 		VertexCount = 0;
 		BufferSize = 0;
 		VertexStride = 0;
@@ -112,30 +179,44 @@ namespace flex
 		{
 			std::string name;
 			int size;
+			Renderer::Type type;
+			bool normalized;
+			int byteSize;
 		};
 
 		static VertexType vertexTypes[] = {
-			{ "in_Position", 3 },
-			{ "in_Position2D", 2 },
-			{ "in_TexCoord", 2 },
-			{ "in_TexCoord_UVW", 3 },
-			{ "in_Color_32", 1 },
-			{ "in_Color", 4 },
-			{ "in_Tangent", 3 },
-			{ "in_Bitangent", 3 },
-			{ "in_Normal", 3 },
+			{ "in_Position", 3, Renderer::Type::FLOAT, false, sizeof(glm::vec3) },
+			{ "in_Position2D", 2, Renderer::Type::FLOAT, false, sizeof(glm::vec2) },
+			{ "in_TexCoord", 2, Renderer::Type::FLOAT, false, sizeof(glm::vec2) },
+			{ "in_TexCoord_UVW", 3, Renderer::Type::FLOAT, false, sizeof(glm::vec3) },
+			{ "in_Color_32", 1, Renderer::Type::FLOAT, false, sizeof(glm::int32) },
+			{ "in_Color", 4, Renderer::Type::FLOAT, false, sizeof(glm::vec4) },
+			{ "in_Tangent", 3, Renderer::Type::FLOAT, false, sizeof(glm::vec3) },
+			{ "in_Bitangent", 3, Renderer::Type::FLOAT, false, sizeof(glm::vec3) },
+			{ "in_Normal", 3, Renderer::Type::FLOAT, false, sizeof(glm::vec3) },
+			{ "in_TexCoord", 2, Renderer::Type::HALF_FLOAT, false, sizeof(glm::uint16) * 2 },
+			{ "in_NormalOct", 2, Renderer::Type::SHORT, true, sizeof(glm::int16) * 2 },
+			{ "in_TangentFrame", 4, Renderer::Type::SHORT, true, sizeof(glm::int16) * 4 },
 		};
 
 		const size_t vertexTypeCount = sizeof(vertexTypes) / sizeof(vertexTypes[0]);
-		float* currentLocation = (float*)0;
+		char* currentLocation = (char*)0;
+		int stride = (int)GetStreamStride(0);
 		for (size_t i = 0; i < vertexTypeCount; ++i)
 		{
 			VertexAttribute vertexAttribute = VertexAttribute(1 << i);
 			if (Attributes & (int)vertexAttribute)
 			{
-				renderer->DescribeShaderVariable(renderID, vertexTypes[i].name, vertexTypes[i].size, Renderer::Type::FLOAT, false,
-					(int)VertexStride, currentLocation);
-				currentLocation += vertexTypes[i].size;
+				renderer->DescribeShaderVariable(renderID, vertexTypes[i].name, vertexTypes[i].size, vertexTypes[i].type, vertexTypes[i].normalized,
+					stride, currentLocation);
+				currentLocation += vertexTypes[i].byteSize;
+
+				if (SeparatePositions && vertexAttribute == VertexAttribute::POSITION)
+				{
+					// Everything else lives in the second stream
+					currentLocation = (char*)0 + GetStreamOffset(1);
+					stride = (int)GetStreamStride(1);
+				}
 			}
 		}
 	}
@@ -0,0 +1,31 @@
+#include "stdafx.hpp"
+
+#include "VertexBufferWriter.hpp"
+
+#if FLEX_F16C_RUNTIME_CHECK
+#include <intrin.h>
+#endif
+
+namespace flex
+{
+#if FLEX_F16C_RUNTIME_CHECK
+	static bool DetectF16C()
+	{
+		int cpuInfo[4];
+		__cpuid(cpuInfo, 1);
+
+		const bool f16c = (cpuInfo[2] & (1 << 29)) != 0;
+		const bool osxsave = (cpuInfo[2] & (1 << 27)) != 0;
+		if (!f16c || !osxsave)
+		{
+			return false;
+		}
+
+		// F16C instructions are VEX encoded, so the OS must also be saving the upper halves of YMM registers
+		const unsigned long long xcr0 = _xgetbv(0);
+		return (xcr0 & 0x6) == 0x6;
+	}
+
+	const bool CPU_SUPPORTS_F16C = DetectF16C();
+#endif
+} // namespace flex
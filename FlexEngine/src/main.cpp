@@ -2,7 +2,11 @@
 
 #include <windows.h>
 
+#include <cstring>
+
 #include "FlexEngine.hpp"
+#include "Logger.hpp"
+#include "UnitTests.hpp"
 
 // Memory leak checking includes
 #if defined(DEBUG) | defined(_DEBUG)
@@ -13,9 +17,6 @@
 
 int main(int argc, char *argv[])
 {
-	UNREFERENCED_PARAMETER(argc);
-	UNREFERENCED_PARAMETER(argv);
-
 	// Notify user if heap is corrupt
 	HeapSetInformation(NULL, HeapEnableTerminationOnCorruption, NULL, 0);
 
@@ -25,6 +26,12 @@ int main(int argc, char *argv[])
 	//_CrtSetBreakAlloc(1932);
 #endif
 
+	if (argc > 1 && strcmp(argv[1], "-test") == 0)
+	{
+		flex::Logger::Initialize();
+		exit(flex::RunUnitTests() ? EXIT_SUCCESS : EXIT_FAILURE);
+	}
+
 	{
 		flex::FlexEngine* engineInstance = new flex::FlexEngine();
 		engineInstance->Initialize();